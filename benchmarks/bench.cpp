@@ -0,0 +1,115 @@
+#include "headers/benchmarks.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+
+// every block carries its size in a header so that frees can be subtracted; reports
+// may allocate from several threads
+static constexpr size_t HEADER = alignof(std::max_align_t);
+static std::atomic<size_t> liveBytes = 0;
+static std::atomic<size_t> allocations = 0;
+
+
+void* operator new(const size_t size) {
+  auto* memory = static_cast<unsigned char*>(std::malloc(size + HEADER));
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(memory) = size;
+  liveBytes += size;
+  ++allocations;
+  return memory + HEADER;
+}
+
+void operator delete(void* memory) noexcept {
+  if (!memory) {
+    return;
+  }
+  auto* block = static_cast<unsigned char*>(memory) - HEADER;
+  liveBytes -= *reinterpret_cast<size_t*>(block);
+  std::free(block);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  operator delete(memory);
+}
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  operator delete(memory);
+}
+
+// over-aligned blocks (array elements, regions) are counted, their bytes are not
+void* operator new(const size_t size, const std::align_val_t alignment) {
+  const auto align = static_cast<size_t>(alignment);
+  void* memory = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  ++allocations;
+  return memory;
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t, const std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+size_t allocatedBytes() {
+  return liveBytes;
+}
+
+size_t allocationCount() {
+  return allocations;
+}
+
+
+int main(const int argc, char** argv) {
+  const std::map<std::string, int (*)(const std::vector<std::string>&)> reports = {
+    {"tid-memory", runTidMemoryReport},
+    {"dataflow", runDataflowReport},
+    {"semantic-parallel", runSemanticParallelReport},
+    {"concurrent-compilation", runConcurrentCompilationReport},
+    {"vm", runVmReport},
+    {"quickening", runQuickeningReport},
+    {"backends", runBackendsReport},
+    {"optimizer", runOptimizerReport},
+    {"peephole", runPeepholeReport},
+    {"cse", runSubexpressionsReport},
+    {"switch", runSwitchReport},
+    {"ssa", runSsaReport},
+    {"frames", runFramesReport},
+    {"strings", runStringsReport},
+    {"memory", runMemoryReport},
+    {"jit", runJitReport},
+    {"aot", runAotReport},
+  };
+
+  if (argc < 2 || !reports.contains(argv[1])) {
+    std::cerr << "Usage: " << argv[0] << " <report> [arguments...]" << std::endl;
+    std::cerr << "Reports:" << std::endl;
+    for (const auto& [name, _] : reports) {
+      std::cerr << "  " << name << std::endl;
+    }
+    return 1;
+  }
+
+  try {
+    return reports.at(argv[1])(std::vector<std::string>(argv + 2, argv + argc));
+  } catch (const std::exception& e) {
+    std::cerr << "Benchmark error: " << e.what() << std::endl;
+    return -1;
+  }
+}
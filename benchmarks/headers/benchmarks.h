@@ -0,0 +1,88 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+
+#include "../../includes/libraries.h"
+
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+
+// keywords file, relative to the build directory (same convention as main.cpp)
+inline const std::string BENCH_KEYWORDS_PATH = "../assets/keywords.txt";
+inline const std::string BENCH_PROGRAMS_PATH = "../assets/benchmarks";
+
+
+// Bytes currently allocated through the global operator new, and calls of it so far
+// (the counting operator new/delete live in bench.cpp)
+size_t allocatedBytes();
+size_t allocationCount();
+
+
+// Generated Cppt inputs
+std::string generateDeclarationHeavySource(size_t functions, size_t localsPerFunction);
+std::string generateLongFunctionSource(const std::string& name, size_t statements);
+
+// Labels of a generated switch: the ints 0..n-1, n ints far apart, or n strings
+enum class SwitchLabels { DENSE, SPARSE, STRING };
+// A state machine: one function whose switch of `cases` arms returns the next state,
+// called `dispatches` times from a loop that sums the states
+std::string generateSwitchSource(size_t cases, SwitchLabels labels, size_t dispatches);
+
+// (name, source) of every assets/benchmarks/*.cppt program, sorted by name
+std::vector<std::pair<std::string, std::string>> loadBenchmarkPrograms();
+
+// Best of `repeats` runs of a program on an interpreter (VirtualMachine, RegisterMachine);
+// `setup` configures each machine before its run
+struct Measurement {
+  double ms = 0;
+  uint64_t instructions = 0;
+  std::string output;
+};
+
+template <typename Machine, typename Program>
+Measurement measure(const Program& program, const size_t repeats, const std::function<void(Machine&)>& setup = {}) {
+  Measurement result;
+  for (size_t run = 0; run < repeats; ++run) {
+    Machine vm(program);
+    if (setup) {
+      setup(vm);
+    }
+    std::istringstream in;
+    std::ostringstream out;
+    const auto start = std::chrono::steady_clock::now();
+    vm.run(in, out);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (run == 0 || ms < result.ms) {
+      result.ms = ms;
+    }
+    result.instructions = vm.getExecutedInstructions();
+    result.output = out.str();
+  }
+  return result;
+}
+
+
+// Reports: every runner takes the remaining command-line arguments and returns an exit code
+int runTidMemoryReport(const std::vector<std::string>& args);
+int runDataflowReport(const std::vector<std::string>& args);
+int runSemanticParallelReport(const std::vector<std::string>& args);
+int runConcurrentCompilationReport(const std::vector<std::string>& args);
+int runVmReport(const std::vector<std::string>& args);
+int runQuickeningReport(const std::vector<std::string>& args);
+int runJitReport(const std::vector<std::string>& args);
+int runAotReport(const std::vector<std::string>& args);
+int runBackendsReport(const std::vector<std::string>& args);
+int runOptimizerReport(const std::vector<std::string>& args);
+int runPeepholeReport(const std::vector<std::string>& args);
+int runSubexpressionsReport(const std::vector<std::string>& args);
+int runSwitchReport(const std::vector<std::string>& args);
+int runSsaReport(const std::vector<std::string>& args);
+int runFramesReport(const std::vector<std::string>& args);
+int runStringsReport(const std::vector<std::string>& args);
+int runMemoryReport(const std::vector<std::string>& args);
+
+
+#endif //BENCHMARKS_H
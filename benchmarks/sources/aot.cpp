@@ -0,0 +1,63 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+#include <filesystem>
+
+
+// Compiles every program of assets/benchmarks to a native executable through the C++
+// backend and compares its run time with the stack VM's (interpreted and with the JIT);
+// the native time is the whole process, start included. The outputs must be equal.
+int runAotReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "cppt-aot";
+  std::filesystem::create_directories(directory);
+
+  std::cout << "stack VM vs ahead-of-time C++ (" << (std::getenv("CXX") ? std::getenv("CXX") : "c++")
+            << " -O2), best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(10) << "interp ms"
+            << std::setw(9) << "jit ms" << std::setw(11) << "native ms" << std::setw(10) << "vs interp"
+            << std::setw(8) << "vs jit" << std::setw(12) << "compile ms" << std::setw(10) << "C++ B"
+            << "  output" << std::endl;
+
+  bool equal = true;
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& program = context.generate();
+    const Measurement interpreted = measure<VirtualMachine>(program, repeats);
+    const Measurement jit = measure<VirtualMachine>(program, repeats, [](VirtualMachine& vm) { vm.setJit(true); });
+
+    const std::string& cpp = context.generateCpp();
+    const std::string executable = (directory / name).string();
+    const std::string output = executable + ".out";
+    auto start = std::chrono::steady_clock::now();
+    compileNative(cpp, executable);
+    const double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    double nativeMs = 0;
+    const std::string command = "\"" + executable + "\" < /dev/null > \"" + output + "\" 2>&1";
+    for (size_t run = 0; run < repeats; ++run) {
+      start = std::chrono::steady_clock::now();
+      if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error("\"" + executable + "\" failed");
+      }
+      const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < nativeMs) {
+        nativeMs = ms;
+      }
+    }
+    std::ifstream file(output, std::ios::binary);
+    const std::string nativeOutput((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << interpreted.ms << std::setw(9) << jit.ms << std::setw(11) << nativeMs
+              << std::setprecision(2) << std::setw(10) << interpreted.ms / nativeMs << std::setw(8)
+              << jit.ms / nativeMs << std::setprecision(0) << std::setw(12) << compileMs << std::setw(10)
+              << cpp.size() << "  " << nativeOutput
+              << (interpreted.output == nativeOutput ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && interpreted.output == nativeOutput;
+  }
+  std::filesystem::remove_all(directory);
+  return equal ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+
+
+// Compiles many small generated files in one process: first one after another, then
+// from a pool of threads with one CompilationContext per file. Every file's result
+// (warnings, identifier and type counts) must match the serial run.
+int runConcurrentCompilationReport(const std::vector<std::string>& args) {
+  const size_t files = args.size() > 0 ? std::stoul(args[0]) : 1000;
+  const size_t threads = args.size() > 1 ? std::stoul(args[1]) :
+    std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  std::vector<std::string> sources(files);
+  for (size_t i = 0; i < files; ++i) {
+    for (size_t f = 0; f < 1 + i % 4; ++f) {
+      sources[i] += generateLongFunctionSource("file_" + std::to_string(i) + "_" + std::to_string(f), 10 + i % 30);
+    }
+  }
+
+  const auto compile = [&](const size_t i) {
+    CompilationContext context(sources[i], BENCH_KEYWORDS_PATH);
+    context.setThreads(1); // the files are the parallel units
+    context.analyze();
+
+    std::string summary = std::to_string(context.getTID().identifierCount()) + "/" +
+      std::to_string(context.getTypes().size());
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      summary += "|" + diagnostic.toString();
+    }
+    return summary;
+  };
+
+  std::vector<std::string> serial(files);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < files; ++i) {
+    serial[i] = compile(i);
+  }
+  const double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<std::string> parallel(files);
+  std::vector<std::string> errors(files);
+  std::atomic<size_t> next = 0;
+  const auto worker = [&] {
+    for (size_t i = next++; i < files; i = next++) {
+      try {
+        parallel[i] = compile(i);
+      } catch (const std::exception& e) {
+        errors[i] = e.what();
+      }
+    }
+  };
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  const double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  for (size_t i = 0; i < files; ++i) {
+    if (!errors[i].empty() || parallel[i] != serial[i]) {
+      std::cerr << "File " << i << " compiled differently on the pool: " << errors[i] << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "files: " << files << ", pool threads: " << threads << ", hardware threads: " <<
+    std::thread::hardware_concurrency() << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "  one after another: " << serialMs << " ms" << std::endl;
+  std::cout << "  thread pool:       " << parallelMs << " ms (" << serialMs / parallelMs << "x)" << std::endl;
+  std::cout << "  all " << files << " results identical to the serial run" << std::endl;
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+
+
+// Times CFG construction and the bit-vector dataflow on generated functions of growing
+// size. Blocks and locals grow with the statement count while the number of slots (bits
+// per vector) does not, so the time per statement should stay flat.
+int runDataflowReport(const std::vector<std::string>& args) {
+  const size_t smallest = args.size() > 0 ? std::stoul(args[0]) : 500;
+  const size_t steps = args.size() > 1 ? std::stoul(args[1]) : 6;
+
+  std::vector<size_t> sizes;
+  std::string source;
+  for (size_t i = 0, statements = smallest; i < steps; ++i, statements *= 2) {
+    sizes.push_back(statements);
+    source += generateLongFunctionSource("long_function_" + std::to_string(i), statements);
+  }
+
+  CompilationContext context(source, BENCH_KEYWORDS_PATH);
+  context.analyze();
+  const ASTNodePtr& program = context.getProgram();
+  const SemanticAnalyzer& analyzer = context.getSemanticAnalyzer();
+
+  std::cout << "statements  locals  slots  blocks  warnings  cfg ms  dataflow ms  ns/statement" << std::endl;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    const ASTNodePtr& function = program->getChild(i);
+
+    const auto start = std::chrono::steady_clock::now();
+    const ControlFlowGraph graph = ControlFlowGraph::build(function, analyzer.getTypes());
+    const auto built = std::chrono::steady_clock::now();
+    DataflowAnalyzer dataflow(graph);
+    dataflow.solve();
+    const size_t warnings = dataflow.diagnose(analyzer.getTID()).size();
+    const auto solved = std::chrono::steady_clock::now();
+
+    const double cfgMs = std::chrono::duration<double, std::milli>(built - start).count();
+    const double dataflowMs = std::chrono::duration<double, std::milli>(solved - built).count();
+    std::cout << std::setw(10) << sizes[i] << std::setw(8) << graph.getLocals().size()
+              << std::setw(7) << graph.slotCount()              << std::setw(8) << graph.getBlocks().size() << std::setw(10) << warnings
+              << std::fixed << std::setprecision(2) << std::setw(8) << cfgMs << std::setw(13) << dataflowMs
+              << std::setw(14) << (cfgMs + dataflowMs) * 1e6 / static_cast<double>(sizes[i]) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// Deep recursion: each of the 20 descents is 50000 calls deep
+static const std::string DEEP_RECURSION_SOURCE = R"(
+func int depth(int n) {
+  if (n == 0) {
+    return 0;
+  }
+  return depth(n - 1) + 1;
+}
+func void main() {
+  int total = 0;
+  for (int i = 0; i < 20; i = i + 1) {
+    total = total + depth(50000);
+  }
+  cout << total;
+}
+)";
+
+
+// Milliseconds of `body`, best of `repeats` runs
+static double bestOf(const size_t repeats, const std::function<void()>& body) {
+  double best = 0;
+  for (size_t run = 0; run < repeats; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = run == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+
+// Runs the call-heavy programs of assets/benchmarks and a deep recursion on the stack VM,
+// whose frames are windows into one FrameStack, and compares them with two baselines: the
+// stack as it was before, a vector of DEFAULT_STACK_SIZE values initialized for every
+// machine, and a frame allocated on the heap for every call (the run plus one allocation,
+// argument copy and free per call, replayed on frames of the callees' average size)
+int runFramesReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "stack VM call frames, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(11) << "calls"
+            << std::setw(8) << "frame" << std::setw(14) << "setup ms" << std::setw(14) << "eager ms"
+            << std::setw(11) << "run ms" << std::setw(16) << "heap frames ms" << std::setw(10) << "saved"
+            << "  output" << std::endl;
+
+  std::vector<std::pair<std::string, std::string>> programs;
+  for (auto& [name, source] : loadBenchmarkPrograms()) {
+    if (name == "fib" || name == "calls") {
+      programs.emplace_back(name, std::move(source));
+    }
+  }
+  programs.emplace_back("deep-recursion", DEEP_RECURSION_SOURCE);
+
+  for (const auto& [name, source] : programs) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& program = context.generate();
+
+    uint64_t calls;
+    {
+      VirtualMachine vm(program);
+      DispatchProfile profile;
+      std::istringstream in;
+      std::ostringstream out;
+      vm.run(in, out, profile);
+      calls = profile.opcodes[static_cast<size_t>(OpCode::CALL)];
+    }
+    size_t frame = 0;
+    size_t parameters = 0;
+    for (size_t i = 1; i < program.functions.size(); ++i) {
+      frame += program.functions[i].slots + program.functions[i].maxStack;
+      parameters += program.functions[i].parameters;
+    }
+    const size_t callees = std::max<size_t>(program.functions.size() - 1, 1);
+    frame = std::max<size_t>(frame / callees, 1);
+    parameters /= callees;
+
+    // the machine before and after its run: what a frame stack costs when nothing calls
+    const double setup = bestOf(repeats, [&] { VirtualMachine vm(program); });
+    const double eager = bestOf(repeats, [&] {
+      std::vector<Value> stack(VirtualMachine::DEFAULT_STACK_SIZE);
+      volatile const Value* sink = stack.data();
+      (void) sink;
+    });
+    std::string output;
+    const double run = bestOf(repeats, [&] {
+      VirtualMachine vm(program);
+      std::istringstream in;
+      std::ostringstream out;
+      vm.run(in, out);
+      output = out.str();
+    });
+    const double heap = bestOf(repeats, [&] {
+      Value argument = Value::ofInt(1);
+      for (uint64_t call = 0; call < calls; ++call) {
+        auto* values = static_cast<Value*>(::operator new(frame * sizeof(Value)));
+        std::fill_n(values, std::max<size_t>(parameters, 1), argument);
+        argument = values[0];
+        ::operator delete(values);
+      }
+    }) + run;
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(11) << calls << std::setw(8) << frame
+              << std::fixed << std::setprecision(3) << std::setw(14) << setup << std::setw(14) << eager
+              << std::setprecision(1) << std::setw(11) << run << std::setw(16) << heap << std::setw(9)
+              << 100.0 * (heap - run) / heap << "%  " << output << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "../headers/benchmarks.h"
+
+#include <numeric>
+
+
+std::string generateDeclarationHeavySource(const size_t functions, const size_t localsPerFunction) {
+  // local names repeat across functions, like real code does; every fourth one is long
+  // enough to leave the small-string buffer
+  static const std::vector<std::string> stems = {
+    "i", "value", "counter", "accumulatedResultValue", "x", "tmp", "index", "partialSumOfElements"
+  };
+  static const std::vector<std::string> types = {"int", "float", "char", "bool", "string"};
+
+  std::string source;
+  source.reserve(functions * localsPerFunction * 24);
+
+  for (size_t f = 0; f < functions; ++f) {
+    source += "func int generated_function_" + std::to_string(f) + "(int a, int b) {\n";
+
+    // locals are spread over nested blocks of eight declarations each
+    size_t open = 0;
+    for (size_t l = 0; l < localsPerFunction; ++l) {
+      if (l % 8 == 0 && l != 0) {
+        source += "{\n";
+        ++open;
+      }
+      source += "  " + types[l % types.size()] + " " + stems[l % stems.size()] + "_" + std::to_string(l / 8) + ";\n";
+    }
+    source.append(open, '}');
+    source += "\n  return a;\n}\n\n";
+  }
+  return source;
+}
+
+std::string generateLongFunctionSource(const std::string& name, const size_t statements) {
+  // one long body: a few accumulators live through the whole function, every statement
+  // group declares its temporaries in a block of its own (loop bodies, branches); every
+  // fifth temporary is only assigned on one path, so its read is "maybe uninitialized"
+  std::string source = "func int " + name + "(int a) {\n  int acc = a;\n  int total = 0;\n";
+  for (size_t k = 1; k <= statements; ++k) {
+    const std::string t = "t" + std::to_string(k % 7);
+    const std::string bound = std::to_string(k);
+    switch (k % 5) {
+      case 0:
+        source += "  { int " + t + "; if (a > " + bound + ") { " + t + " = acc; } total = total + " + t + "; }\n";
+        break;
+      case 1:
+        source += "  { int " + t + " = acc + 1; acc = " + t + " * 2; }\n";
+        break;
+      case 2:
+        source += "  { int " + t + " = acc; while (" + t + " > a) { " + t + " = " + t + " - 1; if (" + t +
+          " == 3) { break; } } total = total + " + t + "; }\n";
+        break;
+      case 3:
+        source += "  for (int i = 0; i < " + bound + "; i = i + 1) { int " + t + " = i * acc; total = total + " +
+          t + "; }\n";
+        break;
+      default:
+        source += "  switch (a) { case 1: acc = 2; break; default: acc = acc * 2; break; }\n";
+        break;
+    }
+  }
+  return source + "  return acc + total;\n}\n\n";
+}
+
+std::string generateSwitchSource(const size_t cases, const SwitchLabels labels, const size_t dispatches) {
+  // the case k goes to the state k + stride (mod cases): the stride is coprime to the
+  // count, so every case is visited, and about 0.6 of the count, so that consecutive
+  // dispatches land far apart in the table or the tree
+  size_t stride = cases * 5 / 8 + 1;
+  while (std::gcd(stride, cases) != 1) {
+    ++stride;
+  }
+  const auto label = [&](const size_t k) {
+    switch (labels) {
+      case SwitchLabels::DENSE:
+        return std::to_string(k);
+      case SwitchLabels::SPARSE:
+        return std::to_string(k * k + 3 * k); // increasing, gaps growing with k
+      default:
+        return "\"state_" + std::to_string(k) + "\"";
+    }
+  };
+  const std::string type = labels == SwitchLabels::STRING ? "string" : "int";
+
+  std::string source = "func " + type + " step(" + type + " state) {\n  " + type + " next = " + label(0) +
+    ";\n  switch (state) {\n";
+  for (size_t k = 0; k < cases; ++k) {
+    source += "    case " + label(k) + ": next = " + label((k + stride) % cases) + "; break;\n";
+  }
+  source += "    default: next = " + label(0) + "; break;\n  }\n  return next;\n}\n\n";
+  source += type + " state = " + label(0) + ";\nint visits = 0;\n";
+  source += "for (int i = 0; i < " + std::to_string(dispatches) + "; i = i + 1) {\n  state = step(state);\n";
+  source += "  if (state == " + label(0) + ") {\n    visits = visits + 1;\n  }\n}\ncout << visits;\n";
+  return source;
+}
@@ -0,0 +1,175 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// A function filling and summing a local array, called n times
+static const std::string ARRAY_SOURCE = R"(
+func int total(int k) {
+  array< int > values[64];
+  for (int i = 0; i < 64; i = i + 1) {
+    values[i] = i * k;
+  }
+  int sum = 0;
+  for (int i = 0; i < 64; i = i + 1) {
+    sum = sum + values[i];
+  }
+  return sum;
+}
+func void main() {
+  int n;
+  cin >> n;
+  int result = 0;
+  for (int i = 0; i < n; i = i + 1) {
+    result = result + total(i);
+  }
+  cout << result;
+}
+)";
+
+// The same with a local 8 x 8 matrix
+static const std::string MATRIX_SOURCE = R"(
+func int trace(int k) {
+  array< array< int > > m[8][8];
+  for (int i = 0; i < 8; i = i + 1) {
+    for (int j = 0; j < 8; j = j + 1) {
+      m[i][j] = i + j + k;
+    }
+  }
+  int sum = 0;
+  for (int i = 0; i < 8; i = i + 1) {
+    sum = sum + m[i][i];
+  }
+  return sum;
+}
+func void main() {
+  int n;
+  cin >> n;
+  int result = 0;
+  for (int i = 0; i < n; i = i + 1) {
+    result = result + trace(i);
+  }
+  cout << result;
+}
+)";
+
+// Local strings: a flat concatenation (its characters are allocated by the string) and
+// a rope of it
+static const std::string STRING_SOURCE = R"(
+func int check(string word) {
+  string twice = word + word;
+  string more = twice + twice;
+  if (more == word) {
+    return 0;
+  }
+  return 1;
+}
+func void main() {
+  int n;
+  cin >> n;
+  int result = 0;
+  for (int i = 0; i < n; i = i + 1) {
+    result = result + check("a string longer than a value");
+  }
+  cout << result;
+}
+)";
+
+// Arrays that escape their call: always on the heap, freed by its collections
+static const std::string ESCAPING_SOURCE = R"(
+func array< int > make(int k) {
+  array< int > values[64];
+  values[0] = k;
+  return values;
+}
+func void main() {
+  int n;
+  cin >> n;
+  int result = 0;
+  for (int i = 0; i < n; i = i + 1) {
+    array< int > made = make(i);
+    result = result + made[0];
+  }
+  cout << result;
+}
+)";
+
+
+// One program's runs with or without regions
+struct MemoryRun {
+  double mallocs = 0; // per iteration
+  double ms = 0; // best run
+  MemoryStatistics memory;
+  std::string output;
+};
+
+static MemoryRun measureMemory(const std::string& source, const bool regions, const size_t n, const size_t repeats) {
+  CompilationContext context(source, BENCH_KEYWORDS_PATH);
+  context.setRegions(regions);
+  const RPNProgram& program = context.generate();
+
+  // a run of n iterations over one of none: the machine's own allocations cancel out
+  MemoryRun result;
+  size_t calls = 0;
+  for (const std::string& count : {std::string("0"), std::to_string(n)}) {
+    const size_t before = allocationCount();
+    VirtualMachine vm(program);
+    std::istringstream in(count);
+    std::ostringstream out;
+    vm.run(in, out);
+    calls = allocationCount() - before - calls;
+    result.memory = vm.getMemoryStatistics();
+    result.output = out.str();
+  }
+  result.mallocs = static_cast<double>(calls) / static_cast<double>(n);
+
+  for (size_t run = 0; run < repeats; ++run) {
+    VirtualMachine vm(program);
+    std::istringstream in(std::to_string(n));
+    std::ostringstream out;
+    const auto start = std::chrono::steady_clock::now();
+    vm.run(in, out);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.ms = run == 0 ? ms : std::min(result.ms, ms);
+  }
+  return result;
+}
+
+
+// Runs programs calling a function n times on the stack VM, with the arrays and strings
+// that escape analysis keeps local in the region of their call and without (everything
+// on the heap): allocations (operator new calls) per iteration, run time, the region's
+// peak and the heap objects alive at the end with the collections that freed the others
+int runMemoryReport(const std::vector<std::string>& args) {
+  const size_t n = args.size() > 0 ? std::stoul(args[0]) : 100000;
+  const size_t repeats = args.size() > 1 ? std::stoul(args[1]) : 3;
+
+  const std::vector<std::pair<std::string, const std::string*>> programs = {
+    {"local-array", &ARRAY_SOURCE},
+    {"local-matrix", &MATRIX_SOURCE},
+    {"local-strings", &STRING_SOURCE},
+    {"escaping-array", &ESCAPING_SOURCE},
+  };
+
+  std::cout << "memory on the stack VM, n = " << n << ", best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(15) << "mallocs/iter"
+            << std::setw(15) << "heap only" << std::setw(10) << "run ms" << std::setw(11) << "heap ms"
+            << std::setw(13) << "region KiB" << std::setw(8) << "alive" << std::setw(13) << "collections"
+            << "  output" << std::endl;
+
+  for (const auto& [name, source] : programs) {
+    const MemoryRun regions = measureMemory(*source, true, n, repeats);
+    const MemoryRun heap = measureMemory(*source, false, n, repeats);
+    if (regions.output != heap.output) {
+      throw std::runtime_error("'" + name + "' prints " + regions.output + " with regions, " + heap.output +
+        " without");
+    }
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(15) << regions.mallocs << std::setw(15) << heap.mallocs << std::setprecision(1)
+              << std::setw(10) << regions.ms << std::setw(11) << heap.ms << std::setw(13)
+              << regions.memory.region.peakBytes / 1024 << std::setw(8) << regions.memory.heapObjects
+              << std::setw(13) << regions.memory.collections << "  " << regions.output << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/register-vm.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// Compiles every program of assets/benchmarks with and without ASTOptimizer and compares
+// the instructions (in the code and executed) and the time on both backends; the outputs
+// must be equal
+int runOptimizerReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "AST optimizer off / on, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(13) << "code instr"
+            << std::setw(24) << "stack executed" << std::setw(18) << "stack ms" << std::setw(24)
+            << "register executed" << std::setw(18) << "register ms" << "  output" << std::endl;
+
+  bool equal = true;
+  OptimizationStatistics total;
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext plain(source, BENCH_KEYWORDS_PATH);
+    plain.setOptimization(false);
+    CompilationContext optimized(source, BENCH_KEYWORDS_PATH);
+
+    const Measurement stackBefore = measure<VirtualMachine>(plain.generate(), repeats);
+    const Measurement stackAfter = measure<VirtualMachine>(optimized.generate(), repeats);
+    const Measurement registerBefore = measure<RegisterMachine>(plain.generateRegisters(), repeats);
+    const Measurement registerAfter = measure<RegisterMachine>(optimized.generateRegisters(), repeats);
+
+    const auto pair = [](const auto before, const auto after) {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(1) << before << " / " << after;
+      return out.str();
+    };
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(13)
+              << pair(plain.getBytecode().instructionCount(), optimized.getBytecode().instructionCount())
+              << std::setw(24) << pair(stackBefore.instructions, stackAfter.instructions) << std::setw(18)
+              << pair(stackBefore.ms, stackAfter.ms) << std::setw(24)
+              << pair(registerBefore.instructions, registerAfter.instructions) << std::setw(18)
+              << pair(registerBefore.ms, registerAfter.ms) << "  " << stackAfter.output;
+
+    const bool same = stackBefore.output == stackAfter.output && stackBefore.output == registerBefore.output &&
+      stackBefore.output == registerAfter.output;
+    std::cout << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && same;
+
+    const OptimizationStatistics& statistics = optimized.getOptimizationStatistics();
+    total.foldedExpressions += statistics.foldedExpressions;
+    total.propagatedConstants += statistics.propagatedConstants;
+    total.removedStatements += statistics.removedStatements;
+    total.deadStores += statistics.deadStores;
+    total.removedDeclarations += statistics.removedDeclarations;
+    total.simplifiedSwitches += statistics.simplifiedSwitches;
+  }
+
+  std::cout << std::endl << "folded " << total.foldedExpressions << ", propagated " << total.propagatedConstants
+            << ", removed " << total.removedStatements << " statements and " << total.removedDeclarations
+            << " declarations, " << total.deadStores << " dead stores, " << total.simplifiedSwitches
+            << " switches simplified" << std::endl;
+  return equal ? 0 : 1;
+}
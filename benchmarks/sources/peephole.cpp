@@ -0,0 +1,100 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// Opcode names of a pair or triple index of DispatchProfile
+static std::string sequenceName(size_t index, const size_t length) {
+  std::string name;
+  for (size_t i = 0; i < length; ++i) {
+    name = std::string(OPCODE_NAMES[index % OPCODE_COUNT]) + (name.empty() ? "" : " ") + name;
+    index /= OPCODE_COUNT;
+  }
+  return name;
+}
+
+// The `count` most frequent sequences, by their average share of each program's dispatches
+static void printTopSequences(const std::vector<double>& shares, const size_t length, const size_t count) {
+  std::vector<size_t> order(shares.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return shares[a] > shares[b]; });
+  for (size_t i = 0; i < count && shares[order[i]] > 0; ++i) {
+    std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(5) << 100.0 * shares[order[i]] << "%  "
+              << sequenceName(order[i], length) << std::endl;
+  }
+}
+
+// Profiles the stack VM on every program of assets/benchmarks without PeepholeOptimizer
+// (the most frequent opcode sequences, averaged over the programs: what superinstructions
+// pay off), then compares the dispatched instructions and the time with it; the outputs
+// must be equal
+int runPeepholeReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+  const size_t top = args.size() > 1 ? std::stoul(args[1]) : 12;
+  const auto programs = loadBenchmarkPrograms();
+
+  std::vector<double> pairs(OPCODE_COUNT * OPCODE_COUNT);
+  std::vector<double> triples(OPCODE_COUNT * OPCODE_COUNT * OPCODE_COUNT);
+  for (const auto& [name, source] : programs) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    context.setPeephole(false);
+    VirtualMachine vm(context.generate());
+    DispatchProfile profile;
+    std::istringstream in;
+    std::ostringstream out;
+    vm.run(in, out, profile);
+    const double weight = static_cast<double>(vm.getExecutedInstructions()) * static_cast<double>(programs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      pairs[i] += static_cast<double>(profile.pairs[i]) / weight;
+    }
+    for (size_t i = 0; i < triples.size(); ++i) {
+      triples[i] += static_cast<double>(profile.triples[i]) / weight;
+    }
+  }
+  std::cout << "most frequent opcode pairs without the peephole pass (share of the dispatches)" << std::endl;
+  printTopSequences(pairs, 2, top);
+  std::cout << "most frequent opcode triples" << std::endl;
+  printTopSequences(triples, 3, top);
+
+  std::cout << std::endl << "peephole off / on, stack VM, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(13) << "code instr"
+            << std::setw(24) << "executed" << std::setw(8) << "ratio" << std::setw(18) << "ms" << std::setw(9)
+            << "speedup" << "  output" << std::endl;
+
+  bool equal = true;
+  PeepholeStatistics total;
+  for (const auto& [name, source] : programs) {
+    CompilationContext plain(source, BENCH_KEYWORDS_PATH);
+    plain.setPeephole(false);
+    CompilationContext optimized(source, BENCH_KEYWORDS_PATH);
+    const Measurement before = measure<VirtualMachine>(plain.generate(), repeats);
+    const Measurement after = measure<VirtualMachine>(optimized.generate(), repeats);
+
+    const auto pair = [](const auto first, const auto second) {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(1) << first << " / " << second;
+      return out.str();
+    };
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(13)
+              << pair(plain.getBytecode().instructionCount(), optimized.getBytecode().instructionCount())
+              << std::setw(24) << pair(before.instructions, after.instructions) << std::fixed
+              << std::setprecision(2) << std::setw(8)
+              << static_cast<double>(after.instructions) / static_cast<double>(before.instructions)
+              << std::setw(18) << pair(before.ms, after.ms) << std::setprecision(2) << std::setw(9)
+              << before.ms / after.ms << "  " << after.output
+              << (before.output == after.output ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && before.output == after.output;
+
+    const PeepholeStatistics& statistics = optimized.getPeepholeStatistics();
+    total.superinstructions += statistics.superinstructions;
+    total.threadedJumps += statistics.threadedJumps;
+    total.removedInstructions += statistics.removedInstructions;
+  }
+
+  std::cout << std::endl << total.superinstructions << " superinstructions, " << total.threadedJumps
+            << " jumps threaded, " << total.removedInstructions << " instructions removed" << std::endl;
+  return equal ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+
+
+// Semantic analysis of a many-function program with 1, 2, 4, ... threads. Every run
+// parses the source into a fresh context, and the merged warnings must be the same
+// for every thread count.
+int runSemanticParallelReport(const std::vector<std::string>& args) {
+  const size_t functions = args.size() > 0 ? std::stoul(args[0]) : 2000;
+  const size_t statements = args.size() > 1 ? std::stoul(args[1]) : 60;
+  const size_t maxThreads = args.size() > 2 ? std::stoul(args[2]) :
+    std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  std::string source;
+  for (size_t f = 0; f < functions; ++f) {
+    source += generateLongFunctionSource("function_" + std::to_string(f), statements);
+  }
+
+  std::cout << "functions: " << functions << ", statements per function: " << statements <<
+    ", hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+  std::cout << "threads   time ms   speedup  warnings" << std::endl;
+
+  double serialMs = 0;
+  std::vector<std::string> reference;
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    context.setThreads(threads);
+    context.parse();
+
+    const auto start = std::chrono::steady_clock::now();
+    context.analyze();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> warnings;
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      warnings.push_back(diagnostic.toString());
+    }
+    if (threads == 1) {
+      serialMs = ms;
+      reference = warnings;
+    } else if (warnings != reference) {
+      std::cerr << "Diagnostics differ between 1 and " << threads << " threads!" << std::endl;
+      return 1;
+    }
+
+    std::cout << std::setw(7) << threads << std::fixed << std::setprecision(2) << std::setw(10) << ms
+              << std::setw(10) << serialMs / ms << std::setw(10) << warnings.size() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/register-vm.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// Compiles every program of assets/benchmarks straight from the AST and through the SSA
+// form, and compares the size of the SSA form, the instructions (in the code and
+// executed) and the time on both backends; the outputs must be equal
+int runSsaReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "bytecode from the AST / from the SSA form, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(14) << "values/phis"
+            << std::setw(13) << "code instr" << std::setw(24) << "stack executed" << std::setw(18) << "stack ms"
+            << std::setw(24) << "register executed" << std::setw(18) << "register ms" << "  output" << std::endl;
+
+  bool equal = true;
+  uint64_t stackTotal[2] = {0, 0};
+  uint64_t registerTotal[2] = {0, 0};
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext direct(source, BENCH_KEYWORDS_PATH);
+    CompilationContext lowered(source, BENCH_KEYWORDS_PATH);
+    lowered.setSSA(true);
+
+    const Measurement stackBefore = measure<VirtualMachine>(direct.generate(), repeats);
+    const Measurement stackAfter = measure<VirtualMachine>(lowered.generate(), repeats);
+    const Measurement registerBefore = measure<RegisterMachine>(direct.generateRegisters(), repeats);
+    const Measurement registerAfter = measure<RegisterMachine>(lowered.generateRegisters(), repeats);
+
+    size_t values = 0;
+    size_t phis = 0;
+    for (const SSAFunction& function : lowered.buildSSA().functions) {
+      values += function.values.size();
+      phis += std::count_if(function.values.begin(), function.values.end(),
+        [](const SSAInstruction& instruction) { return instruction.op == SSAOp::PHI; });
+    }
+
+    const auto pair = [](const auto before, const auto after) {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(1) << before << " / " << after;
+      return out.str();
+    };
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(14) << pair(values, phis)
+              << std::setw(13)
+              << pair(direct.getBytecode().instructionCount(), lowered.getBytecode().instructionCount())
+              << std::setw(24) << pair(stackBefore.instructions, stackAfter.instructions) << std::setw(18)
+              << pair(stackBefore.ms, stackAfter.ms) << std::setw(24)
+              << pair(registerBefore.instructions, registerAfter.instructions) << std::setw(18)
+              << pair(registerBefore.ms, registerAfter.ms) << "  " << stackAfter.output;
+
+    const bool same = stackBefore.output == stackAfter.output && stackBefore.output == registerBefore.output &&
+      stackBefore.output == registerAfter.output;
+    std::cout << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && same;
+
+    stackTotal[0] += stackBefore.instructions;
+    stackTotal[1] += stackAfter.instructions;
+    registerTotal[0] += registerBefore.instructions;
+    registerTotal[1] += registerAfter.instructions;
+  }
+
+  const auto ratio = [](const uint64_t total[2]) {
+    return 100.0 * static_cast<double>(total[1]) / static_cast<double>(total[0]);
+  };
+  std::cout << std::endl << "executed instructions through SSA: stack " << std::fixed << std::setprecision(2)
+            << ratio(stackTotal) << "%, register " << ratio(registerTotal) << "% of the direct generation"
+            << std::endl;
+  return equal ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// A string built one character at a time: n appends to a string growing to n characters
+static const std::string APPEND_SOURCE = R"(
+func void main() {
+  int n;
+  cin >> n;
+  string s = "";
+  for (int i = 0; i < n; i = i + 1) {
+    s = s + 'x';
+  }
+  cout << s;
+}
+)";
+
+// Short strings made and compared n times: two concatenations and a comparison each
+static const std::string SHORT_SOURCE = R"(
+func void main() {
+  int n;
+  cin >> n;
+  int count = 0;
+  for (int i = 0; i < n; i = i + 1) {
+    string word = "ab";
+    word = word + 'c' + "de";
+    if (word == "abcde") {
+      count = count + 1;
+    }
+  }
+  cout << count;
+}
+)";
+
+// A long literal compared with the same literal n times (the key depends on the input,
+// so the optimizer cannot fold the comparison)
+static const std::string LITERAL_SOURCE = R"(
+func void main() {
+  int n;
+  cin >> n;
+  int count = 0;
+  string key = "none";
+  if (n > 0) {
+    key = "a key much longer than a value cell";
+  }
+  for (int i = 0; i < n; i = i + 1) {
+    if (key == "a key much longer than a value cell") {
+      count = count + 1;
+    }
+  }
+  cout << count;
+}
+)";
+
+
+// Milliseconds of `body`, best of `repeats` runs
+static double bestOf(const size_t repeats, const std::function<void()>& body) {
+  double best = 0;
+  for (size_t run = 0; run < repeats; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = run == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+
+// Runs string workloads on the stack VM: the heap objects and bytes a run keeps (over a
+// run with n = 0) and its time, next to the string operations of the same run replayed
+// on the representation before short strings, ropes and interning (every string a new
+// heap object, every concatenation a copy of both sides, every comparison of the
+// characters)
+int runStringsReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  struct Workload {
+    std::string name;
+    const std::string* source;
+    size_t n;
+    std::function<void(size_t)> replay;
+  };
+  const auto append = [](const size_t n) {
+    std::vector<std::unique_ptr<std::string>> heap;
+    heap.push_back(std::make_unique<std::string>());
+    for (size_t i = 0; i < n; ++i) {
+      heap.push_back(std::make_unique<std::string>(*heap.back() + 'x'));
+    }
+  };
+  const auto shortStrings = [](const size_t n) {
+    std::vector<std::unique_ptr<std::string>> heap;
+    const std::string literal = "abcde";
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+      heap.push_back(std::make_unique<std::string>(std::string("ab") + 'c'));
+      heap.push_back(std::make_unique<std::string>(*heap.back() + "de"));
+      count += *heap.back() == literal;
+    }
+    volatile size_t sink = count;
+    (void) sink;
+  };
+  const auto literal = [](const size_t n) {
+    const std::string key = "a key much longer than a value cell";
+    const std::string other = key;
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+      count += key.compare(other) == 0;
+    }
+    volatile size_t sink = count;
+    (void) sink;
+  };
+  const std::vector<Workload> workloads = {
+    {"append", &APPEND_SOURCE, 2000, append},
+    {"append", &APPEND_SOURCE, 20000, append},
+    {"append", &APPEND_SOURCE, 100000, append},
+    {"short", &SHORT_SOURCE, 1000000, shortStrings},
+    {"literal", &LITERAL_SOURCE, 1000000, literal},
+  };
+
+  std::cout << "strings on the stack VM, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(10) << "program" << std::right << std::setw(9) << "n" << std::setw(10)
+            << "objects" << std::setw(12) << "heap KiB" << std::setw(10) << "run ms" << std::setw(14)
+            << "copying ms" << "  output" << std::endl;
+
+  for (const auto& [name, source, n, replay] : workloads) {
+    CompilationContext context(*source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& program = context.generate();
+    const std::string input = std::to_string(n);
+
+    size_t objects = 0;
+    size_t bytes = 0;
+    std::string output;
+    for (const std::string& count : {std::string("0"), input}) {
+      const size_t before = allocatedBytes();
+      VirtualMachine vm(program);
+      std::istringstream in(count);
+      std::ostringstream out;
+      vm.run(in, out);
+      objects = vm.getHeap().objectCount() - objects;
+      bytes = allocatedBytes() - before - bytes;
+      output = out.str();
+    }
+    const double run = bestOf(repeats, [&] {
+      VirtualMachine vm(program);
+      std::istringstream in(input);
+      std::ostringstream out;
+      vm.run(in, out);
+    });
+    const double copying = bestOf(repeats, [&] { replay(n); });
+    if (output.size() > 12) {
+      output = std::to_string(output.size()) + " characters";
+    }
+
+    std::cout << std::left << std::setw(10) << name << std::right << std::setw(9) << n << std::setw(10) << objects
+              << std::setw(12) << bytes / 1024 << std::fixed << std::setprecision(1) << std::setw(10) << run
+              << std::setw(14) << copying << "  " << output << std::endl;
+  }
+  return 0;
+}
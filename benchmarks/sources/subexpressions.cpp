@@ -0,0 +1,64 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/register-vm.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// Compiles every program of assets/benchmarks with and without CommonSubexpressions (the
+// rest of the optimization on) and compares the instructions (in the code and executed)
+// and the time on both backends; the outputs must be equal
+int runSubexpressionsReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "common subexpression elimination off / on, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(9) << "shared" << std::setw(13)
+            << "code instr" << std::setw(24) << "stack executed" << std::setw(18) << "stack ms" << std::setw(24)
+            << "register executed" << std::setw(18) << "register ms" << "  output" << std::endl;
+
+  bool equal = true;
+  uint64_t stackTotal[2] = {0, 0};
+  uint64_t registerTotal[2] = {0, 0};
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext plain(source, BENCH_KEYWORDS_PATH);
+    plain.setCommonSubexpressions(false);
+    CompilationContext shared(source, BENCH_KEYWORDS_PATH);
+
+    const Measurement stackBefore = measure<VirtualMachine>(plain.generate(), repeats);
+    const Measurement stackAfter = measure<VirtualMachine>(shared.generate(), repeats);
+    const Measurement registerBefore = measure<RegisterMachine>(plain.generateRegisters(), repeats);
+    const Measurement registerAfter = measure<RegisterMachine>(shared.generateRegisters(), repeats);
+
+    const auto pair = [](const auto before, const auto after) {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(1) << before << " / " << after;
+      return out.str();
+    };
+    const SubexpressionStatistics& statistics = shared.getSubexpressionStatistics();
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(9)
+              << pair(statistics.values, statistics.reuses) << std::setw(13)
+              << pair(plain.getBytecode().instructionCount(), shared.getBytecode().instructionCount())
+              << std::setw(24) << pair(stackBefore.instructions, stackAfter.instructions) << std::setw(18)
+              << pair(stackBefore.ms, stackAfter.ms) << std::setw(24)
+              << pair(registerBefore.instructions, registerAfter.instructions) << std::setw(18)
+              << pair(registerBefore.ms, registerAfter.ms) << "  " << stackAfter.output;
+
+    const bool same = stackBefore.output == stackAfter.output && stackBefore.output == registerBefore.output &&
+      stackBefore.output == registerAfter.output;
+    std::cout << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && same;
+
+    stackTotal[0] += stackBefore.instructions;
+    stackTotal[1] += stackAfter.instructions;
+    registerTotal[0] += registerBefore.instructions;
+    registerTotal[1] += registerAfter.instructions;
+  }
+
+  const auto saved = [](const uint64_t total[2]) {
+    return 100.0 * (static_cast<double>(total[0]) - static_cast<double>(total[1])) / static_cast<double>(total[0]);
+  };
+  std::cout << std::endl << "executed instructions saved: stack " << std::fixed << std::setprecision(2)
+            << saved(stackTotal) << "%, register " << saved(registerTotal) << "% (shared: values kept / reuses)"
+            << std::endl;
+  return equal ? 0 : 1;
+}
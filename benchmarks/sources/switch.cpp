@@ -0,0 +1,70 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/vm.h"
+
+
+// How RPNGenerator dispatched the switches of a program
+static std::string loweringName(const RPNProgram& program) {
+  for (size_t pc = 0; pc < program.code.size(); pc += instructionSize(static_cast<OpCode>(program.code[pc]))) {
+    if (program.code[pc] == static_cast<uint8_t>(OpCode::SWITCH_TABLE)) {
+      return "jump table";
+    }
+    if (program.code[pc] == static_cast<uint8_t>(OpCode::SWITCH_STRING)) {
+      return "perfect hash";
+    }
+  }
+  return "tree";
+}
+
+// Dispatch time of generated state-machine switches of 4 to 10000 cases (dense ints,
+// sparse ints, strings) on the stack VM: the comparison chain (the optimization off)
+// against the lowering RPNGenerator picks, interpreted and with the JIT. The times are
+// per iteration of the calling loop (a call, the switch, a return and a comparison), the
+// JIT's include compiling the function; the outputs must be equal
+int runSwitchReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+  const size_t dispatches = args.size() > 1 ? std::stoul(args[1]) : 100000;
+  static const std::vector<size_t> counts = {4, 16, 64, 256, 1024, 10000};
+  static const std::vector<std::pair<SwitchLabels, std::string>> shapes = {
+    {SwitchLabels::DENSE, "dense"}, {SwitchLabels::SPARSE, "sparse"}, {SwitchLabels::STRING, "string"}};
+
+  std::cout << "switch dispatch, stack VM, " << dispatches << " dispatches, best of " << repeats
+            << " runs, ns per dispatch (chain / lowered)" << std::endl;
+  std::cout << std::left << std::setw(8) << "labels" << std::right << std::setw(7) << "cases" << "  " << std::left
+            << std::setw(14) << "lowering" << std::right << std::setw(20) << "interpreter" << std::setw(9)
+            << "speedup" << std::setw(20) << "jit" << std::setw(9) << "speedup" << "  output" << std::endl;
+
+  bool equal = true;
+  for (const auto& [labels, shape] : shapes) {
+    for (const size_t count : counts) {
+      const std::string source = generateSwitchSource(count, labels, dispatches);
+      CompilationContext chain(source, BENCH_KEYWORDS_PATH);
+      chain.setOptimization(false);
+      CompilationContext lowered(source, BENCH_KEYWORDS_PATH);
+
+      const auto enableJit = [](VirtualMachine& vm) { vm.setJit(true); };
+      const Measurement before = measure<VirtualMachine>(chain.generate(), repeats);
+      const Measurement after = measure<VirtualMachine>(lowered.generate(), repeats);
+      const Measurement jitBefore = measure<VirtualMachine>(chain.generate(), repeats, enableJit);
+      const Measurement jitAfter = measure<VirtualMachine>(lowered.generate(), repeats, enableJit);
+
+      const auto perDispatch = [&](const Measurement& first, const Measurement& second) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << first.ms * 1e6 / static_cast<double>(dispatches) << " / "
+            << second.ms * 1e6 / static_cast<double>(dispatches);
+        return out.str();
+      };
+      const bool same = before.output == after.output && before.output == jitBefore.output &&
+        before.output == jitAfter.output;
+      std::cout << std::left << std::setw(8) << shape << std::right << std::setw(7) << count << "  " << std::left
+                << std::setw(14) << loweringName(lowered.getBytecode()) << std::right << std::setw(20)
+                << perDispatch(before, after) << std::fixed << std::setprecision(2) << std::setw(9)
+                << before.ms / after.ms << std::setw(20) << perDispatch(jitBefore, jitAfter) << std::setw(9)
+                << jitBefore.ms / jitAfter.ms << "  " << after.output << (same ? "" : "  OUTPUT DIFFERS")
+                << std::endl;
+      equal = equal && same;
+    }
+  }
+  return equal ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+
+
+// Layout of TID entries before pooling: every entry owned its name, the name of its
+// scope and its additional info, and entries were bucketed by name
+enum class LegacyIdentifierType {
+  FUNCTION, INT, FLOAT, CHAR, BOOL, VOID, STRING, ARRAY, UNKNOWN
+};
+
+struct LegacyIdentifierInfo {
+  std::string name;
+  std::string scope;
+
+  LegacyIdentifierType type;
+
+  bool isInitialized;
+  bool isUsed;
+
+  std::string additionalInfo;
+};
+
+
+int runTidMemoryReport(const std::vector<std::string>& args) {
+  const size_t functions = args.size() > 0 ? std::stoul(args[0]) : 2000;
+  const size_t locals = args.size() > 1 ? std::stoul(args[1]) : 64;
+
+  const std::string source = generateDeclarationHeavySource(functions, locals);
+
+  CompilationContext context(source, BENCH_KEYWORDS_PATH);
+
+  const auto start = std::chrono::steady_clock::now();
+  context.analyze();
+  const auto parsed = std::chrono::steady_clock::now();
+
+  const TID& tid = context.getTID();
+
+  // rebuild the legacy table from the same symbols and measure both by what they allocate
+  size_t before = allocatedBytes();
+  {
+    std::unordered_map<std::string, std::vector<LegacyIdentifierInfo>> legacy;
+    for (uint32_t i = 0; i < tid.identifierCount(); ++i) {
+      const IdentifierHandle info(&tid, i);
+      legacy[info.getName()].push_back({
+        info.getName(), tid.getScope(info.getScope()).name, LegacyIdentifierType::UNKNOWN,
+        info.isInitialized(), info.isUsed(), info.getAdditionalInfo()
+      });
+    }
+    const size_t legacyBytes = allocatedBytes() - before;
+
+    before = allocatedBytes();
+    const TID copy = tid;
+    const size_t pooledBytes = allocatedBytes() - before;
+
+    const auto usage = copy.memoryUsage();
+    const auto symbols = static_cast<double>(tid.identifierCount());
+
+    std::cout << "TID memory report" << std::endl;
+    std::cout << "  source:      " << functions << " functions x " << locals << " locals, "
+              << source.size() << " bytes" << std::endl;
+    std::cout << "  identifiers: " << tid.identifierCount() << ", distinct names: "
+              << tid.getInterner().size() << ", scopes: " << tid.scopeCount() << std::endl;
+    std::cout << "  parse + semantic time: "
+              << std::chrono::duration<double, std::milli>(parsed - start).count() << " ms" << std::endl;
+    std::cout << std::endl;
+    std::cout << "  legacy entries (3 strings per entry):  " << legacyBytes << " bytes ("
+              << static_cast<double>(legacyBytes) / symbols << " bytes/identifier)" << std::endl;
+    std::cout << "  pooled records + scopes + interner:    " << pooledBytes << " bytes ("
+              << static_cast<double>(pooledBytes) / symbols << " bytes/identifier)" << std::endl;
+    std::cout << "    records " << usage.records << ", scope tables " << usage.scopes
+              << ", interner " << usage.interner << ", side table " << usage.sideTable << std::endl;
+    std::cout << "  reduction:   " << static_cast<double>(legacyBytes) / static_cast<double>(pooledBytes)
+              << "x" << std::endl;
+  }
+  return 0;
+}
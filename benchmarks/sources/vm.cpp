@@ -0,0 +1,172 @@
+#include "../headers/benchmarks.h"
+
+#include "../../compiler/headers/compilation-context.h"
+#include "../../virtual-machine/headers/register-vm.h"
+#include "../../virtual-machine/headers/vm.h"
+
+#include <filesystem>
+
+
+std::vector<std::pair<std::string, std::string>> loadBenchmarkPrograms() {
+  std::vector<std::pair<std::string, std::string>> programs;
+  for (const auto& entry : std::filesystem::directory_iterator(BENCH_PROGRAMS_PATH)) {
+    if (entry.path().extension() != ".cppt") {
+      continue;
+    }
+    std::ifstream file(entry.path(), std::ios::binary);
+    programs.emplace_back(entry.path().stem().string(),
+      std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+  }
+  std::sort(programs.begin(), programs.end());
+  return programs;
+}
+
+
+// Runs every program of assets/benchmarks on the stack VM (best of N runs) and reports
+// the dispatched instructions per second
+int runVmReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "stack VM, " << (RPN_VM_COMPUTED_GOTO ? "computed goto" : "switch") << " dispatch, best of "
+            << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(10) << "code B"
+            << std::setw(14) << "instructions" << std::setw(10) << "time ms" << std::setw(12) << "M instr/s"
+            << "  output" << std::endl;
+
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& program = context.generate();
+    const auto [best, instructions, output] = measure<VirtualMachine>(program, repeats);
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << program.code.size()
+              << std::setw(14) << instructions << std::fixed << std::setprecision(1) << std::setw(10) << best
+              << std::setw(12) << static_cast<double>(instructions) / best / 1000.0 << "  " << output << std::endl;
+  }
+  return 0;
+}
+
+
+// Runs every program of assets/benchmarks on both backends (stack and register bytecode)
+// and compares the dispatched instructions and the time; the outputs must be equal
+int runBackendsReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+
+  std::cout << "stack vs register bytecode, best of " << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(14) << "stack instr"
+            << std::setw(14) << "reg instr" << std::setw(8) << "ratio" << std::setw(11) << "stack ms"
+            << std::setw(9) << "reg ms" << std::setw(9) << "speedup" << std::setw(12) << "code B s/r"
+            << std::setw(12) << "slots s/r" << "  output" << std::endl;
+
+  bool equal = true;
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& stackProgram = context.generate();
+    const RegisterProgram& registerProgram = context.generateRegisters();
+    const Measurement stack = measure<VirtualMachine>(stackProgram, repeats);
+    const Measurement registers = measure<RegisterMachine>(registerProgram, repeats);
+
+    // frame size of the whole program: slots (and operand stack) over all functions
+    uint32_t stackSlots = 0;
+    uint32_t registerSlots = 0;
+    for (const auto& function : stackProgram.functions) {
+      stackSlots += function.slots + function.maxStack;
+    }
+    for (const auto& function : registerProgram.functions) {
+      registerSlots += function.slots;
+    }
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(14) << stack.instructions
+              << std::setw(14) << registers.instructions << std::fixed << std::setprecision(2) << std::setw(8)
+              << static_cast<double>(registers.instructions) / static_cast<double>(stack.instructions)
+              << std::setprecision(1) << std::setw(11) << stack.ms << std::setw(9) << registers.ms
+              << std::setprecision(2) << std::setw(9) << stack.ms / registers.ms << std::setw(12)
+              << std::to_string(stackProgram.code.size()) + "/" + std::to_string(registerProgram.code.size())
+              << std::setw(12) << std::to_string(stackSlots) + "/" + std::to_string(registerSlots) << "  "
+              << registers.output << (stack.output == registers.output ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && stack.output == registers.output;
+  }
+  return equal ? 0 : 1;
+}
+
+
+// Splits the arithmetic and comparison dispatches of the stack VM on every program of
+// assets/benchmarks into typed opcodes (no kind checked), quickened ones (guarded) and
+// generic ones
+int runQuickeningReport(const std::vector<std::string>&) {
+  const auto among = [](const OpCode op, const OpCode first, const OpCode last) {
+    return static_cast<uint8_t>(op) >= static_cast<uint8_t>(first) &&
+      static_cast<uint8_t>(op) <= static_cast<uint8_t>(last);
+  };
+
+  std::cout << "arithmetic and comparison dispatches of the stack VM" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(14) << "dispatched"
+            << std::setw(14) << "typed" << std::setw(14) << "quickened" << std::setw(14) << "generic" << std::endl;
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    VirtualMachine vm(context.generate());
+    DispatchProfile profile;
+    std::istringstream in;
+    std::ostringstream out;
+    vm.run(in, out, profile);
+
+    uint64_t typed = 0;
+    uint64_t quickened = 0;
+    uint64_t generic = 0;
+    for (size_t i = 0; i < OPCODE_COUNT; ++i) {
+      const auto op = static_cast<OpCode>(i);
+      if (among(op, OpCode::LOAD_LOCAL_ADD_CONST, OpCode::I64_TO_F64)) {
+        typed += profile.opcodes[i];
+      } else if (among(op, OpCode::QUICK_ADD_INT, OpCode::QUICK_NEQ_FLOAT)) {
+        quickened += profile.opcodes[i];
+      } else if (among(op, OpCode::ADD, OpCode::NEG) || among(op, OpCode::LT, OpCode::NEQ)) {
+        generic += profile.opcodes[i];
+      }
+    }
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(14) << vm.getExecutedInstructions()
+              << std::setw(14) << typed << std::setw(14) << quickened << std::setw(14) << generic << std::endl;
+  }
+  return 0;
+}
+
+
+// Runs every program of assets/benchmarks on the stack VM with and without the JIT and
+// compares the times; the outputs must be equal
+int runJitReport(const std::vector<std::string>& args) {
+  const size_t repeats = args.size() > 0 ? std::stoul(args[0]) : 3;
+  if (!RPN_VM_JIT) {
+    std::cout << "the JIT needs Linux on x86-64" << std::endl;
+    return 0;
+  }
+
+  std::cout << "stack VM, interpreter vs template JIT (threshold " << Jit::HOT_THRESHOLD << "), best of "
+            << repeats << " runs" << std::endl;
+  std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(10) << "interp ms"
+            << std::setw(9) << "jit ms" << std::setw(9) << "speedup" << std::setw(11) << "functions"
+            << std::setw(13) << "bytecode B" << std::setw(11) << "native B" << std::setw(10) << "entries"
+            << std::setw(14) << "dispatched" << "  output" << std::endl;
+
+  bool equal = true;
+  for (const auto& [name, source] : loadBenchmarkPrograms()) {
+    CompilationContext context(source, BENCH_KEYWORDS_PATH);
+    const RPNProgram& program = context.generate();
+    const Measurement interpreted = measure<VirtualMachine>(program, repeats);
+    const Measurement compiled = measure<VirtualMachine>(program, repeats,
+      [](VirtualMachine& vm) { vm.setJit(true); });
+
+    VirtualMachine vm(program);
+    vm.setJit(true);
+    std::istringstream in;
+    std::ostringstream out;
+    vm.run(in, out);
+    const JitStatistics statistics = vm.getJitStatistics();
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << interpreted.ms << std::setw(9) << compiled.ms << std::setprecision(2)
+              << std::setw(9) << interpreted.ms / compiled.ms << std::setw(11) << statistics.compiledFunctions
+              << std::setw(13) << statistics.bytecodeBytes << std::setw(11) << statistics.nativeBytes
+              << std::setw(10) << vm.getNativeEntries() << std::setw(14) << compiled.instructions << "  "
+              << compiled.output << (interpreted.output == compiled.output ? "" : "  OUTPUT DIFFERS") << std::endl;
+    equal = equal && interpreted.output == compiled.output;
+  }
+  return equal ? 0 : 1;
+}
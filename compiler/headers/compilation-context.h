@@ -0,0 +1,137 @@
+#ifndef COMPILATION_CONTEXT_H
+#define COMPILATION_CONTEXT_H
+
+
+#include "../../includes/libraries.h"
+#include "cpp-emitter.h"
+#include "../../ir/headers/ssa-builder.h"
+#include "../../ir/headers/ssa-inliner.h"
+#include "../../ir/headers/ssa-loop-optimizer.h"
+#include "../../ir/headers/ssa-lowering.h"
+#include "../../ir/headers/ssa-optimizer.h"
+#include "../../lexical-analyzer/headers/lexer.h"
+#include "../../optimizer/headers/ast-optimizer.h"
+#include "../../optimizer/headers/common-subexpressions.h"
+#include "../../optimizer/headers/escape-analysis.h"
+#include "../../optimizer/headers/peephole.h"
+#include "../../optimizer/headers/range-analysis.h"
+#include "../../syntax-analyzer/headers/parser.h"
+#include "../../semantic-analyzer/headers/semantic.h"
+#include "../../semantic-analyzer/headers/register-generator.h"
+#include "../../semantic-analyzer/headers/rpn.h"
+
+
+// Everything one compilation owns: the source and its tokens, the AST, the interner,
+// type table and identifier tables, the diagnostics and the bytecode. Nothing is shared between
+// contexts (the compiler has no global state), so any number of them can be compiled
+// at once on different threads; a single context is not meant to be shared by threads.
+class CompilationContext {
+public:
+  CompilationContext(std::string source, const std::string& keywordsPath) :
+  lexer_(std::move(source), keywordsPath) {
+    semantic_.setVerbose(false);
+  }
+
+  CompilationContext(const CompilationContext&) = delete;
+  CompilationContext& operator=(const CompilationContext&) = delete;
+
+  // The phases; each runs the previous ones first if needed, errors are thrown
+  const std::vector<Token>& tokenize();
+  const ASTNodePtr& parse();
+  void analyze();
+  void optimize(); // does nothing when the optimization is off
+  const RPNProgram& generate();
+  const RegisterProgram& generateRegisters(); // the register backend, independent of generate()
+  const SSAProgram& buildSSA(); // the SSA form of the optimized AST, inlined and loop-optimized when optimizing
+  const std::string& generateCpp(); // the ahead-of-time backend: a C++20 translation unit
+
+  // ASTOptimizer, then RangeAnalysis (the subscripts every backend may leave unchecked)
+  // and CommonSubexpressions, between the analysis and the code generation, and the
+  // lowering of switches to jump tables, trees and hashes (on by default); must be set
+  // before the first optimize() or generate()
+  void setOptimization(const bool optimization) { optimization_ = optimization; }
+  [[nodiscard]] bool isOptimizing() const { return optimization_; }
+
+  // CommonSubexpressions for the stack and register backends when optimizing (on by
+  // default); must be set before the first optimize() or generate()
+  void setCommonSubexpressions(const bool sharing) { commonSubexpressions_ = sharing; }
+  [[nodiscard]] bool isCommonSubexpressions() const { return commonSubexpressions_; }
+
+  // EscapeAnalysis when optimizing, so the bytecode backends make what never outlives
+  // its call in the call's region instead of the heap (on by default); must be set
+  // before the first optimize() or generate()
+  void setRegions(const bool regions) { regions_ = regions; }
+  [[nodiscard]] bool isRegions() const { return regions_; }
+
+  // generate() and generateRegisters() lower the SSA form of buildSSA() instead of
+  // compiling the AST directly (off by default); must be set before the first generate()
+  void setSSA(const bool ssa) { ssa_ = ssa; }
+  [[nodiscard]] bool isSSA() const { return ssa_; }
+
+  // PeepholeOptimizer on the stack bytecode generate() returns (on by default); must be
+  // set before the first generate()
+  void setPeephole(const bool peephole) { peephole_ = peephole; }
+  [[nodiscard]] bool isPeephole() const { return peephole_; }
+
+  // Debug output of the parser and the semantic analyzer (off by default)
+  void setVerbose(bool verbose);
+  [[nodiscard]] bool isVerbose() const { return verbose_; }
+
+  // Threads for the parallel semantic phase (see SemanticAnalyzer::setThreads); use 1
+  // when the contexts themselves are compiled in parallel
+  void setThreads(const size_t threads) { semantic_.setThreads(threads); }
+
+  [[nodiscard]] const std::string& getSource() const { return lexer_.getSource(); }
+  [[nodiscard]] const ASTNodePtr& getProgram() const { return program_; }
+  [[nodiscard]] SemanticAnalyzer& getSemanticAnalyzer() { return semantic_; }
+  [[nodiscard]] const SemanticAnalyzer& getSemanticAnalyzer() const { return semantic_; }
+  [[nodiscard]] const TID& getTID() const { return semantic_.getTID(); }
+  [[nodiscard]] const TypeTable& getTypes() const { return semantic_.getTypes(); }
+  [[nodiscard]] const std::vector<Diagnostic>& getDiagnostics() const { return semantic_.getDiagnostics(); }
+  [[nodiscard]] const OptimizationStatistics& getOptimizationStatistics() const { return optimizationStatistics_; }
+  [[nodiscard]] const RangeStatistics& getRangeStatistics() const { return rangeStatistics_; }
+  [[nodiscard]] const SubexpressionStatistics& getSubexpressionStatistics() const { return subexpressionStatistics_; }
+  [[nodiscard]] const EscapeStatistics& getEscapeStatistics() const { return escapeStatistics_; }
+  [[nodiscard]] const InliningStatistics& getInliningStatistics() const { return inliningStatistics_; }
+  [[nodiscard]] const SSAOptimizationStatistics& getSSAOptimizationStatistics() const { return ssaStatistics_; }
+  [[nodiscard]] const LoopStatistics& getLoopStatistics() const { return loopStatistics_; }
+  [[nodiscard]] const PeepholeStatistics& getPeepholeStatistics() const { return peepholeStatistics_; }
+  [[nodiscard]] const RPNProgram& getBytecode() const { return bytecode_; }
+  [[nodiscard]] const RegisterProgram& getRegisterBytecode() const { return registerBytecode_; }
+  [[nodiscard]] const std::string& getCpp() const { return cpp_; }
+
+private:
+  LexicalAnalyzer lexer_;
+  SemanticAnalyzer semantic_;
+  ASTNodePtr program_;
+  bool verbose_ = false;
+  bool analyzed_ = false;
+  bool optimization_ = true;
+  bool optimized_ = false;
+  OptimizationStatistics optimizationStatistics_;
+  std::unordered_set<const ASTNode*> inBounds_;
+  RangeStatistics rangeStatistics_;
+  bool commonSubexpressions_ = true;
+  SharedExpressions shared_;
+  SubexpressionStatistics subexpressionStatistics_;
+  bool regions_ = true;
+  LocalAllocations locals_;
+  EscapeStatistics escapeStatistics_;
+  bool ssa_ = false;
+  SSAProgram ssaProgram_;
+  bool ssaBuilt_ = false;
+  InliningStatistics inliningStatistics_;
+  SSAOptimizationStatistics ssaStatistics_;
+  LoopStatistics loopStatistics_;
+  bool peephole_ = true;
+  PeepholeStatistics peepholeStatistics_;
+  RPNProgram bytecode_;
+  bool generated_ = false;
+  RegisterProgram registerBytecode_;
+  bool registersGenerated_ = false;
+  std::string cpp_;
+  bool cppGenerated_ = false;
+};
+
+
+#endif //COMPILATION_CONTEXT_H
@@ -0,0 +1,102 @@
+#ifndef CPP_EMITTER_H
+#define CPP_EMITTER_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/tid.h"
+#include "../../semantic-analyzer/headers/types.h"
+
+#include <functional>
+#include <sstream>
+
+
+// The runtime every emitted translation unit starts with (cpp-runtime.cpp)
+extern const char* const CPP_RUNTIME;
+
+
+// Ahead-of-time backend: translates an analysed AST into one standalone C++20
+// translation unit (CPP_RUNTIME, then the program). Every Cppt type is a C++ type, int
+// -> int64_t, float -> double, string -> std::string, array< T > -> rt::Array< T >
+// (contiguous, shared by copies); cin and cout go through the buffered rt::in and
+// rt::out. Every operation that can fail at run time carries its source line, so errors
+// read as the VM's. C++ leaves the order of operands unspecified where Cppt evaluates
+// left to right: operands whose order can be observed (calls, checked operations, reads
+// of state a call may change) are evaluated into temporaries first.
+class CppEmitter {
+public:
+  CppEmitter(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  std::string emit(const ASTNodePtr& program);
+
+  // INDEX nodes that index data() directly instead of at() (RangeAnalysis); none by default
+  void setInBounds(const std::unordered_set<const ASTNode*>* inBounds) { inBounds_ = inBounds; }
+
+private:
+  const TID& tid_;
+  const TypeTable& types_;
+  const std::unordered_set<const ASTNode*>* inBounds_ = nullptr;
+  std::ostringstream out_;
+  size_t indent_ = 0;
+
+  // state of the function being emitted
+  TypeId returnType_ = TypeTable::VOID;
+  std::unordered_set<uint32_t> locals_; // bindings of the function's parameters and locals
+  uint32_t line_ = 0; // the line the VM would report, follows RPNGenerator's
+  size_t labels_ = 0;
+  size_t temporaries_ = 0;
+
+  // innermost enclosing loop or switch: `break` and `continue` become C++ break/continue
+  // or gotos to these labels
+  struct Target {
+    bool loop;
+    std::string breakLabel; // empty: C++ break
+    std::string continueLabel; // empty: C++ continue
+    bool breakUsed = false;
+    bool continueUsed = false;
+  };
+  std::vector<Target> targets_;
+
+  void function(const ASTNodePtr& node);
+  void entry(const ASTNodePtr& program, const ASTNodePtr& main);
+
+  void statement(const ASTNodePtr& node);
+  // The statements of a block (or a single statement) inside braces already written
+  void body(const ASTNodePtr& node);
+  void declaration(const ASTNodePtr& node);
+  void assignment(const ASTNodePtr& node);
+  void loop(const ASTNodePtr& node);
+  void switchStatement(const ASTNodePtr& node);
+  void jump(bool isBreak);
+
+  // C++ expression of the node's type
+  std::string expression(const ASTNodePtr& node);
+  std::string operatorExpression(const ASTNodePtr& node);
+  std::string literal(const ASTNodePtr& node) const;
+  std::string call(const ASTNodePtr& node);
+  std::string comparison(my::TokenType op, const std::string& lhs, TypeId left, const std::string& rhs,
+    TypeId right) const;
+
+  // `combine` applied to the operands, each evaluated before the next
+  std::string sequence(const std::vector<const ASTNode*>& nodes, const std::vector<std::string>& operands,
+    const std::function<std::string(const std::vector<std::string>&)>& combine);
+
+  // C++ expression converting `value` of type `source` to `target`
+  std::string convert(const std::string& value, TypeId target, TypeId source) const;
+
+  [[nodiscard]] bool isLocal(uint32_t binding) const { return locals_.contains(binding); }
+  [[nodiscard]] bool isInBounds(const ASTNode* node) const { return inBounds_ && inBounds_->contains(node); }
+  [[nodiscard]] std::string variable(uint32_t binding, const std::string& name) const;
+  [[nodiscard]] static std::string functionName(uint32_t binding, const std::string& name);
+  [[nodiscard]] std::string cppType(TypeId type) const;
+  [[nodiscard]] std::string lineText() const { return std::to_string(line_); }
+  void write(const std::string& text);
+};
+
+
+// Writes `source` next to `executable` and compiles it with the local C++ compiler ($CXX
+// or c++, -std=c++20 -O2); throws with the compiler's status when it fails
+void compileNative(const std::string& source, const std::string& executable);
+
+
+#endif //CPP_EMITTER_H
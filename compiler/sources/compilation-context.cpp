@@ -0,0 +1,130 @@
+#include "../headers/compilation-context.h"
+
+
+const std::vector<Token>& CompilationContext::tokenize() {
+  return lexer_.getTokens();
+}
+
+const ASTNodePtr& CompilationContext::parse() {
+  if (!program_) {
+    tokenize();
+    Parser parser(lexer_, semantic_, verbose_);
+    program_ = parser.program();
+  }
+  return program_;
+}
+
+void CompilationContext::analyze() {
+  if (!analyzed_) {
+    analyzed_ = true; // a failed analysis is not retried on the half-updated tables
+    semantic_.analyze(parse());
+  }
+}
+
+void CompilationContext::optimize() {
+  if (!optimized_) {
+    analyze();
+    optimized_ = true;
+    if (optimization_) {
+      ASTOptimizer optimizer(semantic_.getTID(), semantic_.getTypes());
+      optimizer.optimize(program_);
+      optimizationStatistics_ = optimizer.getStatistics();
+      RangeAnalysis ranges(semantic_.getTID(), semantic_.getTypes());
+      inBounds_ = ranges.analyze(program_);
+      rangeStatistics_ = ranges.getStatistics();
+      if (commonSubexpressions_) {
+        CommonSubexpressions subexpressions(semantic_.getTID());
+        shared_ = subexpressions.analyze(program_);
+        subexpressionStatistics_ = subexpressions.getStatistics();
+      }
+      if (regions_) {
+        EscapeAnalysis escapes(semantic_.getTID(), semantic_.getTypes());
+        locals_ = escapes.analyze(program_);
+        escapeStatistics_ = escapes.getStatistics();
+      }
+    }
+  }
+}
+
+const RPNProgram& CompilationContext::generate() {
+  if (!generated_) {
+    if (ssa_) {
+      SSALowering lowering(semantic_.getTypes());
+      bytecode_ = lowering.lowerStack(buildSSA());
+    } else {
+      optimize();
+      RPNGenerator generator(semantic_.getTID(), semantic_.getTypes());
+      generator.setInBounds(&inBounds_);
+      generator.setSharedExpressions(&shared_);
+      generator.setLocalAllocations(&locals_);
+      generator.setSwitchLowering(optimization_);
+      bytecode_ = generator.generate(program_);
+    }
+    if (peephole_) {
+      PeepholeOptimizer peephole;
+      peephole.optimize(bytecode_);
+      peepholeStatistics_ = peephole.getStatistics();
+    }
+    generated_ = true;
+  }
+  return bytecode_;
+}
+
+const RegisterProgram& CompilationContext::generateRegisters() {
+  if (!registersGenerated_) {
+    if (ssa_) {
+      SSALowering lowering(semantic_.getTypes());
+      registerBytecode_ = lowering.lowerRegisters(buildSSA());
+    } else {
+      optimize();
+      RegisterGenerator generator(semantic_.getTID(), semantic_.getTypes());
+      generator.setSharedExpressions(&shared_);
+      generator.setLocalAllocations(&locals_);
+      generator.setSwitchLowering(optimization_);
+      registerBytecode_ = generator.generate(program_);
+    }
+    registersGenerated_ = true;
+  }
+  return registerBytecode_;
+}
+
+const SSAProgram& CompilationContext::buildSSA() {
+  if (!ssaBuilt_) {
+    optimize();
+    SSABuilder builder(semantic_.getTID(), semantic_.getTypes());
+    builder.setInBounds(&inBounds_);
+    builder.setLocalAllocations(&locals_);
+    ssaProgram_ = builder.build(program_);
+    if (optimization_) {
+      SSAInliner inliner;
+      inliner.run(ssaProgram_);
+      inliningStatistics_ = inliner.getStatistics();
+      SSAOptimizer optimizer;
+      optimizer.run(ssaProgram_);
+      SSALoopOptimizer loops;
+      loops.run(ssaProgram_);
+      loopStatistics_ = loops.getStatistics();
+      optimizer.run(ssaProgram_);
+      ssaStatistics_ = optimizer.getStatistics();
+    }
+    verify(ssaProgram_);
+    ssaBuilt_ = true;
+  }
+  return ssaProgram_;
+}
+
+const std::string& CompilationContext::generateCpp() {
+  if (!cppGenerated_) {
+    optimize();
+    CppEmitter emitter(semantic_.getTID(), semantic_.getTypes());
+    emitter.setInBounds(&inBounds_);
+    cpp_ = emitter.emit(program_);
+    cppGenerated_ = true;
+  }
+  return cpp_;
+}
+
+void CompilationContext::setVerbose(const bool verbose) {
+  verbose_ = verbose;
+  semantic_.setVerbose(verbose);
+}
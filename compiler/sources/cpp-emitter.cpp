@@ -0,0 +1,729 @@
+#include "../headers/cpp-emitter.h"
+
+#include "../../global_functions/global_funcs.h"
+
+#include <cmath>
+#include <filesystem>
+
+
+// Contains a call: anything may happen during it (output, input, globals change)
+static bool containsCall(const ASTNode* node) {
+  if (!node) {
+    return false;
+  }
+  if (node->getType() == ASTNodeType::CALL) {
+    return true;
+  }
+  return std::any_of(node->getChildren().begin(), node->getChildren().end(),
+    [](const ASTNodePtr& child) { return containsCall(child.get()); });
+}
+
+// Can stop the program with an error, or contains a call
+static bool hasEffect(const ASTNode* node) {
+  if (!node) {
+    return false;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::CALL:
+    case ASTNodeType::INDEX:
+      return true;
+    case ASTNodeType::EXPRESSION:
+      if (node->getTokenType() == my::TokenType::DIV && node->getTypeId() == TypeTable::INT) {
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  return std::any_of(node->getChildren().begin(), node->getChildren().end(),
+    [](const ASTNodePtr& child) { return hasEffect(child.get()); });
+}
+
+
+std::string CppEmitter::emit(const ASTNodePtr& program) {
+  out_.str("");
+  indent_ = 0;
+
+  std::vector<ASTNodePtr> functions;
+  ASTNodePtr main;
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      functions.push_back(declaration);
+      if (declaration->getValue() == "main" && declaration->getChildren().size() == 1) {
+        main = declaration;
+      }
+    }
+  }
+
+  out_ << CPP_RUNTIME << "\n// Compiled from Cppt\n\n";
+
+  // globals hold their zero values even for functions that run before the declaration
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::VARIABLE_DECLARATION) {
+      write(cppType(declaration->getTypeId()) + " " + variable(declaration->getBinding(), declaration->getValue()) +
+        "{};");
+    }
+  }
+  out_ << "\n";
+
+  // every function's prototype first, calls can precede definitions
+  for (const auto& node : functions) {
+    const auto& children = node->getChildren();
+    std::string signature = cppType(types_.get(node->getTypeId()).element) + " " +
+      functionName(node->getBinding(), node->getValue()) + "(int line";
+    for (size_t i = 0; i + 1 < children.size(); ++i) {
+      signature += ", " + cppType(children[i]->getTypeId()) + " " +
+        variable(children[i]->getBinding(), children[i]->getValue());
+    }
+    write(signature + ");");
+  }
+  out_ << "\n";
+
+  for (const auto& node : functions) {
+    function(node);
+    out_ << "\n";
+  }
+  entry(program, main);
+  return out_.str();
+}
+
+void CppEmitter::function(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  returnType_ = types_.get(node->getTypeId()).element;
+  locals_.clear();
+  labels_ = 0;
+  temporaries_ = 0;
+  line_ = node->getLine();
+
+  std::string signature = cppType(returnType_) + " " + functionName(node->getBinding(), node->getValue()) +
+    "(const int line";
+  for (size_t i = 0; i + 1 < children.size(); ++i) {
+    locals_.insert(children[i]->getBinding());
+    signature += ", " + cppType(children[i]->getTypeId()) + " " +
+      variable(children[i]->getBinding(), children[i]->getValue());
+  }
+  write(signature + ") {");
+  ++indent_;
+  write("const rt::Call call(line, \"" + node->getValue() + "\");");
+  statement(children.back());
+
+  // falling off the end
+  if (returnType_ != TypeTable::VOID) {
+    write("rt::fail(" + lineText() + ", \"function '" + node->getValue() + "' ended without returning a value\");");
+  }
+  --indent_;
+  write("}");
+}
+
+void CppEmitter::entry(const ASTNodePtr& program, const ASTNodePtr& main) {
+  returnType_ = TypeTable::VOID;
+  locals_.clear();
+  labels_ = 0;
+  temporaries_ = 0;
+
+  write("static void run() {");
+  ++indent_;
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration);
+    }
+  }
+  if (main) {
+    line_ = main->getLine();
+    const std::string call = functionName(main->getBinding(), main->getValue()) + "(" + lineText() + ")";
+    write(types_.get(main->getTypeId()).element == TypeTable::VOID ? call + ";" : "static_cast<void>(" + call + ");");
+  }
+  --indent_;
+  write("}");
+  out_ << "\n";
+  write("int main() {");
+  write("  return rt::start(run);");
+  write("}");
+}
+
+
+void CppEmitter::statement(const ASTNodePtr& node) {
+  line_ = node->getLine();
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK:
+      write("{");
+      ++indent_;
+      body(node);
+      --indent_;
+      write("}");
+      break;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      declaration(node);
+      break;
+    case ASTNodeType::ASSIGNMENT:
+      assignment(node);
+      break;
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      write("if (" + convert(expression(children[0]), TypeTable::BOOL, children[0]->getTypeId()) + ") {");
+      ++indent_;
+      body(children[1]);
+      --indent_;
+      if (children.size() > 2) {
+        write("} else {");
+        ++indent_;
+        body(children[2]);
+        --indent_;
+      }
+      write("}");
+      break;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      loop(node);
+      break;
+    case ASTNodeType::SWITCH:
+      switchStatement(node);
+      break;
+    case ASTNodeType::RETURN_STATEMENT:
+      if (node->getChildren().empty()) {
+        write("return;");
+      } else {
+        const ASTNodePtr& value = node->getChild(0);
+        write("return " + convert(expression(value), returnType_, value->getTypeId()) + ";");
+      }
+      break;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        std::string read;
+        switch (types_.kind(target->getTypeId())) {
+          case TypeKind::INT:
+            read = "readInt";
+            break;
+          case TypeKind::FLOAT:
+            read = "readFloat";
+            break;
+          case TypeKind::CHAR:
+            read = "readChar";
+            break;
+          case TypeKind::BOOL:
+            read = "readBool";
+            break;
+          case TypeKind::STRING:
+            read = "readString";
+            break;
+          default:
+            throw std::runtime_error("Code generation error: cannot read a value of type '" +
+              types_.toString(target->getTypeId()) + "'.");
+        }
+        write(variable(target->getBinding(), target->getValue()) + " = rt::in." + read + "(" + lineText() + ");");
+      }
+      break;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : node->getChildren()) {
+        write("rt::out.print(" + expression(value) + ");");
+      }
+      break;
+    case ASTNodeType::BREAK:
+      jump(true);
+      break;
+    case ASTNodeType::CONTINUE:
+      jump(false);
+      break;
+    default: { // expression statement, its value is dropped
+      const std::string value = expression(node);
+      write(node->getTypeId() == TypeTable::VOID ? value + ";" : "static_cast<void>(" + value + ");");
+      break;
+    }
+  }
+}
+
+void CppEmitter::body(const ASTNodePtr& node) {
+  if (node->getType() != ASTNodeType::BLOCK) {
+    statement(node);
+    return;
+  }
+  line_ = node->getLine();
+  for (const auto& instruction : node->getChildren()) {
+    statement(instruction);
+  }
+}
+
+void CppEmitter::declaration(const ASTNodePtr& node) {
+  const TypeId type = node->getTypeId();
+  const auto& children = node->getChildren();
+
+  std::string value;
+  if (children[0]) {
+    value = convert(expression(children[0]), type, children[0]->getTypeId());
+  } else if (children.size() > 1) { // sized array, the sizes in order
+    value = cppType(type) + "::make({";
+    for (size_t i = 1; i < children.size(); ++i) {
+      value += (i > 1 ? ", " : "") + convert(expression(children[i]), TypeTable::INT, children[i]->getTypeId());
+    }
+    value += "}, " + lineText() + ")";
+  } else {
+    value = cppType(type) + "{}";
+  }
+
+  const std::string name = variable(node->getBinding(), node->getValue());
+  if (tid_.getRecord(node->getBinding()).scope == GLOBAL_SCOPE) {
+    write(name + " = " + value + ";");
+  } else {
+    write(cppType(type) + " " + name + " = " + value + ";");
+    locals_.insert(node->getBinding()); // the initializer cannot see the variable
+  }
+}
+
+void CppEmitter::assignment(const ASTNodePtr& node) {
+  const ASTNodePtr& target = node->getChild(0);
+  const ASTNodePtr& value = node->getChild(1);
+
+  if (target->getType() == ASTNodeType::IDENTIFIER) {
+    write(variable(target->getBinding(), target->getValue()) + " = " +
+      convert(expression(value), target->getTypeId(), value->getTypeId()) + ";");
+    return;
+  }
+
+  // element store: the array and index first, then the value, checked last
+  const ASTNodePtr& array = target->getChild(0);
+  const ASTNodePtr& index = target->getChild(1);
+  const std::string line = lineText();
+  const bool inBounds = isInBounds(target.get());
+  write(sequence({array.get(), index.get(), value.get()}, {expression(array),
+      convert(expression(index), TypeTable::INT, index->getTypeId()),
+      convert(expression(value), target->getTypeId(), value->getTypeId())},
+    [&](const std::vector<std::string>& operands) {
+      if (inBounds) {
+        return operands[0] + ".data()[" + operands[1] + "] = " + operands[2];
+      }
+      return operands[0] + ".set(" + operands[1] + ", " + operands[2] + ", " + line + ")";
+    }) + ";");
+}
+
+void CppEmitter::loop(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+
+  if (node->getTokenType() == my::TokenType::WHILE) {
+    write("while (" + convert(expression(children[0]), TypeTable::BOOL, children[0]->getTypeId()) + ") {");
+    ++indent_;
+    targets_.push_back({true, "", ""});
+    body(children[1]);
+    targets_.pop_back();
+    --indent_;
+    write("}");
+    return;
+  }
+
+  // for: `continue` runs the step, a goto to the label before it; the body has its own
+  // braces so that the goto does not cross its declarations
+  const std::string next = "next_" + std::to_string(labels_++);
+  write("{");
+  ++indent_;
+  statement(children[0]);
+  line_ = node->getLine();
+  write("while (" + convert(expression(children[1]), TypeTable::BOOL, children[1]->getTypeId()) + ") {");
+  ++indent_;
+  write("{");
+  ++indent_;
+  targets_.push_back({true, "", next});
+  body(children[3]);
+  const bool continued = targets_.back().continueUsed;
+  targets_.pop_back();
+  --indent_;
+  write("}");
+  if (continued) {
+    write(next + ":;");
+  }
+  statement(children[2]);
+  --indent_;
+  write("}");
+  --indent_;
+  write("}");
+}
+
+void CppEmitter::switchStatement(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const size_t number = labels_++;
+  const std::string end = "end_" + std::to_string(number);
+  const auto arm = [&](const size_t i) { return "case_" + std::to_string(number) + "_" + std::to_string(i); };
+
+  // the subject is evaluated once; an int or char one is dispatched by a C++ switch (the
+  // C++ compiler picks the jump table or the comparison tree), a string one is compared
+  // with each label
+  const TypeId type = children[0]->getTypeId();
+  const std::string subject = "s" + std::to_string(temporaries_++);
+  write("{");
+  ++indent_;
+  write("const " + cppType(type) + " " + subject + " = " + expression(children[0]) + ";");
+
+  std::string fallback = end;
+  bool literals = true;
+  for (size_t i = 1; i < children.size(); ++i) {
+    if (children[i]->getTokenType() != my::TokenType::CASE) {
+      fallback = arm(i);
+    } else {
+      literals = literals && children[i]->getChild(0)->getType() == ASTNodeType::LITERAL;
+    }
+  }
+  if (types_.kind(type) != TypeKind::STRING && literals) {
+    write("switch (int64_t(" + subject + ")) {"); // a char by its (signed) code
+    std::unordered_set<int64_t> values; // 7 and 007 go to the first arm
+    for (size_t i = 1; i < children.size(); ++i) {
+      const ASTNodePtr& label = children[i];
+      if (label->getTokenType() != my::TokenType::CASE) {
+        continue;
+      }
+      const ASTNodePtr& value = label->getChild(0);
+      const int64_t key = value->getTokenType() == my::TokenType::CHAR_LITERAL ?
+        decodeCharLiteral(value->getValue()) : decodeIntegerLiteral(value->getValue());
+      if (values.insert(key).second) {
+        line_ = label->getLine();
+        write("  case int64_t(" + std::to_string(key) + "): goto " + arm(i) + ";");
+      }
+    }
+    write("  default: goto " + fallback + ";");
+    write("}");
+  } else {
+    for (size_t i = 1; i < children.size(); ++i) {
+      const ASTNodePtr& label = children[i];
+      if (label->getTokenType() != my::TokenType::CASE) {
+        continue;
+      }
+      line_ = label->getLine();
+      write("if " + comparison(my::TokenType::EQ, subject, type, expression(label->getChild(0)),
+        label->getChild(0)->getTypeId()) + " goto " + arm(i) + ";");
+    }
+    write("goto " + fallback + ";");
+  }
+
+  // the arms in source order, each one ends with the `break` the parser consumed
+  targets_.push_back({false, end, ""});
+  for (size_t i = 1; i < children.size(); ++i) {
+    const auto& instructions = children[i]->getChildren();
+    write(arm(i) + ": {");
+    ++indent_;
+    line_ = children[i]->getLine();
+    const size_t first = children[i]->getTokenType() == my::TokenType::CASE ? 1 : 0;
+    for (size_t j = first; j < instructions.size(); ++j) {
+      statement(instructions[j]);
+    }
+    if (i + 1 < children.size()) {
+      write("goto " + end + ";");
+    }
+    --indent_;
+    write("}");
+  }
+  targets_.pop_back();
+  write(end + ":;");
+  --indent_;
+  write("}");
+}
+
+void CppEmitter::jump(const bool isBreak) {
+  auto target = targets_.rbegin();
+  if (!isBreak) { // switches are not continued
+    while (!target->loop) {
+      ++target;
+    }
+  }
+  const std::string& label = isBreak ? target->breakLabel : target->continueLabel;
+  if (label.empty()) {
+    write(isBreak ? "break;" : "continue;");
+  } else {
+    (isBreak ? target->breakUsed : target->continueUsed) = true;
+    write("goto " + label + ";");
+  }
+}
+
+
+std::string CppEmitter::expression(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL:
+      return literal(node);
+    case ASTNodeType::IDENTIFIER:
+      return variable(node->getBinding(), node->getValue());
+    case ASTNodeType::INDEX: { // the array is evaluated before the arguments of at()
+      const ASTNodePtr& index = node->getChild(1);
+      const std::string array = expression(node->getChild(0));
+      const std::string position = convert(expression(index), TypeTable::INT, index->getTypeId());
+      if (isInBounds(node.get())) { // proven: nothing to check
+        return array + ".data()[" + position + "]";
+      }
+      return array + ".at(" + position + ", " + lineText() + ")";
+    }
+    case ASTNodeType::CALL:
+      return call(node);
+    case ASTNodeType::EXPRESSION:
+      return operatorExpression(node);
+    default:
+      throw std::runtime_error("Code generation error: instruction used as an expression.");
+  }
+}
+
+std::string CppEmitter::operatorExpression(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const my::TokenType op = node->getTokenType();
+
+  if (children.size() == 1) {
+    const TypeId type = children[0]->getTypeId();
+    const std::string operand = expression(children[0]);
+    if (op == my::TokenType::NOT) {
+      return "!" + convert(operand, TypeTable::BOOL, type);
+    }
+    return type == TypeTable::FLOAT ? "(-" + operand + ")" : "rt::neg(" + convert(operand, TypeTable::INT, type) + ")";
+  }
+
+  const TypeId left = children[0]->getTypeId();
+  const TypeId right = children[1]->getTypeId();
+  switch (op) {
+    case my::TokenType::COMMA:
+      return "(static_cast<void>(" + expression(children[0]) + "), " + expression(children[1]) + ")";
+    case my::TokenType::AND:
+    case my::TokenType::OR: // C++'s && and || short-circuit the same way
+      return "(" + convert(expression(children[0]), TypeTable::BOOL, left) +
+        (op == my::TokenType::AND ? " && " : " || ") + convert(expression(children[1]), TypeTable::BOOL, right) + ")";
+    case my::TokenType::LT:
+    case my::TokenType::GT:
+    case my::TokenType::EQ:
+    case my::TokenType::NEQ:
+      return sequence({children[0].get(), children[1].get()}, {expression(children[0]), expression(children[1])},
+        [&](const std::vector<std::string>& operands) {
+          return comparison(op, operands[0], left, operands[1], right);
+        });
+    default:
+      break;
+  }
+
+  // strings concatenate, floats are computed if either side is one, integers wrap
+  const TypeId result = node->getTypeId();
+  const std::string line = lineText();
+  std::vector<std::string> operands = {expression(children[0]), expression(children[1])};
+  if (result != TypeTable::STRING) {
+    operands[0] = convert(operands[0], result, left);
+    operands[1] = convert(operands[1], result, right);
+  }
+  return sequence({children[0].get(), children[1].get()}, operands, [&](const std::vector<std::string>& values) {
+    const std::string& a = values[0];
+    const std::string& b = values[1];
+    if (result != TypeTable::INT) {
+      switch (op) {
+        case my::TokenType::PLUS:
+          return "(" + a + " + " + b + ")";
+        case my::TokenType::MINUS:
+          return "(" + a + " - " + b + ")";
+        case my::TokenType::MUL:
+          return "(" + a + " * " + b + ")";
+        case my::TokenType::DIV:
+          return "(" + a + " / " + b + ")";
+        default:
+          break;
+      }
+    } else {
+      switch (op) {
+        case my::TokenType::PLUS:
+          return "rt::add(" + a + ", " + b + ")";
+        case my::TokenType::MINUS:
+          return "rt::sub(" + a + ", " + b + ")";
+        case my::TokenType::MUL:
+          return "rt::mul(" + a + ", " + b + ")";
+        case my::TokenType::DIV:
+          return "rt::div(" + a + ", " + b + ", " + line + ")";
+        default:
+          break;
+      }
+    }
+    throw std::runtime_error("Code generation error: unknown operator " + node->getValue() + ".");
+  });
+}
+
+std::string CppEmitter::comparison(const my::TokenType op, const std::string& lhs, const TypeId left,
+  const std::string& rhs, const TypeId right) const {
+  // strings compare as strings, numbers as floats if either side is one, else as integers
+  const TypeId domain = left == TypeTable::STRING ? TypeTable::STRING :
+    left == TypeTable::FLOAT || right == TypeTable::FLOAT ? TypeTable::FLOAT : TypeTable::INT;
+  const std::string a = domain == TypeTable::STRING ? lhs : convert(lhs, domain, left);
+  const std::string b = domain == TypeTable::STRING ? rhs : convert(rhs, domain, right);
+  switch (op) {
+    case my::TokenType::LT:
+      return "(" + a + " < " + b + ")";
+    case my::TokenType::GT:
+      return "(" + a + " > " + b + ")";
+    case my::TokenType::EQ:
+      return "(" + a + " == " + b + ")";
+    default:
+      return "(" + a + " != " + b + ")";
+  }
+}
+
+std::string CppEmitter::literal(const ASTNodePtr& node) const {
+  const std::string lexeme = node->getValue();
+  switch (node->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL: {
+      const int64_t value = decodeIntegerLiteral(lexeme);
+      return value == INT64_MIN ? "INT64_MIN" : "int64_t(" + std::to_string(value) + ")";
+    }
+    case my::TokenType::FLOAT_LITERAL: {
+      const double value = decodeFloatLiteral(lexeme);
+      if (!std::isfinite(value)) { // folded constants: by bit pattern
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return "std::bit_cast<double>(uint64_t(" + std::to_string(bits) + "u))";
+      }
+      char text[32];
+      std::snprintf(text, sizeof(text), "%.17g", value);
+      std::string result = text;
+      if (result.find_first_of(".e") == std::string::npos) {
+        result += ".0";
+      }
+      return result;
+    }
+    case my::TokenType::CHAR_LITERAL: {
+      const char value = decodeCharLiteral(lexeme);
+      if (value >= ' ' && value <= '~' && value != '\'' && value != '\\') {
+        return std::string("'") + value + "'";
+      }
+      return "char(" + std::to_string(static_cast<int>(value)) + ")";
+    }
+    case my::TokenType::STRING_LITERAL: {
+      std::string result = "std::string(\"";
+      for (const char c : decodeStringLiteral(lexeme)) {
+        if (c == '"' || c == '\\' || c == '?') {
+          result += '\\';
+          result += c;
+        } else if (c >= ' ' && c <= '~') {
+          result += c;
+        } else { // three octal digits, never taken for more
+          char escape[8];
+          std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+          result += escape;
+        }
+      }
+      return result + "\")";
+    }
+    default: // true / false
+      return lexeme == "true" ? "true" : "false";
+  }
+}
+
+std::string CppEmitter::call(const ASTNodePtr& node) {
+  const TypeInfo& signature = types_.get(tid_.getRecord(node->getBinding()).type);
+  const auto& arguments = node->getChildren();
+  std::vector<const ASTNode*> nodes;
+  std::vector<std::string> values;
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    nodes.push_back(arguments[i].get());
+    values.push_back(convert(expression(arguments[i]), signature.parameters[i], arguments[i]->getTypeId()));
+  }
+  const std::string callee = functionName(node->getBinding(), node->getValue()) + "(" + lineText();
+  return sequence(nodes, values, [&](const std::vector<std::string>& operands) {
+    std::string result = callee;
+    for (const auto& operand : operands) {
+      result += ", " + operand;
+    }
+    return result + ")";
+  });
+}
+
+
+std::string CppEmitter::sequence(const std::vector<const ASTNode*>& nodes, const std::vector<std::string>& operands,
+  const std::function<std::string(const std::vector<std::string>&)>& combine) {
+  // reads of globals and elements a call may change
+  const std::function<bool(const ASTNode*)> readsState = [&](const ASTNode* node) {
+    if (!node) {
+      return false;
+    }
+    if ((node->getType() == ASTNodeType::IDENTIFIER && !isLocal(node->getBinding())) ||
+      node->getType() == ASTNodeType::INDEX) {
+      return true;
+    }
+    return std::any_of(node->getChildren().begin(), node->getChildren().end(),
+      [&](const ASTNodePtr& child) { return readsState(child.get()); });
+  };
+
+  // the order can be observed when two operands have effects (which error is reported,
+  // which output comes first) or one calls and another reads what the call may change
+  bool ordered = false;
+  for (size_t i = 0; i < nodes.size() && !ordered; ++i) {
+    for (size_t j = 0; j < nodes.size() && !ordered; ++j) {
+      ordered = i != j && ((hasEffect(nodes[i]) && hasEffect(nodes[j])) ||
+        (containsCall(nodes[i]) && readsState(nodes[j])));
+    }
+  }
+  if (!ordered) {
+    return combine(operands);
+  }
+
+  std::string result = "[&] {";
+  std::vector<std::string> temporaries;
+  for (const auto& operand : operands) {
+    temporaries.push_back("t" + std::to_string(temporaries_++));
+    result += " auto " + temporaries.back() + " = " + operand + ";";
+  }
+  return result + " return " + combine(temporaries) + "; }()";
+}
+
+std::string CppEmitter::convert(const std::string& value, const TypeId target, const TypeId source) const {
+  if (target == source || !TypeTable::isScalar(target)) {
+    return value;
+  }
+  switch (target) {
+    case TypeTable::INT:
+      return source == TypeTable::FLOAT ? "rt::toInt(" + value + ", " + lineText() + ")" : "int64_t(" + value + ")";
+    case TypeTable::FLOAT:
+      return "double(" + value + ")";
+    case TypeTable::CHAR:
+      return source == TypeTable::FLOAT ? "rt::toChar(" + value + ", " + lineText() + ")" : "char(" + value + ")";
+    default:
+      return "rt::truth(" + value + ")";
+  }
+}
+
+std::string CppEmitter::variable(const uint32_t binding, const std::string& name) const {
+  return name + "_" + std::to_string(binding); // shadowed names have their own records
+}
+
+std::string CppEmitter::functionName(const uint32_t binding, const std::string& name) {
+  return name + "_" + std::to_string(binding);
+}
+
+std::string CppEmitter::cppType(const TypeId type) const {
+  switch (types_.kind(type)) {
+    case TypeKind::VOID:
+      return "void";
+    case TypeKind::INT:
+      return "int64_t";
+    case TypeKind::FLOAT:
+      return "double";
+    case TypeKind::CHAR:
+      return "char";
+    case TypeKind::BOOL:
+      return "bool";
+    case TypeKind::STRING:
+      return "std::string";
+    case TypeKind::ARRAY:
+      return "rt::Array<" + cppType(types_.get(type).element) + ">";
+    default:
+      throw std::runtime_error("Code generation error: no C++ type for '" + types_.toString(type) + "'.");
+  }
+}
+
+void CppEmitter::write(const std::string& text) {
+  out_ << std::string(2 * indent_, ' ') << text << '\n';
+}
+
+
+void compileNative(const std::string& source, const std::string& executable) {
+  const std::string path = executable + ".cpp";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << source;
+    if (!file) {
+      throw std::runtime_error("Native compilation error: cannot write \"" + path + "\".");
+    }
+  }
+
+  const char* compiler = std::getenv("CXX");
+  const std::string command = std::string(compiler && *compiler ? compiler : "c++") +
+    " -std=c++20 -O2 -pthread -o \"" + executable + "\" \"" + path + "\"";
+  const int status = std::system(command.c_str());
+  std::filesystem::remove(path);
+  if (status != 0) {
+    throw std::runtime_error("Native compilation error: \"" + command + "\" exited with status " +
+      std::to_string(status) + ".");
+  }
+}
@@ -0,0 +1,393 @@
+#include "../headers/cpp-emitter.h"
+
+
+// Copied at the start of every translation unit CppEmitter produces. It mirrors the
+// VM's semantics: wrapping integer arithmetic, checked division and float to integer
+// conversions, bounds-checked arrays with reference semantics, the same text for every
+// printed value and every runtime error ("Runtime error at line N: ...", exit status
+// 249 like `Language --run`). Nothing is ever freed, the VM's heap lives until the end
+// of the run as well.
+const char* const CPP_RUNTIME = R"cpp(#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include <pthread.h>
+#include <unistd.h>
+
+
+namespace rt {
+
+[[noreturn]] inline void fail(int line, const std::string& message);
+
+template <typename T>
+class Array;
+
+
+// stdout through one buffer, written with write(2) when it is full, before input is
+// read and at the end of the run
+class Output {
+public:
+  void flush() {
+    size_t written = 0;
+    while (written < size_) {
+      const ssize_t result = ::write(1, buffer_ + written, size_ - written);
+      if (result <= 0) {
+        break;
+      }
+      written += static_cast<size_t>(result);
+    }
+    size_ = 0;
+  }
+
+  void put(const char c) {
+    if (size_ == sizeof(buffer_)) {
+      flush();
+    }
+    buffer_[size_++] = c;
+  }
+
+  void write(const char* data, size_t size) {
+    while (size > 0) {
+      if (size_ == sizeof(buffer_)) {
+        flush();
+      }
+      const size_t chunk = size < sizeof(buffer_) - size_ ? size : sizeof(buffer_) - size_;
+      std::memcpy(buffer_ + size_, data, chunk);
+      size_ += chunk;
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  void print(const int64_t value) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* first = end;
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    do {
+      *--first = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+      *--first = '-';
+    }
+    write(first, static_cast<size_t>(end - first));
+  }
+
+  void print(const double value) { // std::ostream's default format
+    char text[32];
+    write(text, static_cast<size_t>(std::snprintf(text, sizeof(text), "%g", value)));
+  }
+
+  void print(const char value) { put(value); }
+  void print(const bool value) { put(value ? '1' : '0'); }
+  void print(const std::string& value) { write(value.data(), value.size()); }
+
+  template <typename T>
+  void print(const Array<T>& array) {
+    put('[');
+    for (int64_t i = 0; i < array.size(); ++i) {
+      if (i > 0) {
+        write(", ", 2);
+      }
+      print(array.data()[i]);
+    }
+    put(']');
+  }
+
+private:
+  char buffer_[1 << 16];
+  size_t size_ = 0;
+};
+
+inline Output out;
+
+
+// stdin through one buffer, parsed the way std::istream >> parses it in the classic
+// locale; the output is flushed before the buffer is refilled, so prompts appear
+class Input {
+public:
+  int64_t readInt(const int line) {
+    skipSpace();
+    bool negative = false;
+    if (peek() == '-' || peek() == '+') {
+      negative = peek() == '-';
+      ++position_;
+    }
+    uint64_t magnitude = 0;
+    bool digits = false;
+    bool overflow = false;
+    while (peek() >= '0' && peek() <= '9') {
+      const auto digit = static_cast<uint64_t>(peek() - '0');
+      overflow = overflow || magnitude > (UINT64_MAX - digit) / 10;
+      magnitude = magnitude * 10 + digit;
+      digits = true;
+      ++position_;
+    }
+    const uint64_t limit = negative ? uint64_t{1} << 63 : (uint64_t{1} << 63) - 1;
+    if (!digits || overflow || magnitude > limit) {
+      fail(line, "cannot read a value of type 'int'");
+    }
+    return negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+  }
+
+  double readFloat(const int line) {
+    skipSpace();
+    std::string text;
+    const auto take = [&] {
+      text += static_cast<char>(peek());
+      ++position_;
+    };
+    const auto digits = [&] {
+      while (peek() >= '0' && peek() <= '9') {
+        take();
+      }
+    };
+    if (peek() == '-' || peek() == '+') {
+      take();
+    }
+    digits();
+    if (peek() == '.') {
+      take();
+      digits();
+    }
+    if (peek() == 'e' || peek() == 'E') {
+      take();
+      if (peek() == '-' || peek() == '+') {
+        take();
+      }
+      digits();
+    }
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || std::isinf(value)) {
+      fail(line, "cannot read a value of type 'float'");
+    }
+    return value;
+  }
+
+  char readChar(const int line) {
+    skipSpace();
+    if (peek() == EOF) {
+      fail(line, "cannot read a value of type 'char'");
+    }
+    return static_cast<char>(buffer_[position_++]);
+  }
+
+  bool readBool(const int line) { // true / false or a number
+    const std::string word = readWord(line, "bool");
+    return word == "true" || (word != "false" && std::strtod(word.c_str(), nullptr) != 0.0);
+  }
+
+  std::string readString(const int line) { return readWord(line, "string"); }
+
+private:
+  char buffer_[1 << 16];
+  size_t position_ = 0;
+  size_t size_ = 0;
+
+  int peek() {
+    if (position_ == size_) {
+      out.flush();
+      const ssize_t result = ::read(0, buffer_, sizeof(buffer_));
+      if (result <= 0) {
+        return EOF;
+      }
+      position_ = 0;
+      size_ = static_cast<size_t>(result);
+    }
+    return static_cast<unsigned char>(buffer_[position_]);
+  }
+
+  void skipSpace() {
+    while (peek() == ' ' || (peek() >= '\t' && peek() <= '\r')) {
+      ++position_;
+    }
+  }
+
+  std::string readWord(const int line, const char* type) {
+    skipSpace();
+    if (peek() == EOF) {
+      fail(line, std::string("cannot read a value of type '") + type + "'");
+    }
+    std::string word;
+    while (peek() != EOF && peek() != ' ' && (peek() < '\t' || peek() > '\r')) {
+      word += static_cast<char>(buffer_[position_++]);
+    }
+    return word;
+  }
+};
+
+inline Input in;
+
+
+[[noreturn]] inline void fail(const int line, const std::string& message) {
+  out.flush();
+  const std::string text = "Runtime error at line " + std::to_string(line) + ": " + message + "\n";
+  [[maybe_unused]] const ssize_t written = ::write(2, text.data(), text.size());
+  std::_Exit(249);
+}
+
+[[noreturn]] inline void outOfBounds(const int64_t index, const int64_t size, const int line) {
+  fail(line, "index " + std::to_string(index) + " is out of bounds for an array of size " + std::to_string(size));
+}
+
+
+template <typename T>
+struct IsArray : std::false_type {};
+
+template <typename T>
+struct IsArray<Array<T>> : std::true_type {};
+
+
+// array< T >: a handle to one contiguous block of elements (the header and the elements
+// in a single allocation); copies of the handle share the elements like the VM's arrays
+template <typename T>
+class Array {
+public:
+  Array() : block_(&empty_) {}
+
+  // sizes[0] x sizes[1] x ... elements, the innermost ones zero values
+  static Array make(const std::initializer_list<int64_t> sizes, const int line) {
+    return make(sizes.begin(), sizes.size(), line);
+  }
+
+  static Array make(const int64_t* sizes, const size_t dimensions, const int line) {
+    if (dimensions == 0) {
+      return Array();
+    }
+    if (sizes[0] < 0) {
+      fail(line, "negative array size " + std::to_string(sizes[0]));
+    }
+    void* memory = ::operator new(sizeof(Block) + static_cast<size_t>(sizes[0]) * sizeof(T));
+    Array array(new (memory) Block{sizes[0]});
+    T* elements = array.data();
+    for (int64_t i = 0; i < sizes[0]; ++i) {
+      if constexpr (IsArray<T>::value) {
+        new (elements + i) T(dimensions > 1 ? T::make(sizes + 1, dimensions - 1, line) : T());
+      } else {
+        new (elements + i) T();
+      }
+    }
+    return array;
+  }
+
+  [[nodiscard]] int64_t size() const { return block_->size; }
+  [[nodiscard]] T* data() const { return reinterpret_cast<T*>(block_ + 1); }
+
+  [[nodiscard]] T& at(const int64_t index, const int line) const {
+    if (static_cast<uint64_t>(index) >= static_cast<uint64_t>(block_->size)) {
+      outOfBounds(index, block_->size, line);
+    }
+    return data()[index];
+  }
+
+  void set(const int64_t index, T value, const int line) const {
+    at(index, line) = std::move(value);
+  }
+
+private:
+  struct alignas(16) Block {
+    int64_t size;
+  };
+
+  inline static Block empty_{0};
+  Block* block_;
+
+  explicit Array(Block* block) : block_(block) {}
+};
+
+
+// integers wrap around instead of overflowing
+inline int64_t add(const int64_t a, const int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+inline int64_t sub(const int64_t a, const int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+
+inline int64_t mul(const int64_t a, const int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+}
+
+inline int64_t neg(const int64_t a) {
+  return static_cast<int64_t>(0 - static_cast<uint64_t>(a));
+}
+
+inline int64_t div(const int64_t a, const int64_t b, const int line) {
+  if (b == 0) {
+    fail(line, "integer division by zero");
+  }
+  return b == -1 ? neg(a) : a / b;
+}
+
+// out-of-range float to integer conversions are undefined in C++, they are rejected
+inline int64_t toInt(const double value, const int line) {
+  if (!std::isfinite(value) || value >= 9223372036854775808.0 || value < -9223372036854775808.0) {
+    fail(line, "float value " + std::to_string(value) + " does not fit an int");
+  }
+  return static_cast<int64_t>(value);
+}
+
+inline char toChar(const double value, const int line) {
+  return static_cast<char>(toInt(value, line));
+}
+
+// condition value of a scalar
+inline bool truth(const int64_t value) { return value != 0; }
+inline bool truth(const double value) { return value != 0.0; }
+inline bool truth(const char value) { return value != 0; }
+inline bool truth(const bool value) { return value; }
+
+
+// Depth of the calls in progress, limited like the VM's frames
+inline uint32_t depth = 0;
+inline constexpr uint32_t MAX_CALL_DEPTH = 100000;
+
+struct Call {
+  Call(const int line, const char* name) {
+    if (depth == MAX_CALL_DEPTH) {
+      fail(line, std::string("stack overflow in a call of '") + name + "': more than " +
+        std::to_string(MAX_CALL_DEPTH) + " nested calls");
+    }
+    ++depth;
+  }
+  ~Call() { --depth; }
+
+  Call(const Call&) = delete;
+  Call& operator=(const Call&) = delete;
+};
+
+
+// Runs the program on a thread with a stack large enough for MAX_CALL_DEPTH calls
+inline int start(void (*program)()) {
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  pthread_attr_setstacksize(&attributes, size_t{1} << 30);
+  pthread_t thread;
+  const auto body = [](void* argument) -> void* {
+    reinterpret_cast<void (*)()>(argument)();
+    return nullptr;
+  };
+  if (pthread_create(&thread, &attributes, body, reinterpret_cast<void*>(program)) != 0) {
+    program();
+  } else {
+    pthread_join(thread, nullptr);
+  }
+  out.flush();
+  return 0;
+}
+
+} // namespace rt
+
+)cpp";
@@ -106,4 +106,22 @@ inline std::string getTokenValue(const my::TokenType token) {
 }
 
 
+// Literal lexemes -> values (the lexer keeps quotes around string and char literals)
+inline int64_t decodeIntegerLiteral(const std::string& lexeme) {
+  return std::stoll(lexeme);
+}
+
+inline double decodeFloatLiteral(const std::string& lexeme) {
+  return std::stod(lexeme);
+}
+
+inline char decodeCharLiteral(const std::string& lexeme) {
+  return lexeme.size() >= 3 ? lexeme[1] : '\0';
+}
+
+inline std::string decodeStringLiteral(const std::string& lexeme) {
+  return lexeme.size() >= 2 ? lexeme.substr(1, lexeme.size() - 2) : std::string();
+}
+
+
 #endif //GLOBAL_FUNCS_H
@@ -18,11 +18,10 @@
 #include <cstdlib>
 #include <random>
 #include <stack>
-
-
-// const variables
-inline int COUNT = 0;
-static inline std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+#include <optional>
+#include <memory>
+#include <algorithm>
+#include <deque>
 
 
 #endif //LIBRARIES_H
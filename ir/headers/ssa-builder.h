@@ -0,0 +1,126 @@
+#ifndef SSA_BUILDER_H
+#define SSA_BUILDER_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+#include "../../semantic-analyzer/headers/tid.h"
+#include "../../semantic-analyzer/headers/types.h"
+#include "ssa.h"
+
+
+// Builds the SSA form of an analysed AST in one pass, after Braun et al., "Simple and
+// Efficient Construction of Static Single Assignment Form" (CC 2013): a local variable
+// is a map from block to its current value; reading it in a block without one asks the
+// predecessors, through a phi where there are several. A block is sealed once all its
+// predecessors are known; until then its phis are incomplete and get their operands
+// when it is sealed. A phi whose operands are all one value (or itself) is replaced by
+// that value, and the phis that used it are checked again. Globals stay in memory
+// (LOAD_GLOBAL / STORE_GLOBAL). Conditions become branches as in the generators, loops
+// are laid out with the test after the body, and a switch compares its subject with
+// each label in turn.
+class SSABuilder {
+public:
+  SSABuilder(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  SSAProgram build(const ASTNodePtr& program);
+
+  // INDEX nodes whose checks can be left out (RangeAnalysis); none by default
+  void setInBounds(const std::unordered_set<const ASTNode*>* inBounds) { inBounds_ = inBounds; }
+
+  // Arrays and strings made in the region of their call (EscapeAnalysis): LOCAL_ARRAY
+  // arrays, SSAFunction::localStrings; none by default
+  void setLocalAllocations(const LocalAllocations* locals) { locals_ = locals; }
+
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+  static constexpr uint32_t SYNTHETIC = 1u << 31; // variables of `&&` / `||` values, not bindings
+
+  const TID& tid_;
+  const TypeTable& types_;
+  const std::unordered_set<const ASTNode*>* inBounds_ = nullptr;
+  const LocalAllocations* locals_ = nullptr;
+  SSAProgram program_;
+
+  std::unordered_map<uint32_t, uint32_t> functionByBinding_;
+  std::unordered_map<uint32_t, uint32_t> globalByBinding_;
+  std::unordered_map<std::string, uint32_t> stringIndex_;
+
+  // state of the function being built
+  SSAFunction* function_ = nullptr;
+  uint32_t current_ = NONE; // block being filled; NONE after a return, break or continue
+  std::vector<uint32_t> layout_; // blocks in the order they were entered
+  std::vector<SSAValue> entryValues_; // parameters and constants, placed first in the entry
+  std::vector<std::vector<SSAValue>> phis_; // per block
+  std::vector<std::unordered_map<uint32_t, SSAValue>> definitions_; // per block: variable -> value
+  std::vector<bool> sealed_;
+  std::vector<std::vector<std::pair<uint32_t, SSAValue>>> incompletePhis_; // per block
+  std::unordered_map<SSAValue, SSAValue> replaced_; // trivial phi -> the value it stands for
+  std::unordered_map<SSAValue, std::vector<SSAValue>> phiUsers_;
+  std::unordered_map<uint32_t, TypeId> variableTypes_;
+  std::map<std::tuple<SSAOp, TypeId, int64_t>, SSAValue> constants_;
+  uint32_t synthetic_ = SYNTHETIC;
+  TypeId returnType_ = TypeTable::VOID;
+  uint32_t line_ = 0;
+  std::vector<uint32_t> breakTargets_;
+  std::vector<uint32_t> continueTargets_;
+
+  void buildEntry(const ASTNodePtr& program, const ASTNodePtr& main);
+  void buildFunction(const ASTNodePtr& function, uint32_t index);
+  void beginFunction(uint32_t index);
+  // Orders the values by block, drops the replaced and unused phis and constants
+  void endFunction();
+
+  void statement(const ASTNodePtr& node);
+  void declaration(const ASTNodePtr& node);
+  void assignment(const ASTNodePtr& node);
+  void loop(const ASTNodePtr& node);
+  void switchStatement(const ASTNodePtr& node);
+
+  // Branches to `whenTrue` or `whenFalse`: `!`, `&&` and `||` become branches, the other
+  // operands one BRANCH each
+  void condition(const ASTNodePtr& node, uint32_t whenTrue, uint32_t whenFalse);
+  SSAValue value(const ASTNodePtr& node);
+  SSAValue convertedValue(const ASTNodePtr& node, TypeId type);
+  SSAValue operatorValue(const ASTNodePtr& node);
+  // `a && b` as a value: a bool variable assigned on both paths, read after them
+  SSAValue logicalValue(const ASTNodePtr& node);
+  SSAValue call(const ASTNodePtr& node);
+  SSAValue literal(const ASTNodePtr& node);
+  SSAValue zeroValue(TypeId type);
+  // Evaluates an expression for its effects only
+  void effect(const ASTNodePtr& node);
+
+  // Braun et al.: the current value of a variable
+  void writeVariable(uint32_t variable, uint32_t block, SSAValue value);
+  SSAValue readVariable(uint32_t variable, uint32_t block);
+  SSAValue readVariableRecursive(uint32_t variable, uint32_t block);
+  SSAValue addPhiOperands(uint32_t variable, SSAValue phi);
+  SSAValue tryRemoveTrivialPhi(SSAValue phi);
+  void sealBlock(uint32_t block);
+  // The value a replaced phi stands for (the value itself otherwise)
+  SSAValue resolve(SSAValue value) const;
+  [[nodiscard]] bool isLocal(uint32_t binding) const;
+
+  uint32_t newBlock();
+  void addEdge(uint32_t from, uint32_t to);
+  // Continues in `block` (a loop body, whose predecessors come from the test after it)
+  void enter(uint32_t block);
+  // enter() where `block` has predecessors; without, the code after is unreachable
+  void reach(uint32_t block);
+
+  SSAValue emit(SSAOp op, TypeId type, std::vector<SSAValue> operands, int64_t immediate = 0);
+  void jump(uint32_t target);
+  void branch(SSAValue condition, uint32_t whenTrue, uint32_t whenFalse);
+  // A constant (or an undefined value) of the entry block, one per distinct value
+  SSAValue constant(TypeId type, int64_t immediate, SSAOp op = SSAOp::CONSTANT);
+
+  [[nodiscard]] static std::optional<SSAOp> conversion(TypeId target, TypeId source);
+  [[nodiscard]] ValueKind valueKind(TypeId type) const;
+  uint32_t globalIndex(uint32_t binding);
+  uint32_t addString(const std::string& value);
+};
+
+
+#endif //SSA_BUILDER_H
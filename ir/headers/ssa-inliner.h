@@ -0,0 +1,53 @@
+#ifndef SSA_INLINER_H
+#define SSA_INLINER_H
+
+
+#include "../../includes/libraries.h"
+#include "ssa.h"
+
+
+// What one SSAInliner::run() did
+struct InliningStatistics {
+  size_t calls = 0; // call sites replaced by the callee's body
+  size_t functions = 0; // distinct functions inlined somewhere
+  size_t recursive = 0; // functions left alone because they are on a call cycle
+};
+
+
+// Inlines small functions into their callers on the SSA form. The call graph is split
+// into strongly connected components (Tarjan); a function on a cycle is never inlined,
+// and the others are handled callees first, so a body is inlined with its own calls
+// inlined already. A call is inlined when the callee is tiny, when it is small and the
+// call is inside a loop, or when it is the callee's only call site and the body is not
+// large; a caller stops growing at a limit. The callee's blocks are copied into the
+// caller with its parameters replaced by the arguments; the block of the call is split
+// after it, every return becomes a jump to that join point, and a phi there merges the
+// returned values. SSAOptimizer is meant to run afterwards.
+class SSAInliner {
+public:
+  void run(SSAProgram& program);
+
+  [[nodiscard]] const InliningStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+  static constexpr size_t TINY = 8; // instructions inlined at every call
+  static constexpr size_t SMALL = 40; // inlined into loops
+  static constexpr size_t SINGLE_CALL = 120; // inlined at the only call site
+  static constexpr size_t CALLER_LIMIT = 2000; // no inlining into a caller this big
+
+  InliningStatistics statistics_;
+
+  // Instructions of a function that do work (no parameters, constants, phis or jumps)
+  [[nodiscard]] static size_t size(const SSAFunction& function);
+  // Functions in the order to handle them (callees first) and which are on a cycle
+  static std::vector<uint32_t> bottomUp(const SSAProgram& program, std::vector<bool>& recursive);
+  // Replaces `call` in `caller` by a copy of `callee`; the new blocks follow the call's
+  // block in `layout`. What the callee made in the region of its call now lasts as long
+  // as the caller's: nothing the copy makes goes there when the call is in a loop.
+  static void inlineCall(SSAFunction& caller, SSAValue call, const SSAFunction& callee, bool inLoop,
+    std::vector<uint32_t>& layout);
+};
+
+
+#endif //SSA_INLINER_H
@@ -0,0 +1,53 @@
+#ifndef SSA_LOOP_OPTIMIZER_H
+#define SSA_LOOP_OPTIMIZER_H
+
+
+#include "../../includes/libraries.h"
+#include "ssa.h"
+
+
+// What one SSALoopOptimizer::run() did
+struct LoopStatistics {
+  size_t loops = 0; // natural loops found
+  size_t preheaders = 0; // blocks added in front of a loop header
+  size_t hoisted = 0; // invariant values moved out of a loop
+  size_t reduced = 0; // multiplications by an induction variable replaced by additions
+};
+
+
+// Loop optimizations on the SSA form, inner loops before the loops around them. Every
+// loop gets a preheader (the only block entering it); pure values computed from values
+// defined outside the loop are moved there, since they cannot fail and compute the same
+// thing every iteration. Then multiplications i * k of a basic induction variable i
+// (a header phi stepped by an invariant c on every back edge) are replaced by a new
+// induction variable that starts at init * k and is stepped by c * k. An add costs a
+// dispatch just like a multiplication, so that is only done when c * k is a constant
+// the step can be fused with, or when one new variable replaces several products.
+// SSAOptimizer is meant to run afterwards to fold what the preheaders start with.
+class SSALoopOptimizer {
+public:
+  void run(SSAProgram& program);
+
+  [[nodiscard]] const LoopStatistics& getStatistics() const { return statistics_; }
+
+private:
+  LoopStatistics statistics_;
+  SSAFunction* function_ = nullptr;
+  std::vector<uint32_t> layout_; // the blocks in the order compact() gets them
+  std::vector<bool> inLoop_; // per block, of the loop being optimized
+
+  // The block entering `header` from outside the loop, made when there is none
+  uint32_t preheader(uint32_t header);
+  void hoistInvariants(const SSALoop& loop, uint32_t preheader);
+  void reduceStrength(const SSALoop& loop, uint32_t preheader);
+
+  [[nodiscard]] bool isInvariant(SSAValue value) const;
+  [[nodiscard]] bool isConstant(SSAValue value) const;
+  // Puts `value` last before the terminator of `block`
+  void insertBeforeTerminator(uint32_t block, SSAValue value);
+  // Gives `value` a new list of operands (at the end of the arena)
+  void setOperands(SSAValue value, const std::vector<SSAValue>& operands);
+};
+
+
+#endif //SSA_LOOP_OPTIMIZER_H
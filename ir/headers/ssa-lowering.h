@@ -0,0 +1,106 @@
+#ifndef SSA_LOWERING_H
+#define SSA_LOWERING_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+#include "../../semantic-analyzer/headers/register-allocator.h"
+#include "../../semantic-analyzer/headers/register-bytecode.h"
+#include "../../semantic-analyzer/headers/types.h"
+#include "ssa.h"
+
+
+// Translates the SSA form out into either bytecode. Critical edges are split first, so
+// the copies into a block's phis go at the end of its predecessors. A phi and an operand
+// that are never live at once become one variable (Budimlic et al., "Fast Copy
+// Coalescing and Live-Range Identification", PLDI 2002), and the copy between them
+// disappears.
+//
+// Registers: every variable is a virtual register (parameters 0..n-1), the remaining
+// phi copies are MOVEs ordered so that none overwrites a source still to be read (a
+// cycle goes through a temporary), and LinearScanAllocator folds the registers into
+// frame slots.
+//
+// Stack: the expression trees are found again. A value with one use, later in its own
+// block and not by a phi, is computed where it is used when only the values of that
+// use's tree are computed in between, so no effect changes order; the others are
+// stored to a slot once and loaded at each use, constants are pushed at each use. A
+// variable of several values and a value other blocks read keep their own slot, a
+// value used only in its block takes one that is reused after its last load.
+class SSALowering {
+public:
+  explicit SSALowering(const TypeTable& types) : types_(types) {}
+
+  RPNProgram lowerStack(const SSAProgram& program);
+  RegisterProgram lowerRegisters(const SSAProgram& program);
+
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  const TypeTable& types_;
+  BytecodeProgram* bytecode_ = nullptr; // pools of the program being lowered
+  std::unordered_map<uint64_t, uint32_t> floatIndex_;
+
+  // state of the function being lowered
+  SSAFunction function_;
+  std::vector<uint32_t> layout_; // blocks in code order: split edges after their source
+  std::vector<uint32_t> uses_; // per value; a phi operand counts at the end of its predecessor
+  std::vector<SSAValue> user_; // the only user of a value with one use
+  std::vector<SSAValue> congruence_; // representative of the class of each value
+
+  // stack
+  RPNProgram* stack_ = nullptr;
+  RPNFunction* stackFunction_ = nullptr;
+  std::vector<bool> folded_; // computed inside its user's tree
+  std::vector<uint32_t> slots_; // per value kept in a slot
+  std::vector<uint32_t> blockOffsets_;
+  std::vector<std::pair<uint32_t, uint32_t>> patches_; // (operand position, block)
+  uint32_t stackDepth_ = 0;
+  uint32_t line_ = 0;
+
+  // registers
+  RegisterFunctionIR ir_;
+  std::vector<uint32_t> registers_; // per value
+
+  void beginFunction(const SSAFunction& function);
+  void countUses();
+  [[nodiscard]] uint32_t phiOperandIndex(uint32_t block, uint32_t successor) const;
+  // Sorts the phis and their operands into classes that can share a slot (congruence_):
+  // an operand's class joins the phi's when no value of one is live where a value of the
+  // other is defined. `computed` is the position in its block where each value is computed
+  void coalescePhis(const std::vector<uint32_t>& computed);
+
+  void lowerStackFunction(uint32_t index);
+  // Which values are computed inside their user's tree (folded_), backward over a block
+  void foldTrees(uint32_t block);
+  void assignSlots();
+  void pushTree(SSAValue value);
+  // Pushes an operand, a float when `asFloat` and it is an int
+  void pushOperand(SSAValue value, bool asFloat = false);
+  void pushConstant(const SSAInstruction& instruction, bool asFloat);
+  void pushZero(TypeId type);
+  // LOAD_INDEX / STORE_INDEX over a chain of folded LOAD_INDEX: one LOAD_ELEMENT /
+  // STORE_ELEMENT where the indices after the first cannot fail or have an effect
+  void pushElement(SSAValue value, const SSAValue* stored = nullptr);
+  // Whether a folded tree can neither fail nor have an effect
+  [[nodiscard]] bool isPlainTree(SSAValue value) const;
+  void emitStackRoot(SSAValue value);
+  void emitStackCopies(uint32_t block);
+  void emitStackTerminator(uint32_t block, uint32_t next);
+  void emitStack(OpCode op, int delta);
+  void emitStack(OpCode op, int delta, uint32_t operand);
+  void emitStack(OpCode op, int delta, uint32_t first, uint32_t second);
+  void emitStackJump(OpCode op, int delta, uint32_t block);
+
+  void lowerRegisterFunction(RegisterProgram& program, uint32_t index);
+  void emitRegisterInstruction(SSAValue value, uint32_t next);
+  void emitRegisterCopies(uint32_t block);
+  void emitRegister(RegOp op, std::vector<uint32_t> operands);
+  uint32_t newRegister(const std::string& name = "");
+
+  [[nodiscard]] ValueKind valueKind(TypeId type) const;
+  uint32_t addFloat(double value);
+};
+
+
+#endif //SSA_LOWERING_H
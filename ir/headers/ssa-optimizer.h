@@ -0,0 +1,57 @@
+#ifndef SSA_OPTIMIZER_H
+#define SSA_OPTIMIZER_H
+
+
+#include "../../includes/libraries.h"
+#include "../../virtual-machine/headers/runtime.h"
+#include "ssa.h"
+
+#include <optional>
+
+
+// What SSAOptimizer::run() did, summed over the runs of one optimizer
+struct SSAOptimizationStatistics {
+  size_t folded = 0; // operations on constants replaced by their result
+  size_t branches = 0; // branches on a constant replaced by a jump
+  size_t phis = 0; // phis of a single value removed
+  size_t dead = 0; // values computed for nothing removed
+  size_t merged = 0; // blocks merged into their only predecessor
+  size_t rounds = 0; // rounds of all the passes, summed over the functions
+};
+
+
+// Cleans up the SSA form, mostly after SSAInliner put arguments in place of parameters:
+// constants are moved to the entry block (once per value, as SSABuilder makes them) and
+// operations on them folded with the interpreters' Runtime, branches on a constant become
+// jumps and the blocks no longer reached are dropped, phis merging a single value and
+// values nothing uses are removed, and a block that is the only successor of its only
+// predecessor is merged into it. The passes repeat until none changes the function.
+class SSAOptimizer {
+public:
+  void run(SSAProgram& program);
+
+  [[nodiscard]] const SSAOptimizationStatistics& getStatistics() const { return statistics_; }
+
+private:
+  SSAOptimizationStatistics statistics_;
+  Runtime runtime_; // evaluates folded operations exactly like the interpreters
+  SSAFunction* function_ = nullptr;
+  std::vector<SSAValue> forward_; // per value: the value replacing it (itself if none)
+
+  bool hoistConstants();
+  bool foldConstants();
+  bool removeTrivialPhis();
+  bool foldBranches();
+  bool removeDeadValues();
+  bool mergeBlocks();
+
+  // Points every operand at the value replacing it
+  void rewriteOperands();
+  [[nodiscard]] SSAValue resolve(SSAValue value);
+  // The result of an operation on constants, or nullopt if it has none or fails at run time
+  [[nodiscard]] std::optional<int64_t> evaluate(SSAValue value);
+  [[nodiscard]] static std::optional<Value> constantValue(const SSAInstruction& instruction);
+};
+
+
+#endif //SSA_OPTIMIZER_H
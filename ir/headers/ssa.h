@@ -0,0 +1,206 @@
+#ifndef SSA_H
+#define SSA_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+#include "../../semantic-analyzer/headers/types.h"
+
+#include <span>
+
+
+// Instructions of the SSA form: X(name, mnemonic). Every instruction defines at most one
+// value (its own index) of a static type; operands are values, the immediate holds
+// what is not a value:
+//
+//   PARAMETER                 immediate: the parameter's index (entry block only)
+//   CONSTANT                  immediate: the value of an int, char or bool, the bit
+//                             pattern of a float, an SSAProgram::strings index
+//   UNDEF                     a variable read before any assignment on some path
+//   PHI                       one operand per predecessor of the block, in their order
+//   LOAD_GLOBAL / STORE_GLOBAL  immediate: global slot; STORE_GLOBAL value
+//   NEW_ARRAY sizes..         immediate: ValueKind of the innermost elements, with
+//                             LOCAL_ARRAY when the array never outlives its call
+//   LOAD_INDEX array index    immediate: 1 when RangeAnalysis proved the index in bounds
+//   STORE_INDEX array index value
+//   ADD .. NEQ, NEG, NOT      operand types as in the source (an int and a float mix)
+//   TO_INT .. TO_BOOL         scalar conversions (assignments, arguments, returns)
+//   CALL arguments..          immediate: function index; VOID type for void functions
+//   PRINT value, READ         READ immediate: ValueKind of the value read
+//   JUMP, BRANCH condition    terminators: the block's successors are the targets, for
+//   RETURN value, RETURN_VOID   BRANCH the one taken on true first
+//   TRAP, HALT                TRAP immediate: SSAProgram::strings index of the message
+#define SSA_OPCODES(X)               \
+  X(PARAMETER, "param")              \
+  X(CONSTANT, "const")               \
+  X(UNDEF, "undef")                  \
+  X(PHI, "phi")                      \
+  X(LOAD_GLOBAL, "load.global")      \
+  X(STORE_GLOBAL, "store.global")    \
+  X(NEW_ARRAY, "new.array")          \
+  X(LOAD_INDEX, "load.index")        \
+  X(STORE_INDEX, "store.index")      \
+  X(ADD, "add")                      \
+  X(SUB, "sub")                      \
+  X(MUL, "mul")                      \
+  X(DIV, "div")                      \
+  X(NEG, "neg")                      \
+  X(NOT, "not")                      \
+  X(LT, "lt")                        \
+  X(GT, "gt")                        \
+  X(EQ, "eq")                        \
+  X(NEQ, "neq")                      \
+  X(TO_INT, "to.int")                \
+  X(TO_FLOAT, "to.float")            \
+  X(TO_CHAR, "to.char")              \
+  X(TO_BOOL, "to.bool")              \
+  X(CALL, "call")                    \
+  X(PRINT, "print")                  \
+  X(READ, "read")                    \
+  X(JUMP, "jump")                    \
+  X(BRANCH, "branch")                \
+  X(RETURN, "return")                \
+  X(RETURN_VOID, "return.void")      \
+  X(TRAP, "trap")                    \
+  X(HALT, "halt")
+
+enum class SSAOp : uint8_t {
+#define SSA_OPCODE_ENUM(name, mnemonic) name,
+  SSA_OPCODES(SSA_OPCODE_ENUM)
+#undef SSA_OPCODE_ENUM
+};
+
+inline constexpr const char* SSA_OPCODE_MNEMONICS[] = {
+#define SSA_OPCODE_MNEMONIC(name, mnemonic) mnemonic,
+  SSA_OPCODES(SSA_OPCODE_MNEMONIC)
+#undef SSA_OPCODE_MNEMONIC
+};
+
+// Ends a basic block: control goes to the block's successors, or leaves the function
+inline constexpr bool isTerminator(const SSAOp op) {
+  return op >= SSAOp::JUMP;
+}
+
+// Can neither fail nor have an effect, so it may run anywhere its operands are computed
+// (an integer division by zero fails, a float one does not)
+inline constexpr bool isPure(const SSAOp op, const TypeId type) {
+  switch (op) {
+    case SSAOp::CONSTANT:
+    case SSAOp::UNDEF:
+    case SSAOp::ADD:
+    case SSAOp::SUB:
+    case SSAOp::MUL:
+    case SSAOp::NEG:
+    case SSAOp::NOT:
+    case SSAOp::LT:
+    case SSAOp::GT:
+    case SSAOp::EQ:
+    case SSAOp::NEQ:
+    case SSAOp::TO_FLOAT:
+    case SSAOp::TO_BOOL:
+      return true;
+    case SSAOp::DIV:
+      return type == TypeTable::FLOAT;
+    default: // loads, stores, calls, input and output, TO_INT and TO_CHAR of a float
+      return false;
+  }
+}
+
+
+using SSAValue = uint32_t; // index of the defining instruction in SSAFunction::values
+
+struct SSAInstruction {
+  SSAOp op;
+  TypeId type = TypeTable::VOID; // VOID: defines no value
+  uint32_t block = 0;
+  uint32_t line = 0;
+  uint32_t firstOperand = 0; // into SSAFunction::operands
+  uint32_t operandCount = 0;
+  int64_t immediate = 0;
+};
+
+struct SSABlock {
+  std::vector<SSAValue> instructions; // phis first, the terminator last
+  std::vector<uint32_t> predecessors; // a block branching here twice is listed twice
+  std::vector<uint32_t> successors;
+};
+
+// One function in SSA form. The instructions live in one arena and refer to each other
+// by index, as do the blocks; block 0 is the entry, and the blocks are in layout order.
+struct SSAFunction {
+  std::string name;
+  uint32_t parameters = 0;
+  TypeId returnType = TypeTable::VOID;
+  bool localStrings = false; // see RPNFunction
+  std::vector<SSAInstruction> values;
+  std::vector<SSAValue> operands; // every instruction's operands, consecutive
+  std::vector<std::string> names; // per value: the variable it was assigned to, or ""
+  std::vector<SSABlock> blocks;
+
+  [[nodiscard]] std::span<const SSAValue> operandsOf(const SSAValue value) const {
+    const SSAInstruction& instruction = values[value];
+    return {operands.data() + instruction.firstOperand, instruction.operandCount};
+  }
+
+  [[nodiscard]] std::span<SSAValue> operandsOf(const SSAValue value) {
+    const SSAInstruction& instruction = values[value];
+    return {operands.data() + instruction.firstOperand, instruction.operandCount};
+  }
+
+  // Appends an instruction to the arena (not to a block)
+  SSAValue add(SSAOp op, TypeId type, uint32_t block, uint32_t line, std::span<const SSAValue> arguments,
+    int64_t immediate = 0);
+};
+
+// A whole program: function 0 runs the top-level instructions, then `main`
+struct SSAProgram {
+  std::vector<SSAFunction> functions;
+  std::vector<std::string> strings;
+  uint32_t globals = 0;
+  std::vector<std::string> globalNames;
+};
+
+
+// Textual form, one instruction per line:
+//   %7 = add %5, %6 : int
+//   %4 = phi [%1, b0], [%7, b2] : int        ; i
+//   branch %8, b2, b3
+std::string dump(const SSAProgram& program, const TypeTable& types);
+
+// Checks the invariants the lowering relies on and throws std::runtime_error on the first
+// one broken: every block ends with its only terminator and its phis come first, with
+// one operand per predecessor; the edges agree with the terminators and every block is
+// reachable from the entry; operands are values, defined by an instruction that
+// dominates the use (for a phi operand, the end of the predecessor it comes from)
+void verify(const SSAProgram& program);
+
+// Puts a new block on every edge from a block with several successors to a block with
+// phis, so the copies a phi needs can be placed at the end of its predecessors
+void splitCriticalEdges(SSAFunction& function);
+
+// Immediate dominator of every block (the entry's is itself), by the iterative algorithm
+// of Cooper, Harvey and Kennedy; UINT32_MAX for unreachable blocks
+std::vector<uint32_t> dominators(const SSAFunction& function);
+
+// A natural loop: the header and every block that reaches one of its back edges (an
+// edge into the header from a block it dominates) without passing the header
+struct SSALoop {
+  uint32_t header = 0;
+  std::vector<uint32_t> blocks; // the header first, then by block id
+};
+
+// The natural loops of a function, the back edges into one header make one loop; an
+// outer loop comes before the loops nested in it
+std::vector<SSALoop> findLoops(const SSAFunction& function);
+
+// Removes the `index`-th predecessor of `block` and the matching operand of its phis
+void removePredecessor(SSAFunction& function, uint32_t block, size_t index);
+
+// Drops the blocks the entry cannot reach (with their operands of the phis they jumped
+// to) and the values no block holds, then numbers the blocks in the order of `layout`
+// (the reachable blocks, the entry first; all of them in their current order if empty)
+// and the values block by block
+void compact(SSAFunction& function, const std::vector<uint32_t>& layout = {});
+
+
+#endif //SSA_H
@@ -0,0 +1,901 @@
+#include "../headers/ssa-builder.h"
+
+
+SSAProgram SSABuilder::build(const ASTNodePtr& program) {
+  program_ = SSAProgram();
+  functionByBinding_.clear();
+  globalByBinding_.clear();
+  stringIndex_.clear();
+
+  // every function's signature first, calls can precede definitions
+  std::vector<ASTNodePtr> functions;
+  ASTNodePtr main;
+  program_.functions.emplace_back();
+  program_.functions[0].name = "<top-level>";
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      continue;
+    }
+    functionByBinding_[declaration->getBinding()] = static_cast<uint32_t>(program_.functions.size());
+    functions.push_back(declaration);
+
+    SSAFunction& function = program_.functions.emplace_back();
+    function.name = declaration->getValue();
+    function.parameters = static_cast<uint32_t>(declaration->getChildren().size() - 1);
+    function.returnType = types_.get(declaration->getTypeId()).element;
+    if (function.name == "main" && function.parameters == 0) {
+      main = declaration;
+    }
+  }
+
+  buildEntry(program, main);
+  for (size_t i = 0; i < functions.size(); ++i) {
+    buildFunction(functions[i], static_cast<uint32_t>(i + 1));
+  }
+  return std::move(program_);
+}
+
+void SSABuilder::buildEntry(const ASTNodePtr& program, const ASTNodePtr& main) {
+  beginFunction(0);
+
+  // globals hold their zero values even for functions that run before the declaration
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::VARIABLE_DECLARATION) {
+      line_ = declaration->getLine();
+      emit(SSAOp::STORE_GLOBAL, TypeTable::VOID, {zeroValue(declaration->getTypeId())},
+        globalIndex(declaration->getBinding()));
+    }
+  }
+
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration);
+    }
+  }
+  if (current_ != NONE) {
+    if (main) {
+      line_ = main->getLine();
+      const uint32_t index = functionByBinding_.at(main->getBinding());
+      emit(SSAOp::CALL, program_.functions[index].returnType, {}, index);
+    }
+    emit(SSAOp::HALT, TypeTable::VOID, {});
+  }
+  endFunction();
+}
+
+void SSABuilder::buildFunction(const ASTNodePtr& function, const uint32_t index) {
+  beginFunction(index);
+  returnType_ = function_->returnType;
+  line_ = function->getLine();
+  function_->localStrings = locals_ && locals_->strings.contains(function.get());
+
+  const auto& children = function->getChildren();
+  const TypeInfo& signature = types_.get(function->getTypeId());
+  for (size_t i = 0; i + 1 < children.size(); ++i) {
+    const uint32_t binding = children[i]->getBinding();
+    const SSAValue parameter = function_->add(SSAOp::PARAMETER, signature.parameters[i], 0, line_, {},
+      static_cast<int64_t>(i));
+    function_->names[parameter] = children[i]->getValue();
+    entryValues_.push_back(parameter);
+    variableTypes_[binding] = signature.parameters[i];
+    writeVariable(binding, 0, parameter);
+  }
+  statement(children.back());
+
+  // falling off the end
+  if (current_ != NONE) {
+    if (returnType_ == TypeTable::VOID) {
+      emit(SSAOp::RETURN_VOID, TypeTable::VOID, {});
+    } else {
+      emit(SSAOp::TRAP, TypeTable::VOID, {},
+        addString("function '" + function->getValue() + "' ended without returning a value"));
+    }
+  }
+  endFunction();
+}
+
+void SSABuilder::beginFunction(const uint32_t index) {
+  function_ = &program_.functions[index];
+  layout_.clear();
+  entryValues_.clear();
+  phis_.clear();
+  definitions_.clear();
+  sealed_.clear();
+  incompletePhis_.clear();
+  replaced_.clear();
+  phiUsers_.clear();
+  variableTypes_.clear();
+  constants_.clear();
+  synthetic_ = SYNTHETIC;
+  returnType_ = TypeTable::VOID;
+
+  const uint32_t entry = newBlock();
+  sealBlock(entry);
+  enter(entry);
+}
+
+void SSABuilder::endFunction() {
+  SSAFunction& function = *function_;
+
+  // each block with its phis first
+  std::vector<std::vector<SSAValue>> contents(function.blocks.size());
+  for (const uint32_t block : layout_) {
+    std::vector<SSAValue>& list = contents[block];
+    if (block == 0) {
+      list = entryValues_;
+    }
+    for (const SSAValue phi : phis_[block]) {
+      if (!replaced_.contains(phi)) {
+        list.push_back(phi);
+      }
+    }
+    list.insert(list.end(), function.blocks[block].instructions.begin(), function.blocks[block].instructions.end());
+  }
+
+  // a block whose only predecessor jumps to it alone continues that predecessor (the
+  // step of a loop after its body, the empty blocks after an if or a loop)
+  std::vector<bool> merged(function.blocks.size(), false);
+  for (const uint32_t block : layout_) {
+    std::vector<uint32_t>& successors = function.blocks[block].successors;
+    while (!merged[block] && successors.size() == 1) {
+      const uint32_t next = successors[0];
+      const SSABlock& following = function.blocks[next];
+      if (next == 0 || next == block || following.predecessors.size() != 1 ||
+        function.values[contents[next].front()].op == SSAOp::PHI) {
+        break;
+      }
+      contents[block].pop_back(); // the jump
+      contents[block].insert(contents[block].end(), contents[next].begin(), contents[next].end());
+      contents[next].clear();
+      merged[next] = true;
+      successors = following.successors;
+      for (const uint32_t successor : successors) {
+        auto& predecessors = function.blocks[successor].predecessors;
+        std::replace(predecessors.begin(), predecessors.end(), next, block);
+      }
+    }
+  }
+
+  // the blocks in layout order
+  std::vector<std::vector<SSAValue>> lists;
+  std::vector<uint32_t> blockId(function.blocks.size(), NONE);
+  std::vector<uint32_t> order;
+  for (const uint32_t block : layout_) {
+    if (!merged[block]) {
+      blockId[block] = static_cast<uint32_t>(lists.size());
+      lists.push_back(std::move(contents[block]));
+      order.push_back(block);
+    }
+  }
+
+  // phis and constants nothing reads are dropped, which may leave others unread
+  std::vector<uint32_t> uses(function.values.size(), 0);
+  for (const auto& list : lists) {
+    for (const SSAValue value : list) {
+      for (const SSAValue operand : function.operandsOf(value)) {
+        if (resolve(operand) != value) {
+          ++uses[resolve(operand)];
+        }
+      }
+    }
+  }
+  const auto isDroppable = [&](const SSAValue value) {
+    const SSAOp op = function.values[value].op;
+    return uses[value] == 0 && (op == SSAOp::PHI || op == SSAOp::CONSTANT || op == SSAOp::UNDEF);
+  };
+  std::vector<bool> dropped(function.values.size(), false);
+  std::vector<SSAValue> unused;
+  for (const auto& list : lists) {
+    for (const SSAValue value : list) {
+      if (isDroppable(value)) {
+        unused.push_back(value);
+      }
+    }
+  }
+  while (!unused.empty()) {
+    const SSAValue value = unused.back();
+    unused.pop_back();
+    if (dropped[value]) {
+      continue;
+    }
+    dropped[value] = true;
+    for (const SSAValue operand : function.operandsOf(value)) {
+      if (const SSAValue source = resolve(operand); source != value && --uses[source] == 0 && isDroppable(source)) {
+        unused.push_back(source);
+      }
+    }
+  }
+
+  // renumbered in block order, operands through the replaced phis
+  SSAFunction compact;
+  compact.name = std::move(function.name);
+  compact.parameters = function.parameters;
+  compact.returnType = function.returnType;
+  compact.localStrings = function.localStrings;
+  std::vector<SSAValue> valueId(function.values.size(), NONE);
+  for (uint32_t block = 0; block < lists.size(); ++block) {
+    for (const SSAValue value : lists[block]) {
+      if (!dropped[value]) {
+        valueId[value] = static_cast<SSAValue>(compact.values.size());
+        const SSAInstruction& instruction = function.values[value];
+        compact.values.push_back(instruction);
+        compact.values.back().block = block;
+        compact.names.push_back(function.names[value]);
+      }
+    }
+  }
+  for (size_t i = 0; i < valueId.size(); ++i) {
+    if (valueId[i] == NONE) {
+      continue;
+    }
+    SSAInstruction& instruction = compact.values[valueId[i]];
+    const auto operands = function.operandsOf(static_cast<SSAValue>(i));
+    instruction.firstOperand = static_cast<uint32_t>(compact.operands.size());
+    for (const SSAValue operand : operands) {
+      const SSAValue renamed = valueId[resolve(operand)];
+      if (renamed == NONE) {
+        throw std::runtime_error("Code generation error: SSA value used outside the reachable code.");
+      }
+      compact.operands.push_back(renamed);
+    }
+  }
+
+  compact.blocks.resize(lists.size());
+  for (uint32_t block = 0; block < lists.size(); ++block) {
+    SSABlock& target = compact.blocks[block];
+    for (const SSAValue value : lists[block]) {
+      if (!dropped[value]) {
+        target.instructions.push_back(valueId[value]);
+      }
+    }
+    const SSABlock& source = function.blocks[order[block]];
+    for (const uint32_t predecessor : source.predecessors) {
+      target.predecessors.push_back(blockId[predecessor]);
+    }
+    for (const uint32_t successor : source.successors) {
+      target.successors.push_back(blockId[successor]);
+    }
+  }
+  function = std::move(compact);
+  function_ = nullptr;
+}
+
+
+void SSABuilder::statement(const ASTNodePtr& node) {
+  if (current_ == NONE) {
+    return; // after a return, break or continue
+  }
+  line_ = node->getLine();
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK:
+      for (const auto& instruction : node->getChildren()) {
+        statement(instruction);
+      }
+      break;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      declaration(node);
+      break;
+    case ASTNodeType::ASSIGNMENT:
+      assignment(node);
+      break;
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      const uint32_t then = newBlock();
+      const uint32_t otherwise = newBlock();
+      const uint32_t end = children.size() > 2 ? newBlock() : otherwise;
+      condition(children[0], then, otherwise);
+      sealBlock(then);
+      reach(then);
+      statement(children[1]);
+      if (current_ != NONE) {
+        jump(end);
+      }
+      if (children.size() > 2) {
+        sealBlock(otherwise);
+        reach(otherwise);
+        statement(children[2]);
+        if (current_ != NONE) {
+          jump(end);
+        }
+      }
+      sealBlock(end);
+      reach(end);
+      break;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      loop(node);
+      break;
+    case ASTNodeType::SWITCH:
+      switchStatement(node);
+      break;
+    case ASTNodeType::RETURN_STATEMENT:
+      if (node->getChildren().empty()) {
+        emit(SSAOp::RETURN_VOID, TypeTable::VOID, {});
+      } else {
+        emit(SSAOp::RETURN, TypeTable::VOID, {convertedValue(node->getChild(0), returnType_)});
+      }
+      break;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        const TypeId type = target->getTypeId();
+        const SSAValue input = emit(SSAOp::READ, type, {}, static_cast<int64_t>(valueKind(type)));
+        if (isLocal(target->getBinding())) {
+          function_->names[input] = target->getValue();
+          writeVariable(target->getBinding(), current_, input);
+        } else {
+          emit(SSAOp::STORE_GLOBAL, TypeTable::VOID, {input}, globalIndex(target->getBinding()));
+        }
+      }
+      break;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : node->getChildren()) {
+        emit(SSAOp::PRINT, TypeTable::VOID, {this->value(value)});
+      }
+      break;
+    case ASTNodeType::BREAK:
+      jump(breakTargets_.back());
+      break;
+    case ASTNodeType::CONTINUE:
+      jump(continueTargets_.back());
+      break;
+    default: // expression statement
+      effect(node);
+      break;
+  }
+}
+
+void SSABuilder::declaration(const ASTNodePtr& node) {
+  const TypeId type = node->getTypeId();
+  const auto& children = node->getChildren();
+  const uint32_t local = locals_ && locals_->arrays.contains(node.get()) ? LOCAL_ARRAY : 0;
+
+  SSAValue initial;
+  if (children[0]) {
+    initial = convertedValue(children[0], type);
+  } else if (children.size() > 1) { // sized array
+    std::vector<SSAValue> sizes;
+    for (size_t i = 1; i < children.size(); ++i) {
+      sizes.push_back(value(children[i]));
+    }
+    const ValueKind leaf = sizes.size() < types_.rank(type) ? ValueKind::ARRAY : valueKind(types_.scalar(type));
+    initial = emit(SSAOp::NEW_ARRAY, type, std::move(sizes), static_cast<int64_t>(static_cast<uint32_t>(leaf) | local));
+  } else if (local) {
+    initial = emit(SSAOp::NEW_ARRAY, type, {},
+      static_cast<int64_t>(static_cast<uint32_t>(valueKind(types_.get(type).element)) | local));
+  } else {
+    initial = zeroValue(type);
+  }
+
+  // the initializer cannot see the variable, so it is defined only now
+  if (!isLocal(node->getBinding())) {
+    emit(SSAOp::STORE_GLOBAL, TypeTable::VOID, {initial}, globalIndex(node->getBinding()));
+    return;
+  }
+  if (function_->values[initial].op != SSAOp::CONSTANT && function_->names[initial].empty()) {
+    function_->names[initial] = node->getValue();
+  }
+  variableTypes_[node->getBinding()] = type;
+  writeVariable(node->getBinding(), current_, initial);
+}
+
+void SSABuilder::assignment(const ASTNodePtr& node) {
+  const ASTNodePtr& target = node->getChild(0);
+  const ASTNodePtr& value = node->getChild(1);
+
+  if (target->getType() == ASTNodeType::IDENTIFIER) {
+    const SSAValue assigned = convertedValue(value, target->getTypeId());
+    if (!isLocal(target->getBinding())) {
+      emit(SSAOp::STORE_GLOBAL, TypeTable::VOID, {assigned}, globalIndex(target->getBinding()));
+      return;
+    }
+    if (function_->values[assigned].op != SSAOp::CONSTANT && function_->names[assigned].empty()) {
+      function_->names[assigned] = target->getValue();
+    }
+    writeVariable(target->getBinding(), current_, assigned);
+    return;
+  }
+
+  // element store: the array and index first, then the value
+  const SSAValue array = this->value(target->getChild(0));
+  const SSAValue index = this->value(target->getChild(1));
+  const bool proven = inBounds_ && inBounds_->contains(target.get());
+  emit(SSAOp::STORE_INDEX, TypeTable::VOID, {array, index, convertedValue(value, target->getTypeId())}, proven);
+}
+
+// The body comes first and the test after it, so each iteration takes one conditional
+// branch; the test block is entered by a jump from before the loop
+void SSABuilder::loop(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const bool isWhile = node->getTokenType() == my::TokenType::WHILE;
+  if (!isWhile) {
+    statement(children[0]);
+  }
+
+  const uint32_t test = newBlock();
+  const uint32_t body = newBlock();
+  const uint32_t end = newBlock();
+  const uint32_t next = isWhile ? test : newBlock(); // `continue` runs the step of `for`
+  line_ = node->getLine();
+  jump(test);
+
+  enter(body);
+  breakTargets_.push_back(end);
+  continueTargets_.push_back(next);
+  statement(children[isWhile ? 1 : 3]);
+  breakTargets_.pop_back();
+  continueTargets_.pop_back();
+  if (!isWhile) {
+    if (current_ != NONE) {
+      jump(next);
+    }
+    sealBlock(next);
+    reach(next);
+    statement(children[2]);
+  }
+  if (current_ != NONE) {
+    line_ = node->getLine();
+    jump(test);
+  }
+
+  sealBlock(test);
+  reach(test);
+  line_ = node->getLine();
+  condition(children[isWhile ? 0 : 1], body, end);
+  sealBlock(body);
+  sealBlock(end);
+  reach(end);
+}
+
+// The subject is evaluated once and compared with the labels in source order; the
+// arms follow, each one ending with the `break` the parser consumed
+void SSABuilder::switchStatement(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const SSAValue subject = value(children[0]);
+  std::vector<uint32_t> arms(children.size() - 1);
+  for (uint32_t& arm : arms) {
+    arm = newBlock();
+  }
+  const uint32_t end = newBlock();
+
+  uint32_t fallback = end;
+  for (size_t i = 1; i < children.size(); ++i) {
+    const ASTNodePtr& arm = children[i];
+    if (arm->getTokenType() != my::TokenType::CASE) {
+      fallback = arms[i - 1];
+      continue;
+    }
+    line_ = arm->getLine();
+    const SSAValue equal = emit(SSAOp::EQ, TypeTable::BOOL, {subject, value(arm->getChild(0))});
+    const uint32_t next = newBlock();
+    branch(equal, arms[i - 1], next);
+    sealBlock(next);
+    reach(next);
+  }
+  jump(fallback);
+
+  breakTargets_.push_back(end);
+  for (size_t i = 1; i < children.size(); ++i) {
+    const auto& instructions = children[i]->getChildren();
+    sealBlock(arms[i - 1]);
+    reach(arms[i - 1]);
+    line_ = children[i]->getLine();
+    const size_t first = children[i]->getTokenType() == my::TokenType::CASE ? 1 : 0;
+    for (size_t j = first; j < instructions.size(); ++j) {
+      statement(instructions[j]);
+    }
+    if (current_ != NONE) {
+      jump(end);
+    }
+  }
+  breakTargets_.pop_back();
+  sealBlock(end);
+  reach(end);
+}
+
+
+void SSABuilder::condition(const ASTNodePtr& node, const uint32_t whenTrue, const uint32_t whenFalse) {
+  const my::TokenType op = node->getType() == ASTNodeType::EXPRESSION ? node->getTokenType() : my::TokenType::UNKNOWN;
+  const auto& children = node->getChildren();
+  if (op == my::TokenType::NOT && children.size() == 1) {
+    condition(children[0], whenFalse, whenTrue);
+  } else if (op == my::TokenType::AND || op == my::TokenType::OR) {
+    // the right operand runs only when the left one does not decide
+    const uint32_t right = newBlock();
+    if (op == my::TokenType::AND) {
+      condition(children[0], right, whenFalse);
+    } else {
+      condition(children[0], whenTrue, right);
+    }
+    sealBlock(right);
+    reach(right);
+    condition(children[1], whenTrue, whenFalse);
+  } else {
+    branch(value(node), whenTrue, whenFalse);
+  }
+}
+
+SSAValue SSABuilder::value(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL:
+      return literal(node);
+    case ASTNodeType::IDENTIFIER:
+      if (isLocal(node->getBinding())) {
+        return readVariable(node->getBinding(), current_);
+      }
+      return emit(SSAOp::LOAD_GLOBAL, node->getTypeId(), {}, globalIndex(node->getBinding()));
+    case ASTNodeType::INDEX: {
+      const SSAValue array = value(node->getChild(0));
+      const SSAValue index = value(node->getChild(1));
+      const bool proven = inBounds_ && inBounds_->contains(node.get());
+      return emit(SSAOp::LOAD_INDEX, node->getTypeId(), {array, index}, proven);
+    }
+    case ASTNodeType::CALL:
+      return call(node);
+    case ASTNodeType::EXPRESSION:
+      return operatorValue(node);
+    default:
+      throw std::runtime_error("Code generation error: instruction used as an expression.");
+  }
+}
+
+SSAValue SSABuilder::convertedValue(const ASTNodePtr& node, const TypeId type) {
+  const SSAValue result = value(node);
+  if (const std::optional<SSAOp> convert = conversion(type, node->getTypeId())) {
+    return emit(*convert, type, {result});
+  }
+  return result;
+}
+
+SSAValue SSABuilder::operatorValue(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const my::TokenType op = node->getTokenType();
+
+  if (children.size() == 1) {
+    return emit(op == my::TokenType::NOT ? SSAOp::NOT : SSAOp::NEG, node->getTypeId(), {value(children[0])});
+  }
+
+  SSAOp instruction;
+  switch (op) {
+    case my::TokenType::COMMA:
+      effect(children[0]);
+      return value(children[1]);
+    case my::TokenType::AND:
+    case my::TokenType::OR:
+      return logicalValue(node);
+    case my::TokenType::PLUS:
+      instruction = SSAOp::ADD;
+      break;
+    case my::TokenType::MINUS:
+      instruction = SSAOp::SUB;
+      break;
+    case my::TokenType::MUL:
+      instruction = SSAOp::MUL;
+      break;
+    case my::TokenType::DIV:
+      instruction = SSAOp::DIV;
+      break;
+    case my::TokenType::LT:
+      instruction = SSAOp::LT;
+      break;
+    case my::TokenType::GT:
+      instruction = SSAOp::GT;
+      break;
+    case my::TokenType::EQ:
+      instruction = SSAOp::EQ;
+      break;
+    case my::TokenType::NEQ:
+      instruction = SSAOp::NEQ;
+      break;
+    default:
+      throw std::runtime_error("Code generation error: unknown operator " + node->getValue() + ".");
+  }
+  const SSAValue left = value(children[0]);
+  const SSAValue right = value(children[1]);
+  return emit(instruction, node->getTypeId(), {left, right});
+}
+
+SSAValue SSABuilder::logicalValue(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const uint32_t result = synthetic_++;
+  variableTypes_[result] = TypeTable::BOOL;
+
+  writeVariable(result, current_, convertedValue(children[0], TypeTable::BOOL));
+  const uint32_t right = newBlock();
+  const uint32_t end = newBlock();
+  if (node->getTokenType() == my::TokenType::AND) {
+    branch(readVariable(result, current_), right, end);
+  } else {
+    branch(readVariable(result, current_), end, right);
+  }
+  sealBlock(right);
+  reach(right);
+  writeVariable(result, current_, convertedValue(children[1], TypeTable::BOOL));
+  jump(end);
+  sealBlock(end);
+  reach(end);
+  return readVariable(result, current_);
+}
+
+SSAValue SSABuilder::call(const ASTNodePtr& node) {
+  const TypeInfo& signature = types_.get(tid_.getRecord(node->getBinding()).type);
+  const auto& arguments = node->getChildren();
+  std::vector<SSAValue> operands;
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    operands.push_back(convertedValue(arguments[i], signature.parameters[i]));
+  }
+  const uint32_t function = functionByBinding_.at(node->getBinding());
+  return emit(SSAOp::CALL, program_.functions[function].returnType, std::move(operands), function);
+}
+
+SSAValue SSABuilder::literal(const ASTNodePtr& node) {
+  const std::string& lexeme = node->getValue();
+  switch (node->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL:
+      return constant(TypeTable::INT, decodeIntegerLiteral(lexeme));
+    case my::TokenType::FLOAT_LITERAL: {
+      const double value = decodeFloatLiteral(lexeme);
+      int64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return constant(TypeTable::FLOAT, bits);
+    }
+    case my::TokenType::CHAR_LITERAL:
+      return constant(TypeTable::CHAR, static_cast<uint8_t>(decodeCharLiteral(lexeme)));
+    case my::TokenType::STRING_LITERAL:
+      return constant(TypeTable::STRING, addString(decodeStringLiteral(lexeme)));
+    default: // true / false
+      return constant(TypeTable::BOOL, lexeme == "true" ? 1 : 0);
+  }
+}
+
+SSAValue SSABuilder::zeroValue(const TypeId type) {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+    case TypeKind::FLOAT: // +0.0 is all zero bits
+    case TypeKind::CHAR:
+    case TypeKind::BOOL:
+      return constant(type, 0);
+    case TypeKind::STRING:
+      return constant(type, addString(""));
+    case TypeKind::ARRAY: // a new array every time: arrays are mutable
+      return emit(SSAOp::NEW_ARRAY, type, {}, static_cast<int64_t>(valueKind(types_.get(type).element)));
+    default:
+      throw std::runtime_error("Code generation error: no value of type '" + types_.toString(type) + "'.");
+  }
+}
+
+void SSABuilder::effect(const ASTNodePtr& node) {
+  if (node->getType() == ASTNodeType::EXPRESSION && node->getTokenType() == my::TokenType::COMMA &&
+    node->getChildren().size() == 2) {
+    effect(node->getChild(0));
+    effect(node->getChild(1));
+  } else {
+    value(node); // still evaluated: it may fail at run time
+  }
+}
+
+
+void SSABuilder::writeVariable(const uint32_t variable, const uint32_t block, const SSAValue value) {
+  definitions_[block][variable] = value;
+}
+
+SSAValue SSABuilder::readVariable(const uint32_t variable, const uint32_t block) {
+  if (const auto definition = definitions_[block].find(variable); definition != definitions_[block].end()) {
+    return resolve(definition->second);
+  }
+  return readVariableRecursive(variable, block);
+}
+
+SSAValue SSABuilder::readVariableRecursive(const uint32_t variable, const uint32_t block) {
+  const TypeId type = variableTypes_.at(variable);
+  const auto& predecessors = function_->blocks[block].predecessors;
+  const auto newPhi = [&] {
+    const SSAValue phi = function_->add(SSAOp::PHI, type, block, line_, {});
+    if (variable < SYNTHETIC) {
+      function_->names[phi] = tid_.getInterner().getName(tid_.getRecord(variable).symbol);
+    }
+    phis_[block].push_back(phi);
+    return phi;
+  };
+  SSAValue result;
+  if (!sealed_[block]) { // completed when the block is sealed
+    result = newPhi();
+    incompletePhis_[block].emplace_back(variable, result);
+  } else if (predecessors.size() == 1) {
+    result = readVariable(variable, predecessors[0]);
+  } else if (predecessors.empty()) { // the entry: read before any assignment
+    result = constant(type, 0, SSAOp::UNDEF);
+  } else {
+    // the phi is the variable's value here while the predecessors are asked (loops)
+    result = newPhi();
+    writeVariable(variable, block, result);
+    result = addPhiOperands(variable, result);
+  }
+  writeVariable(variable, block, result);
+  return result;
+}
+
+SSAValue SSABuilder::addPhiOperands(const uint32_t variable, const SSAValue phi) {
+  const uint32_t block = function_->values[phi].block;
+  std::vector<SSAValue> operands;
+  for (size_t i = 0; i < function_->blocks[block].predecessors.size(); ++i) {
+    operands.push_back(readVariable(variable, function_->blocks[block].predecessors[i]));
+  }
+
+  SSAInstruction& instruction = function_->values[phi];
+  instruction.firstOperand = static_cast<uint32_t>(function_->operands.size());
+  instruction.operandCount = static_cast<uint32_t>(operands.size());
+  function_->operands.insert(function_->operands.end(), operands.begin(), operands.end());
+  for (const SSAValue operand : operands) {
+    if (function_->values[operand].op == SSAOp::PHI) {
+      phiUsers_[operand].push_back(phi);
+    }
+  }
+  return tryRemoveTrivialPhi(phi);
+}
+
+SSAValue SSABuilder::tryRemoveTrivialPhi(const SSAValue phi) {
+  SSAValue same = NONE;
+  for (const SSAValue operand : function_->operandsOf(phi)) {
+    const SSAValue source = resolve(operand);
+    if (source == same || source == phi) {
+      continue;
+    }
+    if (same != NONE) {
+      return phi; // merges at least two values
+    }
+    same = source;
+  }
+  if (same == NONE) { // unreachable, or read before any assignment
+    same = constant(function_->values[phi].type, 0, SSAOp::UNDEF);
+  }
+  replaced_[phi] = same;
+
+  // the phis that used this one may have become trivial
+  std::vector<SSAValue> users;
+  if (const auto found = phiUsers_.find(phi); found != phiUsers_.end()) {
+    users = std::move(found->second);
+    phiUsers_.erase(found);
+  }
+  if (function_->values[same].op == SSAOp::PHI) {
+    auto& inherited = phiUsers_[same];
+    inherited.insert(inherited.end(), users.begin(), users.end());
+  }
+  for (const SSAValue user : users) {
+    if (user != phi && !replaced_.contains(user)) {
+      tryRemoveTrivialPhi(user);
+    }
+  }
+  return resolve(same);
+}
+
+void SSABuilder::sealBlock(const uint32_t block) {
+  for (size_t i = 0; i < incompletePhis_[block].size(); ++i) {
+    const auto [variable, phi] = incompletePhis_[block][i];
+    addPhiOperands(variable, phi);
+  }
+  incompletePhis_[block].clear();
+  sealed_[block] = true;
+}
+
+SSAValue SSABuilder::resolve(SSAValue value) const {
+  for (auto found = replaced_.find(value); found != replaced_.end(); found = replaced_.find(value)) {
+    value = found->second;
+  }
+  return value;
+}
+
+bool SSABuilder::isLocal(const uint32_t binding) const {
+  return tid_.getRecord(binding).scope != GLOBAL_SCOPE;
+}
+
+
+uint32_t SSABuilder::newBlock() {
+  function_->blocks.emplace_back();
+  phis_.emplace_back();
+  definitions_.emplace_back();
+  sealed_.push_back(false);
+  incompletePhis_.emplace_back();
+  return static_cast<uint32_t>(function_->blocks.size() - 1);
+}
+
+void SSABuilder::addEdge(const uint32_t from, const uint32_t to) {
+  function_->blocks[from].successors.push_back(to);
+  function_->blocks[to].predecessors.push_back(from);
+}
+
+void SSABuilder::enter(const uint32_t block) {
+  current_ = block;
+  layout_.push_back(block);
+}
+
+void SSABuilder::reach(const uint32_t block) {
+  if (function_->blocks[block].predecessors.empty()) {
+    current_ = NONE;
+  } else {
+    enter(block);
+  }
+}
+
+SSAValue SSABuilder::emit(const SSAOp op, const TypeId type, std::vector<SSAValue> operands, const int64_t immediate) {
+  const SSAValue value = function_->add(op, type, current_, line_, operands, immediate);
+  function_->blocks[current_].instructions.push_back(value);
+  if (isTerminator(op)) {
+    current_ = NONE;
+  }
+  return value;
+}
+
+void SSABuilder::jump(const uint32_t target) {
+  const uint32_t from = current_;
+  emit(SSAOp::JUMP, TypeTable::VOID, {});
+  addEdge(from, target);
+}
+
+void SSABuilder::branch(const SSAValue condition, const uint32_t whenTrue, const uint32_t whenFalse) {
+  const uint32_t from = current_;
+  emit(SSAOp::BRANCH, TypeTable::VOID, {condition});
+  addEdge(from, whenTrue);
+  addEdge(from, whenFalse);
+}
+
+SSAValue SSABuilder::constant(const TypeId type, const int64_t immediate, const SSAOp op) {
+  const auto [entry, inserted] = constants_.try_emplace({op, type, immediate}, 0);
+  if (inserted) {
+    entry->second = function_->add(op, type, 0, line_, {}, immediate);
+    entryValues_.push_back(entry->second);
+  }
+  return entry->second;
+}
+
+
+std::optional<SSAOp> SSABuilder::conversion(const TypeId target, const TypeId source) {
+  if (target == source || !TypeTable::isScalar(target)) {
+    return std::nullopt;
+  }
+  switch (target) {
+    case TypeTable::INT:
+      return SSAOp::TO_INT;
+    case TypeTable::FLOAT:
+      return SSAOp::TO_FLOAT;
+    case TypeTable::CHAR:
+      return SSAOp::TO_CHAR;
+    default:
+      return SSAOp::TO_BOOL;
+  }
+}
+
+ValueKind SSABuilder::valueKind(const TypeId type) const {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      return ValueKind::INT;
+    case TypeKind::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeKind::CHAR:
+      return ValueKind::CHAR;
+    case TypeKind::BOOL:
+      return ValueKind::BOOL;
+    case TypeKind::STRING:
+      return ValueKind::STRING;
+    case TypeKind::ARRAY:
+      return ValueKind::ARRAY;
+    default:
+      return ValueKind::VOID;
+  }
+}
+
+uint32_t SSABuilder::globalIndex(const uint32_t binding) {
+  const auto [global, inserted] = globalByBinding_.try_emplace(binding, program_.globals);
+  if (inserted) {
+    ++program_.globals;
+    program_.globalNames.push_back(tid_.getInterner().getName(tid_.getRecord(binding).symbol));
+  }
+  return global->second;
+}
+
+uint32_t SSABuilder::addString(const std::string& value) {
+  const auto [entry, inserted] = stringIndex_.try_emplace(value, static_cast<uint32_t>(program_.strings.size()));
+  if (inserted) {
+    program_.strings.push_back(value);
+  }
+  return entry->second;
+}
@@ -0,0 +1,253 @@
+#include "../headers/ssa-inliner.h"
+
+#include <functional>
+
+
+void SSAInliner::run(SSAProgram& program) {
+  statistics_ = InliningStatistics();
+  std::vector<bool> recursive;
+  const std::vector<uint32_t> order = bottomUp(program, recursive);
+  statistics_.recursive = static_cast<size_t>(std::count(recursive.begin(), recursive.end(), true));
+
+  std::vector<size_t> sites(program.functions.size(), 0);
+  for (const SSAFunction& function : program.functions) {
+    for (const SSAInstruction& instruction : function.values) {
+      if (instruction.op == SSAOp::CALL) {
+        ++sites[static_cast<size_t>(instruction.immediate)];
+      }
+    }
+  }
+
+  std::vector<bool> inlined(program.functions.size(), false);
+  for (const uint32_t index : order) {
+    SSAFunction& caller = program.functions[index];
+    std::vector<bool> inLoop(caller.blocks.size(), false);
+    for (const SSALoop& loop : findLoops(caller)) {
+      for (const uint32_t block : loop.blocks) {
+        inLoop[block] = true;
+      }
+    }
+    std::vector<std::pair<SSAValue, bool>> calls; // (call, inside a loop)
+    for (const SSABlock& block : caller.blocks) {
+      for (const SSAValue value : block.instructions) {
+        if (caller.values[value].op == SSAOp::CALL) {
+          calls.emplace_back(value, inLoop[caller.values[value].block]);
+        }
+      }
+    }
+
+    std::vector<uint32_t> layout(caller.blocks.size());
+    std::iota(layout.begin(), layout.end(), 0);
+    size_t callerSize = size(caller);
+    bool changed = false;
+    for (const auto& [call, loop] : calls) {
+      const auto target = static_cast<uint32_t>(caller.values[call].immediate);
+      if (target == index || recursive[target]) {
+        continue;
+      }
+      const SSAFunction& callee = program.functions[target];
+      const size_t calleeSize = size(callee);
+      const bool worth = calleeSize <= TINY || (loop && calleeSize <= SMALL) ||
+        (sites[target] == 1 && calleeSize <= SINGLE_CALL);
+      if (!worth || callerSize + calleeSize > CALLER_LIMIT) {
+        continue;
+      }
+      inlineCall(caller, call, callee, loop, layout);
+      callerSize += calleeSize;
+      changed = true;
+      ++statistics_.calls;
+      if (!inlined[target]) {
+        inlined[target] = true;
+        ++statistics_.functions;
+      }
+    }
+    if (changed) {
+      compact(caller, layout);
+    }
+  }
+}
+
+size_t SSAInliner::size(const SSAFunction& function) {
+  size_t count = 0;
+  for (const SSABlock& block : function.blocks) {
+    for (const SSAValue value : block.instructions) {
+      switch (function.values[value].op) {
+        case SSAOp::PARAMETER:
+        case SSAOp::CONSTANT:
+        case SSAOp::UNDEF:
+        case SSAOp::PHI:
+        case SSAOp::JUMP:
+          break;
+        default:
+          ++count;
+          break;
+      }
+    }
+  }
+  return count;
+}
+
+std::vector<uint32_t> SSAInliner::bottomUp(const SSAProgram& program, std::vector<bool>& recursive) {
+  const size_t count = program.functions.size();
+  std::vector<std::vector<uint32_t>> callees(count);
+  for (uint32_t function = 0; function < count; ++function) {
+    for (const SSAInstruction& instruction : program.functions[function].values) {
+      if (instruction.op == SSAOp::CALL) {
+        callees[function].push_back(static_cast<uint32_t>(instruction.immediate));
+      }
+    }
+  }
+
+  // Tarjan: a component is complete only after every component it calls
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> number(count, NONE);
+  std::vector<uint32_t> low(count, 0);
+  std::vector<bool> onStack(count, false);
+  std::vector<uint32_t> stack;
+  uint32_t next = 0;
+  recursive.assign(count, false);
+  const std::function<void(uint32_t)> visit = [&](const uint32_t function) {
+    number[function] = low[function] = next++;
+    stack.push_back(function);
+    onStack[function] = true;
+    for (const uint32_t callee : callees[function]) {
+      if (number[callee] == NONE) {
+        visit(callee);
+        low[function] = std::min(low[function], low[callee]);
+      } else if (onStack[callee]) {
+        low[function] = std::min(low[function], number[callee]);
+      }
+      if (callee == function) {
+        recursive[function] = true;
+      }
+    }
+    if (low[function] != number[function]) {
+      return;
+    }
+    const size_t first = std::find(stack.begin(), stack.end(), function) - stack.begin();
+    for (size_t i = first; i < stack.size(); ++i) {
+      onStack[stack[i]] = false;
+      order.push_back(stack[i]);
+      if (stack.size() - first > 1) {
+        recursive[stack[i]] = true;
+      }
+    }
+    stack.resize(first);
+  };
+  for (uint32_t function = 0; function < count; ++function) {
+    if (number[function] == NONE) {
+      visit(function);
+    }
+  }
+  return order;
+}
+
+void SSAInliner::inlineCall(SSAFunction& caller, const SSAValue call, const SSAFunction& callee, const bool inLoop,
+  std::vector<uint32_t>& layout) {
+  const SSAInstruction instruction = caller.values[call];
+  const uint32_t block = instruction.block;
+  caller.localStrings = caller.localStrings && callee.localStrings && !inLoop;
+  const std::vector<SSAValue> arguments(caller.operandsOf(call).begin(), caller.operandsOf(call).end());
+
+  // the join point takes what follows the call, and the block's successors
+  const auto join = static_cast<uint32_t>(caller.blocks.size());
+  caller.blocks.emplace_back();
+  {
+    auto& instructions = caller.blocks[block].instructions;
+    const auto position = std::find(instructions.begin(), instructions.end(), call);
+    caller.blocks[join].instructions.assign(position + 1, instructions.end());
+    instructions.erase(position, instructions.end());
+  }
+  for (const SSAValue value : caller.blocks[join].instructions) {
+    caller.values[value].block = join;
+  }
+  caller.blocks[join].successors = std::move(caller.blocks[block].successors);
+  caller.blocks[block].successors.clear();
+  for (const uint32_t successor : caller.blocks[join].successors) {
+    auto& predecessors = caller.blocks[successor].predecessors;
+    std::replace(predecessors.begin(), predecessors.end(), block, join);
+  }
+
+  // the callee's blocks and values, parameters replaced by the arguments
+  const auto first = static_cast<uint32_t>(caller.blocks.size());
+  caller.blocks.resize(first + callee.blocks.size());
+  std::vector<SSAValue> valueId(callee.values.size(), NONE);
+  std::vector<std::pair<uint32_t, SSAValue>> returns; // (block, value or NONE)
+  for (uint32_t source = 0; source < callee.blocks.size(); ++source) {
+    const uint32_t target = first + source;
+    SSABlock& copy = caller.blocks[target];
+    for (const uint32_t predecessor : callee.blocks[source].predecessors) {
+      copy.predecessors.push_back(first + predecessor);
+    }
+    for (const uint32_t successor : callee.blocks[source].successors) {
+      copy.successors.push_back(first + successor);
+    }
+    for (const SSAValue value : callee.blocks[source].instructions) {
+      const SSAInstruction& original = callee.values[value];
+      switch (original.op) {
+        case SSAOp::PARAMETER:
+          valueId[value] = arguments[static_cast<size_t>(original.immediate)];
+          continue;
+        case SSAOp::RETURN:
+        case SSAOp::RETURN_VOID:
+          returns.emplace_back(target, original.op == SSAOp::RETURN ? callee.operandsOf(value)[0] : NONE);
+          copy.instructions.push_back(caller.add(SSAOp::JUMP, TypeTable::VOID, target, original.line, {}));
+          copy.successors.push_back(join);
+          continue;
+        default:
+          break;
+      }
+      const auto operands = callee.operandsOf(value);
+      int64_t immediate = original.immediate;
+      if (original.op == SSAOp::NEW_ARRAY && inLoop) {
+        immediate &= ~static_cast<int64_t>(LOCAL_ARRAY);
+      }
+      valueId[value] = caller.add(original.op, original.type, target, original.line, operands, immediate);
+      caller.names[valueId[value]] = callee.names[value];
+      copy.instructions.push_back(valueId[value]);
+    }
+  }
+  for (SSAValue value = 0; value < callee.values.size(); ++value) {
+    if (valueId[value] != NONE && callee.values[value].op != SSAOp::PARAMETER) {
+      for (SSAValue& operand : caller.operandsOf(valueId[value])) {
+        operand = valueId[operand];
+      }
+    }
+  }
+
+  // into the callee's entry, out of its returns
+  caller.blocks[block].instructions.push_back(caller.add(SSAOp::JUMP, TypeTable::VOID, block, instruction.line, {}));
+  caller.blocks[block].successors.push_back(first);
+  caller.blocks[first].predecessors.push_back(block);
+  std::vector<SSAValue> results;
+  for (const auto& [from, value] : returns) {
+    caller.blocks[join].predecessors.push_back(from);
+    if (value != NONE) {
+      results.push_back(valueId[value]);
+    }
+  }
+
+  SSAValue result = NONE;
+  if (instruction.type != TypeTable::VOID) {
+    if (results.size() == 1) {
+      result = results[0];
+    } else {
+      // no returns leave the join point unreachable, and with it every use of the call
+      result = caller.add(results.empty() ? SSAOp::UNDEF : SSAOp::PHI, instruction.type, join, instruction.line,
+        results);
+      auto& instructions = caller.blocks[join].instructions;
+      instructions.insert(instructions.begin(), result);
+    }
+    for (SSAValue& operand : caller.operands) {
+      if (operand == call) {
+        operand = result;
+      }
+    }
+  }
+
+  const auto position = std::find(layout.begin(), layout.end(), block) + 1;
+  std::vector<uint32_t> added(callee.blocks.size() + 1);
+  std::iota(added.begin(), added.end() - 1, first);
+  added.back() = join;
+  layout.insert(position, added.begin(), added.end());
+}
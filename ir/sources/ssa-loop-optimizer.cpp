@@ -0,0 +1,266 @@
+#include "../headers/ssa-loop-optimizer.h"
+
+
+void SSALoopOptimizer::run(SSAProgram& program) {
+  statistics_ = LoopStatistics();
+  for (SSAFunction& function : program.functions) {
+    function_ = &function;
+    layout_.resize(function.blocks.size());
+    std::iota(layout_.begin(), layout_.end(), 0);
+    std::vector<uint32_t> done; // headers of the loops optimized
+    while (true) {
+      // a loop has fewer blocks than the loops around it, so the smallest one left goes first
+      const std::vector<SSALoop> loops = findLoops(function);
+      const auto next = std::find_if(loops.rbegin(), loops.rend(), [&](const SSALoop& loop) {
+        return std::find(done.begin(), done.end(), loop.header) == done.end();
+      });
+      if (next == loops.rend()) {
+        break;
+      }
+      done.push_back(next->header);
+      ++statistics_.loops;
+      inLoop_.assign(function.blocks.size(), false);
+      for (const uint32_t block : next->blocks) {
+        inLoop_[block] = true;
+      }
+      const uint32_t entry = preheader(next->header);
+      if (entry == UINT32_MAX) {
+        continue;
+      }
+      inLoop_.resize(function.blocks.size(), false);
+      hoistInvariants(*next, entry);
+      reduceStrength(*next, entry);
+    }
+    if (!done.empty()) {
+      compact(function, layout_);
+    }
+  }
+  function_ = nullptr;
+}
+
+
+uint32_t SSALoopOptimizer::preheader(const uint32_t header) {
+  SSAFunction& function = *function_;
+  std::vector<size_t> outside; // indices of the predecessors entering the loop
+  for (size_t i = 0; i < function.blocks[header].predecessors.size(); ++i) {
+    if (!inLoop_[function.blocks[header].predecessors[i]]) {
+      outside.push_back(i);
+    }
+  }
+  if (outside.empty()) {
+    return UINT32_MAX;
+  }
+  if (outside.size() == 1) {
+    const uint32_t predecessor = function.blocks[header].predecessors[outside[0]];
+    if (function.blocks[predecessor].successors.size() == 1) {
+      return predecessor;
+    }
+  }
+
+  const auto entry = static_cast<uint32_t>(function.blocks.size());
+  function.blocks.emplace_back();
+  SSABlock& loop = function.blocks[header];
+  const uint32_t line = function.values[loop.instructions.front()].line;
+  // the header's phis take what enters the loop from the preheader, merged there by a phi
+  for (const SSAValue phi : loop.instructions) {
+    if (function.values[phi].op != SSAOp::PHI) {
+      break;
+    }
+    std::vector<SSAValue> inside;
+    std::vector<SSAValue> entering;
+    const auto operands = function.operandsOf(phi);
+    for (size_t i = 0; i < operands.size(); ++i) {
+      (inLoop_[loop.predecessors[i]] ? inside : entering).push_back(operands[i]);
+    }
+    SSAValue merged = entering[0];
+    if (entering.size() > 1) {
+      merged = function.add(SSAOp::PHI, function.values[phi].type, entry, function.values[phi].line, entering);
+      function.blocks[entry].instructions.push_back(merged);
+    }
+    inside.push_back(merged);
+    setOperands(phi, inside);
+  }
+  function.blocks[entry].instructions.push_back(function.add(SSAOp::JUMP, TypeTable::VOID, entry, line, {}));
+
+  std::vector<uint32_t> predecessors;
+  for (const uint32_t predecessor : loop.predecessors) {
+    (inLoop_[predecessor] ? predecessors : function.blocks[entry].predecessors).push_back(predecessor);
+  }
+  predecessors.push_back(entry);
+  loop.predecessors = std::move(predecessors);
+  for (const uint32_t predecessor : function.blocks[entry].predecessors) {
+    auto& successors = function.blocks[predecessor].successors;
+    std::replace(successors.begin(), successors.end(), header, entry);
+  }
+  function.blocks[entry].successors = {header};
+  layout_.insert(std::find(layout_.begin(), layout_.end(), header), entry);
+  ++statistics_.preheaders;
+  return entry;
+}
+
+
+void SSALoopOptimizer::hoistInvariants(const SSALoop& loop, const uint32_t preheader) {
+  SSAFunction& function = *function_;
+  // a value moved out makes the values computed from it invariant: repeat until none moves
+  bool moved = true;
+  while (moved) {
+    moved = false;
+    for (const uint32_t block : loop.blocks) {
+      std::erase_if(function.blocks[block].instructions, [&](const SSAValue value) {
+        const SSAInstruction& instruction = function.values[value];
+        if (instruction.op == SSAOp::PHI || instruction.op == SSAOp::CONSTANT || instruction.op == SSAOp::UNDEF ||
+          !isPure(instruction.op, instruction.type)) {
+          return false;
+        }
+        const auto operands = function.operandsOf(value);
+        if (!std::all_of(operands.begin(), operands.end(), [&](const SSAValue operand) { return isInvariant(operand); })) {
+          return false;
+        }
+        function.values[value].block = preheader;
+        insertBeforeTerminator(preheader, value);
+        ++statistics_.hoisted;
+        moved = true;
+        return true;
+      });
+    }
+  }
+}
+
+
+void SSALoopOptimizer::reduceStrength(const SSALoop& loop, const uint32_t preheader) {
+  SSAFunction& function = *function_;
+  const std::vector<uint32_t>& predecessors = function.blocks[loop.header].predecessors;
+  const auto entering = static_cast<size_t>(
+    std::find(predecessors.begin(), predecessors.end(), preheader) - predecessors.begin());
+
+  // basic induction variables: phi = [init, next..] with next = phi + step or phi - step
+  struct Induction {
+    SSAValue phi;
+    SSAValue init;
+    SSAValue next;
+    SSAValue step;
+    SSAOp op;
+  };
+  std::vector<Induction> inductions;
+  for (const SSAValue phi : function.blocks[loop.header].instructions) {
+    if (function.values[phi].op != SSAOp::PHI) {
+      break;
+    }
+    if (function.values[phi].type != TypeTable::INT) {
+      continue;
+    }
+    const auto operands = function.operandsOf(phi);
+    SSAValue next = UINT32_MAX;
+    bool single = true;
+    for (size_t i = 0; i < operands.size(); ++i) {
+      if (i != entering) {
+        single = single && (next == UINT32_MAX || next == operands[i]);
+        next = operands[i];
+      }
+    }
+    if (!single || next == UINT32_MAX || isInvariant(next)) {
+      continue;
+    }
+    const SSAInstruction& instruction = function.values[next];
+    const auto sides = function.operandsOf(next);
+    SSAValue step = UINT32_MAX;
+    if (instruction.op == SSAOp::ADD && sides[0] == phi && isInvariant(sides[1])) {
+      step = sides[1];
+    } else if (instruction.op == SSAOp::ADD && sides[1] == phi && isInvariant(sides[0])) {
+      step = sides[0];
+    } else if (instruction.op == SSAOp::SUB && sides[0] == phi && isInvariant(sides[1])) {
+      step = sides[1];
+    }
+    if (step != UINT32_MAX && function.values[step].type == TypeTable::INT) {
+      inductions.push_back({phi, operands[entering], next, step, instruction.op});
+    }
+  }
+  if (inductions.empty()) {
+    return;
+  }
+
+  // the products of one variable and one invariant factor
+  std::map<std::pair<size_t, SSAValue>, std::vector<SSAValue>> products;
+  for (const uint32_t block : loop.blocks) {
+    for (const SSAValue value : function.blocks[block].instructions) {
+      if (function.values[value].op != SSAOp::MUL || function.values[value].type != TypeTable::INT) {
+        continue;
+      }
+      const auto operands = function.operandsOf(value);
+      for (size_t side = 0; side < 2; ++side) {
+        const SSAValue factor = operands[1 - side];
+        const auto induction = std::find_if(inductions.begin(), inductions.end(), [&](const Induction& candidate) {
+          return candidate.phi == operands[side];
+        });
+        if (induction != inductions.end() && isInvariant(factor) && function.values[factor].type == TypeTable::INT) {
+          products[{static_cast<size_t>(induction - inductions.begin()), factor}].push_back(value);
+          break;
+        }
+      }
+    }
+  }
+
+  std::vector<SSAValue> replacement(function.values.size(), UINT32_MAX);
+  for (const auto& [key, multiplications] : products) {
+    const Induction& induction = inductions[key.first];
+    const SSAValue factor = key.second;
+    if (!(isConstant(induction.step) && isConstant(factor)) && multiplications.size() < 2) {
+      continue;
+    }
+    const uint32_t line = function.values[multiplications[0]].line;
+    const SSAValue start = function.add(SSAOp::MUL, TypeTable::INT, preheader, line,
+      std::vector<SSAValue>{induction.init, factor});
+    insertBeforeTerminator(preheader, start);
+    const SSAValue stride = function.add(SSAOp::MUL, TypeTable::INT, preheader, line,
+      std::vector<SSAValue>{induction.step, factor});
+    insertBeforeTerminator(preheader, stride);
+
+    const SSAValue phi = function.add(SSAOp::PHI, TypeTable::INT, loop.header, line, {});
+    auto& header = function.blocks[loop.header].instructions;
+    header.insert(header.begin(), phi);
+    const uint32_t block = function.values[induction.next].block;
+    const SSAValue stepped = function.add(induction.op, TypeTable::INT, block, line, std::vector<SSAValue>{phi, stride});
+    auto& instructions = function.blocks[block].instructions;
+    instructions.insert(std::find(instructions.begin(), instructions.end(), induction.next) + 1, stepped);
+    std::vector<SSAValue> operands(predecessors.size(), stepped);
+    operands[entering] = start;
+    setOperands(phi, operands);
+
+    for (const SSAValue multiplication : multiplications) {
+      replacement[multiplication] = phi;
+    }
+    statistics_.reduced += multiplications.size();
+  }
+
+  for (const uint32_t block : loop.blocks) {
+    std::erase_if(function.blocks[block].instructions, [&](const SSAValue value) {
+      return value < replacement.size() && replacement[value] != UINT32_MAX;
+    });
+  }
+  for (SSAValue& operand : function.operands) {
+    if (operand < replacement.size() && replacement[operand] != UINT32_MAX) {
+      operand = replacement[operand];
+    }
+  }
+}
+
+
+bool SSALoopOptimizer::isInvariant(const SSAValue value) const {
+  return !inLoop_[function_->values[value].block];
+}
+
+bool SSALoopOptimizer::isConstant(const SSAValue value) const {
+  return function_->values[value].op == SSAOp::CONSTANT;
+}
+
+void SSALoopOptimizer::insertBeforeTerminator(const uint32_t block, const SSAValue value) {
+  auto& instructions = function_->blocks[block].instructions;
+  instructions.insert(instructions.end() - 1, value);
+}
+
+void SSALoopOptimizer::setOperands(const SSAValue value, const std::vector<SSAValue>& operands) {
+  SSAInstruction& instruction = function_->values[value];
+  instruction.firstOperand = static_cast<uint32_t>(function_->operands.size());
+  instruction.operandCount = static_cast<uint32_t>(operands.size());
+  function_->operands.insert(function_->operands.end(), operands.begin(), operands.end());
+}
@@ -0,0 +1,1111 @@
+#include "../headers/ssa-lowering.h"
+
+
+// Operations that only name a value: nothing is computed where they stand
+static bool isFree(const SSAOp op) {
+  return op == SSAOp::PARAMETER || op == SSAOp::CONSTANT || op == SSAOp::UNDEF || op == SSAOp::PHI;
+}
+
+static bool isBinary(const SSAOp op) {
+  return op >= SSAOp::ADD && op <= SSAOp::NEQ && op != SSAOp::NEG && op != SSAOp::NOT;
+}
+
+
+void SSALowering::beginFunction(const SSAFunction& function) {
+  function_ = function;
+  const auto original = static_cast<uint32_t>(function_.blocks.size());
+  splitCriticalEdges(function_);
+
+  // a split edge is laid out right after the block it leaves
+  std::vector<std::vector<uint32_t>> splits(original);
+  for (uint32_t block = original; block < function_.blocks.size(); ++block) {
+    splits[function_.blocks[block].predecessors[0]].push_back(block);
+  }
+  layout_.clear();
+  for (uint32_t block = 0; block < original; ++block) {
+    layout_.push_back(block);
+    layout_.insert(layout_.end(), splits[block].begin(), splits[block].end());
+  }
+  countUses();
+}
+
+void SSALowering::countUses() {
+  uses_.assign(function_.values.size(), 0);
+  user_.assign(function_.values.size(), NONE);
+  for (const SSABlock& block : function_.blocks) {
+    for (const SSAValue value : block.instructions) {
+      for (const SSAValue operand : function_.operandsOf(value)) {
+        ++uses_[operand];
+        user_[operand] = value;
+      }
+    }
+  }
+}
+
+void SSALowering::coalescePhis(const std::vector<uint32_t>& computed) {
+  const size_t count = function_.values.size();
+  const size_t blocks = function_.blocks.size();
+  // phis and parameters are defined together at the top of their block
+  const auto at = [&](const SSAValue value) {
+    const SSAOp op = function_.values[value].op;
+    return op == SSAOp::PHI || op == SSAOp::PARAMETER ? 0 : computed[value] + 1;
+  };
+
+  // live-out values of every block; a phi reads its operand at the end of the predecessor
+  std::vector<BitVector> uses(blocks, BitVector(count));
+  std::vector<BitVector> definitions(blocks, BitVector(count));
+  std::vector<BitVector> phiReads(blocks, BitVector(count)); // by the phis of the successor
+  for (uint32_t block = 0; block < blocks; ++block) {
+    const SSABlock& current = function_.blocks[block];
+    for (const SSAValue value : current.instructions) {
+      definitions[block].set(value);
+      const auto operands = function_.operandsOf(value);
+      for (size_t i = 0; i < operands.size(); ++i) {
+        if (function_.values[value].op == SSAOp::PHI) {
+          phiReads[current.predecessors[i]].set(operands[i]);
+        } else if (function_.values[operands[i]].block != block) {
+          uses[block].set(operands[i]);
+        }
+      }
+    }
+  }
+  std::vector<BitVector> liveIn(blocks, BitVector(count));
+  std::vector<BitVector> liveOut(blocks, BitVector(count));
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = layout_.size(); i-- > 0;) {
+      const uint32_t block = layout_[i];
+      BitVector out = phiReads[block];
+      for (const uint32_t successor : function_.blocks[block].successors) {
+        out |= liveIn[successor];
+      }
+      liveOut[block] = std::move(out);
+      changed |= liveIn[block].assignTransfer(uses[block], liveOut[block], definitions[block]);
+    }
+  }
+
+  const std::vector<uint32_t> idom = dominators(function_);
+  const auto strictlyDominates = [&](const uint32_t dominator, uint32_t block) {
+    while (block != 0) {
+      block = idom[block];
+      if (block == dominator) {
+        return true;
+      }
+    }
+    return false;
+  };
+  // whether `value` is still to be read where `definition` is written
+  const auto liveAt = [&](const SSAValue value, const SSAValue definition) {
+    const uint32_t block = function_.values[definition].block;
+    const uint32_t home = function_.values[value].block;
+    if (home == block ? at(value) > at(definition) : !strictlyDominates(home, block)) {
+      return false;
+    }
+    if (liveOut[block].test(value)) {
+      return true;
+    }
+    for (const SSAValue later : function_.blocks[block].instructions) {
+      const auto operands = function_.operandsOf(later);
+      if (function_.values[later].op != SSAOp::PHI && at(later) > at(definition) &&
+        std::find(operands.begin(), operands.end(), value) != operands.end()) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // a phi joins the class of an operand none of whose values interferes with its own
+  congruence_.resize(count);
+  std::vector<std::vector<SSAValue>> members(count);
+  for (SSAValue value = 0; value < count; ++value) {
+    congruence_[value] = value;
+    members[value] = {value};
+  }
+  const auto hasParameter = [&](const SSAValue representative) {
+    return std::any_of(members[representative].begin(), members[representative].end(),
+      [&](const SSAValue value) { return function_.values[value].op == SSAOp::PARAMETER; });
+  };
+  for (const uint32_t block : layout_) {
+    for (const SSAValue phi : function_.blocks[block].instructions) {
+      if (function_.values[phi].op != SSAOp::PHI) {
+        break;
+      }
+      for (const SSAValue operand : function_.operandsOf(phi)) {
+        const SSAValue left = congruence_[phi];
+        const SSAValue right = congruence_[operand];
+        const SSAOp op = function_.values[operand].op;
+        if (left == right || op == SSAOp::CONSTANT || op == SSAOp::UNDEF ||
+          (hasParameter(left) && hasParameter(right))) {
+          continue;
+        }
+        const bool interferes = std::any_of(members[left].begin(), members[left].end(), [&](const SSAValue a) {
+          return std::any_of(members[right].begin(), members[right].end(), [&](const SSAValue b) {
+            return liveAt(a, b) || liveAt(b, a);
+          });
+        });
+        if (interferes) {
+          continue;
+        }
+        for (const SSAValue value : members[right]) {
+          congruence_[value] = left;
+        }
+        members[left].insert(members[left].end(), members[right].begin(), members[right].end());
+        members[right].clear();
+      }
+    }
+  }
+}
+
+uint32_t SSALowering::phiOperandIndex(const uint32_t block, const uint32_t successor) const {
+  const auto& predecessors = function_.blocks[successor].predecessors;
+  return static_cast<uint32_t>(std::find(predecessors.begin(), predecessors.end(), block) - predecessors.begin());
+}
+
+
+RPNProgram SSALowering::lowerStack(const SSAProgram& program) {
+  RPNProgram result;
+  stack_ = &result;
+  bytecode_ = &result;
+  floatIndex_.clear();
+  result.strings = program.strings;
+  result.globals = program.globals;
+  result.globalNames = program.globalNames;
+  for (const SSAFunction& function : program.functions) {
+    RPNFunction& lowered = result.functions.emplace_back();
+    lowered.name = function.name;
+    lowered.parameters = function.parameters;
+    lowered.returnsValue = function.returnType != TypeTable::VOID;
+    lowered.localStrings = function.localStrings;
+  }
+
+  for (uint32_t index = 0; index < program.functions.size(); ++index) {
+    beginFunction(program.functions[index]);
+    lowerStackFunction(index);
+  }
+  stack_ = nullptr;
+  bytecode_ = nullptr;
+  return result;
+}
+
+void SSALowering::lowerStackFunction(const uint32_t index) {
+  stackFunction_ = &stack_->functions[index];
+  stackFunction_->entry = static_cast<uint32_t>(stack_->code.size());
+  stackDepth_ = 0;
+  folded_.assign(function_.values.size(), false);
+  for (uint32_t block = 0; block < function_.blocks.size(); ++block) {
+    foldTrees(block);
+  }
+  assignSlots();
+
+  blockOffsets_.assign(function_.blocks.size(), NONE);
+  patches_.clear();
+  for (size_t i = 0; i < layout_.size(); ++i) {
+    const uint32_t block = layout_[i];
+    blockOffsets_[block] = static_cast<uint32_t>(stack_->code.size());
+    const auto& instructions = function_.blocks[block].instructions;
+    for (size_t j = 0; j + 1 < instructions.size(); ++j) {
+      const SSAValue value = instructions[j];
+      if (!isFree(function_.values[value].op) && !folded_[value]) {
+        emitStackRoot(value);
+      }
+    }
+    emitStackCopies(block);
+    emitStackTerminator(block, i + 1 < layout_.size() ? layout_[i + 1] : NONE);
+  }
+  for (const auto& [position, block] : patches_) {
+    writeOperand(&stack_->code[position], blockOffsets_[block]);
+  }
+  stackFunction_->end = static_cast<uint32_t>(stack_->code.size());
+  stackFunction_ = nullptr;
+}
+
+void SSALowering::foldTrees(const uint32_t block) {
+  const auto& instructions = function_.blocks[block].instructions;
+  std::unordered_map<SSAValue, size_t> position;
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    position[instructions[i]] = i;
+  }
+
+  for (size_t k = instructions.size(); k-- > 0;) {
+    const SSAValue value = instructions[k];
+    const SSAInstruction& instruction = function_.values[value];
+    if (isFree(instruction.op) || instruction.type == TypeTable::VOID || uses_[value] != 1) {
+      continue;
+    }
+    const SSAValue user = user_[value];
+    const SSAInstruction& using_ = function_.values[user];
+    if (using_.block != block || using_.op == SSAOp::PHI) {
+      continue;
+    }
+    const size_t end = position.at(user);
+
+    // everything computed in between belongs to the user's tree
+    bool inTree = true;
+    for (size_t i = k + 1; inTree && i < end; ++i) {
+      const SSAValue between = instructions[i];
+      inTree = isFree(function_.values[between].op) || (folded_[between] && position.at(user_[between]) <= end);
+    }
+    // and the operands before this one are not computed after it
+    const auto operands = function_.operandsOf(user);
+    for (size_t i = 0; inTree && operands[i] != value; ++i) {
+      const auto found = position.find(operands[i]);
+      inTree = !folded_[operands[i]] || found == position.end() || found->second < k;
+    }
+    folded_[value] = inTree;
+  }
+}
+
+void SSALowering::assignSlots() {
+  const size_t count = function_.values.size();
+  slots_.assign(count, NONE);
+  uint32_t next = function_.parameters;
+  std::vector<std::string>& names = stackFunction_->slotNames;
+  names.assign(next, "");
+  const auto name = [&](const uint32_t slot, const std::string& variable) {
+    if (names.size() <= slot) {
+      names.resize(slot + 1);
+    }
+    if (variable.empty() || names[slot] == variable || names[slot].starts_with(variable + "/") ||
+      names[slot].ends_with("/" + variable) || names[slot].find("/" + variable + "/") != std::string::npos) {
+      return;
+    }
+    names[slot] += names[slot].empty() ? variable : "/" + variable;
+  };
+
+  // where each value is read: another block (a phi reads at the end of a predecessor)
+  std::vector<bool> elsewhere(count, false);
+  for (uint32_t block = 0; block < function_.blocks.size(); ++block) {
+    for (const SSAValue value : function_.blocks[block].instructions) {
+      const auto operands = function_.operandsOf(value);
+      for (size_t i = 0; i < operands.size(); ++i) {
+        const uint32_t at = function_.values[value].op == SSAOp::PHI
+          ? function_.blocks[block].predecessors[i] : block;
+        if (at != function_.values[operands[i]].block) {
+          elsewhere[operands[i]] = true;
+        }
+      }
+    }
+  }
+
+  // the root whose tree computes each value, and the positions of the roots
+  std::vector<SSAValue> root(count, NONE);
+  std::vector<uint32_t> position(count, NONE);
+  for (const SSABlock& block : function_.blocks) {
+    for (size_t i = block.instructions.size(); i-- > 0;) {
+      const SSAValue value = block.instructions[i];
+      position[value] = static_cast<uint32_t>(i);
+      root[value] = folded_[value] ? root[user_[value]] : value;
+    }
+  }
+
+  const auto needsSlot = [&](const SSAValue value) {
+    const SSAInstruction& instruction = function_.values[value];
+    return !isFree(instruction.op) && !folded_[value] && instruction.type != TypeTable::VOID && uses_[value] > 0;
+  };
+
+  // where in its block the tree of each value is computed
+  std::vector<uint32_t> computed(count, NONE);
+  for (SSAValue value = 0; value < count; ++value) {
+    if (root[value] != NONE) {
+      computed[value] = position[root[value]];
+    }
+  }
+
+  coalescePhis(computed);
+
+  // a class of phis and their operands shares one slot, a parameter's if it has one
+  for (SSAValue value = 0; value < count; ++value) {
+    const SSAInstruction& instruction = function_.values[value];
+    if (instruction.op == SSAOp::PARAMETER) {
+      slots_[congruence_[value]] = static_cast<uint32_t>(instruction.immediate);
+    }
+  }
+  for (SSAValue value = 0; value < count; ++value) {
+    const SSAValue representative = congruence_[value];
+    if (function_.values[value].op == SSAOp::PHI || representative != value) {
+      if (slots_[representative] == NONE) {
+        slots_[representative] = next++;
+      }
+      slots_[value] = slots_[representative];
+    }
+    if (slots_[value] != NONE) {
+      name(slots_[value], function_.names[value]);
+    }
+  }
+  for (SSAValue value = 0; value < count; ++value) {
+    if (!needsSlot(value) || slots_[value] != NONE) {
+      continue;
+    }
+    if (elsewhere[value]) {
+      slots_[value] = next++;
+      name(slots_[value], function_.names[value]);
+    }
+  }
+
+  // the values read only in their block share slots, free again after the last read
+  const uint32_t temporaries = next;
+  uint32_t slotCount = next;
+  for (const SSABlock& block : function_.blocks) {
+    const auto& instructions = block.instructions;
+    std::vector<std::vector<SSAValue>> released(instructions.size());
+    std::unordered_map<SSAValue, uint32_t> lastRead;
+    for (const SSAValue value : instructions) {
+      for (const SSAValue operand : function_.operandsOf(value)) {
+        if (needsSlot(operand) && slots_[operand] == NONE) {
+          const uint32_t at = function_.values[value].op == SSAOp::PHI
+            ? static_cast<uint32_t>(instructions.size() - 1) : position[root[value]];
+          lastRead[operand] = std::max(lastRead[operand], at);
+        }
+      }
+    }
+    for (const uint32_t successor : block.successors) { // the copies before the jump
+      const uint32_t edge = phiOperandIndex(static_cast<uint32_t>(&block - function_.blocks.data()), successor);
+      for (const SSAValue phi : function_.blocks[successor].instructions) {
+        if (function_.values[phi].op != SSAOp::PHI) {
+          break;
+        }
+        const SSAValue operand = function_.operandsOf(phi)[edge];
+        if (needsSlot(operand) && slots_[operand] == NONE) {
+          lastRead[operand] = static_cast<uint32_t>(instructions.size() - 1);
+        }
+      }
+    }
+
+    std::vector<uint32_t> free;
+    uint32_t nextTemporary = temporaries;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+      for (const SSAValue value : released[i]) {
+        free.push_back(slots_[value]);
+      }
+      const SSAValue value = instructions[i];
+      if (!needsSlot(value) || slots_[value] != NONE) {
+        continue;
+      }
+      if (free.empty()) {
+        slots_[value] = nextTemporary++;
+      } else {
+        slots_[value] = free.back();
+        free.pop_back();
+      }
+      name(slots_[value], function_.names[value]);
+      released[lastRead.at(value)].push_back(value);
+    }
+    slotCount = std::max(slotCount, nextTemporary);
+  }
+  stackFunction_->slots = slotCount;
+  names.resize(slotCount);
+}
+
+
+void SSALowering::emitStackRoot(const SSAValue value) {
+  const SSAInstruction& instruction = function_.values[value];
+  line_ = instruction.line;
+  pushTree(value);
+  if (instruction.type == TypeTable::VOID) {
+    return;
+  }
+  if (uses_[value] > 0) {
+    emitStack(OpCode::STORE_LOCAL, -1, slots_[value]);
+  } else {
+    emitStack(OpCode::POP, -1); // still computed: it may fail or have an effect
+  }
+}
+
+void SSALowering::pushTree(const SSAValue value) {
+  const SSAInstruction& instruction = function_.values[value];
+  const auto operands = function_.operandsOf(value);
+  const auto immediate = static_cast<uint32_t>(instruction.immediate);
+  line_ = instruction.line;
+
+  if (isBinary(instruction.op)) {
+    // typed opcodes as in RPNGenerator: two ints, or a float with a float or an int
+    const TypeId left = function_.values[operands[0]].type;
+    const TypeId right = function_.values[operands[1]].type;
+    const bool integers = left == TypeTable::INT && right == TypeTable::INT;
+    const bool floats = !integers && (left == TypeTable::INT || left == TypeTable::FLOAT) &&
+      (right == TypeTable::INT || right == TypeTable::FLOAT);
+    pushOperand(operands[0], floats);
+    pushOperand(operands[1], floats);
+    line_ = instruction.line;
+    static constexpr OpCode opcodes[][3] = {
+      {OpCode::ADD, OpCode::ADD_I64, OpCode::ADD_F64}, {OpCode::SUB, OpCode::SUB_I64, OpCode::SUB_F64},
+      {OpCode::MUL, OpCode::MUL_I64, OpCode::MUL_F64}, {OpCode::DIV, OpCode::DIV_I64, OpCode::DIV_F64},
+      {OpCode::NOP, OpCode::NOP, OpCode::NOP}, {OpCode::NOP, OpCode::NOP, OpCode::NOP},
+      {OpCode::LT, OpCode::LT_I64, OpCode::LT_F64}, {OpCode::GT, OpCode::GT_I64, OpCode::GT_F64},
+      {OpCode::EQ, OpCode::EQ_I64, OpCode::EQ_F64}, {OpCode::NEQ, OpCode::NEQ_I64, OpCode::NEQ_F64},
+    };
+    const auto row = static_cast<size_t>(instruction.op) - static_cast<size_t>(SSAOp::ADD);
+    emitStack(opcodes[row][integers ? 1 : floats ? 2 : 0], -1);
+    return;
+  }
+
+  switch (instruction.op) {
+    case SSAOp::LOAD_GLOBAL:
+      emitStack(OpCode::LOAD_GLOBAL, 1, immediate);
+      break;
+    case SSAOp::STORE_GLOBAL:
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(OpCode::STORE_GLOBAL, -1, immediate);
+      break;
+    case SSAOp::NEW_ARRAY:
+      for (const SSAValue size : operands) {
+        pushOperand(size);
+      }
+      line_ = instruction.line;
+      emitStack(OpCode::NEW_ARRAY, 1 - static_cast<int>(operands.size()), static_cast<uint32_t>(operands.size()),
+        immediate);
+      break;
+    case SSAOp::LOAD_INDEX:
+      pushElement(value);
+      break;
+    case SSAOp::STORE_INDEX:
+      pushElement(value, &operands[2]);
+      break;
+    case SSAOp::NEG: {
+      const TypeId type = function_.values[operands[0]].type;
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(type == TypeTable::INT ? OpCode::NEG_I64 : type == TypeTable::FLOAT ? OpCode::NEG_F64 : OpCode::NEG, 0);
+      break;
+    }
+    case SSAOp::NOT:
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(OpCode::NOT, 0);
+      break;
+    case SSAOp::TO_FLOAT:
+      if (function_.values[operands[0]].type == TypeTable::INT) {
+        pushOperand(operands[0], true); // I64_TO_F64, or a float constant
+        break;
+      }
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(OpCode::TO_FLOAT, 0);
+      break;
+    case SSAOp::TO_INT:
+    case SSAOp::TO_CHAR:
+    case SSAOp::TO_BOOL:
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(instruction.op == SSAOp::TO_INT ? OpCode::TO_INT
+        : instruction.op == SSAOp::TO_CHAR ? OpCode::TO_CHAR : OpCode::TO_BOOL, 0);
+      break;
+    case SSAOp::CALL:
+      for (const SSAValue argument : operands) {
+        pushOperand(argument);
+      }
+      line_ = instruction.line;
+      emitStack(OpCode::CALL, (instruction.type != TypeTable::VOID ? 1 : 0) - static_cast<int>(operands.size()),
+        immediate);
+      break;
+    case SSAOp::PRINT:
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(OpCode::PRINT, -1);
+      break;
+    case SSAOp::READ:
+      emitStack(OpCode::READ, 1, immediate);
+      break;
+    default:
+      throw std::runtime_error(std::string("Code generation error: SSA instruction ") +
+        SSA_OPCODE_MNEMONICS[static_cast<uint8_t>(instruction.op)] + " has no stack form.");
+  }
+}
+
+void SSALowering::pushOperand(const SSAValue value, const bool asFloat) {
+  const SSAInstruction& instruction = function_.values[value];
+  const bool converted = asFloat && instruction.type == TypeTable::INT;
+  if (instruction.op == SSAOp::CONSTANT) {
+    pushConstant(instruction, converted);
+    return;
+  }
+  if (instruction.op == SSAOp::UNDEF) {
+    pushZero(converted ? TypeTable::FLOAT : instruction.type);
+    return;
+  }
+  if (folded_[value]) {
+    pushTree(value);
+  } else {
+    emitStack(OpCode::LOAD_LOCAL, 1, slots_[value]);
+  }
+  if (converted) {
+    emitStack(OpCode::I64_TO_F64, 0);
+  }
+}
+
+void SSALowering::pushConstant(const SSAInstruction& instruction, const bool asFloat) {
+  const int64_t value = instruction.immediate;
+  switch (instruction.type) {
+    case TypeTable::INT:
+      if (asFloat) { // an int constant is converted now
+        emitStack(OpCode::PUSH_FLOAT, 1, addFloat(static_cast<double>(value)));
+      } else if (value >= INT32_MIN && value <= INT32_MAX) {
+        emitStack(OpCode::PUSH_INT, 1, static_cast<uint32_t>(static_cast<int32_t>(value)));
+      } else {
+        stack_->integers.push_back(value);
+        emitStack(OpCode::PUSH_LONG, 1, static_cast<uint32_t>(stack_->integers.size() - 1));
+      }
+      break;
+    case TypeTable::FLOAT: {
+      double real;
+      std::memcpy(&real, &value, sizeof(real));
+      emitStack(OpCode::PUSH_FLOAT, 1, addFloat(real));
+      break;
+    }
+    case TypeTable::CHAR:
+      emitStack(OpCode::PUSH_CHAR, 1, static_cast<uint32_t>(value));
+      break;
+    case TypeTable::BOOL:
+      emitStack(OpCode::PUSH_BOOL, 1, static_cast<uint32_t>(value));
+      break;
+    default: // strings
+      emitStack(OpCode::PUSH_STRING, 1, static_cast<uint32_t>(value));
+      break;
+  }
+}
+
+void SSALowering::pushZero(const TypeId type) {
+  switch (types_.kind(type)) {
+    case TypeKind::FLOAT:
+      emitStack(OpCode::PUSH_FLOAT, 1, addFloat(0.0));
+      break;
+    case TypeKind::CHAR:
+      emitStack(OpCode::PUSH_CHAR, 1, 0);
+      break;
+    case TypeKind::BOOL:
+      emitStack(OpCode::PUSH_BOOL, 1, 0);
+      break;
+    case TypeKind::STRING: {
+      auto& strings = stack_->strings;
+      const auto empty = static_cast<uint32_t>(std::find(strings.begin(), strings.end(), "") - strings.begin());
+      if (empty == strings.size()) {
+        strings.emplace_back();
+      }
+      emitStack(OpCode::PUSH_STRING, 1, empty);
+      break;
+    }
+    case TypeKind::ARRAY:
+      emitStack(OpCode::NEW_ARRAY, 1, 0, static_cast<uint32_t>(valueKind(types_.get(type).element)));
+      break;
+    default:
+      emitStack(OpCode::PUSH_INT, 1, 0);
+      break;
+  }
+}
+
+void SSALowering::pushElement(const SSAValue value, const SSAValue* stored) {
+  // the chain from the outermost subscript in, then reversed
+  std::vector<SSAValue> indices;
+  std::vector<bool> proven;
+  SSAValue access = value;
+  SSAValue array;
+  while (true) {
+    const auto operands = function_.operandsOf(access);
+    indices.push_back(operands[1]);
+    proven.push_back(function_.values[access].immediate != 0);
+    array = operands[0];
+    if (function_.values[array].op != SSAOp::LOAD_INDEX || !folded_[array]) {
+      break;
+    }
+    access = array;
+  }
+  std::reverse(indices.begin(), indices.end());
+  std::reverse(proven.begin(), proven.end());
+
+  // a group of indices starts at every index that must be checked before it is computed
+  std::vector<bool> starts(indices.size());
+  starts[0] = true;
+  for (size_t i = 1; i < indices.size(); ++i) {
+    starts[i] = !isPlainTree(indices[i]);
+  }
+  if (stored) {
+    starts.back() = starts.back() || !isPlainTree(*stored);
+  }
+
+  const uint32_t line = function_.values[value].line;
+  pushOperand(array);
+  for (size_t first = 0; first < indices.size();) {
+    size_t end = first + 1;
+    while (end < indices.size() && !starts[end]) {
+      ++end;
+    }
+    for (size_t i = first; i < end; ++i) {
+      pushOperand(indices[i]);
+    }
+    const auto count = static_cast<uint32_t>(end - first);
+    const bool checked = !std::all_of(proven.begin() + static_cast<ptrdiff_t>(first),
+      proven.begin() + static_cast<ptrdiff_t>(end), [](const bool inBounds) { return inBounds; });
+    if (stored && end == indices.size()) {
+      pushOperand(*stored);
+      line_ = line;
+      if (count == 1) {
+        emitStack(checked ? OpCode::STORE_INDEX : OpCode::STORE_INDEX_UNCHECKED, -3);
+      } else {
+        emitStack(checked ? OpCode::STORE_ELEMENT : OpCode::STORE_ELEMENT_UNCHECKED, -static_cast<int>(count) - 2,
+          count);
+      }
+    } else {
+      line_ = line;
+      if (count == 1) {
+        emitStack(checked ? OpCode::LOAD_INDEX : OpCode::LOAD_INDEX_UNCHECKED, -1);
+      } else {
+        emitStack(checked ? OpCode::LOAD_ELEMENT : OpCode::LOAD_ELEMENT_UNCHECKED, -static_cast<int>(count), count);
+      }
+    }
+    first = end;
+  }
+}
+
+bool SSALowering::isPlainTree(const SSAValue value) const {
+  const SSAInstruction& instruction = function_.values[value];
+  if (isFree(instruction.op) || !folded_[value]) {
+    return true; // a constant or a load
+  }
+  if (!isPure(instruction.op, instruction.type)) {
+    return false;
+  }
+  const auto operands = function_.operandsOf(value);
+  return std::all_of(operands.begin(), operands.end(), [&](const SSAValue operand) { return isPlainTree(operand); });
+}
+
+// The copies into the phis of the block jumped to, all read before any is written
+void SSALowering::emitStackCopies(const uint32_t block) {
+  const SSABlock& source = function_.blocks[block];
+  if (source.successors.size() != 1) {
+    return;
+  }
+  const uint32_t target = source.successors[0];
+  const uint32_t edge = phiOperandIndex(block, target);
+  std::vector<std::pair<SSAValue, SSAValue>> copies; // (phi, value)
+  for (const SSAValue phi : function_.blocks[target].instructions) {
+    if (function_.values[phi].op != SSAOp::PHI) {
+      break;
+    }
+    const SSAValue operand = function_.operandsOf(phi)[edge];
+    const SSAOp op = function_.values[operand].op;
+    if (op == SSAOp::CONSTANT || op == SSAOp::UNDEF || slots_[operand] != slots_[phi]) {
+      copies.emplace_back(phi, operand);
+    }
+  }
+  if (copies.empty()) {
+    return;
+  }
+  line_ = function_.values[source.instructions.back()].line;
+
+  const auto readsTarget = [&](const SSAValue operand) {
+    const SSAOp op = function_.values[operand].op;
+    return op != SSAOp::CONSTANT && op != SSAOp::UNDEF && std::any_of(copies.begin(), copies.end(),
+      [&](const auto& copy) { return slots_[copy.first] == slots_[operand]; });
+  };
+  if (std::none_of(copies.begin(), copies.end(), [&](const auto& copy) { return readsTarget(copy.second); })) {
+    for (const auto& [phi, operand] : copies) {
+      pushOperand(operand);
+      emitStack(OpCode::STORE_LOCAL, -1, slots_[phi]);
+    }
+    return;
+  }
+  for (const auto& copy : copies) {
+    pushOperand(copy.second);
+  }
+  for (size_t i = copies.size(); i-- > 0;) {
+    emitStack(OpCode::STORE_LOCAL, -1, slots_[copies[i].first]);
+  }
+}
+
+void SSALowering::emitStackTerminator(const uint32_t block, const uint32_t next) {
+  const SSABlock& current = function_.blocks[block];
+  const SSAValue terminator = current.instructions.back();
+  const SSAInstruction& instruction = function_.values[terminator];
+  const auto operands = function_.operandsOf(terminator);
+  line_ = instruction.line;
+  switch (instruction.op) {
+    case SSAOp::JUMP:
+      if (current.successors[0] != next) {
+        emitStackJump(OpCode::JUMP, 0, current.successors[0]);
+      }
+      break;
+    case SSAOp::BRANCH: {
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      if (function_.values[operands[0]].type != TypeTable::BOOL) {
+        emitStack(OpCode::TO_BOOL, 0);
+      }
+      const uint32_t whenTrue = current.successors[0];
+      const uint32_t whenFalse = current.successors[1];
+      if (whenTrue == next) {
+        emitStackJump(OpCode::JUMP_IF_FALSE, -1, whenFalse);
+      } else if (whenFalse == next) {
+        emitStackJump(OpCode::JUMP_IF_TRUE, -1, whenTrue);
+      } else {
+        emitStackJump(OpCode::JUMP_IF_FALSE, -1, whenFalse);
+        emitStackJump(OpCode::JUMP, 0, whenTrue);
+      }
+      break;
+    }
+    case SSAOp::RETURN:
+      pushOperand(operands[0]);
+      line_ = instruction.line;
+      emitStack(OpCode::RETURN, -1);
+      break;
+    case SSAOp::RETURN_VOID:
+      emitStack(OpCode::RETURN_VOID, 0);
+      break;
+    case SSAOp::TRAP:
+      emitStack(OpCode::TRAP, 0, static_cast<uint32_t>(instruction.immediate));
+      break;
+    default: // HALT
+      emitStack(OpCode::HALT, 0);
+      break;
+  }
+}
+
+void SSALowering::emitStack(const OpCode op, const int delta) {
+  stackDepth_ = static_cast<uint32_t>(static_cast<int>(stackDepth_) + delta);
+  stackFunction_->maxStack = std::max(stackFunction_->maxStack, stackDepth_);
+  if (stack_->lines.empty() || stack_->lines.back().second != line_) {
+    stack_->lines.emplace_back(static_cast<uint32_t>(stack_->code.size()), line_);
+  }
+  stack_->code.push_back(static_cast<uint8_t>(op));
+}
+
+void SSALowering::emitStack(const OpCode op, const int delta, const uint32_t operand) {
+  emitStack(op, delta);
+  stack_->code.resize(stack_->code.size() + sizeof(uint32_t));
+  writeOperand(&stack_->code[stack_->code.size() - sizeof(uint32_t)], operand);
+}
+
+void SSALowering::emitStack(const OpCode op, const int delta, const uint32_t first, const uint32_t second) {
+  emitStack(op, delta, first);
+  stack_->code.resize(stack_->code.size() + sizeof(uint32_t));
+  writeOperand(&stack_->code[stack_->code.size() - sizeof(uint32_t)], second);
+}
+
+void SSALowering::emitStackJump(const OpCode op, const int delta, const uint32_t block) {
+  emitStack(op, delta, 0);
+  patches_.emplace_back(static_cast<uint32_t>(stack_->code.size() - sizeof(uint32_t)), block);
+}
+
+
+RegisterProgram SSALowering::lowerRegisters(const SSAProgram& program) {
+  RegisterProgram result;
+  bytecode_ = &result;
+  floatIndex_.clear();
+  result.strings = program.strings;
+  result.globals = program.globals;
+  result.globalNames = program.globalNames;
+  for (const SSAFunction& function : program.functions) {
+    RPNFunction& lowered = result.functions.emplace_back();
+    lowered.name = function.name;
+    lowered.parameters = function.parameters;
+    lowered.returnsValue = function.returnType != TypeTable::VOID;
+    lowered.localStrings = function.localStrings;
+  }
+
+  for (uint32_t index = 0; index < program.functions.size(); ++index) {
+    beginFunction(program.functions[index]);
+    lowerRegisterFunction(result, index);
+  }
+  bytecode_ = nullptr;
+  return result;
+}
+
+void SSALowering::lowerRegisterFunction(RegisterProgram& program, const uint32_t index) {
+  ir_ = RegisterFunctionIR();
+  ir_.parameters = function_.parameters;
+  for (uint32_t i = 0; i < function_.parameters; ++i) {
+    newRegister();
+  }
+  registers_.assign(function_.values.size(), NONE);
+  std::vector<uint32_t> position(function_.values.size(), NONE);
+  for (const SSABlock& block : function_.blocks) {
+    for (uint32_t i = 0; i < block.instructions.size(); ++i) {
+      position[block.instructions[i]] = i;
+    }
+  }
+  coalescePhis(position);
+
+  // one register per class of phis and their operands, a parameter's if it has one
+  for (SSAValue value = 0; value < function_.values.size(); ++value) {
+    const SSAInstruction& instruction = function_.values[value];
+    if (instruction.op == SSAOp::PARAMETER) {
+      registers_[congruence_[value]] = static_cast<uint32_t>(instruction.immediate);
+    }
+  }
+  for (SSAValue value = 0; value < function_.values.size(); ++value) {
+    const SSAValue representative = congruence_[value];
+    if (function_.values[value].type == TypeTable::VOID) {
+      continue;
+    }
+    if (registers_[representative] == NONE) {
+      registers_[representative] = newRegister();
+    }
+    registers_[value] = registers_[representative];
+    std::string& name = ir_.names[registers_[value]];
+    if (const std::string& variable = function_.names[value]; !variable.empty() && name.empty()) {
+      name = variable;
+    }
+  }
+
+  ir_.labels.assign(function_.blocks.size(), NONE); // one label per block
+  for (size_t i = 0; i < layout_.size(); ++i) {
+    const uint32_t block = layout_[i];
+    ir_.labels[block] = static_cast<uint32_t>(ir_.instructions.size());
+    const auto& instructions = function_.blocks[block].instructions;
+    for (size_t j = 0; j + 1 < instructions.size(); ++j) {
+      emitRegisterInstruction(instructions[j], NONE);
+    }
+    emitRegisterCopies(block);
+    emitRegisterInstruction(instructions.back(), i + 1 < layout_.size() ? layout_[i + 1] : NONE);
+  }
+  encodeFunction(ir_, program, index);
+}
+
+void SSALowering::emitRegisterInstruction(const SSAValue value, const uint32_t next) {
+  const SSAInstruction& instruction = function_.values[value];
+  const auto operands = function_.operandsOf(value);
+  const uint32_t target = registers_[value];
+  const auto immediate = static_cast<uint32_t>(instruction.immediate);
+  const auto reg = [&](const size_t operand) { return registers_[operands[operand]]; };
+  const auto& successors = function_.blocks[instruction.block].successors;
+  line_ = instruction.line;
+
+  switch (instruction.op) {
+    case SSAOp::PARAMETER:
+    case SSAOp::PHI:
+      break;
+    case SSAOp::CONSTANT:
+      switch (instruction.type) {
+        case TypeTable::INT:
+          if (instruction.immediate >= INT32_MIN && instruction.immediate <= INT32_MAX) {
+            emitRegister(RegOp::LOAD_INT, {target, immediate});
+          } else {
+            bytecode_->integers.push_back(instruction.immediate);
+            emitRegister(RegOp::LOAD_LONG, {target, static_cast<uint32_t>(bytecode_->integers.size() - 1)});
+          }
+          break;
+        case TypeTable::FLOAT: {
+          double real;
+          std::memcpy(&real, &instruction.immediate, sizeof(real));
+          emitRegister(RegOp::LOAD_FLOAT, {target, addFloat(real)});
+          break;
+        }
+        case TypeTable::CHAR:
+          emitRegister(RegOp::LOAD_CHAR, {target, immediate});
+          break;
+        case TypeTable::BOOL:
+          emitRegister(RegOp::LOAD_BOOL, {target, immediate});
+          break;
+        default:
+          emitRegister(RegOp::LOAD_STRING, {target, immediate});
+          break;
+      }
+      break;
+    case SSAOp::UNDEF:
+      switch (types_.kind(instruction.type)) {
+        case TypeKind::FLOAT:
+          emitRegister(RegOp::LOAD_FLOAT, {target, addFloat(0.0)});
+          break;
+        case TypeKind::CHAR:
+          emitRegister(RegOp::LOAD_CHAR, {target, 0});
+          break;
+        case TypeKind::BOOL:
+          emitRegister(RegOp::LOAD_BOOL, {target, 0});
+          break;
+        case TypeKind::STRING: {
+          auto& strings = bytecode_->strings;
+          const auto empty = static_cast<uint32_t>(std::find(strings.begin(), strings.end(), "") - strings.begin());
+          if (empty == strings.size()) {
+            strings.emplace_back();
+          }
+          emitRegister(RegOp::LOAD_STRING, {target, empty});
+          break;
+        }
+        case TypeKind::ARRAY:
+          emitRegister(RegOp::NEW_ARRAY, {target, static_cast<uint32_t>(valueKind(types_.get(instruction.type).element)),
+            0});
+          break;
+        default:
+          emitRegister(RegOp::LOAD_INT, {target, 0});
+          break;
+      }
+      break;
+    case SSAOp::LOAD_GLOBAL:
+      emitRegister(RegOp::LOAD_GLOBAL, {target, immediate});
+      break;
+    case SSAOp::STORE_GLOBAL:
+      emitRegister(RegOp::STORE_GLOBAL, {immediate, reg(0)});
+      break;
+    case SSAOp::NEW_ARRAY: {
+      std::vector<uint32_t> arguments = {target, immediate, static_cast<uint32_t>(operands.size())};
+      for (size_t i = 0; i < operands.size(); ++i) {
+        arguments.push_back(reg(i));
+      }
+      emitRegister(RegOp::NEW_ARRAY, std::move(arguments));
+      break;
+    }
+    case SSAOp::LOAD_INDEX:
+      emitRegister(RegOp::LOAD_INDEX, {target, reg(0), reg(1)});
+      break;
+    case SSAOp::STORE_INDEX:
+      emitRegister(RegOp::STORE_INDEX, {reg(0), reg(1), reg(2)});
+      break;
+    case SSAOp::ADD:
+    case SSAOp::SUB:
+    case SSAOp::MUL:
+    case SSAOp::DIV:
+    case SSAOp::LT:
+    case SSAOp::GT:
+    case SSAOp::EQ:
+    case SSAOp::NEQ: {
+      static constexpr RegOp opcodes[] = {RegOp::ADD, RegOp::SUB, RegOp::MUL, RegOp::DIV, RegOp::NEG, RegOp::NOT,
+        RegOp::LT, RegOp::GT, RegOp::EQ, RegOp::NEQ};
+      emitRegister(opcodes[static_cast<size_t>(instruction.op) - static_cast<size_t>(SSAOp::ADD)],
+        {target, reg(0), reg(1)});
+      break;
+    }
+    case SSAOp::NEG:
+      emitRegister(RegOp::NEG, {target, reg(0)});
+      break;
+    case SSAOp::NOT:
+      emitRegister(RegOp::NOT, {target, reg(0)});
+      break;
+    case SSAOp::TO_INT:
+      emitRegister(RegOp::TO_INT, {target, reg(0)});
+      break;
+    case SSAOp::TO_FLOAT:
+      emitRegister(RegOp::TO_FLOAT, {target, reg(0)});
+      break;
+    case SSAOp::TO_CHAR:
+      emitRegister(RegOp::TO_CHAR, {target, reg(0)});
+      break;
+    case SSAOp::TO_BOOL:
+      emitRegister(RegOp::TO_BOOL, {target, reg(0)});
+      break;
+    case SSAOp::CALL: {
+      std::vector<uint32_t> arguments;
+      if (instruction.type != TypeTable::VOID) {
+        arguments.push_back(target);
+      }
+      arguments.push_back(immediate);
+      arguments.push_back(static_cast<uint32_t>(operands.size()));
+      for (size_t i = 0; i < operands.size(); ++i) {
+        arguments.push_back(reg(i));
+      }
+      emitRegister(instruction.type != TypeTable::VOID ? RegOp::CALL : RegOp::CALL_VOID, std::move(arguments));
+      break;
+    }
+    case SSAOp::PRINT:
+      emitRegister(RegOp::PRINT, {reg(0)});
+      break;
+    case SSAOp::READ:
+      emitRegister(RegOp::READ, {target, immediate});
+      break;
+    case SSAOp::JUMP:
+      if (successors[0] != next) {
+        emitRegister(RegOp::JUMP, {successors[0]});
+      }
+      break;
+    case SSAOp::BRANCH:
+      if (successors[0] == next) {
+        emitRegister(RegOp::JUMP_IF_FALSE, {reg(0), successors[1]});
+      } else if (successors[1] == next) {
+        emitRegister(RegOp::JUMP_IF_TRUE, {reg(0), successors[0]});
+      } else {
+        emitRegister(RegOp::JUMP_IF_FALSE, {reg(0), successors[1]});
+        emitRegister(RegOp::JUMP, {successors[0]});
+      }
+      break;
+    case SSAOp::RETURN:
+      emitRegister(RegOp::RETURN, {reg(0)});
+      break;
+    case SSAOp::RETURN_VOID:
+      emitRegister(RegOp::RETURN_VOID, {});
+      break;
+    case SSAOp::TRAP:
+      emitRegister(RegOp::TRAP, {immediate});
+      break;
+    case SSAOp::HALT:
+      emitRegister(RegOp::HALT, {});
+      break;
+  }
+}
+
+// The phi copies of an edge are one parallel assignment: a copy is emitted once no other
+// still reads its target, and a cycle is broken by saving one target in a temporary
+void SSALowering::emitRegisterCopies(const uint32_t block) {
+  const SSABlock& source = function_.blocks[block];
+  if (source.successors.size() != 1) {
+    return;
+  }
+  const uint32_t target = source.successors[0];
+  const uint32_t edge = phiOperandIndex(block, target);
+  std::vector<std::pair<uint32_t, uint32_t>> copies; // (target, source) registers
+  for (const SSAValue phi : function_.blocks[target].instructions) {
+    if (function_.values[phi].op != SSAOp::PHI) {
+      break;
+    }
+    if (const uint32_t from = registers_[function_.operandsOf(phi)[edge]]; from != registers_[phi]) {
+      copies.emplace_back(registers_[phi], from);
+    }
+  }
+  line_ = function_.values[source.instructions.back()].line;
+
+  while (!copies.empty()) {
+    const auto ready = std::find_if(copies.begin(), copies.end(), [&](const auto& copy) {
+      return std::none_of(copies.begin(), copies.end(), [&](const auto& other) { return other.second == copy.first; });
+    });
+    if (ready != copies.end()) {
+      emitRegister(RegOp::MOVE, {ready->first, ready->second});
+      copies.erase(ready);
+      continue;
+    }
+    const uint32_t saved = copies.front().first;
+    const uint32_t temporary = newRegister();
+    emitRegister(RegOp::MOVE, {temporary, saved});
+    for (auto& copy : copies) {
+      if (copy.second == saved) {
+        copy.second = temporary;
+      }
+    }
+  }
+}
+
+void SSALowering::emitRegister(const RegOp op, std::vector<uint32_t> operands) {
+  ir_.instructions.push_back({op, line_, std::move(operands)});
+}
+
+uint32_t SSALowering::newRegister(const std::string& name) {
+  ir_.names.push_back(name);
+  return ir_.virtualRegisters++;
+}
+
+
+ValueKind SSALowering::valueKind(const TypeId type) const {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      return ValueKind::INT;
+    case TypeKind::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeKind::CHAR:
+      return ValueKind::CHAR;
+    case TypeKind::BOOL:
+      return ValueKind::BOOL;
+    case TypeKind::STRING:
+      return ValueKind::STRING;
+    case TypeKind::ARRAY:
+      return ValueKind::ARRAY;
+    default:
+      return ValueKind::VOID;
+  }
+}
+
+uint32_t SSALowering::addFloat(const double value) {
+  uint64_t bits; // by bit pattern: 0.0 and -0.0 are different constants
+  std::memcpy(&bits, &value, sizeof(bits));
+  const auto [entry, inserted] = floatIndex_.try_emplace(bits, static_cast<uint32_t>(bytecode_->floats.size()));
+  if (inserted) {
+    bytecode_->floats.push_back(value);
+  }
+  return entry->second;
+}
@@ -0,0 +1,380 @@
+#include "../headers/ssa-optimizer.h"
+
+#include <tuple>
+
+
+static ValueKind valueKind(const TypeId type) {
+  switch (type) {
+    case TypeTable::INT:
+      return ValueKind::INT;
+    case TypeTable::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeTable::CHAR:
+      return ValueKind::CHAR;
+    case TypeTable::BOOL:
+      return ValueKind::BOOL;
+    default: // strings live on the heap, arrays have no constants
+      return ValueKind::VOID;
+  }
+}
+
+
+void SSAOptimizer::run(SSAProgram& program) {
+  for (SSAFunction& function : program.functions) {
+    function_ = &function;
+    bool changed = true;
+    while (changed) {
+      ++statistics_.rounds;
+      forward_.resize(function.values.size());
+      std::iota(forward_.begin(), forward_.end(), 0);
+      changed = hoistConstants();
+      changed |= foldConstants();
+      changed |= removeTrivialPhis();
+      changed |= foldBranches();
+      changed |= removeDeadValues();
+      changed |= mergeBlocks();
+      if (changed) {
+        compact(function);
+      }
+    }
+  }
+  function_ = nullptr;
+}
+
+
+bool SSAOptimizer::hoistConstants() {
+  SSAFunction& function = *function_;
+  std::map<std::tuple<SSAOp, TypeId, int64_t>, SSAValue> constants;
+  std::vector<SSAValue> hoisted;
+  bool changed = false;
+  for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+    std::erase_if(function.blocks[block].instructions, [&](const SSAValue value) {
+      const SSAInstruction& instruction = function.values[value];
+      if (instruction.op != SSAOp::CONSTANT && instruction.op != SSAOp::UNDEF) {
+        return false;
+      }
+      const auto [entry, inserted] = constants.try_emplace({instruction.op, instruction.type, instruction.immediate},
+        value);
+      if (!inserted) {
+        forward_[value] = entry->second;
+        changed = true;
+        return true;
+      }
+      if (block != 0) {
+        function.values[value].block = 0;
+        hoisted.push_back(value);
+        changed = true;
+        return true;
+      }
+      return false;
+    });
+  }
+  // after the parameters and the entry's own constants
+  auto& entry = function.blocks[0].instructions;
+  const auto position = std::find_if(entry.begin(), entry.end(), [&](const SSAValue value) {
+    const SSAOp op = function.values[value].op;
+    return op != SSAOp::PARAMETER && op != SSAOp::CONSTANT && op != SSAOp::UNDEF;
+  });
+  entry.insert(position, hoisted.begin(), hoisted.end());
+  if (changed) {
+    rewriteOperands();
+  }
+  return changed;
+}
+
+
+bool SSAOptimizer::foldConstants() {
+  SSAFunction& function = *function_;
+  bool changed = false;
+  for (SSABlock& block : function.blocks) {
+    for (const SSAValue value : block.instructions) {
+      const std::optional<int64_t> result = evaluate(value);
+      if (!result) {
+        continue;
+      }
+      // the value keeps its index, so its uses need no rewriting
+      SSAInstruction& instruction = function.values[value];
+      instruction.op = SSAOp::CONSTANT;
+      instruction.operandCount = 0;
+      instruction.immediate = *result;
+      ++statistics_.folded;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+
+bool SSAOptimizer::removeTrivialPhis() {
+  SSAFunction& function = *function_;
+  bool changed = false;
+  for (SSABlock& block : function.blocks) {
+    std::erase_if(block.instructions, [&](const SSAValue phi) {
+      if (function.values[phi].op != SSAOp::PHI) {
+        return false;
+      }
+      SSAValue same = phi;
+      for (SSAValue operand : function.operandsOf(phi)) {
+        operand = resolve(operand);
+        if (operand == phi || operand == same) {
+          continue;
+        }
+        if (same != phi) {
+          return false;
+        }
+        same = operand;
+      }
+      if (same == phi) {
+        return false; // only reached from itself
+      }
+      forward_[phi] = same;
+      ++statistics_.phis;
+      changed = true;
+      return true;
+    });
+  }
+  if (changed) {
+    rewriteOperands();
+  }
+  return changed;
+}
+
+
+bool SSAOptimizer::foldBranches() {
+  SSAFunction& function = *function_;
+  bool changed = false;
+  for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+    SSABlock& current = function.blocks[block];
+    if (current.instructions.empty()) {
+      continue;
+    }
+    SSAInstruction& terminator = function.values[current.instructions.back()];
+    if (terminator.op != SSAOp::BRANCH) {
+      continue;
+    }
+    const SSAInstruction& condition = function.values[function.operandsOf(current.instructions.back())[0]];
+    if (condition.op != SSAOp::CONSTANT) {
+      continue;
+    }
+    const uint32_t taken = current.successors[condition.immediate != 0 ? 0 : 1];
+    const uint32_t dropped = current.successors[condition.immediate != 0 ? 1 : 0];
+    auto& predecessors = function.blocks[dropped].predecessors;
+    removePredecessor(function, dropped,
+      static_cast<size_t>(std::find(predecessors.begin(), predecessors.end(), block) - predecessors.begin()));
+    terminator.op = SSAOp::JUMP;
+    terminator.operandCount = 0;
+    current.successors = {taken};
+    ++statistics_.branches;
+    changed = true;
+  }
+  return changed;
+}
+
+
+bool SSAOptimizer::removeDeadValues() {
+  SSAFunction& function = *function_;
+  std::vector<uint32_t> uses(function.values.size(), 0);
+  for (const SSABlock& block : function.blocks) {
+    for (const SSAValue value : block.instructions) {
+      for (const SSAValue operand : function.operandsOf(value)) {
+        uses[operand] += operand != value; // a phi of a loop may use itself
+      }
+    }
+  }
+  // a removed value may leave its operands unused
+  const auto removable = [&](const SSAValue value) {
+    const SSAInstruction& instruction = function.values[value];
+    return uses[value] == 0 && (isPure(instruction.op, instruction.type) || instruction.op == SSAOp::PHI ||
+      instruction.op == SSAOp::LOAD_GLOBAL);
+  };
+  std::vector<bool> dead(function.values.size(), false);
+  std::vector<SSAValue> work;
+  for (const SSABlock& block : function.blocks) {
+    for (const SSAValue value : block.instructions) {
+      if (removable(value)) {
+        dead[value] = true;
+        work.push_back(value);
+      }
+    }
+  }
+  if (work.empty()) {
+    return false;
+  }
+  while (!work.empty()) {
+    const SSAValue value = work.back();
+    work.pop_back();
+    for (const SSAValue operand : function.operandsOf(value)) {
+      if (operand != value && --uses[operand] == 0 && !dead[operand] && removable(operand)) {
+        dead[operand] = true;
+        work.push_back(operand);
+      }
+    }
+  }
+  for (SSABlock& block : function.blocks) {
+    std::erase_if(block.instructions, [&](const SSAValue value) {
+      if (!dead[value]) {
+        return false;
+      }
+      // constants and undefined values are SSABuilder's to clean up, not work saved
+      const SSAOp op = function.values[value].op;
+      statistics_.dead += op != SSAOp::CONSTANT && op != SSAOp::UNDEF;
+      return true;
+    });
+  }
+  return true;
+}
+
+
+bool SSAOptimizer::mergeBlocks() {
+  SSAFunction& function = *function_;
+  bool changed = false;
+  for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+    while (true) {
+      SSABlock& current = function.blocks[block];
+      if (current.successors.size() != 1 || function.values[current.instructions.back()].op != SSAOp::JUMP) {
+        break;
+      }
+      const uint32_t next = current.successors[0];
+      SSABlock& following = function.blocks[next];
+      if (next == 0 || next == block || following.predecessors.size() != 1 ||
+        function.values[following.instructions.front()].op == SSAOp::PHI) {
+        break;
+      }
+      current.instructions.pop_back();
+      for (const SSAValue value : following.instructions) {
+        function.values[value].block = block;
+        current.instructions.push_back(value);
+      }
+      current.successors = std::move(following.successors);
+      for (const uint32_t successor : current.successors) {
+        auto& predecessors = function.blocks[successor].predecessors;
+        std::replace(predecessors.begin(), predecessors.end(), next, block);
+      }
+      // no longer reached, so compact() drops it
+      following.instructions.clear();
+      following.predecessors.clear();
+      following.successors.clear();
+      ++statistics_.merged;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+
+void SSAOptimizer::rewriteOperands() {
+  for (const SSABlock& block : function_->blocks) {
+    for (const SSAValue value : block.instructions) {
+      for (SSAValue& operand : function_->operandsOf(value)) {
+        operand = resolve(operand);
+      }
+    }
+  }
+}
+
+SSAValue SSAOptimizer::resolve(SSAValue value) {
+  while (forward_[value] != value) {
+    value = forward_[value] = forward_[forward_[value]];
+  }
+  return value;
+}
+
+
+std::optional<int64_t> SSAOptimizer::evaluate(const SSAValue value) {
+  const SSAInstruction& instruction = function_->values[value];
+  if (instruction.op < SSAOp::ADD || instruction.op > SSAOp::TO_BOOL) {
+    return std::nullopt;
+  }
+  const ValueKind kind = valueKind(instruction.type);
+  if (kind == ValueKind::VOID) {
+    return std::nullopt;
+  }
+  std::vector<Value> operands;
+  for (const SSAValue operand : function_->operandsOf(value)) {
+    const std::optional<Value> constant = constantValue(function_->values[operand]);
+    if (!constant) {
+      return std::nullopt;
+    }
+    operands.push_back(*constant);
+  }
+
+  Value result;
+  try {
+    switch (instruction.op) {
+      case SSAOp::ADD:
+        result = runtime_.arithmetic(Operator::ADD, operands[0], operands[1]);
+        break;
+      case SSAOp::SUB:
+        result = runtime_.arithmetic(Operator::SUB, operands[0], operands[1]);
+        break;
+      case SSAOp::MUL:
+        result = runtime_.arithmetic(Operator::MUL, operands[0], operands[1]);
+        break;
+      case SSAOp::DIV:
+        result = runtime_.arithmetic(Operator::DIV, operands[0], operands[1]);
+        break;
+      case SSAOp::NEG:
+        result = operands[0].kind == ValueKind::FLOAT ? Value::ofFloat(-operands[0].real) :
+          Value::ofInt(static_cast<int64_t>(0 - static_cast<uint64_t>(operands[0].asInteger())));
+        break;
+      case SSAOp::NOT:
+        result = Value::ofBool(!operands[0].isTrue());
+        break;
+      case SSAOp::LT:
+        result = Value::ofBool(Runtime::compare(Operator::LT, operands[0], operands[1]));
+        break;
+      case SSAOp::GT:
+        result = Value::ofBool(Runtime::compare(Operator::GT, operands[0], operands[1]));
+        break;
+      case SSAOp::EQ:
+        result = Value::ofBool(Runtime::compare(Operator::EQ, operands[0], operands[1]));
+        break;
+      case SSAOp::NEQ:
+        result = Value::ofBool(!Runtime::compare(Operator::EQ, operands[0], operands[1]));
+        break;
+      default: // the conversions
+        result = Runtime::convert(kind, operands[0]);
+        break;
+    }
+  } catch (const std::exception&) {
+    return std::nullopt; // fails at run time, with the line of the operation
+  }
+
+  if (result.kind != kind) {
+    return std::nullopt;
+  }
+  switch (kind) {
+    case ValueKind::FLOAT: {
+      int64_t bits;
+      std::memcpy(&bits, &result.real, sizeof(bits));
+      return bits;
+    }
+    case ValueKind::CHAR:
+      return static_cast<uint8_t>(result.character);
+    case ValueKind::BOOL:
+      return result.boolean ? 1 : 0;
+    default:
+      return result.integer;
+  }
+}
+
+std::optional<Value> SSAOptimizer::constantValue(const SSAInstruction& instruction) {
+  if (instruction.op != SSAOp::CONSTANT) {
+    return std::nullopt;
+  }
+  switch (instruction.type) {
+    case TypeTable::INT:
+      return Value::ofInt(instruction.immediate);
+    case TypeTable::FLOAT: {
+      double real;
+      std::memcpy(&real, &instruction.immediate, sizeof(real));
+      return Value::ofFloat(real);
+    }
+    case TypeTable::CHAR:
+      return Value::ofChar(static_cast<char>(instruction.immediate));
+    case TypeTable::BOOL:
+      return Value::ofBool(instruction.immediate != 0);
+    default:
+      return std::nullopt;
+  }
+}
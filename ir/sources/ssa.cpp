@@ -0,0 +1,520 @@
+#include "../headers/ssa.h"
+
+#include <sstream>
+
+
+SSAValue SSAFunction::add(const SSAOp op, const TypeId type, const uint32_t block, const uint32_t line,
+  const std::span<const SSAValue> arguments, const int64_t immediate) {
+  const auto value = static_cast<SSAValue>(values.size());
+  values.push_back({op, type, block, line, static_cast<uint32_t>(operands.size()),
+    static_cast<uint32_t>(arguments.size()), immediate});
+  operands.insert(operands.end(), arguments.begin(), arguments.end());
+  names.emplace_back();
+  return value;
+}
+
+
+static std::string constantText(const SSAProgram& program, const SSAInstruction& instruction) {
+  std::ostringstream out;
+  switch (instruction.type) {
+    case TypeTable::FLOAT: {
+      double value;
+      std::memcpy(&value, &instruction.immediate, sizeof(value));
+      out << value;
+      break;
+    }
+    case TypeTable::CHAR:
+      out << "'" << static_cast<char>(instruction.immediate) << "'";
+      break;
+    case TypeTable::BOOL:
+      out << (instruction.immediate ? "true" : "false");
+      break;
+    case TypeTable::STRING:
+      out << '"' << program.strings[static_cast<size_t>(instruction.immediate)] << '"';
+      break;
+    default:
+      out << instruction.immediate;
+      break;
+  }
+  return out.str();
+}
+
+std::string dump(const SSAProgram& program, const TypeTable& types) {
+  std::ostringstream out;
+  for (const SSAFunction& function : program.functions) {
+    out << "function " << function.name << "(";
+    for (uint32_t i = 0; i < function.parameters; ++i) {
+      out << (i ? ", " : "") << "%" << i;
+    }
+    out << ") -> " << types.toString(function.returnType) << std::endl;
+
+    for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+      out << "b" << block << ":";
+      const SSABlock& current = function.blocks[block];
+      if (!current.predecessors.empty()) {
+        out << " ; preds";
+        for (const uint32_t predecessor : current.predecessors) {
+          out << " b" << predecessor;
+        }
+      }
+      out << std::endl;
+
+      for (const SSAValue value : current.instructions) {
+        const SSAInstruction& instruction = function.values[value];
+        std::ostringstream line;
+        line << "  ";
+        if (instruction.type != TypeTable::VOID) {
+          line << "%" << value << " = ";
+        }
+        line << SSA_OPCODE_MNEMONICS[static_cast<uint8_t>(instruction.op)];
+
+        std::vector<std::string> parts;
+        const auto operands = function.operandsOf(value);
+        switch (instruction.op) {
+          case SSAOp::PARAMETER:
+          case SSAOp::LOAD_GLOBAL:
+          case SSAOp::STORE_GLOBAL:
+            parts.push_back(instruction.op == SSAOp::PARAMETER
+              ? std::to_string(instruction.immediate)
+              : "@" + program.globalNames[static_cast<size_t>(instruction.immediate)]);
+            break;
+          case SSAOp::CONSTANT:
+            parts.push_back(constantText(program, instruction));
+            break;
+          case SSAOp::CALL:
+            parts.push_back(program.functions[static_cast<size_t>(instruction.immediate)].name);
+            break;
+          case SSAOp::NEW_ARRAY:
+            parts.emplace_back(valueKindName(arrayLeaf(static_cast<uint32_t>(instruction.immediate))));
+            if (isLocalArray(static_cast<uint32_t>(instruction.immediate))) {
+              parts.emplace_back("local");
+            }
+            break;
+          case SSAOp::READ:
+            parts.emplace_back(valueKindName(static_cast<ValueKind>(instruction.immediate)));
+            break;
+          case SSAOp::TRAP:
+            parts.push_back('"' + program.strings[static_cast<size_t>(instruction.immediate)] + '"');
+            break;
+          default:
+            break;
+        }
+        for (size_t i = 0; i < operands.size(); ++i) {
+          if (instruction.op == SSAOp::PHI) {
+            parts.push_back("[%" + std::to_string(operands[i]) + ", b" +
+              std::to_string(current.predecessors[i]) + "]");
+          } else {
+            parts.push_back("%" + std::to_string(operands[i]));
+          }
+        }
+        for (const uint32_t successor : current.successors) {
+          if (instruction.op == SSAOp::JUMP || instruction.op == SSAOp::BRANCH) {
+            parts.push_back("b" + std::to_string(successor));
+          }
+        }
+        if ((instruction.op == SSAOp::LOAD_INDEX || instruction.op == SSAOp::STORE_INDEX) && instruction.immediate) {
+          parts.emplace_back("unchecked");
+        }
+        for (size_t i = 0; i < parts.size(); ++i) {
+          line << (i ? ", " : " ") << parts[i];
+        }
+        if (instruction.type != TypeTable::VOID) {
+          line << " : " << types.toString(instruction.type);
+        }
+        out << line.str();
+        if (!function.names[value].empty()) {
+          out << std::string(line.str().size() < 40 ? 40 - line.str().size() : 1, ' ') << "; "
+              << function.names[value];
+        }
+        out << std::endl;
+      }
+    }
+    out << std::endl;
+  }
+  return out.str();
+}
+
+
+std::vector<uint32_t> dominators(const SSAFunction& function) {
+  constexpr uint32_t NONE = UINT32_MAX;
+  const size_t count = function.blocks.size();
+
+  // reverse postorder from the entry
+  std::vector<uint32_t> order;
+  std::vector<uint8_t> state(count, 0);
+  std::vector<std::pair<uint32_t, size_t>> stack = {{0, 0}};
+  state[0] = 1;
+  while (!stack.empty()) {
+    auto& [block, next] = stack.back();
+    const auto& successors = function.blocks[block].successors;
+    if (next < successors.size()) {
+      const uint32_t successor = successors[next++];
+      if (!state[successor]) {
+        state[successor] = 1;
+        stack.emplace_back(successor, 0);
+      }
+    } else {
+      order.push_back(block);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  std::vector<uint32_t> rank(count, NONE);
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    rank[order[i]] = i;
+  }
+
+  std::vector<uint32_t> idom(count, NONE);
+  idom[0] = 0;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = 1; i < order.size(); ++i) {
+      const uint32_t block = order[i];
+      uint32_t dominator = NONE;
+      for (const uint32_t predecessor : function.blocks[block].predecessors) {
+        if (idom[predecessor] == NONE) {
+          continue; // not processed yet, or unreachable
+        }
+        if (dominator == NONE) {
+          dominator = predecessor;
+          continue;
+        }
+        uint32_t a = predecessor;
+        uint32_t b = dominator;
+        while (a != b) { // walk up to the common dominator
+          while (rank[a] > rank[b]) {
+            a = idom[a];
+          }
+          while (rank[b] > rank[a]) {
+            b = idom[b];
+          }
+        }
+        dominator = a;
+      }
+      if (idom[block] != dominator) {
+        idom[block] = dominator;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+
+std::vector<SSALoop> findLoops(const SSAFunction& function) {
+  const std::vector<uint32_t> idom = dominators(function);
+  const auto dominates = [&](const uint32_t dominator, uint32_t block) {
+    while (block != dominator && block != 0) {
+      block = idom[block];
+    }
+    return block == dominator;
+  };
+
+  std::vector<SSALoop> loops;
+  for (uint32_t header = 0; header < function.blocks.size(); ++header) {
+    if (idom[header] == UINT32_MAX) {
+      continue;
+    }
+    // backwards from the back edges, stopping at the header
+    std::vector<bool> inLoop(function.blocks.size(), false);
+    std::vector<uint32_t> work;
+    bool backEdge = false;
+    inLoop[header] = true;
+    for (const uint32_t predecessor : function.blocks[header].predecessors) {
+      if (dominates(header, predecessor)) {
+        backEdge = true;
+        if (!inLoop[predecessor]) {
+          inLoop[predecessor] = true;
+          work.push_back(predecessor);
+        }
+      }
+    }
+    if (!backEdge) {
+      continue;
+    }
+    while (!work.empty()) {
+      const uint32_t block = work.back();
+      work.pop_back();
+      for (const uint32_t predecessor : function.blocks[block].predecessors) {
+        if (!inLoop[predecessor] && idom[predecessor] != UINT32_MAX) {
+          inLoop[predecessor] = true;
+          work.push_back(predecessor);
+        }
+      }
+    }
+    SSALoop& loop = loops.emplace_back();
+    loop.header = header;
+    loop.blocks.push_back(header);
+    for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+      if (inLoop[block] && block != header) {
+        loop.blocks.push_back(block);
+      }
+    }
+  }
+  // an enclosing loop has more blocks than the loops inside it
+  std::stable_sort(loops.begin(), loops.end(), [](const SSALoop& a, const SSALoop& b) {
+    return a.blocks.size() > b.blocks.size();
+  });
+  return loops;
+}
+
+
+void removePredecessor(SSAFunction& function, const uint32_t block, const size_t index) {
+  SSABlock& target = function.blocks[block];
+  target.predecessors.erase(target.predecessors.begin() + static_cast<ptrdiff_t>(index));
+  for (const SSAValue phi : target.instructions) {
+    if (function.values[phi].op != SSAOp::PHI) {
+      break;
+    }
+    const auto operands = function.operandsOf(phi);
+    std::copy(operands.begin() + static_cast<ptrdiff_t>(index) + 1, operands.end(),
+      operands.begin() + static_cast<ptrdiff_t>(index));
+    --function.values[phi].operandCount;
+  }
+}
+
+
+void compact(SSAFunction& function, const std::vector<uint32_t>& layout) {
+  constexpr uint32_t NONE = UINT32_MAX;
+  const size_t count = function.blocks.size();
+
+  std::vector<bool> reachable(count, false);
+  std::vector<uint32_t> work = {0};
+  reachable[0] = true;
+  while (!work.empty()) {
+    const uint32_t block = work.back();
+    work.pop_back();
+    for (const uint32_t successor : function.blocks[block].successors) {
+      if (!reachable[successor]) {
+        reachable[successor] = true;
+        work.push_back(successor);
+      }
+    }
+  }
+  for (uint32_t block = 0; block < count; ++block) {
+    if (!reachable[block]) {
+      continue;
+    }
+    auto& predecessors = function.blocks[block].predecessors;
+    for (size_t i = predecessors.size(); i-- > 0;) {
+      if (!reachable[predecessors[i]]) {
+        removePredecessor(function, block, i);
+      }
+    }
+  }
+
+  std::vector<uint32_t> order;
+  if (layout.empty()) {
+    for (uint32_t block = 0; block < count; ++block) {
+      order.push_back(block);
+    }
+  } else {
+    order = layout;
+  }
+  std::vector<uint32_t> blockId(count, NONE);
+  std::vector<uint32_t> kept;
+  for (const uint32_t block : order) {
+    if (reachable[block]) {
+      blockId[block] = static_cast<uint32_t>(kept.size());
+      kept.push_back(block);
+    }
+  }
+
+  SSAFunction result;
+  result.name = std::move(function.name);
+  result.parameters = function.parameters;
+  result.returnType = function.returnType;
+  result.localStrings = function.localStrings;
+  std::vector<SSAValue> valueId(function.values.size(), NONE);
+  for (const uint32_t block : kept) {
+    for (const SSAValue value : function.blocks[block].instructions) {
+      valueId[value] = static_cast<SSAValue>(result.values.size());
+      result.values.push_back(function.values[value]);
+      result.values.back().block = blockId[block];
+      result.names.push_back(std::move(function.names[value]));
+    }
+  }
+  for (SSAValue value = 0; value < valueId.size(); ++value) {
+    if (valueId[value] == NONE) {
+      continue;
+    }
+    SSAInstruction& instruction = result.values[valueId[value]];
+    instruction.firstOperand = static_cast<uint32_t>(result.operands.size());
+    for (const SSAValue operand : function.operandsOf(value)) {
+      result.operands.push_back(valueId[operand]);
+    }
+  }
+  result.blocks.resize(kept.size());
+  for (uint32_t block = 0; block < kept.size(); ++block) {
+    SSABlock& source = function.blocks[kept[block]];
+    SSABlock& target = result.blocks[block];
+    for (const SSAValue value : source.instructions) {
+      target.instructions.push_back(valueId[value]);
+    }
+    for (const uint32_t predecessor : source.predecessors) {
+      target.predecessors.push_back(blockId[predecessor]);
+    }
+    for (const uint32_t successor : source.successors) {
+      target.successors.push_back(blockId[successor]);
+    }
+  }
+  function = std::move(result);
+}
+
+
+static void fail(const SSAFunction& function, const std::string& message) {
+  throw std::runtime_error("SSA verification error in '" + function.name + "': " + message + ".");
+}
+
+static void verifyFunction(const SSAFunction& function) {
+  const auto blockCount = static_cast<uint32_t>(function.blocks.size());
+  if (blockCount == 0) {
+    fail(function, "no blocks");
+  }
+  if (!function.blocks[0].predecessors.empty()) {
+    fail(function, "the entry block has predecessors");
+  }
+
+  // position of every instruction in its block
+  std::vector<uint32_t> position(function.values.size(), UINT32_MAX);
+  for (uint32_t block = 0; block < blockCount; ++block) {
+    const SSABlock& current = function.blocks[block];
+    const std::string where = "b" + std::to_string(block);
+    if (current.instructions.empty() || !isTerminator(function.values[current.instructions.back()].op)) {
+      fail(function, where + " does not end with a terminator");
+    }
+    bool phis = true;
+    for (uint32_t i = 0; i < current.instructions.size(); ++i) {
+      const SSAValue value = current.instructions[i];
+      if (value >= function.values.size() || position[value] != UINT32_MAX) {
+        fail(function, where + " lists %" + std::to_string(value) + " wrongly");
+      }
+      const SSAInstruction& instruction = function.values[value];
+      position[value] = i;
+      if (instruction.block != block) {
+        fail(function, "%" + std::to_string(value) + " is listed in " + where + " but belongs elsewhere");
+      }
+      if (isTerminator(instruction.op) && i + 1 != current.instructions.size()) {
+        fail(function, where + " has a terminator before its end");
+      }
+      if (instruction.op == SSAOp::PHI) {
+        if (!phis) {
+          fail(function, "phi %" + std::to_string(value) + " follows other instructions");
+        }
+        if (instruction.operandCount != current.predecessors.size()) {
+          fail(function, "phi %" + std::to_string(value) + " has " + std::to_string(instruction.operandCount) +
+            " operands for " + std::to_string(current.predecessors.size()) + " predecessors");
+        }
+      } else {
+        phis = false;
+      }
+      if (instruction.op == SSAOp::PARAMETER && (block != 0 || instruction.immediate >= function.parameters)) {
+        fail(function, "parameter %" + std::to_string(value) + " is misplaced");
+      }
+    }
+
+    // the successors are the terminator's targets, each edge is seen from both ends
+    const SSAOp terminator = function.values[current.instructions.back()].op;
+    const size_t targets = terminator == SSAOp::BRANCH ? 2 : terminator == SSAOp::JUMP ? 1 : 0;
+    if (current.successors.size() != targets) {
+      fail(function, where + " has " + std::to_string(current.successors.size()) + " successors for its " +
+        SSA_OPCODE_MNEMONICS[static_cast<uint8_t>(terminator)]);
+    }
+    for (const uint32_t successor : current.successors) {
+      if (successor >= blockCount) {
+        fail(function, where + " jumps to a missing block");
+      }
+      const auto& predecessors = function.blocks[successor].predecessors;
+      if (std::count(predecessors.begin(), predecessors.end(), block) !=
+        std::count(current.successors.begin(), current.successors.end(), successor)) {
+        fail(function, "the edge " + where + " -> b" + std::to_string(successor) + " is not mirrored");
+      }
+    }
+    for (const uint32_t predecessor : current.predecessors) {
+      if (predecessor >= blockCount) {
+        fail(function, where + " has a missing predecessor");
+      }
+      const auto& successors = function.blocks[predecessor].successors;
+      if (std::find(successors.begin(), successors.end(), block) == successors.end()) {
+        fail(function, "the edge b" + std::to_string(predecessor) + " -> " + where + " is not mirrored");
+      }
+    }
+  }
+
+  const std::vector<uint32_t> idom = dominators(function);
+  for (uint32_t block = 0; block < blockCount; ++block) {
+    if (idom[block] == UINT32_MAX) {
+      fail(function, "b" + std::to_string(block) + " is unreachable");
+    }
+  }
+  const auto dominates = [&](const uint32_t dominator, uint32_t block) {
+    while (block != dominator && block != 0) {
+      block = idom[block];
+    }
+    return block == dominator;
+  };
+
+  for (uint32_t block = 0; block < blockCount; ++block) {
+    const SSABlock& current = function.blocks[block];
+    for (const SSAValue value : current.instructions) {
+      const SSAInstruction& instruction = function.values[value];
+      const auto operands = function.operandsOf(value);
+      for (size_t i = 0; i < operands.size(); ++i) {
+        const SSAValue operand = operands[i];
+        const std::string use = "%" + std::to_string(operand) + " used by %" + std::to_string(value);
+        if (operand >= function.values.size() || position[operand] == UINT32_MAX) {
+          fail(function, use + " is not in any block");
+        }
+        const SSAInstruction& definition = function.values[operand];
+        if (definition.type == TypeTable::VOID || definition.type == TypeTable::ERROR) {
+          fail(function, use + " has no value");
+        }
+        if (instruction.op == SSAOp::PHI) {
+          if (definition.type != instruction.type) {
+            fail(function, use + " is of another type than the phi");
+          }
+          if (!dominates(definition.block, current.predecessors[i])) {
+            fail(function, use + " does not dominate the end of b" + std::to_string(current.predecessors[i]));
+          }
+        } else if (definition.block == block ? position[operand] >= position[value]
+          : !dominates(definition.block, block)) {
+          fail(function, use + " does not dominate the use");
+        }
+      }
+    }
+  }
+}
+
+void verify(const SSAProgram& program) {
+  for (const SSAFunction& function : program.functions) {
+    verifyFunction(function);
+  }
+}
+
+
+void splitCriticalEdges(SSAFunction& function) {
+  const auto original = static_cast<uint32_t>(function.blocks.size());
+  for (uint32_t block = 0; block < original; ++block) {
+    if (function.blocks[block].successors.size() < 2) {
+      continue;
+    }
+    for (size_t i = 0; i < function.blocks[block].successors.size(); ++i) {
+      const uint32_t successor = function.blocks[block].successors[i];
+      const SSABlock& target = function.blocks[successor];
+      if (target.instructions.empty() || function.values[target.instructions.front()].op != SSAOp::PHI) {
+        continue;
+      }
+      // the edges from `block` to `successor` before this one are split already, so the
+      // first entry of `block` among the predecessors is this edge
+      auto& predecessors = function.blocks[successor].predecessors;
+      const auto entry = std::find(predecessors.begin(), predecessors.end(), block);
+
+      const auto split = static_cast<uint32_t>(function.blocks.size());
+      const uint32_t line = function.values[function.blocks[block].instructions.back()].line;
+      const SSAValue jump = function.add(SSAOp::JUMP, TypeTable::VOID, split, line, {});
+      *entry = split;
+      function.blocks[block].successors[i] = split;
+      function.blocks.push_back({{jump}, {block}, {successor}});
+    }
+  }
+}
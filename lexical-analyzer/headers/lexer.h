@@ -19,18 +19,26 @@ public:
   Token getLex();
   Token peek(size_t ind);
 
-  std::vector<Token> getTokens() {
-    position_ = 0;
-    static std::vector<Token> tokens = tokenize();
-    return tokens;
+  // Tokens of the whole source, tokenized on the first call and cached in this lexer
+  const std::vector<Token>& getTokens() {
+    if (!tokenized_) {
+      position_ = 0;
+      tokens_ = tokenize();
+      tokenized_ = true;
+    }
+    return tokens_;
   }
 
+  [[nodiscard]] const std::string& getSource() const { return program_; }
+
 private:
-  size_t ind = 0;
   std::string program_;
   size_t position_;
   Trie keywords_;
 
+  std::vector<Token> tokens_;
+  bool tokenized_ = false;
+
   // Функции для проверки символа - буква, цифра, или вообще whitespace...
   static bool isSpace(char c);
   static bool isEnter(char c);
@@ -121,6 +121,7 @@ public:
 
   [[nodiscard]] size_t getLine() const;
   [[nodiscard]] size_t getColumn() const;
+  void setPosition(size_t line, size_t column);
 
 
 private:
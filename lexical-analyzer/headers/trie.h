@@ -7,17 +7,17 @@
 
 class Trie {
   struct Word {
-    std::map<char, Word*> to;
+    std::map<char, std::unique_ptr<Word>> to;
     int64_t termCount = 0;
     bool isTerm = false;
   };
 
 public:
-  bool find(std::string&) const;
+  bool find(std::string&) const; // read-only, safe to call from several threads
   void insert(std::string&) const;
 
 private:
-  Word* root = new Word();
+  std::unique_ptr<Word> root = std::make_unique<Word>();
 };
 
 
@@ -7,6 +7,11 @@ std::vector<Token> LexicalAnalyzer::tokenize() {
   std::vector<Token> tokens;
   std::string op;
 
+  // position of the token being read (1-based), newlines are counted incrementally
+  size_t line = 1;
+  size_t lineStart = 0;
+  size_t scanned = 0;
+
   while (position_ < program_.size()) {
     const char currChar = program_[position_];
 
@@ -15,6 +20,15 @@ std::vector<Token> LexicalAnalyzer::tokenize() {
       continue;
     }
 
+    for (; scanned < position_; ++scanned) {
+      if (program_[scanned] == '\n') {
+        ++line;
+        lineStart = scanned + 1;
+      }
+    }
+    const size_t column = position_ - lineStart + 1;
+    const size_t emitted = tokens.size();
+
     if (isDigit(currChar)) {
       // std::cout << "We've found number!" << std::endl; // Для проверки
 
@@ -58,6 +72,8 @@ std::vector<Token> LexicalAnalyzer::tokenize() {
         tokens.emplace_back(my::TokenType::FOR, word);
       } else if (word == "while") {
         tokens.emplace_back(my::TokenType::WHILE, word);
+      } else if (word == "return") {
+        tokens.emplace_back(my::TokenType::RETURN, word);
       } else if (word == "array") {
         tokens.emplace_back(my::TokenType::ARRAY, word);
       } else if (keywords_.find(word) && isKeyword(word)) {
@@ -76,9 +92,18 @@ std::vector<Token> LexicalAnalyzer::tokenize() {
       }
     } else if (isOperator(op)) {
       // std::cout << "We've found operator!" << std::endl << std::endl; // Для проверки
-      if ((program_[position_] == '-' || program_[position_] == '+')
-        && position_ < program_.size() && isDigit(program_[position_ + 1])) {
-        std::string emplaceNumber = "-";
+      // a sign glued to a number is part of the literal, unless it follows an operand ('n-4')
+      const bool afterOperand = !tokens.empty() && (
+        tokens.back().getType() == my::TokenType::IDENTIFIER ||
+        tokens.back().getType() == my::TokenType::INTEGER_LITERAL ||
+        tokens.back().getType() == my::TokenType::FLOAT_LITERAL ||
+        tokens.back().getType() == my::TokenType::CHAR_LITERAL ||
+        tokens.back().getType() == my::TokenType::STRING_LITERAL ||
+        tokens.back().getType() == my::TokenType::RPAREN ||
+        tokens.back().getType() == my::TokenType::RBRACKET);
+      if ((program_[position_] == '-' || program_[position_] == '+') && !afterOperand
+        && position_ + 1 < program_.size() && isDigit(program_[position_ + 1])) {
+        std::string emplaceNumber = program_[position_] == '-' ? "-" : "";
         ++position_;
 
         std::string number = getNumber();
@@ -109,10 +134,21 @@ std::vector<Token> LexicalAnalyzer::tokenize() {
       tokens.emplace_back(my::TokenType::UNKNOWN, std::string(1, currChar));
       ++position_;
     }
+
+    if (tokens.size() > emitted) {
+      tokens.back().setPosition(line, column);
+    }
   }
 
   // std::cout << "The END!" << std::endl << std::endl; // Для проверки
   tokens.emplace_back(my::TokenType::END, "");
+  for (; scanned < program_.size(); ++scanned) {
+    if (program_[scanned] == '\n') {
+      ++line;
+      lineStart = scanned + 1;
+    }
+  }
+  tokens.back().setPosition(line, position_ - lineStart + 1);
 
   return tokens;
 }
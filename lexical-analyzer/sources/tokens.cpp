@@ -16,3 +16,7 @@ size_t Token::getLine() const {
 size_t Token::getColumn() const {
   return position_.second;
 }
+
+void Token::setPosition(const size_t line, const size_t column) {
+  position_ = {line, column};
+}
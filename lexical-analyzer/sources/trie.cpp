@@ -2,27 +2,29 @@
 
 
 bool Trie::find(std::string& str) const {
-  Word* v = root;
+  const Word* v = root.get();
 
   for (auto ch : str) {
-    if (!v->to[ch]) {
+    const auto next = v->to.find(ch);
+    if (next == v->to.end()) {
       return false;
     }
-    v = v->to[ch];
+    v = next->second.get();
   }
 
   return true;
 }
 
 void Trie::insert(std::string& str) const {
-  Word* v = root;
+  Word* v = root.get();
 
   ++v->termCount;
   for (auto ch : str) {
-    if (!v->to[ch]) {
-      v->to[ch] = new Word();
+    auto& next = v->to[ch];
+    if (!next) {
+      next = std::make_unique<Word>();
     }
-    v = v->to[ch];
+    v = next.get();
     ++v->termCount;
   }
   v->isTerm = true;
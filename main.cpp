@@ -1,9 +1,9 @@
 #include "includes/libraries.h"
 #include "global_functions/global_funcs.h"
 
-#include "lexical-analyzer/headers/lexer.h"
-#include "syntax-analyzer/headers/parser.h"
-#include "semantic-analyzer/headers/semantic.h"
+#include "compiler/headers/compilation-context.h"
+#include "virtual-machine/headers/register-vm.h"
+#include "virtual-machine/headers/vm.h"
 
 #include <filesystem>
 
@@ -17,9 +17,165 @@ void printTokens(const std::vector<Token>& tokens) {
 }
 
 
-int main() {
-  // files' paths with Cppt code and keywords
-  const std::string fileName = "../assets/source_file.cppt";
+// Runs the generated bytecode of the chosen backend; returns the dispatched instructions
+// (and where the run's memory went into `memory`, if given)
+uint64_t execute(const CompilationContext& context, const bool registers, const bool jit, const size_t callDepth,
+  MemoryStatistics* memory = nullptr) {
+  if (registers) {
+    RegisterMachine vm(context.getRegisterBytecode());
+    vm.setCallDepthLimit(callDepth);
+    vm.run(std::cin, std::cout);
+    if (memory) {
+      *memory = vm.getMemoryStatistics();
+    }
+    return vm.getExecutedInstructions();
+  }
+  VirtualMachine vm(context.getBytecode());
+  vm.setCallDepthLimit(callDepth);
+  vm.setJit(jit);
+  vm.run(std::cin, std::cout);
+  if (memory) {
+    *memory = vm.getMemoryStatistics();
+  }
+  return vm.getExecutedInstructions();
+}
+
+
+// Compiles and executes a program without the debugging output (Language --run <file>)
+int runProgram(const std::string& sourceCode, const std::string& keywordsPath, const bool registers,
+  const bool optimize, const bool jit, const bool ssa, const bool regions, const size_t callDepth) {
+  CompilationContext context(sourceCode, keywordsPath);
+  context.setOptimization(optimize);
+  context.setPeephole(optimize);
+  context.setSSA(ssa);
+  context.setRegions(regions);
+  try {
+    if (registers) {
+      context.generateRegisters();
+    } else {
+      context.generate();
+    }
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      std::cerr << diagnostic.toString() << std::endl;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -5;
+  }
+
+  try {
+    execute(context, registers, jit, callDepth);
+  } catch (const std::exception& e) {
+    std::cout.flush();
+    std::cerr << e.what() << std::endl;
+    return -7;
+  }
+  return 0;
+}
+
+
+// Prints the verified SSA form of a program (Language --emit-ssa <file>)
+int printSSA(const std::string& sourceCode, const std::string& keywordsPath, const bool optimize) {
+  CompilationContext context(sourceCode, keywordsPath);
+  context.setOptimization(optimize);
+  try {
+    const SSAProgram& program = context.buildSSA();
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      std::cerr << diagnostic.toString() << std::endl;
+    }
+    std::cout << dump(program, context.getTypes());
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -5;
+  }
+  return 0;
+}
+
+
+// Translates a program to C++ and prints it (Language --emit-cpp <file>) or, given an
+// executable's path, compiles it with the local C++ compiler (Language --native <file>)
+int buildProgram(const std::string& sourceCode, const std::string& keywordsPath, const bool optimize,
+  const std::string& executable) {
+  CompilationContext context(sourceCode, keywordsPath);
+  context.setOptimization(optimize);
+  try {
+    const std::string& cpp = context.generateCpp();
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      std::cerr << diagnostic.toString() << std::endl;
+    }
+    if (executable.empty()) {
+      std::cout << cpp;
+    } else {
+      compileNative(cpp, executable);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -5;
+  }
+  return 0;
+}
+
+
+int main(const int argc, char** argv) {
+  // files' paths with Cppt code and keywords (the source file can be given as an argument);
+  // options: --run (no debugging output), --backend=stack|register (the bytecode to run),
+  // --no-optimize (generate code from the AST as written, no peephole pass), --jit (compile
+  // hot functions of the stack bytecode to native code, Linux x86-64), --ssa (generate either
+  // bytecode from the SSA form), --emit-ssa (print the SSA form), --max-call-depth=<n> (calls
+  // in progress before a stack overflow), --no-regions (every array and string on the heap,
+  // none in the region of its call), --emit-cpp (print the program translated to C++20),
+  // --native (compile that C++ to an executable, named by --output=<path> or after the source
+  // file)
+  bool runOnly = false;
+  bool emitCpp = false;
+  bool native = false;
+  std::string executable;
+  bool registers = false;
+  bool optimize = true;
+  bool jit = false;
+  bool ssa = false;
+  bool emitSSA = false;
+  bool regions = true;
+  size_t callDepth = VirtualMachine::DEFAULT_CALL_DEPTH;
+  std::string fileName = "../assets/source_file.cppt";
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument = argv[i];
+    if (argument == "--run") {
+      runOnly = true;
+    } else if (argument == "--backend=stack" || argument == "--backend=register") {
+      registers = argument == "--backend=register";
+    } else if (argument == "--no-optimize") {
+      optimize = false;
+    } else if (argument == "--jit") {
+      jit = true;
+    } else if (argument == "--ssa") {
+      ssa = true;
+    } else if (argument == "--emit-ssa") {
+      emitSSA = true;
+    } else if (argument == "--no-regions") {
+      regions = false;
+    } else if (argument.starts_with("--max-call-depth=")) {
+      try {
+        callDepth = std::stoul(argument.substr(std::string("--max-call-depth=").size()));
+      } catch (const std::exception&) {
+        std::cerr << "Invalid call depth in \"" << argument << "\"" << std::endl;
+        return 1;
+      }
+    } else if (argument == "--emit-cpp") {
+      emitCpp = true;
+    } else if (argument == "--native") {
+      native = true;
+    } else if (argument.starts_with("--output=")) {
+      executable = argument.substr(std::string("--output=").size());
+    } else if (argument.starts_with("--")) {
+      std::cerr << "Unknown option \"" << argument << "\" (expected --run, --backend=stack|register, "
+                << "--no-optimize, --jit, --ssa, --emit-ssa, --max-call-depth=<n>, --no-regions, --emit-cpp, --native, "
+                << "--output=<path>)" << std::endl;
+      return 1;
+    } else {
+      fileName = argument;
+    }
+  }
   const std::string keywordsPath = "../assets/keywords.txt";
 
   // open file...
@@ -46,9 +202,6 @@ int main() {
     return -1;
   }
 
-  // print file's value in bytes
-  std::cout << "File size: " << lengthOfFile << " bytes" << std::endl << std::endl;
-
   // check the correctness of the file's size calculation
   if (lengthOfFile == -1) {
     std::cerr << "Error: failed to determine file length." << std::endl;
@@ -72,19 +225,42 @@ int main() {
   // close file
   sourceFile.close();
 
+  if (emitSSA) {
+    return printSSA(sourceCode, keywordsPath, optimize);
+  }
+
+  if (emitCpp || native) {
+    if (native && executable.empty()) {
+      executable = std::filesystem::path(fileName).stem().string();
+    }
+    return buildProgram(sourceCode, keywordsPath, optimize, native ? executable : "");
+  }
+
+  if (runOnly) {
+    return runProgram(sourceCode, keywordsPath, registers, optimize, jit, ssa, regions, callDepth);
+  }
+
+  // print file's value in bytes
+  std::cout << "File size: " << lengthOfFile << " bytes" << std::endl << std::endl;
+
   // output file's content (for check)
   std::cout << "Full source code content:" << std::endl;
   std::cout << "````````````````````````````````Cppt````````````````````````````````" << std::endl;
   std::cout << sourceCode << std::endl;
   std::cout << "````````````````````````````````````````````````````````````````````" << std::endl;
 
-  // analyze file's content by lexer
-  LexicalAnalyzer lexer(sourceCode, keywordsPath);
+  // the whole compilation's state (source, tokens, AST, tables) lives in the context
+  CompilationContext context(sourceCode, keywordsPath);
+  context.setVerbose(true);
+  context.setOptimization(optimize);
+  context.setPeephole(optimize);
+  context.setSSA(ssa);
+  context.setRegions(regions);
 
   // debugging output (lexer is going to work)
   std::cout << "Starting tokenization..." << std::endl << std::endl;
 
-  const std::vector<Token> tokens = lexer.tokenize();
+  const std::vector<Token>& tokens = context.tokenize();
 
   // std::cout << "Source code:\n" << sourceCode << std::endl << std::endl;
   std::cout << "Tokenization completed." << std::endl << std::endl << std::endl;
@@ -95,27 +271,101 @@ int main() {
 
   // parser is going to work
   std::cout << std::endl << std::endl << std::endl << std::endl;
-  Parser parser(lexer);
 
   // catch parser's errors
   try {
-    parser.program();
+    context.parse();
     std::cout << "Syntax analyzer has completed successfully!" << std::endl;
-
-    // Semantic analysis
-    /*try {
-      // start semantic here:
-      TID tid;
-      SemanticAnalyzer semantic(tid, );
-      std::cout << "Semantic analysis completed successfully!" << std::endl;
-    } catch (const std::exception& e) {
-      std::cerr << "Semantic analysis error: " << e.what() << std::endl;
-      return -1;
-    }*/
   } catch (const std::exception& e) {
     std::cerr << "Parser's errors: " << e.what() << std::endl;
     return -4;
   }
 
+  // Semantic analysis
+  try {
+    context.analyze();
+    for (const auto& diagnostic : context.getDiagnostics()) {
+      std::cerr << diagnostic.toString() << std::endl;
+    }
+    std::cout << "Semantic analysis completed successfully!" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "Semantic analysis error: " << e.what() << std::endl;
+    return -5;
+  }
+
+  // Bytecode generation
+  try {
+    context.optimize();
+    if (context.isOptimizing()) {
+      const OptimizationStatistics& statistics = context.getOptimizationStatistics();
+      std::cout << std::endl << "Optimizer: " << statistics.foldedExpressions << " folded, "
+                << statistics.propagatedConstants << " propagated, " << statistics.removedStatements
+                << " statements and " << statistics.removedDeclarations << " declarations removed, "
+                << statistics.deadStores << " dead stores, " << statistics.simplifiedSwitches
+                << " switches simplified (" << statistics.rounds << " rounds)" << std::endl;
+      const RangeStatistics& ranges = context.getRangeStatistics();
+      std::cout << "Range analysis: " << ranges.proven << " of " << ranges.subscripts
+                << " subscripts proven in bounds" << std::endl;
+      const SubexpressionStatistics& subexpressions = context.getSubexpressionStatistics();
+      std::cout << "Common subexpressions: " << subexpressions.values << " values computed once for "
+                << subexpressions.reuses << " later computations" << std::endl;
+      if (context.isRegions()) {
+        const EscapeStatistics& escapes = context.getEscapeStatistics();
+        std::cout << "Escape analysis: " << escapes.localArrays << " of " << escapes.arrays
+                  << " arrays and the strings of " << escapes.localStrings << " of " << escapes.functions
+                  << " functions in call regions" << std::endl;
+      }
+    }
+    if (context.isSSA()) {
+      const SSAProgram& program = context.buildSSA();
+      if (context.isOptimizing()) {
+        const InliningStatistics& inlining = context.getInliningStatistics();
+        std::cout << "Inliner: " << inlining.calls << " calls to " << inlining.functions << " functions inlined, "
+                  << inlining.recursive << " recursive functions left alone" << std::endl;
+        const SSAOptimizationStatistics& statistics = context.getSSAOptimizationStatistics();
+        std::cout << "SSA optimizer: " << statistics.folded << " folded, " << statistics.branches
+                  << " branches resolved, " << statistics.phis << " phis and " << statistics.dead
+                  << " dead values removed, " << statistics.merged << " blocks merged (" << statistics.rounds
+                  << " rounds)" << std::endl;
+        const LoopStatistics& loops = context.getLoopStatistics();
+        std::cout << "Loops: " << loops.loops << " loops, " << loops.preheaders << " preheaders added, "
+                  << loops.hoisted << " invariant values hoisted, " << loops.reduced
+                  << " multiplications strength-reduced" << std::endl;
+      }
+      std::cout << std::endl << "SSA:" << std::endl << dump(program, context.getTypes());
+    }
+    if (registers) {
+      std::cout << std::endl << "Register bytecode:" << std::endl << disassemble(context.generateRegisters());
+    } else {
+      const RPNProgram& bytecode = context.generate();
+      if (context.isPeephole()) {
+        const PeepholeStatistics& statistics = context.getPeepholeStatistics();
+        std::cout << "Peephole: " << statistics.superinstructions << " superinstructions, "
+                  << statistics.threadedJumps << " jumps threaded, " << statistics.removedInstructions
+                  << " instructions removed" << std::endl;
+      }
+      std::cout << std::endl << "Bytecode:" << std::endl << disassemble(bytecode);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Code generation error: " << e.what() << std::endl;
+    return -6;
+  }
+
+  // Execution
+  std::cout << std::endl << "Program output:" << std::endl;
+  try {
+    MemoryStatistics memory;
+    const uint64_t executed = execute(context, registers, jit, callDepth, &memory);
+    std::cout << std::endl << "Executed " << executed << " instructions." << std::endl;
+    std::cout << "Memory: " << memory.region.arrays << " arrays and " << memory.region.strings
+              << " strings in call regions (" << memory.region.bytes << " bytes, at most " << memory.region.peakBytes
+              << " at once, " << memory.region.chunks << " chunks), " << memory.heapObjects << " heap objects alive, "
+              << memory.freedObjects << " freed by " << memory.collections << " collections" << std::endl;
+  } catch (const std::exception& e) {
+    std::cout.flush();
+    std::cerr << std::endl << e.what() << std::endl;
+    return -7;
+  }
+
   return 0;
 }
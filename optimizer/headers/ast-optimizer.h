@@ -0,0 +1,99 @@
+#ifndef AST_OPTIMIZER_H
+#define AST_OPTIMIZER_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/tid.h"
+#include "../../semantic-analyzer/headers/types.h"
+#include "../../virtual-machine/headers/runtime.h"
+
+
+// What one ASTOptimizer::optimize() changed
+struct OptimizationStatistics {
+  size_t rounds = 0;
+  size_t foldedExpressions = 0; // operators on constants, short-circuits decided at compile time
+  size_t propagatedConstants = 0; // reads of a local replaced by its only value
+  size_t removedStatements = 0; // unreachable, constant branches, effect-free expression statements
+  size_t deadStores = 0; // assignments whose value is never read
+  size_t removedDeclarations = 0; // locals that are never read
+  size_t simplifiedSwitches = 0; // switches on a constant replaced by the chosen arm
+};
+
+
+// Machine-independent optimization of an analysed AST (types and bindings set), before
+// either backend lowers it; runs in rounds until nothing changes, since every rewrite
+// can enable another one:
+//   - operators on literals are folded with the interpreters' own Runtime, so a folded
+//     program computes exactly what the unfolded one does (an operation that fails at
+//     run time, like a division by zero, is left in place);
+//   - a local that is declared with a literal (or without a value) and never assigned
+//     again is replaced by that literal;
+//   - `if`, `while`, `for` and `switch` on constants keep only the code that can run,
+//     and instructions after `return`, `break` and `continue` are dropped;
+//   - stores that no path reads (liveness over the function's ControlFlowGraph) and
+//     locals that are never read are removed when evaluating them cannot fail.
+// Globals are left alone: functions may run before the top-level code assigns them.
+class ASTOptimizer {
+public:
+  ASTOptimizer(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  void optimize(const ASTNodePtr& program);
+
+  [[nodiscard]] const OptimizationStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr size_t MAX_ROUNDS = 8;
+
+  const TID& tid_;
+  const TypeTable& types_;
+  Runtime runtime_; // evaluates folded operators exactly like the interpreters
+  OptimizationStatistics statistics_;
+  bool changed_ = false;
+
+  // facts about the locals of the code being optimized, gathered at the start of a round
+  std::unordered_map<uint32_t, const ASTNode*> declarations_;
+  std::unordered_map<uint32_t, uint32_t> reads_;
+  std::unordered_set<uint32_t> assigned_;
+  std::unordered_map<uint32_t, ASTNodePtr> constants_; // binding -> literal of the declared type
+  std::unordered_set<const ASTNode*> deadStores_; // targets of assignments nobody reads
+
+  void optimizeFunction(const ASTNodePtr& function);
+  void optimizeTopLevel(const ASTNodePtr& program);
+
+  void beginRound();
+  void collect(const ASTNodePtr& node);
+  void findConstants();
+  void findDeadStores(const ASTNodePtr& function);
+
+  // Rewritten statement, nullptr if it is removed
+  ASTNodePtr statement(const ASTNodePtr& node);
+  // Rewritten instruction list, cut after the first one that never completes
+  std::vector<ASTNodePtr> statements(const std::vector<ASTNodePtr>& instructions, size_t first);
+  ASTNodePtr loop(const ASTNodePtr& node);
+  ASTNodePtr switchStatement(const ASTNodePtr& node);
+  ASTNodePtr declaration(const ASTNodePtr& node);
+  ASTNodePtr expression(const ASTNodePtr& node);
+  ASTNodePtr fold(const ASTNodePtr& node);
+
+  // Value of a literal node, literal node of a value (nullptr if `type` does not match)
+  Value literalValue(const ASTNodePtr& literal);
+  ASTNodePtr makeLiteral(const Value& value, TypeId type, uint32_t line) const;
+  // Zero value of a scalar or string type
+  Value zeroValue(TypeId type);
+  // Kind of the values of a scalar or string type (VOID for the others)
+  [[nodiscard]] static ValueKind valueKind(TypeId type);
+
+  [[nodiscard]] bool isLocal(uint32_t binding) const;
+  // Evaluating `node` has no effect and cannot fail
+  [[nodiscard]] static bool isPure(const ASTNodePtr& node);
+  // Storing a `source` value into a `target` variable cannot fail (float to int can)
+  [[nodiscard]] static bool isSafeConversion(TypeId target, TypeId source);
+  // Control never reaches the instruction after `node`
+  [[nodiscard]] static bool leaves(const ASTNodePtr& node);
+  // `node` has a `break` of the enclosing switch or loop
+  [[nodiscard]] static bool breaksOut(const ASTNodePtr& node);
+};
+
+
+#endif //AST_OPTIMIZER_H
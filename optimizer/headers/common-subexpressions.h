@@ -0,0 +1,98 @@
+#ifndef COMMON_SUBEXPRESSIONS_H
+#define COMMON_SUBEXPRESSIONS_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/tid.h"
+
+
+// What one CommonSubexpressions::analyze() found
+struct SubexpressionStatistics {
+  size_t values = 0; // computations kept for later ones
+  size_t reuses = 0; // computations replaced by a kept value
+};
+
+
+// Common subexpression elimination by hash-consing: the pure expressions (operators,
+// subscripts, variables and literals; no calls, `&&` or `||`) of each basic block are
+// interned into a DAG in evaluation order, so structurally equal ones over the same
+// versions of their variables are one node. A variable gets a new version when it is
+// assigned, declared or read by `cin`, a global also at every call, and subscripts
+// depend on the version of all arrays, which element stores and calls renew. A value
+// is reused where it is certainly computed already: later in the same straight-line
+// run of statements (an `if` or `switch` condition included), or in the right operand
+// of the `&&` / `||` it preceded. The backends keep the first computation in a
+// temporary and load it at the others; this pays only when the expression is big
+// enough (see isWorth), so smaller ones are left alone.
+class CommonSubexpressions {
+public:
+  explicit CommonSubexpressions(const TID& tid) : tid_(tid) {}
+
+  // The first and reusing nodes of every value worth sharing
+  SharedExpressions analyze(const ASTNodePtr& program);
+
+  [[nodiscard]] const SubexpressionStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr uint32_t LEAF = UINT32_MAX;
+  static constexpr size_t STORE_COST = 2; // keeping a value: DUP and STORE_LOCAL on the stack
+  static constexpr size_t EXPENSIVE_WEIGHT = 3; // a division or a subscript counts as this many
+
+  // A DAG node: an operator, subscript, variable version or literal over its operands
+  struct Key {
+    ASTNodeType type;
+    my::TokenType op;
+    TypeId typeId;
+    uint64_t left;
+    uint64_t right;
+    uint64_t version; // variables: own and call version; subscripts: version of the arrays
+
+    bool operator==(const Key&) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  // The computations of one value in the order they run
+  struct Occurrences {
+    const ASTNode* first;
+    size_t weight;
+    std::vector<const ASTNode*> reuses;
+  };
+
+  const TID& tid_;
+  SubexpressionStatistics statistics_;
+
+  std::unordered_map<Key, uint32_t, KeyHash> dag_;
+  std::unordered_map<std::string, uint32_t> literals_;
+  std::unordered_map<uint32_t, uint64_t> versions_; // binding -> assignments so far
+  uint64_t calls_ = 0;
+  uint64_t stores_ = 0; // element stores and calls
+
+  std::unordered_map<uint32_t, size_t> available_; // DAG node -> its occurrences, this block
+  std::vector<Occurrences> occurrences_;
+  std::unordered_set<const ASTNode*> visited_;
+
+  void statement(const ASTNodePtr& node);
+  // Walks an expression in evaluation order; a chained subscript (the array of an INDEX)
+  // is evaluated with its parent, never on its own
+  void expression(const ASTNodePtr& node, bool chained = false);
+  // An expression that can be shared: pure, an operator or subscript, seen only here
+  [[nodiscard]] bool isCandidate(const ASTNode& node) const;
+  [[nodiscard]] static bool isPure(const ASTNode& node);
+  [[nodiscard]] static size_t weight(const ASTNode& node);
+  // Whether keeping a value with `reuses` later computations saves instructions
+  [[nodiscard]] static bool isWorth(size_t weight, size_t reuses);
+
+  // The DAG node of a pure expression as it would evaluate now
+  uint32_t intern(const ASTNode& node);
+  void assign(uint32_t binding);
+  void call();
+  // Control may arrive from elsewhere: nothing computed before is known to be available
+  void flush() { available_.clear(); }
+};
+
+
+#endif //COMMON_SUBEXPRESSIONS_H
@@ -0,0 +1,73 @@
+#ifndef ESCAPE_ANALYSIS_H
+#define ESCAPE_ANALYSIS_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/tid.h"
+#include "../../semantic-analyzer/headers/types.h"
+
+
+// What one EscapeAnalysis::analyze() proved
+struct EscapeStatistics {
+  size_t arrays = 0; // array declarations in functions, each a NEW_ARRAY
+  size_t localArrays = 0; // of them, never outliving their call
+  size_t functions = 0;
+  size_t localStrings = 0; // functions none of whose strings outlive their call
+};
+
+
+// Which arrays and strings can live in the region of the frame making them, released
+// when the call returns. Flow-insensitive, per function: the array and string variables
+// (parameters included) are grouped with whatever they are assigned, and a group
+// escapes when one of its values is returned, stored in a global or an array element,
+// read into a global or passed to a parameter that escapes in its callee (parameters
+// start out not escaping and the functions are analyzed again until that is stable).
+// A concatenation belongs to the groups of its operands, a rope keeps them. An array
+// declared in a function, not in a loop, whose group does not escape is local; the
+// strings of a function are local when none of those it makes (concatenations and
+// input) escapes and none is made in a loop. Allocations in loops stay on the heap:
+// in the region they would pile up until the function returns.
+class EscapeAnalysis {
+public:
+  EscapeAnalysis(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  LocalAllocations analyze(const ASTNodePtr& program);
+
+  [[nodiscard]] const EscapeStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr uint32_t ESCAPED = 0; // the group of everything that escapes
+  static constexpr uint32_t CREATED = 1; // the strings the function makes
+
+  const TID& tid_;
+  const TypeTable& types_;
+  EscapeStatistics statistics_;
+  std::unordered_map<uint32_t, const ASTNode*> functions_; // by binding
+  std::unordered_map<const ASTNode*, std::vector<bool>> escaping_; // parameters, per FUNCTION node
+
+  // the function being analyzed
+  std::vector<uint32_t> parent_; // union-find over the groups
+  std::unordered_map<uint32_t, uint32_t> groupByBinding_;
+  std::vector<std::pair<const ASTNode*, uint32_t>> sites_; // array declarations out of loops, their groups
+  size_t loops_ = 0; // loops around the node being walked
+  bool createsInLoop_ = false;
+
+  // Analyzes `function`; returns whether the escaping parameters changed
+  bool function(const ASTNode* function, LocalAllocations& result);
+  void statement(const ASTNodePtr& node);
+  // The groups the value of `node` belongs to (none when it cannot be a local object)
+  std::vector<uint32_t> expression(const ASTNodePtr& node);
+  // The group of a local or parameter of an array or string type
+  std::optional<uint32_t> variable(const ASTNode* node);
+  void join(const std::vector<uint32_t>& groups, uint32_t group);
+  // The groups of an array or string that is no local's: escaped for an array
+  [[nodiscard]] std::vector<uint32_t> untracked(const ASTNodePtr& node) const;
+
+  [[nodiscard]] bool isTracked(TypeId type) const;
+  uint32_t find(uint32_t group);
+  void unite(uint32_t a, uint32_t b);
+};
+
+
+#endif //ESCAPE_ANALYSIS_H
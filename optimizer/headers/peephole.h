@@ -0,0 +1,55 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+
+
+// What one PeepholeOptimizer::optimize() changed
+struct PeepholeStatistics {
+  size_t superinstructions = 0; // sequences fused into one instruction
+  size_t threadedJumps = 0; // jumps retargeted past the jumps they landed on
+  size_t removedInstructions = 0; // instructions in the code before minus after
+};
+
+
+// Rewrites short instruction sequences of the stack bytecode, function by function:
+//   - jumps that land on a JUMP go straight to its target, a JUMP to the next
+//     instruction and a LOAD_LOCAL then STORE_LOCAL of the same slot are dropped;
+//   - the sequences the benchmark suite dispatches most often (LanguageBench peephole
+//     lists them) become one superinstruction: LOAD_LOCAL_PAIR, LOAD_LOCAL_ADD_CONST,
+//     INC_LOCAL, LT_I64_JUMP_IF_FALSE and GT_I64_JUMP_IF_FALSE (see bytecode.h).
+// A sequence is only fused when no jump lands inside it. Jumps, switch tables, function
+// bounds and the line table are moved to the new offsets; the operand stack never gets
+// deeper.
+class PeepholeOptimizer {
+public:
+  void optimize(RPNProgram& program);
+
+  [[nodiscard]] const PeepholeStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr size_t MAX_THREADED_JUMPS = 16; // a chain this long is a loop of jumps
+
+  struct Instruction {
+    OpCode op;
+    uint32_t operands[2];
+    uint32_t line;
+    uint32_t offset; // in the original code
+  };
+
+  PeepholeStatistics statistics_;
+
+  std::vector<Instruction> decode(const RPNProgram& program, const RPNFunction& function) const;
+  void threadJumps(RPNProgram& program, std::vector<Instruction>& instructions);
+  // The instructions with the fused sequences, the others unchanged
+  std::vector<Instruction> fuse(const RPNProgram& program, const std::vector<Instruction>& instructions);
+
+  [[nodiscard]] static bool isJump(OpCode op);
+  // SWITCH_TABLE or SWITCH_STRING: its targets are in RPNProgram::switches
+  [[nodiscard]] static bool isSwitch(OpCode op);
+};
+
+
+#endif //PEEPHOLE_H
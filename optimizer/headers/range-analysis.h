@@ -0,0 +1,104 @@
+#ifndef RANGE_ANALYSIS_H
+#define RANGE_ANALYSIS_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
+#include "../../semantic-analyzer/headers/tid.h"
+#include "../../semantic-analyzer/headers/types.h"
+
+
+// What one RangeAnalysis::analyze() proved
+struct RangeStatistics {
+  size_t subscripts = 0; // INDEX nodes, one per [ ]
+  size_t proven = 0; // of them, in bounds on every run
+};
+
+
+// Interval analysis of int variables, so that subscripts which cannot be out of bounds
+// lose their checks. Walks every function (and the top-level code) in execution order
+// with the facts that hold at each point:
+//   - a declaration or assignment gives the variable the interval of its value;
+//   - `for (i = a; i < e; i = i + 1)` (or counting down with `>` and `- 1`) keeps i in
+//     [a, e - 1] in its body when the body never assigns i;
+//   - an `if`, `while` or `&&` / `||` condition holds in the code it guards, and its
+//     negation after an `if` whose other branch always leaves.
+// Upper bounds may be symbolic, `n + k` for an int `n` that is never assigned after its
+// declaration; an array declared `a[n][m]` (and never assigned) has length n, and its
+// rows length m while none of them can be replaced (no a[i] = ..., the array is passed
+// around only as a whole row of ints). a[i] is proven when 0 <= i <= n + k with k < 0.
+// Facts about globals are only used for those no code assigns.
+class RangeAnalysis {
+public:
+  RangeAnalysis(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  // The INDEX nodes whose index is inside the array whenever they run
+  std::unordered_set<const ASTNode*> analyze(const ASTNodePtr& program);
+
+  [[nodiscard]] const RangeStatistics& getStatistics() const { return statistics_; }
+
+private:
+  static constexpr uint32_t CONSTANT = ASTNode::NO_BINDING;
+  static constexpr int64_t MAX_OFFSET = int64_t{1} << 40; // keeps the arithmetic on bounds exact
+
+  // value <= symbol + offset (the value of the never assigned int `symbol`), or <= offset
+  struct Bound {
+    uint32_t symbol = CONSTANT;
+    int64_t offset = 0;
+  };
+
+  struct Interval {
+    std::optional<int64_t> lower;
+    std::vector<Bound> upper; // all of them hold
+
+    [[nodiscard]] bool empty() const { return !lower && upper.empty(); }
+  };
+
+  using Facts = std::unordered_map<uint32_t, Interval>;
+
+  const TID& tid_;
+  const TypeTable& types_;
+  RangeStatistics statistics_;
+
+  // the whole program
+  std::unordered_set<uint32_t> assigned_; // targets of assignments and input
+  std::unordered_map<uint32_t, size_t> dimensions_; // sizes given where an array is declared
+  std::unordered_set<uint32_t> reshaped_; // arrays whose rows may be replaced
+
+  // the code being walked
+  std::unordered_map<uint32_t, std::vector<Bound>> lengths_; // array -> length of its dimensions
+  std::unordered_set<const ASTNode*> proven_;
+
+  void collect(const ASTNodePtr& node);
+  // a use of `array` indexed `depth` times, as an assignment target or as a value
+  void use(uint32_t array, size_t depth, bool target);
+  std::vector<std::tuple<uint32_t, size_t, bool>> uses_;
+
+  // Walks a statement; returns false if control never reaches the statement after it
+  bool statement(const ASTNodePtr& node, Facts& facts);
+  void loop(const ASTNodePtr& node, Facts& facts);
+  void expression(const ASTNodePtr& node, const Facts& facts);
+  void subscript(const ASTNode* node, const Facts& facts);
+  // Whether every value at most `bound` is less than `length`
+  [[nodiscard]] bool below(const Bound& bound, const Bound& length, const Facts& facts) const;
+
+  // Adds what `condition` evaluating to `truth` implies
+  void assume(const ASTNodePtr& condition, bool truth, Facts& facts) const;
+  // lhs < rhs (or lhs <= rhs when `orEqual`)
+  void assumeLess(const ASTNodePtr& lhs, const ASTNodePtr& rhs, bool orEqual, Facts& facts) const;
+  void assumeEqual(const ASTNodePtr& lhs, const ASTNodePtr& rhs, Facts& facts) const;
+
+  [[nodiscard]] Interval interval(const ASTNodePtr& node, const Facts& facts) const;
+  // An int variable facts can be kept for: a local, or a global nothing assigns
+  [[nodiscard]] bool isTracked(const ASTNodePtr& node) const;
+  [[nodiscard]] bool isSymbol(uint32_t binding) const;
+  [[nodiscard]] bool isLocal(uint32_t binding) const;
+  // Forgets the variables `node` assigns
+  void forgetAssigned(const ASTNodePtr& node, Facts& facts) const;
+
+  static void add(Interval& interval, const Interval& other);
+  [[nodiscard]] static std::optional<Bound> shift(Bound bound, int64_t delta);
+};
+
+
+#endif //RANGE_ANALYSIS_H
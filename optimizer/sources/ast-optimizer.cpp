@@ -0,0 +1,627 @@
+#include "../headers/ast-optimizer.h"
+
+#include "../../semantic-analyzer/headers/cfg.h"
+#include "../../semantic-analyzer/headers/dataflow.h"
+
+
+void ASTOptimizer::optimize(const ASTNodePtr& program) {
+  statistics_ = OptimizationStatistics();
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      optimizeFunction(declaration);
+    }
+  }
+  optimizeTopLevel(program);
+}
+
+void ASTOptimizer::optimizeFunction(const ASTNodePtr& function) {
+  for (size_t round = 0; round < MAX_ROUNDS; ++round) {
+    beginRound();
+    collect(function);
+    findConstants();
+    findDeadStores(function);
+    function->setChild(function->getChildren().size() - 1, statement(function->getChildren().back()));
+    statistics_.rounds = std::max(statistics_.rounds, round + 1);
+    if (!changed_) {
+      break;
+    }
+  }
+}
+
+// The top-level instructions: only the locals of their blocks and loops are optimized,
+// dead stores are not looked for (there is no ControlFlowGraph of the top level)
+void ASTOptimizer::optimizeTopLevel(const ASTNodePtr& program) {
+  for (size_t round = 0; round < MAX_ROUNDS; ++round) {
+    beginRound();
+    for (const auto& declaration : program->getChildren()) {
+      if (declaration->getType() != ASTNodeType::FUNCTION) {
+        collect(declaration);
+      }
+    }
+    findConstants();
+
+    std::vector<ASTNodePtr> children;
+    for (const auto& declaration : program->getChildren()) {
+      if (declaration->getType() == ASTNodeType::FUNCTION) {
+        children.push_back(declaration);
+      } else if (ASTNodePtr rewritten = statement(declaration)) {
+        children.push_back(std::move(rewritten));
+      }
+    }
+    program->setChildren(std::move(children));
+    statistics_.rounds = std::max(statistics_.rounds, round + 1);
+    if (!changed_) {
+      break;
+    }
+  }
+}
+
+
+void ASTOptimizer::beginRound() {
+  changed_ = false;
+  declarations_.clear();
+  reads_.clear();
+  assigned_.clear();
+  constants_.clear();
+  deadStores_.clear();
+}
+
+void ASTOptimizer::collect(const ASTNodePtr& node) {
+  if (!node) {
+    return;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::VARIABLE_DECLARATION:
+      if (isLocal(node->getBinding())) {
+        declarations_[node->getBinding()] = node.get();
+      }
+      break;
+    case ASTNodeType::IDENTIFIER:
+      ++reads_[node->getBinding()];
+      return;
+    case ASTNodeType::ASSIGNMENT:
+      if (const ASTNodePtr& target = node->getChild(0); target->getType() == ASTNodeType::IDENTIFIER) {
+        assigned_.insert(target->getBinding());
+        collect(node->getChild(1));
+        return;
+      }
+      break; // an element store reads the array
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        assigned_.insert(target->getBinding());
+      }
+      return;
+    default:
+      break;
+  }
+  for (const auto& child : node->getChildren()) {
+    collect(child);
+  }
+}
+
+// Locals with one value for their whole life: declared with a literal or without a
+// value, never assigned or read into afterwards; arrays are shared, so never constant
+void ASTOptimizer::findConstants() {
+  for (const auto& [binding, declaration] : declarations_) {
+    const TypeId type = declaration->getTypeId();
+    const auto& children = declaration->getChildren();
+    if (assigned_.contains(binding) || types_.isArray(type) || children.size() != 1) {
+      continue;
+    }
+
+    const ASTNodePtr& initializer = children[0];
+    if (initializer && initializer->getType() != ASTNodeType::LITERAL) {
+      continue;
+    }
+    try {
+      Value value = initializer ? literalValue(initializer) : zeroValue(type);
+      if (TypeTable::isScalar(type)) {
+        value = Runtime::convert(valueKind(type), value);
+      }
+      if (ASTNodePtr literal = makeLiteral(value, type, declaration->getLine())) {
+        constants_[binding] = std::move(literal);
+      }
+    } catch (const std::exception&) {
+      // the initializer fails at run time (a float that does not fit an int): left as is
+    }
+  }
+}
+
+// Backward liveness inside each reachable block, starting from the block's live-out set
+void ASTOptimizer::findDeadStores(const ASTNodePtr& function) {
+  const ControlFlowGraph graph = ControlFlowGraph::build(function, types_);
+  DataflowAnalyzer dataflow(graph);
+  dataflow.solve();
+
+  const auto& events = graph.getEvents();
+  for (const uint32_t b : graph.reversePostorder()) {
+    const BasicBlock& block = graph.getBlocks()[b];
+    BitVector live = dataflow.liveOut(b);
+    for (uint32_t i = block.lastEvent; i-- > block.firstEvent;) {
+      const CFGEvent& event = events[i];
+      if (event.kind == CFGEvent::Kind::USE) {
+        live.set(event.slot);
+        continue;
+      }
+      if (event.kind == CFGEvent::Kind::DEF && !live.test(event.slot) &&
+        event.node->getType() == ASTNodeType::IDENTIFIER) { // an assignment or input target
+        deadStores_.insert(event.node);
+      }
+      live.reset(event.slot);
+    }
+  }
+}
+
+
+ASTNodePtr ASTOptimizer::statement(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK:
+      node->setChildren(statements(node->getChildren(), 0));
+      return node;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      return declaration(node);
+    case ASTNodeType::ASSIGNMENT: {
+      const ASTNodePtr& target = node->getChild(0);
+      node->setChild(1, expression(node->getChild(1)));
+      if (target->getType() == ASTNodeType::INDEX) {
+        target->setChild(0, expression(target->getChild(0)));
+        target->setChild(1, expression(target->getChild(1)));
+      } else if (deadStores_.contains(target.get()) && isPure(node->getChild(1)) &&
+        isSafeConversion(target->getTypeId(), node->getChild(1)->getTypeId())) {
+        ++statistics_.deadStores;
+        changed_ = true;
+        return nullptr;
+      }
+      return node;
+    }
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      const ASTNodePtr condition = expression(children[0]);
+      if (condition->getType() == ASTNodeType::LITERAL) {
+        ++statistics_.removedStatements;
+        changed_ = true;
+        if (literalValue(condition).isTrue()) {
+          return statement(children[1]);
+        }
+        return children.size() > 2 ? statement(children[2]) : nullptr;
+      }
+      node->setChild(0, condition);
+      node->setChild(1, statement(children[1]));
+      if (children.size() > 2) {
+        if (ASTNodePtr otherwise = statement(children[2])) {
+          node->setChild(2, otherwise);
+        } else { // an `else if` on a false constant
+          node->setChildren({children[0], children[1]});
+        }
+      }
+      return node;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      return loop(node);
+    case ASTNodeType::SWITCH:
+      return switchStatement(node);
+    case ASTNodeType::RETURN_STATEMENT:
+      if (!node->getChildren().empty()) {
+        node->setChild(0, expression(node->getChild(0)));
+      }
+      return node;
+    case ASTNodeType::OUTPUT:
+      for (size_t i = 0; i < node->getChildren().size(); ++i) {
+        node->setChild(i, expression(node->getChild(i)));
+      }
+      return node;
+    case ASTNodeType::INPUT:
+    case ASTNodeType::BREAK:
+    case ASTNodeType::CONTINUE:
+      return node;
+    default: { // expression statement: only its effects matter
+      ASTNodePtr value = expression(node);
+      if (isPure(value)) {
+        ++statistics_.removedStatements;
+        changed_ = true;
+        return nullptr;
+      }
+      return value;
+    }
+  }
+}
+
+std::vector<ASTNodePtr> ASTOptimizer::statements(const std::vector<ASTNodePtr>& instructions, const size_t first) {
+  std::vector<ASTNodePtr> result(instructions.begin(), instructions.begin() + static_cast<ptrdiff_t>(first));
+  for (size_t i = first; i < instructions.size(); ++i) {
+    ASTNodePtr rewritten = statement(instructions[i]);
+    if (!rewritten) {
+      continue;
+    }
+    if (rewritten->getType() == ASTNodeType::BLOCK && rewritten->getChildren().empty()) {
+      changed_ |= rewritten != instructions[i];
+      continue; // what is left of a constant branch
+    }
+    result.push_back(rewritten);
+    if (leaves(rewritten) && i + 1 < instructions.size()) {
+      statistics_.removedStatements += instructions.size() - i - 1;
+      changed_ = true;
+      break;
+    }
+  }
+  return result;
+}
+
+ASTNodePtr ASTOptimizer::loop(const ASTNodePtr& node) {
+  const bool isFor = node->getTokenType() == my::TokenType::FOR;
+  const size_t condition = isFor ? 1 : 0;
+
+  if (isFor) { // the counter stays declared even if unused, the loop needs its slot
+    const ASTNodePtr& counter = node->getChild(0);
+    for (size_t i = 0; i < counter->getChildren().size(); ++i) {
+      if (counter->getChild(i)) {
+        counter->setChild(i, expression(counter->getChild(i)));
+      }
+    }
+  }
+  node->setChild(condition, expression(node->getChild(condition)));
+  if (const ASTNodePtr& test = node->getChild(condition);
+    test->getType() == ASTNodeType::LITERAL && !literalValue(test).isTrue()) {
+    ++statistics_.removedStatements;
+    changed_ = true;
+    if (!isFor) {
+      return nullptr;
+    }
+    auto init = std::make_shared<ASTNode>(ASTNodeType::BLOCK); // the initializer still runs
+    init->setLine(node->getLine());
+    init->addChild(node->getChild(0));
+    return init;
+  }
+
+  if (isFor) {
+    const ASTNodePtr& step = node->getChild(2);
+    step->setChild(1, expression(step->getChild(1)));
+    if (const ASTNodePtr& target = step->getChild(0); target->getType() == ASTNodeType::INDEX) {
+      target->setChild(0, expression(target->getChild(0)));
+      target->setChild(1, expression(target->getChild(1)));
+    }
+  }
+  const ASTNodePtr body = statement(node->getChildren().back());
+  if (auto instructions = body->getChildren();
+    !instructions.empty() && instructions.back()->getType() == ASTNodeType::CONTINUE) {
+    instructions.pop_back(); // the end of the body continues anyway
+    body->setChildren(std::move(instructions));
+    ++statistics_.removedStatements;
+    changed_ = true;
+  }
+  node->setChild(node->getChildren().size() - 1, body);
+  return node;
+}
+
+ASTNodePtr ASTOptimizer::switchStatement(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const ASTNodePtr subject = expression(children[0]);
+  node->setChild(0, subject);
+
+  // a constant subject picks its arm now, unless the arm breaks out of the switch
+  // (the `break` would then leave the enclosing loop instead)
+  if (subject->getType() == ASTNodeType::LITERAL) {
+    const Value value = literalValue(subject);
+    for (size_t i = 1; i < children.size(); ++i) {
+      const ASTNodePtr& arm = children[i];
+      const bool isCase = arm->getTokenType() == my::TokenType::CASE;
+      if (isCase && !Runtime::compare(Operator::EQ, value, literalValue(arm->getChild(0)))) {
+        continue;
+      }
+      if (breaksOut(arm)) {
+        break;
+      }
+      auto chosen = std::make_shared<ASTNode>(ASTNodeType::BLOCK);
+      chosen->setLine(arm->getLine());
+      for (size_t j = isCase ? 1 : 0; j < arm->getChildren().size(); ++j) {
+        chosen->addChild(arm->getChild(j));
+      }
+      ++statistics_.simplifiedSwitches;
+      changed_ = true;
+      return statement(chosen);
+    }
+  }
+
+  for (size_t i = 1; i < children.size(); ++i) {
+    const ASTNodePtr& arm = children[i];
+    arm->setChildren(statements(arm->getChildren(), arm->getTokenType() == my::TokenType::CASE ? 1 : 0));
+  }
+  return node;
+}
+
+ASTNodePtr ASTOptimizer::declaration(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  for (size_t i = 0; i < children.size(); ++i) {
+    if (children[i]) {
+      node->setChild(i, expression(children[i]));
+    }
+  }
+
+  // a local nobody reads or assigns: its initializer is all that could matter
+  const uint32_t binding = node->getBinding();
+  const ASTNodePtr& initializer = children[0];
+  if (isLocal(binding) && !reads_.contains(binding) && !assigned_.contains(binding) && children.size() == 1 &&
+    (!initializer || (isPure(initializer) && isSafeConversion(node->getTypeId(), initializer->getTypeId())))) {
+    ++statistics_.removedDeclarations;
+    changed_ = true;
+    return nullptr;
+  }
+  return node;
+}
+
+
+ASTNodePtr ASTOptimizer::expression(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::IDENTIFIER:
+      if (const auto constant = constants_.find(node->getBinding()); constant != constants_.end()) {
+        ++statistics_.propagatedConstants;
+        changed_ = true;
+        ASTNodePtr literal = constant->second->clone();
+        literal->setLine(node->getLine());
+        return literal;
+      }
+      return node;
+    case ASTNodeType::INDEX:
+    case ASTNodeType::CALL:
+      for (size_t i = 0; i < node->getChildren().size(); ++i) {
+        node->setChild(i, expression(node->getChild(i)));
+      }
+      return node;
+    case ASTNodeType::EXPRESSION:
+      for (size_t i = 0; i < node->getChildren().size(); ++i) {
+        node->setChild(i, expression(node->getChild(i)));
+      }
+      return fold(node);
+    default:
+      return node;
+  }
+}
+
+ASTNodePtr ASTOptimizer::fold(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const my::TokenType op = node->getTokenType();
+  const bool constantLhs = children[0]->getType() == ASTNodeType::LITERAL;
+  const auto folded = [&](ASTNodePtr result) {
+    ++statistics_.foldedExpressions;
+    changed_ = true;
+    return result;
+  };
+
+  if (children.size() == 2) {
+    switch (op) {
+      case my::TokenType::COMMA:
+        return isPure(children[0]) ? folded(children[1]) : node;
+      case my::TokenType::AND:
+      case my::TokenType::OR: {
+        // a deciding left operand skips the right one; otherwise the result is the right
+        // operand's truth value, which is the operand itself when it is a bool already
+        if (!constantLhs) {
+          return node;
+        }
+        const bool decides = literalValue(children[0]).isTrue() == (op == my::TokenType::OR);
+        if (decides) {
+          return folded(makeLiteral(Value::ofBool(op == my::TokenType::OR), TypeTable::BOOL, node->getLine()));
+        }
+        if (children[1]->getType() == ASTNodeType::LITERAL) {
+          return folded(makeLiteral(Value::ofBool(literalValue(children[1]).isTrue()), TypeTable::BOOL,
+            node->getLine()));
+        }
+        return children[1]->getTypeId() == TypeTable::BOOL ? folded(children[1]) : node;
+      }
+      default:
+        break;
+    }
+  }
+
+  for (const auto& child : children) {
+    if (child->getType() != ASTNodeType::LITERAL) {
+      return node;
+    }
+  }
+
+  Value result;
+  try {
+    if (children.size() == 1) {
+      const Value operand = literalValue(children[0]);
+      if (op == my::TokenType::NOT) {
+        result = Value::ofBool(!operand.isTrue());
+      } else if (operand.kind == ValueKind::FLOAT) {
+        result = Value::ofFloat(-operand.real);
+      } else {
+        result = Value::ofInt(static_cast<int64_t>(0 - static_cast<uint64_t>(operand.asInteger())));
+      }
+    } else {
+      const Value lhs = literalValue(children[0]);
+      const Value rhs = literalValue(children[1]);
+      switch (op) {
+        case my::TokenType::PLUS:
+          result = runtime_.arithmetic(Operator::ADD, lhs, rhs);
+          break;
+        case my::TokenType::MINUS:
+          result = runtime_.arithmetic(Operator::SUB, lhs, rhs);
+          break;
+        case my::TokenType::MUL:
+          result = runtime_.arithmetic(Operator::MUL, lhs, rhs);
+          break;
+        case my::TokenType::DIV:
+          result = runtime_.arithmetic(Operator::DIV, lhs, rhs);
+          break;
+        case my::TokenType::LT:
+          result = Value::ofBool(Runtime::compare(Operator::LT, lhs, rhs));
+          break;
+        case my::TokenType::GT:
+          result = Value::ofBool(Runtime::compare(Operator::GT, lhs, rhs));
+          break;
+        case my::TokenType::EQ:
+          result = Value::ofBool(Runtime::compare(Operator::EQ, lhs, rhs));
+          break;
+        case my::TokenType::NEQ:
+          result = Value::ofBool(!Runtime::compare(Operator::EQ, lhs, rhs));
+          break;
+        default:
+          return node;
+      }
+    }
+  } catch (const std::exception&) {
+    return node; // fails at run time, with the line of the operator
+  }
+
+  ASTNodePtr literal = makeLiteral(result, node->getTypeId(), node->getLine());
+  return literal ? folded(literal) : node;
+}
+
+
+Value ASTOptimizer::literalValue(const ASTNodePtr& literal) {
+  const std::string& lexeme = literal->getValue();
+  switch (literal->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL:
+      return Value::ofInt(decodeIntegerLiteral(lexeme));
+    case my::TokenType::FLOAT_LITERAL:
+      return Value::ofFloat(decodeFloatLiteral(lexeme));
+    case my::TokenType::CHAR_LITERAL:
+      return Value::ofChar(decodeCharLiteral(lexeme));
+    case my::TokenType::STRING_LITERAL:
+      return runtime_.intern(decodeStringLiteral(lexeme));
+    default: // true / false
+      return Value::ofBool(lexeme == "true");
+  }
+}
+
+ASTNodePtr ASTOptimizer::makeLiteral(const Value& value, const TypeId type, const uint32_t line) const {
+  std::string lexeme;
+  my::TokenType token;
+  switch (value.kind) {
+    case ValueKind::INT:
+      lexeme = std::to_string(value.integer);
+      token = my::TokenType::INTEGER_LITERAL;
+      break;
+    case ValueKind::FLOAT: {
+      char buffer[32]; // round-trips through decodeFloatLiteral
+      std::snprintf(buffer, sizeof(buffer), "%.17g", value.real);
+      lexeme = buffer;
+      token = my::TokenType::FLOAT_LITERAL;
+      break;
+    }
+    case ValueKind::CHAR:
+      lexeme = std::string("'") + value.character + "'";
+      token = my::TokenType::CHAR_LITERAL;
+      break;
+    case ValueKind::BOOL:
+      lexeme = value.boolean ? "true" : "false";
+      token = my::TokenType::KEYWORD;
+      break;
+    case ValueKind::STRING:
+      lexeme = "\"" + std::string(value.text()) + "\"";
+      token = my::TokenType::STRING_LITERAL;
+      break;
+    default:
+      return nullptr;
+  }
+
+  // the interpreters would convert a value of another kind, the literal would not be
+  if (valueKind(type) != value.kind) {
+    return nullptr;
+  }
+
+  auto literal = std::make_shared<ASTNode>(ASTNodeType::LITERAL, std::move(lexeme), token);
+  literal->setTypeId(type);
+  literal->setLine(line);
+  return literal;
+}
+
+Value ASTOptimizer::zeroValue(const TypeId type) {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      return Value::ofInt(0);
+    case TypeKind::FLOAT:
+      return Value::ofFloat(0.0);
+    case TypeKind::CHAR:
+      return Value::ofChar('\0');
+    case TypeKind::BOOL:
+      return Value::ofBool(false);
+    case TypeKind::STRING:
+      return runtime_.newString("");
+    default:
+      return Value();
+  }
+}
+
+
+ValueKind ASTOptimizer::valueKind(const TypeId type) {
+  switch (type) {
+    case TypeTable::INT:
+      return ValueKind::INT;
+    case TypeTable::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeTable::CHAR:
+      return ValueKind::CHAR;
+    case TypeTable::BOOL:
+      return ValueKind::BOOL;
+    case TypeTable::STRING:
+      return ValueKind::STRING;
+    default: // arrays have no literals
+      return ValueKind::VOID;
+  }
+}
+
+bool ASTOptimizer::isLocal(const uint32_t binding) const {
+  return binding != ASTNode::NO_BINDING && tid_.getRecord(binding).scope != GLOBAL_SCOPE;
+}
+
+bool ASTOptimizer::isPure(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL:
+    case ASTNodeType::IDENTIFIER:
+      return true;
+    case ASTNodeType::EXPRESSION: {
+      const auto& children = node->getChildren();
+      if (node->getTokenType() == my::TokenType::DIV && node->getTypeId() != TypeTable::FLOAT) {
+        // integer division fails on a zero divisor
+        const ASTNodePtr& divisor = children[1];
+        if (divisor->getType() != ASTNodeType::LITERAL || divisor->getTokenType() != my::TokenType::INTEGER_LITERAL ||
+          decodeIntegerLiteral(divisor->getValue()) == 0) {
+          return false;
+        }
+      }
+      return std::all_of(children.begin(), children.end(), isPure);
+    }
+    default: // indexing can fail, calls can do anything
+      return false;
+  }
+}
+
+bool ASTOptimizer::isSafeConversion(const TypeId target, const TypeId source) {
+  return source != TypeTable::FLOAT || (target != TypeTable::INT && target != TypeTable::CHAR);
+}
+
+bool ASTOptimizer::leaves(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::RETURN_STATEMENT:
+    case ASTNodeType::BREAK:
+    case ASTNodeType::CONTINUE:
+      return true;
+    case ASTNodeType::BLOCK:
+      return !node->getChildren().empty() && leaves(node->getChildren().back());
+    case ASTNodeType::IF_STATEMENT:
+      return node->getChildren().size() > 2 && leaves(node->getChild(1)) && leaves(node->getChild(2));
+    default:
+      return false;
+  }
+}
+
+bool ASTOptimizer::breaksOut(const ASTNodePtr& node) {
+  if (!node) {
+    return false;
+  }
+  if (node->getType() == ASTNodeType::BREAK) {
+    return true;
+  }
+  for (const auto& child : node->getChildren()) {
+    // a nested loop or switch owns the breaks inside it
+    if (child && child->getType() != ASTNodeType::LOOP_STATEMENT && child->getType() != ASTNodeType::SWITCH &&
+      breaksOut(child)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,268 @@
+#include "../headers/common-subexpressions.h"
+
+
+SharedExpressions CommonSubexpressions::analyze(const ASTNodePtr& program) {
+  statistics_ = SubexpressionStatistics();
+  dag_.clear();
+  literals_.clear();
+  versions_.clear();
+  calls_ = 0;
+  stores_ = 0;
+  available_.clear();
+  occurrences_.clear();
+  visited_.clear();
+
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      flush();
+      statement(declaration->getChildren().back());
+    }
+  }
+  flush();
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration);
+    }
+  }
+
+  SharedExpressions shared;
+  for (const Occurrences& value : occurrences_) {
+    if (!isWorth(value.weight, value.reuses.size())) {
+      continue;
+    }
+    const auto index = static_cast<uint32_t>(statistics_.values++);
+    shared[value.first] = SharedValue{index, true};
+    for (const ASTNode* reuse : value.reuses) {
+      shared[reuse] = SharedValue{index, false};
+    }
+    statistics_.reuses += value.reuses.size();
+  }
+  return shared;
+}
+
+
+void CommonSubexpressions::statement(const ASTNodePtr& node) {
+  if (!node) {
+    return;
+  }
+  const auto& children = node->getChildren();
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK:
+      flush(); // the generators reuse a block's slots after it
+      for (const auto& instruction : children) {
+        statement(instruction);
+      }
+      flush();
+      break;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      for (const auto& child : children) {
+        if (child) {
+          expression(child);
+        }
+      }
+      assign(node->getBinding());
+      break;
+    case ASTNodeType::ASSIGNMENT: {
+      const ASTNodePtr& target = children[0];
+      if (target->getType() == ASTNodeType::IDENTIFIER) {
+        expression(children[1]);
+        assign(target->getBinding());
+        break;
+      }
+      // the array and indices first, then the value
+      expression(target->getChild(0), true);
+      expression(target->getChild(1));
+      expression(children[1]);
+      ++stores_;
+      break;
+    }
+    case ASTNodeType::IF_STATEMENT:
+      expression(children[0]);
+      for (size_t i = 1; i < children.size(); ++i) {
+        flush();
+        statement(children[i]);
+      }
+      flush();
+      break;
+    case ASTNodeType::LOOP_STATEMENT:
+      if (node->getTokenType() == my::TokenType::WHILE) {
+        flush(); // the condition runs after every iteration
+        expression(children[0]);
+        flush();
+        statement(children[1]);
+      } else {
+        statement(children[0]);
+        flush();
+        expression(children[1]);
+        flush();
+        statement(children[3]);
+        flush(); // `continue` jumps to the step
+        statement(children[2]);
+      }
+      flush();
+      break;
+    case ASTNodeType::SWITCH:
+      expression(children[0]);
+      for (size_t i = 1; i < children.size(); ++i) {
+        flush();
+        const auto& arm = children[i]->getChildren();
+        for (size_t j = children[i]->getTokenType() == my::TokenType::DEFAULT ? 0 : 1; j < arm.size(); ++j) {
+          statement(arm[j]);
+        }
+      }
+      flush();
+      break;
+    case ASTNodeType::RETURN_STATEMENT:
+    case ASTNodeType::OUTPUT:
+      for (const auto& child : children) {
+        expression(child);
+      }
+      break;
+    case ASTNodeType::INPUT:
+      for (const auto& target : children) {
+        assign(target->getBinding());
+      }
+      break;
+    case ASTNodeType::BREAK:
+    case ASTNodeType::CONTINUE:
+      flush();
+      break;
+    default: // expression statement
+      expression(node);
+      break;
+  }
+}
+
+void CommonSubexpressions::expression(const ASTNodePtr& node, const bool chained) {
+  const auto& children = node->getChildren();
+  switch (node->getType()) {
+    case ASTNodeType::CALL:
+      for (const auto& argument : children) {
+        expression(argument);
+      }
+      call();
+      return;
+    case ASTNodeType::EXPRESSION:
+      if (node->getTokenType() == my::TokenType::AND || node->getTokenType() == my::TokenType::OR) {
+        // what only the right operand computes is not available after it
+        expression(children[0]);
+        const auto available = available_;
+        expression(children[1]);
+        available_ = available;
+        return;
+      }
+      break;
+    case ASTNodeType::INDEX:
+      break;
+    default: // variables, literals
+      return;
+  }
+
+  const bool candidate = !chained && isCandidate(*node);
+  visited_.insert(node.get());
+  uint32_t dagNode = LEAF;
+  if (candidate) {
+    dagNode = intern(*node);
+    if (const auto known = available_.find(dagNode); known != available_.end()) {
+      occurrences_[known->second].reuses.push_back(node.get());
+      return;
+    }
+  }
+  for (size_t i = 0; i < children.size(); ++i) {
+    expression(children[i], node->getType() == ASTNodeType::INDEX && i == 0);
+  }
+  if (candidate) {
+    available_[dagNode] = occurrences_.size();
+    occurrences_.push_back({node.get(), weight(*node), {}});
+  }
+}
+
+bool CommonSubexpressions::isCandidate(const ASTNode& node) const {
+  if (visited_.contains(&node)) {
+    return false; // a subtree shared by the AST itself is not numbered twice
+  }
+  if (node.getType() == ASTNodeType::EXPRESSION && (node.getTokenType() == my::TokenType::NOT ||
+    node.getTokenType() == my::TokenType::COMMA)) {
+    return false; // conditions turn `!` into branches
+  }
+  return isPure(node);
+}
+
+bool CommonSubexpressions::isPure(const ASTNode& node) {
+  switch (node.getType()) {
+    case ASTNodeType::LITERAL:
+    case ASTNodeType::IDENTIFIER:
+      return true;
+    case ASTNodeType::EXPRESSION:
+      if (node.getTokenType() == my::TokenType::AND || node.getTokenType() == my::TokenType::OR ||
+        node.getTokenType() == my::TokenType::COMMA) {
+        return false;
+      }
+      [[fallthrough]];
+    case ASTNodeType::INDEX:
+      return std::ranges::all_of(node.getChildren(), [](const ASTNodePtr& child) { return isPure(*child); });
+    default:
+      return false;
+  }
+}
+
+size_t CommonSubexpressions::weight(const ASTNode& node) {
+  size_t total = node.getType() == ASTNodeType::INDEX ||
+    (node.getType() == ASTNodeType::EXPRESSION && node.getTokenType() == my::TokenType::DIV) ? EXPENSIVE_WEIGHT : 1;
+  for (const auto& child : node.getChildren()) {
+    total += weight(*child);
+  }
+  return total;
+}
+
+// A reuse loads the value (one instruction) instead of computing it
+bool CommonSubexpressions::isWorth(const size_t weight, const size_t reuses) {
+  return reuses * (weight - 1) > STORE_COST;
+}
+
+
+uint32_t CommonSubexpressions::intern(const ASTNode& node) {
+  Key key{node.getType(), node.getTokenType(), node.getTypeId(), LEAF, LEAF, 0};
+  switch (node.getType()) {
+    case ASTNodeType::LITERAL:
+      key.left = literals_.try_emplace(node.getValue(), literals_.size()).first->second;
+      break;
+    case ASTNodeType::IDENTIFIER: {
+      const uint32_t binding = node.getBinding();
+      key.left = binding;
+      key.right = versions_[binding];
+      key.version = tid_.getRecord(binding).scope == GLOBAL_SCOPE ? calls_ : 0;
+      break;
+    }
+    default: {
+      const auto& children = node.getChildren();
+      key.left = intern(*children[0]);
+      if (children.size() > 1) {
+        key.right = intern(*children[1]);
+      }
+      if (node.getType() == ASTNodeType::INDEX) {
+        key.version = stores_;
+      }
+      break;
+    }
+  }
+  return dag_.try_emplace(key, static_cast<uint32_t>(dag_.size())).first->second;
+}
+
+void CommonSubexpressions::assign(const uint32_t binding) {
+  ++versions_[binding];
+}
+
+void CommonSubexpressions::call() {
+  ++calls_; // the callee may assign globals and elements
+  ++stores_;
+}
+
+
+size_t CommonSubexpressions::KeyHash::operator()(const Key& key) const {
+  size_t hash = static_cast<size_t>(key.type) * 31 + static_cast<size_t>(key.op);
+  for (const uint64_t part : {static_cast<uint64_t>(key.typeId), key.left, key.right, key.version}) {
+    hash ^= std::hash<uint64_t>{}(part) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
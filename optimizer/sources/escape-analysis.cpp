@@ -0,0 +1,268 @@
+#include "../headers/escape-analysis.h"
+
+
+LocalAllocations EscapeAnalysis::analyze(const ASTNodePtr& program) {
+  functions_.clear();
+  escaping_.clear();
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      functions_[declaration->getBinding()] = declaration.get();
+    }
+  }
+
+  // top-level code is never local: its frame lasts as long as the run
+  LocalAllocations result;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    result = LocalAllocations();
+    statistics_ = EscapeStatistics();
+    for (const auto& [binding, declaration] : functions_) {
+      changed = function(declaration, result) || changed;
+    }
+  }
+  return result;
+}
+
+
+bool EscapeAnalysis::function(const ASTNode* function, LocalAllocations& result) {
+  parent_ = {ESCAPED, CREATED};
+  groupByBinding_.clear();
+  sites_.clear();
+  loops_ = 0;
+  createsInLoop_ = false;
+
+  statement(function->getChildren().back());
+
+  // a group holding an array parameter reaches the caller through its elements
+  std::unordered_set<uint32_t> exposed = {find(ESCAPED)};
+  std::vector<std::pair<uint32_t, bool>> parameters; // groups, array or not
+  for (const auto& parameter : function->getChildren()) {
+    if (parameter->getType() != ASTNodeType::PARAMETER) {
+      continue;
+    }
+    const auto group = variable(parameter.get());
+    const bool array = types_.isArray(parameter->getTypeId());
+    parameters.emplace_back(group ? find(*group) : ESCAPED, array);
+    if (group && array) {
+      exposed.insert(find(*group));
+    }
+  }
+
+  // a parameter escapes with its group, or when it may be stored in another parameter
+  std::vector<bool> escaping;
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    bool escapes = parameters[i].first == find(ESCAPED);
+    for (size_t j = 0; j < parameters.size() && !escapes; ++j) {
+      escapes = j != i && parameters[j].first == parameters[i].first &&
+        (parameters[i].second || parameters[j].second);
+    }
+    escaping.push_back(escapes);
+  }
+
+  for (const auto& [site, group] : sites_) {
+    if (!exposed.contains(find(group))) {
+      result.arrays.insert(site);
+    }
+  }
+  ++statistics_.functions;
+  statistics_.localArrays = result.arrays.size();
+  if (!createsInLoop_ && !exposed.contains(find(CREATED))) {
+    result.strings.insert(function);
+    ++statistics_.localStrings;
+  }
+
+  std::vector<bool>& known = escaping_[function];
+  const bool changed = known != escaping;
+  known = std::move(escaping);
+  return changed;
+}
+
+
+void EscapeAnalysis::statement(const ASTNodePtr& node) {
+  if (!node) {
+    return;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::VARIABLE_DECLARATION: {
+      const auto& children = node->getChildren();
+      for (size_t i = 1; i < children.size(); ++i) {
+        expression(children[i]);
+      }
+      const auto group = variable(node.get());
+      if (children[0]) {
+        const std::vector<uint32_t> value = expression(children[0]);
+        join(value, group ? *group : ESCAPED);
+      } else if (types_.isArray(node->getTypeId())) {
+        // a new array, sized or empty
+        ++statistics_.arrays;
+        if (group && loops_ == 0) {
+          sites_.emplace_back(node.get(), *group);
+        }
+      }
+      return;
+    }
+    case ASTNodeType::ASSIGNMENT: {
+      const ASTNodePtr& target = node->getChild(0);
+      const std::vector<uint32_t> value = expression(node->getChild(1));
+      if (target->getType() == ASTNodeType::IDENTIFIER) {
+        const auto group = variable(target.get());
+        join(value, group ? *group : ESCAPED);
+        return;
+      }
+      // an element lives as long as its array
+      const std::vector<uint32_t> array = expression(target->getChild(0));
+      expression(target->getChild(1));
+      if (array.empty()) {
+        join(value, ESCAPED);
+      }
+      for (const uint32_t group : array) {
+        join(value, group);
+      }
+      return;
+    }
+    case ASTNodeType::RETURN_STATEMENT:
+      if (!node->getChildren().empty()) {
+        join(expression(node->getChild(0)), ESCAPED);
+      }
+      return;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        if (target->getTypeId() == TypeTable::STRING) {
+          createsInLoop_ = createsInLoop_ || loops_ > 0;
+          const auto group = variable(target.get());
+          unite(CREATED, group ? *group : ESCAPED);
+        }
+      }
+      return;
+    case ASTNodeType::LOOP_STATEMENT:
+      ++loops_;
+      for (const auto& child : node->getChildren()) {
+        statement(child);
+      }
+      --loops_;
+      return;
+    case ASTNodeType::BLOCK:
+    case ASTNodeType::IF_STATEMENT:
+    case ASTNodeType::SWITCH:
+    case ASTNodeType::CASE:
+      for (const auto& child : node->getChildren()) {
+        statement(child);
+      }
+      return;
+    case ASTNodeType::BREAK:
+    case ASTNodeType::CONTINUE:
+      return;
+    default:
+      // conditions, outputs and expression statements
+      expression(node);
+      return;
+  }
+}
+
+std::vector<uint32_t> EscapeAnalysis::expression(const ASTNodePtr& node) {
+  if (!node) {
+    return {};
+  }
+  switch (node->getType()) {
+    case ASTNodeType::IDENTIFIER: {
+      // a global array may be reached from anywhere
+      const auto group = variable(node.get());
+      return group ? std::vector<uint32_t>{*group} : untracked(node);
+    }
+    case ASTNodeType::INDEX: {
+      // a row is a view that keeps its array alive; a string element is a value
+      std::vector<uint32_t> array = expression(node->getChild(0));
+      expression(node->getChild(1));
+      if (!isTracked(node->getTypeId())) {
+        return {};
+      }
+      return array.empty() ? untracked(node) : array;
+    }
+    case ASTNodeType::CALL: {
+      const auto callee = functions_.find(node->getBinding());
+      const auto known = callee == functions_.end() ? escaping_.end() : escaping_.find(callee->second);
+      const auto& arguments = node->getChildren();
+      for (size_t i = 0; i < arguments.size(); ++i) {
+        const std::vector<uint32_t> argument = expression(arguments[i]);
+        if (known == escaping_.end() || i >= known->second.size() || known->second[i]) {
+          join(argument, ESCAPED);
+        }
+      }
+      // what a call returns has escaped its callee
+      return untracked(node);
+    }
+    case ASTNodeType::EXPRESSION: {
+      const auto& children = node->getChildren();
+      std::vector<uint32_t> lhs = expression(children[0]);
+      std::vector<uint32_t> rhs = children.size() > 1 ? expression(children[1]) : std::vector<uint32_t>{};
+      if (node->getTokenType() == my::TokenType::COMMA) {
+        return rhs;
+      }
+      if (node->getTokenType() != my::TokenType::PLUS || node->getTypeId() != TypeTable::STRING) {
+        return {};
+      }
+      // a concatenation is a new string, maybe a rope holding both operands
+      createsInLoop_ = createsInLoop_ || loops_ > 0;
+      lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+      lhs.push_back(CREATED);
+      return lhs;
+    }
+    default:
+      for (const auto& child : node->getChildren()) {
+        expression(child);
+      }
+      return {};
+  }
+}
+
+
+std::optional<uint32_t> EscapeAnalysis::variable(const ASTNode* node) {
+  const uint32_t binding = node->getBinding();
+  if (binding == ASTNode::NO_BINDING || !isTracked(node->getTypeId()) ||
+    tid_.getRecord(binding).scope == GLOBAL_SCOPE) {
+    return std::nullopt;
+  }
+  const auto [entry, inserted] = groupByBinding_.try_emplace(binding, static_cast<uint32_t>(parent_.size()));
+  if (inserted) {
+    parent_.push_back(entry->second);
+  }
+  return entry->second;
+}
+
+void EscapeAnalysis::join(const std::vector<uint32_t>& groups, const uint32_t group) {
+  for (const uint32_t other : groups) {
+    unite(other, group);
+  }
+}
+
+
+std::vector<uint32_t> EscapeAnalysis::untracked(const ASTNodePtr& node) const {
+  // what is stored in an array outside the function escapes; a string is only a value
+  return types_.isArray(node->getTypeId()) ? std::vector<uint32_t>{ESCAPED} : std::vector<uint32_t>{};
+}
+
+bool EscapeAnalysis::isTracked(const TypeId type) const {
+  return type != TypeTable::NO_TYPE && (type == TypeTable::STRING || types_.isArray(type));
+}
+
+uint32_t EscapeAnalysis::find(uint32_t group) {
+  while (parent_[group] != group) {
+    parent_[group] = parent_[parent_[group]];
+    group = parent_[group];
+  }
+  return group;
+}
+
+void EscapeAnalysis::unite(const uint32_t a, const uint32_t b) {
+  const uint32_t rootA = find(a);
+  const uint32_t rootB = find(b);
+  if (rootA != rootB) {
+    // the lower root wins, so ESCAPED stays the root of its group
+    if (rootB < rootA) {
+      parent_[rootA] = rootB;
+    } else {
+      parent_[rootB] = rootA;
+    }
+  }
+}
@@ -0,0 +1,219 @@
+#include "../headers/peephole.h"
+
+#include <numeric>
+
+
+void PeepholeOptimizer::optimize(RPNProgram& program) {
+  const size_t before = program.instructionCount();
+
+  // the functions are rewritten into new code in the order they are laid out
+  std::vector<size_t> order(program.functions.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+    [&](const size_t a, const size_t b) { return program.functions[a].entry < program.functions[b].entry; });
+
+  std::vector<uint8_t> code;
+  std::vector<std::pair<uint32_t, uint32_t>> lines;
+  for (const size_t index : order) {
+    RPNFunction& function = program.functions[index];
+    std::vector<Instruction> instructions = decode(program, function);
+    threadJumps(program, instructions);
+    const std::vector<Instruction> fused = fuse(program, instructions);
+
+    const auto entry = static_cast<uint32_t>(code.size());
+    std::vector<uint32_t> offsets(fused.size());
+    uint32_t end = entry;
+    for (size_t i = 0; i < fused.size(); ++i) {
+      offsets[i] = end;
+      end += static_cast<uint32_t>(instructionSize(fused[i].op));
+    }
+
+    // an original instruction moves to the first one kept at or after it: a dropped
+    // instruction is replaced by what follows, and no jump lands inside a fused sequence
+    std::unordered_map<uint32_t, uint32_t> moved;
+    size_t next = 0;
+    for (const auto& instruction : instructions) {
+      while (next < fused.size() && fused[next].offset < instruction.offset) {
+        ++next;
+      }
+      moved[instruction.offset] = next < fused.size() ? offsets[next] : end;
+    }
+
+    for (const auto& instruction : fused) {
+      if (lines.empty() || lines.back().second != instruction.line) {
+        lines.emplace_back(static_cast<uint32_t>(code.size()), instruction.line);
+      }
+      code.push_back(static_cast<uint8_t>(instruction.op));
+      for (uint8_t i = 0; i < OPCODE_OPERANDS[static_cast<uint8_t>(instruction.op)]; ++i) {
+        const uint32_t operand = isJump(instruction.op) ? moved.at(instruction.operands[i]) : instruction.operands[i];
+        code.resize(code.size() + sizeof(uint32_t));
+        writeOperand(&code[code.size() - sizeof(uint32_t)], operand);
+      }
+      if (isSwitch(instruction.op)) {
+        SwitchTable& table = program.switches[instruction.operands[0]];
+        for (uint32_t& target : table.targets) {
+          target = moved.at(target);
+        }
+        table.fallback = moved.at(table.fallback);
+      }
+    }
+    function.entry = entry;
+    function.end = end;
+  }
+
+  program.code = std::move(code);
+  program.lines = std::move(lines);
+  statistics_.removedInstructions += before - program.instructionCount();
+}
+
+std::vector<PeepholeOptimizer::Instruction> PeepholeOptimizer::decode(const RPNProgram& program,
+  const RPNFunction& function) const {
+  std::vector<Instruction> instructions;
+  for (uint32_t pc = function.entry; pc < function.end;) {
+    const auto op = static_cast<OpCode>(program.code[pc]);
+    Instruction& instruction = instructions.emplace_back(Instruction{op, {0, 0}, program.lineAt(pc), pc});
+    for (uint8_t i = 0; i < OPCODE_OPERANDS[static_cast<uint8_t>(op)]; ++i) {
+      instruction.operands[i] = readOperand(&program.code[pc + 1 + 4 * i]);
+    }
+    pc += static_cast<uint32_t>(instructionSize(op));
+  }
+  return instructions;
+}
+
+void PeepholeOptimizer::threadJumps(RPNProgram& program, std::vector<Instruction>& instructions) {
+  std::unordered_map<uint32_t, size_t> byOffset;
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    byOffset[instructions[i].offset] = i;
+  }
+
+  const auto thread = [&](uint32_t& operand) {
+    uint32_t target = operand;
+    for (size_t step = 0; step < MAX_THREADED_JUMPS; ++step) {
+      const auto landing = byOffset.find(target);
+      if (landing == byOffset.end() || instructions[landing->second].op != OpCode::JUMP) {
+        break;
+      }
+      target = instructions[landing->second].operands[0];
+    }
+    if (target != operand) {
+      operand = target;
+      ++statistics_.threadedJumps;
+    }
+  };
+  for (auto& instruction : instructions) {
+    if (isJump(instruction.op)) {
+      thread(instruction.operands[0]);
+    } else if (isSwitch(instruction.op)) {
+      SwitchTable& table = program.switches[instruction.operands[0]];
+      std::for_each(table.targets.begin(), table.targets.end(), thread);
+      thread(table.fallback);
+    }
+  }
+}
+
+std::vector<PeepholeOptimizer::Instruction> PeepholeOptimizer::fuse(const RPNProgram& program,
+  const std::vector<Instruction>& instructions) {
+  std::unordered_set<uint32_t> targets;
+  for (const auto& instruction : instructions) {
+    if (isJump(instruction.op)) {
+      targets.insert(instruction.operands[0]);
+    } else if (isSwitch(instruction.op)) {
+      const SwitchTable& table = program.switches[instruction.operands[0]];
+      targets.insert(table.targets.begin(), table.targets.end());
+      targets.insert(table.fallback);
+    }
+  }
+
+  const auto is = [&](const size_t i, const OpCode op) { return i < instructions.size() && instructions[i].op == op; };
+  // `count` instructions from `first` exist and no jump lands after the first one
+  const auto fits = [&](const size_t first, const size_t count) {
+    if (first + count > instructions.size()) {
+      return false;
+    }
+    for (size_t i = first + 1; i < first + count; ++i) {
+      if (targets.contains(instructions[i].offset)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  // LOAD_LOCAL, PUSH_INT, ADD_I64 or SUB_I64 from `i` (-INT32_MIN has no int32 operand)
+  const auto addsConstant = [&](const size_t i) {
+    return is(i, OpCode::LOAD_LOCAL) && is(i + 1, OpCode::PUSH_INT) &&
+      (is(i + 2, OpCode::ADD_I64) ||
+        (is(i + 2, OpCode::SUB_I64) && static_cast<int32_t>(instructions[i + 1].operands[0]) != INT32_MIN)) &&
+      fits(i, 3);
+  };
+
+  std::vector<Instruction> fused;
+  for (size_t i = 0; i < instructions.size();) {
+    const Instruction& current = instructions[i];
+    const Instruction* next = i + 1 < instructions.size() ? &instructions[i + 1] : nullptr;
+
+    if (addsConstant(i)) {
+      const auto constant = static_cast<int32_t>(next->operands[0]);
+      const int32_t delta = instructions[i + 2].op == OpCode::ADD_I64 ? constant : -constant;
+      if (is(i + 3, OpCode::STORE_LOCAL) && instructions[i + 3].operands[0] == current.operands[0] && fits(i, 4)) {
+        fused.push_back({OpCode::INC_LOCAL, {current.operands[0], static_cast<uint32_t>(delta)}, current.line,
+          current.offset});
+        i += 4;
+      } else {
+        fused.push_back({OpCode::LOAD_LOCAL_ADD_CONST, {current.operands[0], static_cast<uint32_t>(delta)},
+          current.line, current.offset});
+        i += 3;
+      }
+      ++statistics_.superinstructions;
+      continue;
+    }
+
+    if (current.op == OpCode::LOAD_LOCAL && is(i + 1, OpCode::STORE_LOCAL) &&
+      next->operands[0] == current.operands[0] && fits(i, 2)) {
+      i += 2; // x = x
+      continue;
+    }
+
+    // a load that starts LOAD_LOCAL_ADD_CONST is left to it, that saves more dispatches
+    if (current.op == OpCode::LOAD_LOCAL && is(i + 1, OpCode::LOAD_LOCAL) && !addsConstant(i + 1) && fits(i, 2)) {
+      fused.push_back({OpCode::LOAD_LOCAL_PAIR, {current.operands[0], next->operands[0]}, current.line,
+        current.offset});
+      ++statistics_.superinstructions;
+      i += 2;
+      continue;
+    }
+
+    if ((current.op == OpCode::LT_I64 || current.op == OpCode::GT_I64) && is(i + 1, OpCode::JUMP_IF_FALSE) &&
+      fits(i, 2)) {
+      const OpCode op = current.op == OpCode::LT_I64 ? OpCode::LT_I64_JUMP_IF_FALSE : OpCode::GT_I64_JUMP_IF_FALSE;
+      fused.push_back({op, {next->operands[0], 0}, current.line, current.offset});
+      ++statistics_.superinstructions;
+      i += 2;
+      continue;
+    }
+
+    if (current.op == OpCode::JUMP && next && current.operands[0] == next->offset) {
+      ++i;
+      continue;
+    }
+
+    fused.push_back(current);
+    ++i;
+  }
+  return fused;
+}
+
+bool PeepholeOptimizer::isSwitch(const OpCode op) {
+  return op == OpCode::SWITCH_TABLE || op == OpCode::SWITCH_STRING;
+}
+
+bool PeepholeOptimizer::isJump(const OpCode op) {
+  switch (op) {
+    case OpCode::JUMP:
+    case OpCode::JUMP_IF_FALSE:
+    case OpCode::JUMP_IF_TRUE:
+    case OpCode::LT_I64_JUMP_IF_FALSE:
+    case OpCode::GT_I64_JUMP_IF_FALSE:
+      return true;
+    default:
+      return false;
+  }
+}
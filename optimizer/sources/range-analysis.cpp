@@ -0,0 +1,644 @@
+#include "../headers/range-analysis.h"
+
+#include <functional>
+
+
+std::unordered_set<const ASTNode*> RangeAnalysis::analyze(const ASTNodePtr& program) {
+  statistics_ = RangeStatistics();
+  assigned_.clear();
+  dimensions_.clear();
+  reshaped_.clear();
+  uses_.clear();
+  proven_.clear();
+
+  collect(program);
+  for (const auto& [array, depth, target] : uses_) {
+    // replacing a row whose length is known: a[i] = row, or through an alias of a or a[i]
+    if (const auto dimensions = dimensions_.find(array); dimensions != dimensions_.end() &&
+      (target ? depth < dimensions->second : depth + 2 <= dimensions->second)) {
+      reshaped_.insert(array);
+    }
+  }
+
+  // every function on its own (nothing is known about the parameters), then the top level
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      Facts facts;
+      lengths_.clear();
+      statement(declaration->getChildren().back(), facts);
+    }
+  }
+  Facts facts;
+  lengths_.clear();
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration, facts);
+    }
+  }
+  statistics_.proven = proven_.size();
+  return std::move(proven_);
+}
+
+
+void RangeAnalysis::collect(const ASTNodePtr& node) {
+  if (!node) {
+    return;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::ASSIGNMENT: {
+      const ASTNodePtr& target = node->getChild(0);
+      if (target->getType() == ASTNodeType::IDENTIFIER) {
+        assigned_.insert(target->getBinding());
+      } else {
+        size_t depth = 0;
+        const ASTNode* array = target.get();
+        for (; array->getType() == ASTNodeType::INDEX; array = array->getChild(0).get()) {
+          collect(array->getChild(1));
+          ++depth;
+        }
+        if (array->getType() == ASTNodeType::IDENTIFIER) {
+          use(array->getBinding(), depth, true);
+        } else {
+          for (const auto& child : array->getChildren()) {
+            collect(child);
+          }
+        }
+      }
+      collect(node->getChild(1));
+      return;
+    }
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        assigned_.insert(target->getBinding());
+      }
+      return;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      if (!node->getChild(0) && node->getChildren().size() > 1) {
+        dimensions_[node->getBinding()] = node->getChildren().size() - 1;
+      }
+      break;
+    case ASTNodeType::INDEX: {
+      size_t depth = 0;
+      const ASTNode* array = node.get();
+      for (; array->getType() == ASTNodeType::INDEX; array = array->getChild(0).get()) {
+        collect(array->getChild(1));
+        ++depth;
+      }
+      if (array->getType() == ASTNodeType::IDENTIFIER) {
+        use(array->getBinding(), depth, false);
+      } else {
+        for (const auto& child : array->getChildren()) {
+          collect(child);
+        }
+      }
+      return;
+    }
+    case ASTNodeType::IDENTIFIER:
+      use(node->getBinding(), 0, false);
+      return;
+    default:
+      break;
+  }
+  for (const auto& child : node->getChildren()) {
+    collect(child);
+  }
+}
+
+void RangeAnalysis::use(const uint32_t array, const size_t depth, const bool target) {
+  if (array != ASTNode::NO_BINDING) {
+    uses_.emplace_back(array, depth, target);
+  }
+}
+
+
+bool RangeAnalysis::statement(const ASTNodePtr& node, Facts& facts) {
+  if (!node) {
+    return true;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK: {
+      bool reached = true;
+      for (const auto& instruction : node->getChildren()) {
+        reached = statement(instruction, facts) && reached;
+      }
+      return reached;
+    }
+    case ASTNodeType::VARIABLE_DECLARATION: {
+      const auto& children = node->getChildren();
+      for (const auto& child : children) {
+        if (child) {
+          expression(child, facts);
+        }
+      }
+      const uint32_t binding = node->getBinding();
+      Interval value;
+      if (node->getTypeId() == TypeTable::INT) {
+        value = children[0] ? interval(children[0], facts) : Interval{0, {Bound{CONSTANT, 0}}};
+      }
+
+      // a declaration run again (in a loop) gives the variable a new value
+      facts.erase(binding);
+      for (auto& [variable, known] : facts) {
+        std::erase_if(known.upper, [&](const Bound& bound) { return bound.symbol == binding; });
+      }
+      std::erase_if(lengths_, [&](const auto& entry) {
+        return entry.first == binding || std::ranges::any_of(entry.second,
+          [&](const Bound& length) { return length.symbol == binding; });
+      });
+
+      if (node->getTypeId() == TypeTable::INT && (isLocal(binding) || !assigned_.contains(binding)) &&
+        !value.empty()) {
+        facts[binding] = std::move(value);
+      }
+      if (!children[0] && children.size() > 1 && !assigned_.contains(binding)) {
+        // the outer length, and the inner ones while no row can be replaced
+        std::vector<Bound> lengths;
+        const size_t known = reshaped_.contains(binding) ? 1 : children.size() - 1;
+        for (size_t i = 1; i <= known; ++i) {
+          const ASTNodePtr& size = children[i];
+          if (size->getTypeId() != TypeTable::INT) {
+            break;
+          }
+          if (size->getType() == ASTNodeType::LITERAL) {
+            const int64_t length = decodeIntegerLiteral(size->getValue());
+            if (length < 0 || length > MAX_OFFSET) {
+              break;
+            }
+            lengths.push_back(Bound{CONSTANT, length});
+          } else if (size->getType() == ASTNodeType::IDENTIFIER && isSymbol(size->getBinding())) {
+            lengths.push_back(Bound{size->getBinding(), 0});
+          } else {
+            break;
+          }
+        }
+        lengths_[binding] = std::move(lengths);
+      }
+      return true;
+    }
+    case ASTNodeType::ASSIGNMENT: {
+      const ASTNodePtr& target = node->getChild(0);
+      const ASTNodePtr& value = node->getChild(1);
+      expression(target, facts);
+      expression(value, facts);
+      if (target->getType() == ASTNodeType::IDENTIFIER) {
+        Interval result = isTracked(target) ? interval(value, facts) : Interval();
+        if (result.empty()) {
+          facts.erase(target->getBinding());
+        } else {
+          facts[target->getBinding()] = std::move(result);
+        }
+      }
+      return true;
+    }
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      expression(children[0], facts);
+      Facts otherwise = facts;
+      assume(children[0], true, facts);
+      assume(children[0], false, otherwise);
+      const bool thenReached = statement(children[1], facts);
+      const bool elseReached = children.size() <= 2 || statement(children[2], otherwise);
+      if (!thenReached) {
+        facts = std::move(otherwise);
+      } else if (elseReached) {
+        // what holds after both branches: the weaker lower bound, the upper bounds of both
+        for (auto it = facts.begin(); it != facts.end();) {
+          const auto other = otherwise.find(it->first);
+          if (other == otherwise.end()) {
+            it = facts.erase(it);
+            continue;
+          }
+          Interval& known = it->second;
+          const Interval& alternative = other->second;
+          known.lower = known.lower && alternative.lower ?
+            std::optional<int64_t>(std::min(*known.lower, *alternative.lower)) : std::nullopt;
+          std::vector<Bound> upper;
+          for (const Bound& bound : known.upper) {
+            for (const Bound& alternativeBound : alternative.upper) {
+              if (bound.symbol == alternativeBound.symbol) {
+                upper.push_back(Bound{bound.symbol, std::max(bound.offset, alternativeBound.offset)});
+              }
+            }
+          }
+          known.upper = std::move(upper);
+          it = known.empty() ? facts.erase(it) : std::next(it);
+        }
+      }
+      return thenReached || elseReached;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      loop(node, facts);
+      return true;
+    case ASTNodeType::SWITCH: {
+      const auto& children = node->getChildren();
+      expression(children[0], facts);
+      forgetAssigned(node, facts);
+      for (size_t i = 1; i < children.size(); ++i) {
+        Facts arm = facts;
+        for (const auto& instruction : children[i]->getChildren()) {
+          statement(instruction, arm);
+        }
+      }
+      return true;
+    }
+    case ASTNodeType::RETURN_STATEMENT:
+      for (const auto& value : node->getChildren()) {
+        expression(value, facts);
+      }
+      return false;
+    case ASTNodeType::BREAK:
+    case ASTNodeType::CONTINUE:
+      return false;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        facts.erase(target->getBinding());
+      }
+      return true;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : node->getChildren()) {
+        expression(value, facts);
+      }
+      return true;
+    default: // expression statement
+      expression(node, facts);
+      return true;
+  }
+}
+
+// Facts at the top of a loop: those before it, less what any iteration may change; the
+// counter of a `for` keeps the bound it starts from while it moves away from it
+void RangeAnalysis::loop(const ASTNodePtr& node, Facts& facts) {
+  const auto& children = node->getChildren();
+  if (node->getTokenType() == my::TokenType::WHILE) {
+    forgetAssigned(node, facts);
+    expression(children[0], facts);
+    Facts body = facts;
+    assume(children[0], true, body);
+    statement(children[1], body);
+    return;
+  }
+
+  const ASTNodePtr& init = children[0];
+  const ASTNodePtr& condition = children[1];
+  const ASTNodePtr& step = children[2];
+  statement(init, facts);
+  Interval start;
+  uint32_t counter = ASTNode::NO_BINDING;
+  if (init && init->getType() == ASTNodeType::VARIABLE_DECLARATION) {
+    counter = init->getBinding();
+    if (const auto known = facts.find(counter); known != facts.end()) {
+      start = known->second;
+    }
+  }
+  forgetAssigned(node, facts);
+  expression(condition, facts);
+  Facts body = facts;
+
+  // i = i + c or i = i - c, and nothing else assigns i
+  int64_t delta = 0;
+  if (counter != ASTNode::NO_BINDING && init->getTypeId() == TypeTable::INT && step &&
+    step->getType() == ASTNodeType::ASSIGNMENT && step->getChild(0)->getBinding() == counter) {
+    const ASTNodePtr& value = step->getChild(1);
+    const bool plus = value->getTokenType() == my::TokenType::PLUS;
+    if (value->getType() == ASTNodeType::EXPRESSION && value->getChildren().size() == 2 &&
+      (plus || value->getTokenType() == my::TokenType::MINUS)) {
+      for (size_t operand = 0; operand < 2; ++operand) {
+        const ASTNodePtr& self = value->getChild(operand);
+        const ASTNodePtr& amount = value->getChild(1 - operand);
+        if (self->getType() == ASTNodeType::IDENTIFIER && self->getBinding() == counter &&
+          amount->getType() == ASTNodeType::LITERAL && amount->getTypeId() == TypeTable::INT &&
+          (plus || operand == 0)) {
+          const int64_t c = decodeIntegerLiteral(amount->getValue());
+          if (c >= 1 && c <= MAX_OFFSET) {
+            delta = plus ? c : -c;
+          }
+        }
+      }
+    }
+    std::unordered_set<uint32_t> inBody;
+    const std::function<void(const ASTNodePtr&)> targets = [&](const ASTNodePtr& statement) {
+      if (!statement) {
+        return;
+      }
+      if (statement->getType() == ASTNodeType::ASSIGNMENT &&
+        statement->getChild(0)->getType() == ASTNodeType::IDENTIFIER) {
+        inBody.insert(statement->getChild(0)->getBinding());
+      } else if (statement->getType() == ASTNodeType::INPUT) {
+        for (const auto& target : statement->getChildren()) {
+          inBody.insert(target->getBinding());
+        }
+      }
+      for (const auto& child : statement->getChildren()) {
+        targets(child);
+      }
+    };
+    targets(children[3]);
+    if (inBody.contains(counter)) {
+      delta = 0;
+    }
+  }
+
+  if (delta != 0) {
+    // the condition bounds i on the side it moves to, tightly enough that the step
+    // cannot overflow; the bound it starts from then holds in every iteration
+    Facts bounded = body;
+    bounded.erase(counter);
+    assume(condition, true, bounded);
+    bool safe = false;
+    if (const auto known = bounded.find(counter); known != bounded.end()) {
+      if (delta > 0) {
+        safe = std::ranges::any_of(known->second.upper, [&](const Bound& bound) {
+          return bound.symbol == CONSTANT || bound.offset + delta <= 0;
+        });
+      } else {
+        safe = known->second.lower.has_value();
+      }
+    }
+    if (safe) {
+      Interval& counterFacts = body[counter];
+      if (delta > 0) {
+        counterFacts.lower = start.lower;
+      } else {
+        counterFacts.upper = start.upper;
+      }
+      if (counterFacts.empty()) {
+        body.erase(counter);
+      }
+    }
+  }
+  assume(condition, true, body);
+  statement(children[3], body);
+  statement(step, facts);
+  forgetAssigned(step, facts); // the loop may end before the step, or by a break
+}
+
+void RangeAnalysis::expression(const ASTNodePtr& node, const Facts& facts) {
+  if (!node) {
+    return;
+  }
+  if (node->getType() == ASTNodeType::EXPRESSION && node->getChildren().size() == 2 &&
+    (node->getTokenType() == my::TokenType::AND || node->getTokenType() == my::TokenType::OR)) {
+    // the right operand runs only when the left one did not decide
+    expression(node->getChild(0), facts);
+    Facts right = facts;
+    assume(node->getChild(0), node->getTokenType() == my::TokenType::AND, right);
+    expression(node->getChild(1), right);
+    return;
+  }
+  for (const auto& child : node->getChildren()) {
+    expression(child, facts);
+  }
+  if (node->getType() == ASTNodeType::INDEX) {
+    subscript(node.get(), facts);
+  }
+}
+
+void RangeAnalysis::subscript(const ASTNode* node, const Facts& facts) {
+  ++statistics_.subscripts;
+  size_t level = 0;
+  const ASTNode* array = node->getChild(0).get();
+  for (; array->getType() == ASTNodeType::INDEX; array = array->getChild(0).get()) {
+    ++level;
+  }
+  if (array->getType() != ASTNodeType::IDENTIFIER) {
+    return;
+  }
+  const auto lengths = lengths_.find(array->getBinding());
+  if (lengths == lengths_.end() || level >= lengths->second.size()) {
+    return;
+  }
+  const Bound& length = lengths->second[level];
+  const Interval index = interval(node->getChild(1), facts);
+  if (index.lower && *index.lower >= 0 && std::ranges::any_of(index.upper, [&](const Bound& bound) {
+    return below(bound, length, facts);
+  })) {
+    proven_.insert(node);
+  }
+}
+
+bool RangeAnalysis::below(const Bound& bound, const Bound& length, const Facts& facts) const {
+  if (bound.symbol == length.symbol) {
+    return bound.offset < length.offset;
+  }
+  // i <= n + k < m: through what is known about the symbols, n <= c or m >= c
+  const auto known = [&](const uint32_t symbol) -> const Interval* {
+    const auto fact = facts.find(symbol);
+    return fact != facts.end() ? &fact->second : nullptr;
+  };
+  int64_t most = bound.offset;
+  if (bound.symbol != CONSTANT) {
+    const Interval* symbol = known(bound.symbol);
+    if (!symbol) {
+      return false;
+    }
+    const auto upper = std::ranges::find(symbol->upper, CONSTANT, &Bound::symbol);
+    if (upper == symbol->upper.end()) {
+      return false;
+    }
+    most += upper->offset;
+  }
+  int64_t least = length.offset;
+  if (length.symbol != CONSTANT) {
+    const Interval* symbol = known(length.symbol);
+    if (!symbol || !symbol->lower) {
+      return false;
+    }
+    least += *symbol->lower;
+  }
+  return most < least;
+}
+
+
+void RangeAnalysis::assume(const ASTNodePtr& condition, const bool truth, Facts& facts) const {
+  if (condition->getType() != ASTNodeType::EXPRESSION) {
+    return;
+  }
+  const auto& children = condition->getChildren();
+  const my::TokenType op = condition->getTokenType();
+  if (children.size() == 1) {
+    if (op == my::TokenType::NOT) {
+      assume(children[0], !truth, facts);
+    }
+    return;
+  }
+  switch (op) {
+    case my::TokenType::AND:
+    case my::TokenType::OR:
+      // both operands are known only when && is true or || is false
+      if (truth == (op == my::TokenType::AND)) {
+        assume(children[0], truth, facts);
+        assume(children[1], truth, facts);
+      }
+      break;
+    case my::TokenType::LT:
+      truth ? assumeLess(children[0], children[1], false, facts) : assumeLess(children[1], children[0], true, facts);
+      break;
+    case my::TokenType::GT:
+      truth ? assumeLess(children[1], children[0], false, facts) : assumeLess(children[0], children[1], true, facts);
+      break;
+    case my::TokenType::EQ:
+    case my::TokenType::NEQ:
+      if (truth == (op == my::TokenType::EQ)) {
+        assumeEqual(children[0], children[1], facts);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void RangeAnalysis::assumeLess(const ASTNodePtr& lhs, const ASTNodePtr& rhs, const bool orEqual,
+  Facts& facts) const {
+  if (lhs->getTypeId() != TypeTable::INT || rhs->getTypeId() != TypeTable::INT) {
+    return;
+  }
+  const int64_t gap = orEqual ? 0 : 1;
+  const Interval left = interval(lhs, facts);
+  const Interval right = interval(rhs, facts);
+  if (isTracked(lhs)) {
+    Interval bound;
+    for (const Bound& upper : right.upper) {
+      if (const auto shifted = shift(upper, -gap)) {
+        bound.upper.push_back(*shifted);
+      }
+    }
+    add(facts[lhs->getBinding()], bound);
+  }
+  if (isTracked(rhs) && left.lower && *left.lower + gap <= MAX_OFFSET) {
+    add(facts[rhs->getBinding()], Interval{*left.lower + gap, {}});
+  }
+  std::erase_if(facts, [](const auto& entry) { return entry.second.empty(); });
+}
+
+void RangeAnalysis::assumeEqual(const ASTNodePtr& lhs, const ASTNodePtr& rhs, Facts& facts) const {
+  if (lhs->getTypeId() != TypeTable::INT || rhs->getTypeId() != TypeTable::INT) {
+    return;
+  }
+  const Interval left = interval(lhs, facts);
+  const Interval right = interval(rhs, facts);
+  if (isTracked(lhs) && !right.empty()) {
+    add(facts[lhs->getBinding()], right);
+  }
+  if (isTracked(rhs) && !left.empty()) {
+    add(facts[rhs->getBinding()], left);
+  }
+}
+
+
+RangeAnalysis::Interval RangeAnalysis::interval(const ASTNodePtr& node, const Facts& facts) const {
+  Interval result;
+  if (!node || node->getTypeId() != TypeTable::INT) {
+    return result;
+  }
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL: {
+      const int64_t value = decodeIntegerLiteral(node->getValue());
+      if (value >= -MAX_OFFSET && value <= MAX_OFFSET) {
+        result.lower = value;
+        result.upper.push_back(Bound{CONSTANT, value});
+      }
+      return result;
+    }
+    case ASTNodeType::IDENTIFIER:
+      if (isTracked(node)) {
+        if (const auto known = facts.find(node->getBinding()); known != facts.end()) {
+          result = known->second;
+        }
+      }
+      if (isSymbol(node->getBinding())) {
+        add(result, Interval{std::nullopt, {Bound{node->getBinding(), 0}}});
+      }
+      return result;
+    case ASTNodeType::EXPRESSION: {
+      // v + c, c + v, v - c with a constant c, exact only while it cannot overflow
+      const auto& children = node->getChildren();
+      const my::TokenType op = node->getTokenType();
+      if (children.size() != 2 || (op != my::TokenType::PLUS && op != my::TokenType::MINUS)) {
+        return result;
+      }
+      const bool constantRight = children[1]->getType() == ASTNodeType::LITERAL;
+      if (!constantRight && (op == my::TokenType::MINUS || children[0]->getType() != ASTNodeType::LITERAL)) {
+        return result;
+      }
+      const Interval constant = interval(children[constantRight ? 1 : 0], facts);
+      if (!constant.lower) {
+        return result;
+      }
+      const int64_t delta = op == my::TokenType::MINUS ? -*constant.lower : *constant.lower;
+      const Interval value = interval(children[constantRight ? 0 : 1], facts);
+      const bool exact = delta >= 0 ?
+        std::ranges::any_of(value.upper, [&](const Bound& bound) {
+          return bound.symbol == CONSTANT || bound.offset + delta <= 0;
+        }) :
+        value.lower.has_value();
+      if (!exact) {
+        return result;
+      }
+      if (value.lower && *value.lower + delta >= -MAX_OFFSET && *value.lower + delta <= MAX_OFFSET) {
+        result.lower = *value.lower + delta;
+      }
+      for (const Bound& bound : value.upper) {
+        if (const auto shifted = shift(bound, delta)) {
+          result.upper.push_back(*shifted);
+        }
+      }
+      return result;
+    }
+    default:
+      return result;
+  }
+}
+
+bool RangeAnalysis::isTracked(const ASTNodePtr& node) const {
+  return node->getType() == ASTNodeType::IDENTIFIER && node->getTypeId() == TypeTable::INT &&
+    node->getBinding() != ASTNode::NO_BINDING && (isLocal(node->getBinding()) || !assigned_.contains(node->getBinding()));
+}
+
+bool RangeAnalysis::isSymbol(const uint32_t binding) const {
+  return binding != ASTNode::NO_BINDING && !assigned_.contains(binding);
+}
+
+bool RangeAnalysis::isLocal(const uint32_t binding) const {
+  return binding != ASTNode::NO_BINDING && tid_.getRecord(binding).scope != GLOBAL_SCOPE;
+}
+
+void RangeAnalysis::forgetAssigned(const ASTNodePtr& node, Facts& facts) const {
+  if (!node) {
+    return;
+  }
+  if (node->getType() == ASTNodeType::ASSIGNMENT && node->getChild(0)->getType() == ASTNodeType::IDENTIFIER) {
+    facts.erase(node->getChild(0)->getBinding());
+  } else if (node->getType() == ASTNodeType::INPUT) {
+    for (const auto& target : node->getChildren()) {
+      facts.erase(target->getBinding());
+    }
+  }
+  for (const auto& child : node->getChildren()) {
+    forgetAssigned(child, facts);
+  }
+}
+
+
+void RangeAnalysis::add(Interval& interval, const Interval& other) {
+  if (other.lower && (!interval.lower || *other.lower > *interval.lower)) {
+    interval.lower = other.lower;
+  }
+  for (const Bound& bound : other.upper) {
+    const auto same = std::ranges::find_if(interval.upper, [&](const Bound& known) {
+      return known.symbol == bound.symbol;
+    });
+    if (same == interval.upper.end()) {
+      interval.upper.push_back(bound);
+    } else {
+      same->offset = std::min(same->offset, bound.offset);
+    }
+  }
+}
+
+std::optional<RangeAnalysis::Bound> RangeAnalysis::shift(const Bound bound, const int64_t delta) {
+  const int64_t offset = bound.offset + delta;
+  if (offset < -MAX_OFFSET || offset > MAX_OFFSET) {
+    return std::nullopt;
+  }
+  return Bound{bound.symbol, offset};
+}
@@ -2,34 +2,65 @@
 #define AST_NODE_H
 
 
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "../../global_functions/global_funcs.h"
+#include "interner.h"
+#include "types.h"
 
 
+// Children layout per node type:
+//   PROGRAM              - functions and top-level instructions
+//   FUNCTION             - PARAMETER*, BLOCK (value: name, typeId: function type)
+//   PARAMETER            - none (value: name, typeId: declared type)
+//   BLOCK                - instructions
+//   VARIABLE_DECLARATION - initializer (may be null), dimension* (value: name, typeId: declared type)
+//   ASSIGNMENT           - target (IDENTIFIER or INDEX), value
+//   EXPRESSION           - operand or lhs, rhs (tokenType: operator)
+//   LITERAL              - none (tokenType: literal kind, `true`/`false` are KEYWORD)
+//   IDENTIFIER           - none (value: name)
+//   INDEX                - array, index
+//   CALL                 - argument* (value: function name)
+//   IF_STATEMENT         - condition, BLOCK, [BLOCK]
+//   LOOP_STATEMENT       - WHILE: condition, BLOCK; FOR: VARIABLE_DECLARATION, condition, ASSIGNMENT, BLOCK
+//   RETURN_STATEMENT     - [value]
+//   INPUT                - IDENTIFIER+
+//   OUTPUT               - expression+
+//   SWITCH               - subject, CASE* (the last one is `default`, tokenType DEFAULT)
+//   CASE                 - LITERAL, instruction* (default: instruction*)
 enum class ASTNodeType {
   PROGRAM,
   FUNCTION,
+  PARAMETER,
   BLOCK,
   VARIABLE_DECLARATION,
   ASSIGNMENT,
   EXPRESSION,
   LITERAL,
   IDENTIFIER,
+  INDEX,
+  CALL,
   IF_STATEMENT,
   LOOP_STATEMENT,
   RETURN_STATEMENT,
   INPUT,
   OUTPUT,
   SWITCH,
+  CASE,
   BREAK,
   CONTINUE
 };
 
 class ASTNode {
 public:
-  explicit ASTNode(const ASTNodeType& type, std::string  value = "") :
-  type_(type), value_(std::move(value)) {}
+  static constexpr uint32_t NO_BINDING = UINT32_MAX;
+
+  explicit ASTNode(const ASTNodeType& type, std::string  value = "",
+    const my::TokenType tokenType = my::TokenType::UNKNOWN) :
+  type_(type), value_(std::move(value)), tokenType_(tokenType) {}
 
   void addChild(const std::shared_ptr<ASTNode>& child) {
     children_.emplace_back(child);
@@ -39,13 +70,79 @@ public:
     return children_;
   }
 
+  [[nodiscard]] const std::shared_ptr<ASTNode>& getChild(const size_t index) const {
+    return children_.at(index);
+  }
+
+  void setChild(const size_t index, const std::shared_ptr<ASTNode>& child) {
+    children_.at(index) = child;
+  }
+
+  void setChildren(std::vector<std::shared_ptr<ASTNode>> children) {
+    children_ = std::move(children);
+  }
+
+  // Deep copy of the subtree, analysis results (types, bindings) included
+  [[nodiscard]] std::shared_ptr<ASTNode> clone() const {
+    auto copy = std::make_shared<ASTNode>(*this);
+    for (auto& child : copy->children_) {
+      if (child) {
+        child = child->clone();
+      }
+    }
+    return copy;
+  }
+
   [[nodiscard]] ASTNodeType getType() const { return type_; }
   [[nodiscard]] std::string getValue() const { return value_; }
+  [[nodiscard]] my::TokenType getTokenType() const { return tokenType_; }
+
+  // interned name (identifiers, declarations, functions, calls)
+  [[nodiscard]] SymbolId getSymbol() const { return symbol_; }
+  void setSymbol(const SymbolId symbol) { symbol_ = symbol; }
+
+  // declared type for declarations, cached computed type for expressions
+  [[nodiscard]] TypeId getTypeId() const { return typeId_; }
+  void setTypeId(const TypeId typeId) { typeId_ = typeId; }
+
+  // TID record the name resolved to (identifiers, parameters, declarations), NO_BINDING before analysis
+  [[nodiscard]] uint32_t getBinding() const { return binding_; }
+  void setBinding(const uint32_t binding) { binding_ = binding; }
+
+  // source line of the node's first token (for diagnostics)
+  [[nodiscard]] uint32_t getLine() const { return line_; }
+  void setLine(const uint32_t line) { line_ = line; }
 
 private:
   ASTNodeType type_;
   std::string value_;
+  my::TokenType tokenType_;
   std::vector<std::shared_ptr<ASTNode>> children_;
+
+  SymbolId symbol_ = INVALID_SYMBOL;
+  TypeId typeId_ = TypeTable::NO_TYPE;
+  uint32_t binding_ = NO_BINDING;
+  uint32_t line_ = 0;
+};
+
+using ASTNodePtr = std::shared_ptr<ASTNode>;
+
+
+// An expression node of a value the backends compute once (see CommonSubexpressions):
+// the computation that keeps it, or a later one that loads it instead
+struct SharedValue {
+  uint32_t value; // numbered from 0 over the whole program
+  bool first;
+};
+
+using SharedExpressions = std::unordered_map<const ASTNode*, SharedValue>;
+
+
+// What never outlives the call making it (see EscapeAnalysis), so the backends may put
+// it in the region of the call's frame
+struct LocalAllocations {
+  std::unordered_set<const ASTNode*> arrays; // VARIABLE_DECLARATION nodes of arrays
+  std::unordered_set<const ASTNode*> strings; // FUNCTION nodes: every string they make
 };
 
 
@@ -0,0 +1,79 @@
+#ifndef BIT_VECTOR_H
+#define BIT_VECTOR_H
+
+
+#include "../../includes/libraries.h"
+
+
+// Fixed-size set of bits packed into 64-bit words. Set operations (the meet and the
+// transfer functions of the dataflow analyses) work a whole word at a time.
+class BitVector {
+public:
+  BitVector() = default;
+  explicit BitVector(const size_t size, const bool value = false) :
+  size_(size), words_((size + 63) / 64, value ? ~uint64_t{0} : 0) {
+    clearPadding();
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+  [[nodiscard]] bool test(const size_t bit) const { return words_[bit >> 6] >> (bit & 63) & 1; }
+  void set(const size_t bit) { words_[bit >> 6] |= uint64_t{1} << (bit & 63); }
+  void reset(const size_t bit) { words_[bit >> 6] &= ~(uint64_t{1} << (bit & 63)); }
+
+  void fill(const bool value) {
+    std::fill(words_.begin(), words_.end(), value ? ~uint64_t{0} : 0);
+    clearPadding();
+  }
+
+  BitVector& operator&=(const BitVector& other) {
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= other.words_[i];
+    }
+    return *this;
+  }
+
+  BitVector& operator|=(const BitVector& other) {
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] |= other.words_[i];
+    }
+    return *this;
+  }
+
+  // this &= ~other
+  BitVector& andNot(const BitVector& other) {
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= ~other.words_[i];
+    }
+    return *this;
+  }
+
+  // this = gen | (in & ~kill); returns true if this changed
+  bool assignTransfer(const BitVector& gen, const BitVector& in, const BitVector& kill) {
+    bool changed = false;
+    for (size_t i = 0; i < words_.size(); ++i) {
+      const uint64_t word = gen.words_[i] | (in.words_[i] & ~kill.words_[i]);
+      changed |= word != words_[i];
+      words_[i] = word;
+    }
+    return changed;
+  }
+
+  bool operator==(const BitVector& other) const { return words_ == other.words_; }
+
+  [[nodiscard]] size_t memoryUsage() const { return words_.capacity() * sizeof(uint64_t); }
+
+private:
+  size_t size_ = 0;
+  std::vector<uint64_t> words_;
+
+  // bits past size_ stay zero, so whole-word comparisons are exact
+  void clearPadding() {
+    if (size_ & 63) {
+      words_.back() &= (uint64_t{1} << (size_ & 63)) - 1;
+    }
+  }
+};
+
+
+#endif //BIT_VECTOR_H
@@ -0,0 +1,263 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+
+#include "../../includes/libraries.h"
+
+#include <string_view>
+
+
+// Instruction set of the RPN (postfix) bytecode: X(name, operand count). Every instruction
+// is one opcode byte followed by its operands, each a little-endian uint32_t; jump targets
+// are absolute offsets into RPNProgram::code.
+//
+//   PUSH_INT value            int32 immediate (PUSH_LONG takes an RPNProgram::integers index)
+//   PUSH_FLOAT / PUSH_STRING  index into RPNProgram::floats / strings
+//   PUSH_CHAR / PUSH_BOOL     immediate
+//   LOAD_LOCAL / STORE_LOCAL  frame slot (parameters are slots 0..n-1)
+//   LOAD_GLOBAL / STORE_GLOBAL  global slot
+//   NEW_ARRAY dims kind       pops `dims` sizes (outermost first), pushes a new array whose
+//                             innermost elements are zero values of ValueKind `kind`; with
+//                             LOCAL_ARRAY in `kind` it goes to the region of the frame
+//   LOAD_INDEX                array index -> element
+//   STORE_INDEX               array index value ->
+//   LOAD_ELEMENT n            array i1 .. in -> array[i1]..[in], every index checked in
+//                             order; one flat offset over a dense array's dimensions
+//   STORE_ELEMENT n           array i1 .. in value ->
+//   LOAD_INDEX_UNCHECKED ..   the four above without the bounds checks, for indices
+//   STORE_ELEMENT_UNCHECKED   RangeAnalysis proved in bounds
+//   ADD .. NEQ, NEG, NOT      generic operators, the operand kinds pick the operation
+//   ADD_I64 .. NEQ_F64        typed operators, emitted where both operands are statically
+//                             int (I64) or float (F64): no kind is checked at run time
+//   I64_TO_F64                int to float, the int operand of a float operator
+//   QUICK_ADD_INT ..          generic operators quickened by the VM after their first run,
+//                             guarded: int, char and bool operands (INT) or numbers with
+//                             a float (FLOAT); other operands turn them back into generic
+//   TO_INT .. TO_BOOL         scalar conversions (assignments, arguments, returns)
+//   JUMP_IF_FALSE / _TRUE     pop a scalar and jump on its truth value
+//   SWITCH_TABLE table        pops an int, jumps through RPNProgram::switches[table]
+//   SWITCH_STRING table       pops a string, jumps through the perfect hash of that table
+//   CALL function             arguments are on the stack, left to right
+//   READ kind                 reads a value of ValueKind `kind` from the input
+//   TRAP message              runtime error with RPNProgram::strings[message]
+//
+// Superinstructions, only produced by PeepholeOptimizer from the most frequent sequences:
+//   LOAD_LOCAL_PAIR a b       LOAD_LOCAL a, LOAD_LOCAL b
+//   LOAD_LOCAL_ADD_CONST s k  LOAD_LOCAL s, PUSH_INT k, ADD_I64 (or SUB_I64 with -k)
+//   INC_LOCAL s k             LOAD_LOCAL s, PUSH_INT k, ADD_I64 (or SUB_I64 with -k), STORE_LOCAL s
+//   LT_I64_JUMP_IF_FALSE t    LT_I64, JUMP_IF_FALSE t (GT_I64_JUMP_IF_FALSE alike)
+#define RPN_OPCODES(X)       \
+  X(NOP, 0)                  \
+  X(PUSH_INT, 1)             \
+  X(PUSH_LONG, 1)            \
+  X(PUSH_FLOAT, 1)           \
+  X(PUSH_CHAR, 1)            \
+  X(PUSH_BOOL, 1)            \
+  X(PUSH_STRING, 1)          \
+  X(POP, 0)                  \
+  X(DUP, 0)                  \
+  X(LOAD_LOCAL, 1)           \
+  X(STORE_LOCAL, 1)          \
+  X(LOAD_GLOBAL, 1)          \
+  X(STORE_GLOBAL, 1)         \
+  X(NEW_ARRAY, 2)            \
+  X(LOAD_INDEX, 0)           \
+  X(STORE_INDEX, 0)          \
+  X(LOAD_ELEMENT, 1)         \
+  X(STORE_ELEMENT, 1)        \
+  X(LOAD_INDEX_UNCHECKED, 0) \
+  X(STORE_INDEX_UNCHECKED, 0) \
+  X(LOAD_ELEMENT_UNCHECKED, 1) \
+  X(STORE_ELEMENT_UNCHECKED, 1) \
+  X(ADD, 0)                  \
+  X(SUB, 0)                  \
+  X(MUL, 0)                  \
+  X(DIV, 0)                  \
+  X(NEG, 0)                  \
+  X(NOT, 0)                  \
+  X(LT, 0)                   \
+  X(GT, 0)                   \
+  X(EQ, 0)                   \
+  X(NEQ, 0)                  \
+  X(TO_INT, 0)               \
+  X(TO_FLOAT, 0)             \
+  X(TO_CHAR, 0)              \
+  X(TO_BOOL, 0)              \
+  X(JUMP, 1)                 \
+  X(JUMP_IF_FALSE, 1)        \
+  X(JUMP_IF_TRUE, 1)         \
+  X(SWITCH_TABLE, 1)         \
+  X(SWITCH_STRING, 1)        \
+  X(CALL, 1)                 \
+  X(RETURN, 0)               \
+  X(RETURN_VOID, 0)          \
+  X(PRINT, 0)                \
+  X(READ, 1)                 \
+  X(TRAP, 1)                 \
+  X(HALT, 0)                 \
+  X(LOAD_LOCAL_PAIR, 2)      \
+  X(LOAD_LOCAL_ADD_CONST, 2) \
+  X(INC_LOCAL, 2)            \
+  X(LT_I64_JUMP_IF_FALSE, 1) \
+  X(GT_I64_JUMP_IF_FALSE, 1) \
+  X(ADD_I64, 0)              \
+  X(SUB_I64, 0)              \
+  X(MUL_I64, 0)              \
+  X(DIV_I64, 0)              \
+  X(NEG_I64, 0)              \
+  X(LT_I64, 0)               \
+  X(GT_I64, 0)               \
+  X(EQ_I64, 0)               \
+  X(NEQ_I64, 0)              \
+  X(ADD_F64, 0)              \
+  X(SUB_F64, 0)              \
+  X(MUL_F64, 0)              \
+  X(DIV_F64, 0)              \
+  X(NEG_F64, 0)              \
+  X(LT_F64, 0)               \
+  X(GT_F64, 0)               \
+  X(EQ_F64, 0)               \
+  X(NEQ_F64, 0)              \
+  X(I64_TO_F64, 0)           \
+  X(QUICK_ADD_INT, 0)        \
+  X(QUICK_SUB_INT, 0)        \
+  X(QUICK_MUL_INT, 0)        \
+  X(QUICK_DIV_INT, 0)        \
+  X(QUICK_LT_INT, 0)         \
+  X(QUICK_GT_INT, 0)         \
+  X(QUICK_EQ_INT, 0)         \
+  X(QUICK_NEQ_INT, 0)        \
+  X(QUICK_ADD_FLOAT, 0)      \
+  X(QUICK_SUB_FLOAT, 0)      \
+  X(QUICK_MUL_FLOAT, 0)      \
+  X(QUICK_DIV_FLOAT, 0)      \
+  X(QUICK_LT_FLOAT, 0)       \
+  X(QUICK_GT_FLOAT, 0)       \
+  X(QUICK_EQ_FLOAT, 0)       \
+  X(QUICK_NEQ_FLOAT, 0)
+
+enum class OpCode : uint8_t {
+#define RPN_OPCODE_ENUM(name, operands) name,
+  RPN_OPCODES(RPN_OPCODE_ENUM)
+#undef RPN_OPCODE_ENUM
+};
+
+inline constexpr uint8_t OPCODE_OPERANDS[] = {
+#define RPN_OPCODE_OPERANDS(name, operands) operands,
+  RPN_OPCODES(RPN_OPCODE_OPERANDS)
+#undef RPN_OPCODE_OPERANDS
+};
+
+inline constexpr const char* OPCODE_NAMES[] = {
+#define RPN_OPCODE_NAME(name, operands) #name,
+  RPN_OPCODES(RPN_OPCODE_NAME)
+#undef RPN_OPCODE_NAME
+};
+
+inline constexpr size_t OPCODE_COUNT = sizeof(OPCODE_OPERANDS);
+
+// Bytes taken by an instruction with its operands
+inline constexpr size_t instructionSize(const OpCode op) {
+  return 1 + 4 * OPCODE_OPERANDS[static_cast<uint8_t>(op)];
+}
+
+inline uint32_t readOperand(const uint8_t* code) {
+  uint32_t value;
+  std::memcpy(&value, code, sizeof(value));
+  return value;
+}
+
+inline void writeOperand(uint8_t* code, const uint32_t value) {
+  std::memcpy(code, &value, sizeof(value));
+}
+
+
+// Kind of a runtime value (operand of NEW_ARRAY and READ)
+enum class ValueKind : uint8_t {
+  VOID, INT, FLOAT, CHAR, BOOL, STRING, ARRAY
+};
+
+const char* valueKindName(ValueKind kind);
+
+// Flag of the NEW_ARRAY kind operand: the array never outlives the call creating it
+// (EscapeAnalysis), so it is made in the region released when that call returns
+inline constexpr uint32_t LOCAL_ARRAY = 0x100;
+
+inline ValueKind arrayLeaf(const uint32_t kind) { return static_cast<ValueKind>(kind & 0xFF); }
+inline bool isLocalArray(const uint32_t kind) { return (kind & LOCAL_ARRAY) != 0; }
+
+
+// A compiled function (of either bytecode format, see register-bytecode.h)
+struct RPNFunction {
+  std::string name;
+  uint32_t entry = 0; // offset of the first instruction
+  uint32_t end = 0; // offset past the last instruction
+  uint32_t parameters = 0;
+  uint32_t slots = 0; // frame size: parameters, locals and temporaries (registers)
+  uint32_t maxStack = 0; // deepest operand stack the body needs (0 for registers)
+  bool returnsValue = false;
+  bool localStrings = false; // the strings it makes never outlive the call: they go to its region
+  std::vector<std::string> slotNames; // for the disassembler; a reused slot lists every name
+};
+
+// What the bytecode formats share: functions, constant pools, globals and the line
+// table. Function 0 runs the top-level instructions, then `main` if the program
+// defines one.
+struct BytecodeProgram {
+  std::vector<uint8_t> code;
+  std::vector<RPNFunction> functions;
+
+  std::vector<int64_t> integers;
+  std::vector<double> floats;
+  std::vector<std::string> strings;
+
+  uint32_t globals = 0;
+  std::vector<std::string> globalNames;
+
+  // (code offset, source line) at every line change, ordered by offset
+  std::vector<std::pair<uint32_t, uint32_t>> lines;
+
+  // Source line of the instruction at `offset` (0 if unknown)
+  [[nodiscard]] uint32_t lineAt(uint32_t offset) const;
+};
+
+// Hash of SWITCH_STRING labels, one function per seed
+uint32_t switchHash(uint32_t seed, std::string_view text);
+
+// Where a SWITCH_TABLE or SWITCH_STRING goes: targets[find(subject)], or `fallback` (the
+// `default` arm) when find() returns targets.size()
+struct SwitchTable {
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  std::vector<uint32_t> targets; // code offsets
+  uint32_t fallback = 0;
+  // SWITCH_TABLE: the case v is at v - low (every value in between has an entry)
+  int64_t low = 0;
+  // SWITCH_STRING: hash and displace. The label s can only be at the slot
+  // switchHash(seeds[switchHash(0, s) % seeds.size()], s) % targets.size() (a power of
+  // two), where labels holds its RPNProgram::strings index; EMPTY in the unused slots
+  std::vector<uint32_t> seeds;
+  std::vector<uint32_t> labels;
+
+  [[nodiscard]] size_t find(const int64_t value) const {
+    const uint64_t index = static_cast<uint64_t>(value) - static_cast<uint64_t>(low);
+    return index < targets.size() ? static_cast<size_t>(index) : targets.size();
+  }
+
+  [[nodiscard]] size_t find(std::string_view text, const std::vector<std::string>& strings) const;
+};
+
+// Stack (postfix) bytecode
+struct RPNProgram : BytecodeProgram {
+  std::vector<SwitchTable> switches;
+
+  // Number of instructions in the code (not bytes)
+  [[nodiscard]] size_t instructionCount() const;
+};
+
+
+// Human-readable listing of the bytecode, one instruction per line
+std::string disassemble(const RPNProgram& program);
+
+
+#endif //BYTECODE_H
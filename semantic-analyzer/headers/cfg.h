@@ -0,0 +1,71 @@
+#ifndef CFG_H
+#define CFG_H
+
+
+#include "../../includes/libraries.h"
+#include "ast-node.h"
+#include "types.h"
+
+
+// What a statement does to a local variable, in execution order
+struct CFGEvent {
+  enum class Kind : uint8_t {
+    USE,  // the value is read
+    DEF,  // a value is stored
+    KILL  // declared without a value (the variable holds garbage again)
+  };
+
+  Kind kind;
+  uint32_t local; // dense index into ControlFlowGraph::getLocals()
+  uint32_t slot; // the local's dataflow bit
+  const ASTNode* node; // for the diagnostic's line
+};
+
+// Straight-line piece of a function; its events are the range [firstEvent, lastEvent)
+// of ControlFlowGraph::getEvents()
+struct BasicBlock {
+  uint32_t firstEvent = 0;
+  uint32_t lastEvent = 0;
+  std::vector<uint32_t> successors;
+  std::vector<uint32_t> predecessors;
+};
+
+struct LocalVariable {
+  uint32_t binding; // TID record
+  const ASTNode* declaration;
+  bool parameter;
+  uint32_t slot; // dataflow bit, shared by locals whose scopes do not overlap
+};
+
+
+// Control-flow graph of one function built from its analysed AST (bindings must be
+// set). Only the function's own parameters and variables are tracked, globals are not.
+// Locals get stack-like slots: a nested scope reuses the slots of the sibling scopes
+// before it, so the dataflow bit vectors are as wide as the deepest set of locals that
+// is in scope at once, not as the function's total number of locals.
+class ControlFlowGraph {
+public:
+  static constexpr uint32_t ENTRY = 0;
+  static constexpr uint32_t EXIT = 1;
+
+  static ControlFlowGraph build(const ASTNodePtr& function, const TypeTable& types);
+
+  [[nodiscard]] const std::vector<BasicBlock>& getBlocks() const { return blocks_; }
+  [[nodiscard]] const std::vector<CFGEvent>& getEvents() const { return events_; }
+  [[nodiscard]] const std::vector<LocalVariable>& getLocals() const { return locals_; }
+  [[nodiscard]] uint32_t slotCount() const { return slotCount_; }
+
+  // Blocks reachable from ENTRY in reverse postorder (the fast order for forward problems)
+  [[nodiscard]] std::vector<uint32_t> reversePostorder() const;
+
+private:
+  friend class CFGBuilder;
+
+  std::vector<BasicBlock> blocks_;
+  std::vector<CFGEvent> events_;
+  std::vector<LocalVariable> locals_;
+  uint32_t slotCount_ = 0;
+};
+
+
+#endif //CFG_H
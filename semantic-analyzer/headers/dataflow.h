@@ -0,0 +1,53 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+
+#include "../../includes/libraries.h"
+#include "bit-vector.h"
+#include "cfg.h"
+#include "diagnostics.h"
+#include "tid.h"
+
+
+// Bit-vector dataflow over one function's ControlFlowGraph, one bit per local slot:
+//   definite assignment (forward, meet = AND) - assigned on every path
+//   possible assignment (forward, meet = OR)  - assigned on some path
+//   liveness            (backward, meet = OR) - read later on some path
+// Each block's effect is summarised once as gen/kill sets, then a worklist seeded in
+// (reverse) postorder iterates the word-parallel transfer to a fixed point.
+class DataflowAnalyzer {
+public:
+  explicit DataflowAnalyzer(const ControlFlowGraph& graph);
+
+  void solve();
+
+  // Uninitialized reads, dead stores and unused variables, sorted by line; unreachable
+  // code is not reported
+  [[nodiscard]] std::vector<Diagnostic> diagnose(const TID& tid) const;
+
+  [[nodiscard]] const BitVector& definitelyAssignedIn(const uint32_t block) const { return definiteIn_[block]; }
+  [[nodiscard]] const BitVector& liveOut(const uint32_t block) const { return liveOut_[block]; }
+
+private:
+  const ControlFlowGraph& graph_;
+  std::vector<uint32_t> order_; // reachable blocks, reverse postorder
+  std::vector<uint8_t> reachable_;
+
+  // per-block summaries
+  std::vector<BitVector> assignGen_, assignKill_; // stored last / declared without a value last
+  std::vector<BitVector> liveUse_, liveDef_; // read before any store / stored
+
+  std::vector<BitVector> definiteIn_, definiteOut_;
+  std::vector<BitVector> possibleIn_, possibleOut_;
+  std::vector<BitVector> liveIn_, liveOut_;
+
+  void summarizeBlocks();
+  void solveAssignment(std::vector<BitVector>& in, std::vector<BitVector>& out, bool must);
+  void solveLiveness();
+
+  // 'int x = 0;' - a defensive initial value, not worth a dead-store warning
+  static bool isLiteralInitializer(const ASTNode* node);
+};
+
+
+#endif //DATAFLOW_H
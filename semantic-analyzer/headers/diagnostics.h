@@ -0,0 +1,25 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+
+#include "../../includes/libraries.h"
+
+
+// A message about the program that does not stop the compilation (errors are still
+// reported by throwing)
+struct Diagnostic {
+  enum class Severity { WARNING, ERROR };
+
+  Severity severity;
+  uint32_t line; // 0 if unknown
+  std::string message;
+
+  [[nodiscard]] std::string toString() const {
+    std::string text = line ? "line " + std::to_string(line) + ": " : "";
+    text += severity == Severity::WARNING ? "warning: " : "error: ";
+    return text + message;
+  }
+};
+
+
+#endif //DIAGNOSTICS_H
@@ -0,0 +1,82 @@
+#ifndef FUNCTION_ANALYZER_H
+#define FUNCTION_ANALYZER_H
+
+
+#include "../../lexical-analyzer/headers/tokens.h"
+#include "ast-node.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include "diagnostics.h"
+#include "tid.h"
+#include "types.h"
+
+
+// Resolves and type checks one function body (or the top-level instructions) against a
+// TID. Writes go only to that TID and to its own buffers, and the type table is only
+// read, so function bodies can be analysed on separate threads, each on its own TID
+// opened on top of the global one.
+class FunctionAnalyzer {
+public:
+  FunctionAnalyzer(TID& table, const TypeTable& typeTable, const bool verbose) :
+  tid(table), types(typeTable), currentScope(GLOBAL_SCOPE), verbose_(verbose) {}
+
+  // Body of a function whose signature is already declared in the global scope; runs
+  // the dataflow analyses once the body is resolved
+  void analyzeFunction(const ASTNodePtr& function);
+
+  // An instruction of the current scope (the top-level code is analysed this way)
+  void analyzeInstruction(const ASTNodePtr& instruction);
+
+  // Управление областями видимости
+  void enterScope(const std::string& scopeName);
+  void exitScope();
+  [[nodiscard]] ScopeId getCurrentScope() const { return currentScope; }
+
+  // Работа с идентификаторами
+  IdentifierHandle declareIdentifier(SymbolId symbol, TypeId type);
+  IdentifierHandle useIdentifier(SymbolId symbol);
+  void initializeIdentifier(SymbolId symbol);
+
+  // Проверки
+  void checkType(TypeId expectedType, TypeId actualType) const;
+  [[nodiscard]] static bool isAssignable(TypeId target, TypeId source);
+
+  // Warnings of this body and the verbose log of its declarations, in source order
+  [[nodiscard]] std::vector<Diagnostic>& getDiagnostics() { return diagnostics_; }
+  [[nodiscard]] const std::string& getTrace() const { return trace_; }
+
+private:
+  TID& tid;
+  const TypeTable& types;
+  ScopeId currentScope; // Текущая область видимости (узел дерева областей в TID)
+  bool verbose_;
+
+  std::vector<Diagnostic> diagnostics_;
+  std::string trace_;
+
+  // Состояние анализируемой функции
+  TypeId returnType_ = TypeTable::VOID;
+  bool insideFunction_ = false;
+  size_t loopDepth_ = 0; // 'continue' is valid inside loops
+  size_t breakableDepth_ = 0; // 'break' is valid inside loops and switches
+
+  void analyzeDataflow(const ASTNodePtr& function);
+  void analyzeBlock(const ASTNodePtr& block, const std::string& scopeName);
+  void analyzeDeclaration(const ASTNodePtr& declaration);
+  void analyzeAssignment(const ASTNodePtr& assignment);
+  void analyzeLoop(const ASTNodePtr& loop);
+  void analyzeSwitch(const ASTNodePtr& switchNode);
+  void analyzeCondition(const ASTNodePtr& condition, const std::string& statement);
+
+  // Returns the cached type of an expression, computing it on first use
+  TypeId analyzeExpression(const ASTNodePtr& expression);
+  TypeId computeExpressionType(const ASTNodePtr& expression);
+  TypeId computeOperatorType(const ASTNodePtr& expression);
+  TypeId computeCallType(const ASTNodePtr& call);
+  TypeId computeLiteralType(const ASTNodePtr& literal) const;
+
+  void expectAssignable(TypeId target, TypeId source, const std::string& context) const;
+};
+
+
+#endif //FUNCTION_ANALYZER_H
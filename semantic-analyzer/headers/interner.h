@@ -0,0 +1,35 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+
+#include "../../includes/libraries.h"
+
+
+using SymbolId = uint32_t;
+
+inline constexpr SymbolId INVALID_SYMBOL = UINT32_MAX;
+
+
+// Maps every distinct identifier spelling to a dense integer id, so that the rest of
+// the semantic analyzer compares and hashes names as plain integers
+class SymbolInterner {
+public:
+  SymbolId intern(const std::string& name);
+
+  // Returns INVALID_SYMBOL if the name was never interned
+  [[nodiscard]] SymbolId find(const std::string& name) const;
+
+  [[nodiscard]] const std::string& getName(SymbolId symbol) const;
+
+  [[nodiscard]] size_t size() const { return names_.size(); }
+
+  // Approximate heap footprint (hash nodes, bucket array, spellings, reverse index)
+  [[nodiscard]] size_t memoryUsage() const;
+
+private:
+  std::unordered_map<std::string, SymbolId> ids_;
+  std::vector<const std::string*> names_; // points into ids_ keys (node-based, stable)
+};
+
+
+#endif //INTERNER_H
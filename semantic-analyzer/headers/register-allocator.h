@@ -0,0 +1,96 @@
+#ifndef REGISTER_ALLOCATOR_H
+#define REGISTER_ALLOCATOR_H
+
+
+#include "../../includes/libraries.h"
+#include "bit-vector.h"
+#include "register-bytecode.h"
+
+
+// Instruction over virtual registers: the operands are laid out as in the encoding,
+// but registers are virtual and jump targets are label ids
+struct RegisterInstruction {
+  RegOp op;
+  uint32_t line;
+  std::vector<uint32_t> operands;
+};
+
+// One function in three-address form before register allocation
+struct RegisterFunctionIR {
+  std::vector<RegisterInstruction> instructions;
+  std::vector<uint32_t> labels; // label id -> index of the instruction it is bound to
+  uint32_t virtualRegisters = 0;
+  uint32_t parameters = 0; // virtual registers 0..n-1, fixed to frame slots 0..n-1
+  std::vector<std::string> names; // variable per virtual register, "" for temporaries
+
+  // Calls f(operand index, is a definition) for every register operand of `instruction`
+  template <typename Visitor>
+  static void forEachRegister(const RegisterInstruction& instruction, Visitor&& visit) {
+    const char* roles = REGISTER_OPCODE_ROLES[static_cast<uint8_t>(instruction.op)];
+    for (size_t i = 0, operand = 0; roles[i]; ++i, ++operand) {
+      if (roles[i] == 'd' || roles[i] == 'u') {
+        visit(operand, roles[i] == 'd');
+      } else if (roles[i] == 'n') {
+        const uint32_t count = instruction.operands[operand];
+        for (uint32_t j = 0; j < count; ++j) {
+          visit(++operand, false);
+        }
+      }
+    }
+  }
+};
+
+
+// Linear-scan register allocation (Poletto & Sarkar) onto frame slots. Liveness is
+// solved on the basic blocks, each virtual register gets the interval from its first
+// to its last live point, and the intervals are walked by start, reusing the slots of
+// expired ones. There is no register limit, so nothing is spilled; the scan keeps the
+// frame small and, by preferring the slot of the other side of a MOVE, lets the encoder
+// drop the moves whose both sides ended up in one slot.
+class LinearScanAllocator {
+public:
+  explicit LinearScanAllocator(const RegisterFunctionIR& function) : function_(function) {}
+
+  void allocate();
+
+  [[nodiscard]] uint32_t slot(const uint32_t virtualRegister) const { return slots_[virtualRegister]; }
+  [[nodiscard]] uint32_t slotCount() const { return slotCount_; }
+
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  // Positions: a use at instruction p is 2p, a definition 2p + 1, so an interval that
+  // ends at a read can hand its slot to one defined by the same instruction
+  struct Interval {
+    uint32_t start = NONE;
+    uint32_t end = 0;
+
+    void extend(const uint32_t position) {
+      start = std::min(start, position);
+      end = std::max(end, position);
+    }
+  };
+
+  struct Block {
+    uint32_t first;
+    uint32_t last; // inclusive
+    std::vector<uint32_t> successors;
+  };
+
+  const RegisterFunctionIR& function_;
+  std::vector<uint32_t> slots_;
+  uint32_t slotCount_ = 0;
+
+  [[nodiscard]] std::vector<Block> buildBlocks() const;
+  [[nodiscard]] std::vector<Interval> buildIntervals(const std::vector<Block>& blocks) const;
+};
+
+
+// Allocates the frame slots of `function` (LinearScanAllocator) and appends its encoding
+// to the code of `program`, as program.functions[index]: a MOVE between registers that
+// share a slot is dropped, labels become offsets, the lines table and the slot names
+// are filled in
+void encodeFunction(const RegisterFunctionIR& function, RegisterProgram& program, uint32_t index);
+
+
+#endif //REGISTER_ALLOCATOR_H
@@ -0,0 +1,112 @@
+#ifndef REGISTER_BYTECODE_H
+#define REGISTER_BYTECODE_H
+
+
+#include "../../includes/libraries.h"
+#include "bytecode.h"
+
+
+// Instruction set of the three-address register bytecode: X(name, operand roles). A
+// register is a slot of the function's frame (parameters are registers 0..n-1); every
+// operand is a uint32_t like in the stack format. Roles:
+//   d - register written, u - register read, i - immediate or pool index,
+//   t - absolute jump target, n - a count followed by that many registers read
+//
+//   MOVE d s                  d = s
+//   LOAD_INT d value          int32 immediate (LOAD_LONG, LOAD_FLOAT, LOAD_STRING take a
+//                             pool index, LOAD_CHAR and LOAD_BOOL an immediate)
+//   NEW_ARRAY d kind n sizes  see the stack NEW_ARRAY
+//   CALL d function n args    arguments are copied into the callee's first registers
+//   CALL_VOID function n args
+#define REGISTER_OPCODES(X) \
+  X(MOVE, "du")             \
+  X(LOAD_INT, "di")         \
+  X(LOAD_LONG, "di")        \
+  X(LOAD_FLOAT, "di")       \
+  X(LOAD_CHAR, "di")        \
+  X(LOAD_BOOL, "di")        \
+  X(LOAD_STRING, "di")      \
+  X(LOAD_GLOBAL, "di")      \
+  X(STORE_GLOBAL, "iu")     \
+  X(NEW_ARRAY, "din")       \
+  X(LOAD_INDEX, "duu")      \
+  X(STORE_INDEX, "uuu")     \
+  X(ADD, "duu")             \
+  X(SUB, "duu")             \
+  X(MUL, "duu")             \
+  X(DIV, "duu")             \
+  X(NEG, "du")              \
+  X(NOT, "du")              \
+  X(LT, "duu")              \
+  X(GT, "duu")              \
+  X(EQ, "duu")              \
+  X(NEQ, "duu")             \
+  X(TO_INT, "du")           \
+  X(TO_FLOAT, "du")         \
+  X(TO_CHAR, "du")          \
+  X(TO_BOOL, "du")          \
+  X(JUMP, "t")              \
+  X(JUMP_IF_FALSE, "ut")    \
+  X(JUMP_IF_TRUE, "ut")     \
+  X(CALL, "din")            \
+  X(CALL_VOID, "in")        \
+  X(RETURN, "u")            \
+  X(RETURN_VOID, "")        \
+  X(PRINT, "u")             \
+  X(READ, "di")             \
+  X(TRAP, "i")              \
+  X(HALT, "")
+
+enum class RegOp : uint8_t {
+#define REGISTER_OPCODE_ENUM(name, roles) name,
+  REGISTER_OPCODES(REGISTER_OPCODE_ENUM)
+#undef REGISTER_OPCODE_ENUM
+};
+
+inline constexpr const char* REGISTER_OPCODE_ROLES[] = {
+#define REGISTER_OPCODE_ROLES_ENTRY(name, roles) roles,
+  REGISTER_OPCODES(REGISTER_OPCODE_ROLES_ENTRY)
+#undef REGISTER_OPCODE_ROLES_ENTRY
+};
+
+inline constexpr const char* REGISTER_OPCODE_NAMES[] = {
+#define REGISTER_OPCODE_NAME(name, roles) #name,
+  REGISTER_OPCODES(REGISTER_OPCODE_NAME)
+#undef REGISTER_OPCODE_NAME
+};
+
+inline constexpr size_t REGISTER_OPCODE_COUNT = sizeof(REGISTER_OPCODE_NAMES) / sizeof(const char*);
+
+// Number of operands of the instruction at `code` (counted lists included)
+inline size_t registerOperandCount(const uint8_t* code) {
+  const char* roles = REGISTER_OPCODE_ROLES[*code];
+  size_t count = 0;
+  for (; roles[count]; ++count) {
+    if (roles[count] == 'n') {
+      return count + 1 + readOperand(code + 1 + 4 * count);
+    }
+  }
+  return count;
+}
+
+// Bytes taken by the instruction at `code`
+inline size_t registerInstructionSize(const uint8_t* code) {
+  return 1 + 4 * registerOperandCount(code);
+}
+
+// Bytes taken by an instruction without a counted list
+inline constexpr size_t registerInstructionSize(const RegOp op) {
+  return 1 + 4 * std::char_traits<char>::length(REGISTER_OPCODE_ROLES[static_cast<uint8_t>(op)]);
+}
+
+
+// Register bytecode (RPNFunction::slots is the number of registers, maxStack is 0)
+struct RegisterProgram : BytecodeProgram {
+  [[nodiscard]] size_t instructionCount() const;
+};
+
+
+std::string disassemble(const RegisterProgram& program);
+
+
+#endif //REGISTER_BYTECODE_H
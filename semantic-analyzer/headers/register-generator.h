@@ -0,0 +1,132 @@
+#ifndef REGISTER_GENERATOR_H
+#define REGISTER_GENERATOR_H
+
+
+#include "../../includes/libraries.h"
+#include "ast-node.h"
+#include "register-allocator.h"
+#include "register-bytecode.h"
+#include "tid.h"
+#include "types.h"
+
+
+// Compiles an analysed AST into three-address register bytecode, the alternative to
+// RPNGenerator. Every variable and every intermediate result gets its own virtual
+// register, expressions are computed straight into the register they are assigned to,
+// and the constants an operator needs are loaded once at function entry. Loops test
+// their condition at the bottom (one branch per iteration). LinearScanAllocator then
+// maps the virtual registers of each function onto frame slots.
+class RegisterGenerator {
+public:
+  RegisterGenerator(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
+
+  RegisterProgram generate(const ASTNodePtr& program);
+
+  // Comparison trees for switches over ints and chars (see switchStatement); off, every
+  // switch compares its subject with each label in turn (on by default)
+  void setSwitchLowering(const bool lowering) { switchLowering_ = lowering; }
+
+  // Values computed once (CommonSubexpressions): the first computation goes to a register
+  // of its own, the later ones read it; none by default
+  void setSharedExpressions(const SharedExpressions* shared) { shared_ = shared; }
+
+  // Arrays and strings made in the region of their call (EscapeAnalysis): LOCAL_ARRAY
+  // arrays, RPNFunction::localStrings; none by default
+  void setLocalAllocations(const LocalAllocations* locals) { locals_ = locals; }
+
+private:
+  static constexpr size_t MIN_TREE_CASES = 4; // fewer are compared in turn
+  static constexpr size_t TREE_LEAF_CASES = 3; // a comparison tree compares this many in turn
+
+  // An int or char case label of a switch: its value, the literal, the arm
+  struct SwitchCase {
+    int64_t value;
+    ASTNodePtr label;
+    size_t arm;
+  };
+
+  const TID& tid_;
+  const TypeTable& types_;
+  bool switchLowering_ = true;
+  const SharedExpressions* shared_ = nullptr;
+  const LocalAllocations* locals_ = nullptr;
+  RegisterProgram program_;
+
+  std::unordered_map<uint32_t, uint32_t> functionByBinding_;
+  std::unordered_map<uint32_t, uint32_t> globalByBinding_;
+  std::unordered_map<std::string, uint32_t> stringIndex_;
+  std::unordered_map<uint64_t, uint32_t> floatIndex_;
+
+  // state of the function being compiled
+  RegisterFunctionIR ir_;
+  std::vector<RegisterInstruction> prologue_; // constant loads, run once at entry
+  std::map<std::pair<RegOp, uint32_t>, uint32_t> constants_; // (load, operand) -> register
+  std::unordered_map<uint32_t, uint32_t> registerByBinding_;
+  std::unordered_map<uint32_t, uint32_t> registerByValue_; // shared values computed so far
+  TypeId returnType_ = TypeTable::VOID;
+  uint32_t line_ = 0;
+  std::vector<uint32_t> breakLabels_;
+  std::vector<uint32_t> continueLabels_;
+
+  void compileEntry(const ASTNodePtr& program, const ASTNodePtr& main);
+  void compileFunction(const ASTNodePtr& function, uint32_t index);
+  void beginFunction();
+  void endFunction(uint32_t index);
+
+  void statement(const ASTNodePtr& node);
+  void declaration(const ASTNodePtr& node);
+  void assignment(const ASTNodePtr& node);
+  void loop(const ASTNodePtr& node);
+  void switchStatement(const ASTNodePtr& node);
+  // Binary search over `cases` sorted by value, from first to last
+  void switchTree(uint32_t subject, const std::vector<SwitchCase>& cases, size_t first, size_t last,
+    const std::vector<uint32_t>& arms, uint32_t fallback);
+
+  // Jumps to `target` when a condition is `when` and falls through otherwise: `!`, `&&`
+  // and `||` become branches (no bool register is written for them), the other operands
+  // are evaluated and tested by one conditional jump each
+  void condition(const ASTNodePtr& node, uint32_t target, bool when);
+
+  // Register holding the value of an expression: a variable's or a constant's own
+  // register, or a new temporary; never to be written
+  uint32_t value(const ASTNodePtr& node);
+
+  // Computes an expression into `target`, which is written only by the last instruction
+  void valueInto(const ASTNodePtr& node, uint32_t target);
+  // valueInto() without looking for a shared value
+  void computeInto(const ASTNodePtr& node, uint32_t target);
+
+  // Evaluates an expression for its effects only
+  void effect(const ASTNodePtr& node);
+
+  // value() / valueInto() converted to `type` (assignments, arguments, returns)
+  uint32_t convertedValue(const ASTNodePtr& node, TypeId type);
+  void convertedValueInto(const ASTNodePtr& node, TypeId type, uint32_t target);
+
+  void binaryInto(const ASTNodePtr& node, uint32_t target);
+  void logicalInto(const ASTNodePtr& node, uint32_t target);
+  void literalInto(const ASTNodePtr& node, uint32_t target);
+  void callInto(const ASTNodePtr& node, uint32_t target);
+  void zeroValueInto(TypeId type, uint32_t target);
+
+  // Load instruction and operand of a literal
+  std::pair<RegOp, uint32_t> literalLoad(const ASTNodePtr& node);
+  uint32_t constant(RegOp load, uint32_t operand);
+
+  uint32_t newRegister(const std::string& name = "");
+  uint32_t newLabel();
+  void bind(uint32_t label);
+  void emit(RegOp op, std::vector<uint32_t> operands);
+
+  // Conversion instruction to `target` for a value of type `source` (nullopt if none)
+  [[nodiscard]] static std::optional<RegOp> conversion(TypeId target, TypeId source);
+  [[nodiscard]] ValueKind valueKind(TypeId type) const;
+  [[nodiscard]] bool isLocal(uint32_t binding) const { return registerByBinding_.contains(binding); }
+  uint32_t globalIndex(uint32_t binding);
+
+  uint32_t addString(const std::string& value);
+  uint32_t addFloat(double value);
+};
+
+
+#endif //REGISTER_GENERATOR_H
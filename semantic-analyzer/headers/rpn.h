@@ -3,13 +3,139 @@
 
 
 #include "../../includes/libraries.h"
-#include "../../lexical-analyzer/headers/lexer.h"
-#include "../../syntax-analyzer/headers/parser.h"
+#include "ast-node.h"
+#include "bytecode.h"
+#include "tid.h"
+#include "types.h"
 
 
+// Compiles an analysed AST (types and bindings set by SemanticAnalyzer) into postfix
+// bytecode: operands are pushed before their operator, so an expression becomes the
+// reverse Polish notation of its tree. Jumps get absolute offsets, variables get frame
+// slots (locals, stack-like reuse across sibling scopes) or global slots, calls get
+// function indices, so nothing is looked up by name at run time.
 class RPNGenerator {
 public:
+  RPNGenerator(const TID& tid, const TypeTable& types) : tid_(tid), types_(types) {}
 
+  RPNProgram generate(const ASTNodePtr& program);
+
+  // INDEX nodes whose checks can be left out (RangeAnalysis); none by default
+  void setInBounds(const std::unordered_set<const ASTNode*>* inBounds) { inBounds_ = inBounds; }
+
+  // Values computed once (CommonSubexpressions): the first computation is kept in a slot
+  // of its own, the later ones load it; none by default
+  void setSharedExpressions(const SharedExpressions* shared) { shared_ = shared; }
+
+  // Arrays and strings made in the region of their call (EscapeAnalysis): LOCAL_ARRAY
+  // arrays, RPNFunction::localStrings; none by default
+  void setLocalAllocations(const LocalAllocations* locals) { locals_ = locals; }
+
+  // Jump tables, comparison trees and perfect hashes for switches (see switchStatement);
+  // off, every switch compares its subject with each label in turn (on by default)
+  void setSwitchLowering(const bool lowering) { switchLowering_ = lowering; }
+
+private:
+  static constexpr uint32_t UNBOUND = UINT32_MAX;
+  static constexpr size_t MIN_LOWERED_CASES = 4; // fewer are compared in turn
+  static constexpr size_t TREE_LEAF_CASES = 3; // a comparison tree compares this many in turn
+  static constexpr uint32_t MAX_HASH_SEED = 1u << 16; // tried per bucket before the slots double
+
+  // Jump target; jumps emitted before the label is bound are patched when it is
+  struct Label {
+    uint32_t offset = UNBOUND;
+    std::vector<uint32_t> patches; // operand positions
+  };
+
+  // A case label of a switch: its int value (a strings index for a string label), the arm
+  struct SwitchCase {
+    int64_t value;
+    size_t arm;
+  };
+
+  const TID& tid_;
+  const TypeTable& types_;
+  const std::unordered_set<const ASTNode*>* inBounds_ = nullptr;
+  const SharedExpressions* shared_ = nullptr;
+  const LocalAllocations* locals_ = nullptr;
+  bool switchLowering_ = true;
+  RPNProgram program_;
+
+  std::unordered_map<uint32_t, uint32_t> functionByBinding_;
+  std::unordered_map<uint32_t, uint32_t> globalByBinding_;
+  std::unordered_map<std::string, uint32_t> stringIndex_;
+  std::unordered_map<uint64_t, uint32_t> floatIndex_;
+
+  // state of the function being compiled
+  RPNFunction* function_ = nullptr;
+  TypeId returnType_ = TypeTable::VOID;
+  std::unordered_map<uint32_t, uint32_t> slotByBinding_;
+  std::unordered_map<uint32_t, uint32_t> slotByValue_; // shared values computed so far
+  uint32_t nextSlot_ = 0;
+  uint32_t stackDepth_ = 0;
+  uint32_t line_ = 0;
+  std::vector<Label*> breakLabels_;
+  std::vector<Label*> continueLabels_;
+
+  void compileEntry(const ASTNodePtr& program, const ASTNodePtr& main);
+  void compileFunction(const ASTNodePtr& function, uint32_t index);
+  void beginFunction(uint32_t index);
+  void endFunction();
+
+  void statement(const ASTNodePtr& node);
+  void declaration(const ASTNodePtr& node);
+  void assignment(const ASTNodePtr& node);
+  void loop(const ASTNodePtr& node);
+  void switchStatement(const ASTNodePtr& node);
+  // Binary search over `cases` sorted by value, from first to last, on the int in `subject`
+  void switchTree(uint32_t subject, const std::vector<SwitchCase>& cases, size_t first, size_t last,
+    std::vector<Label>& arms, Label& fallback);
+  // The seeds and slots of SWITCH_STRING over the string indices in `cases`
+  void perfectHash(SwitchTable& table, const std::vector<SwitchCase>& cases) const;
+
+  // Jumps to `target` when a condition is `when` and falls through otherwise: `!`, `&&`
+  // and `||` become branches (no bool is pushed for them), the other operands are
+  // evaluated and tested by one conditional jump each
+  void condition(const ASTNodePtr& node, Label& target, bool when);
+  // Pushes the value of an expression (nothing for a void call)
+  void expression(const ASTNodePtr& node);
+  // expression() without looking for a shared value
+  void computeExpression(const ASTNodePtr& node);
+  void operatorExpression(const ASTNodePtr& node);
+  // Pushes array[i1]..[in] of an INDEX chain, or stores `value` there. The indices go to
+  // one LOAD_ELEMENT / STORE_ELEMENT while those after the first (and the stored value)
+  // can neither fail nor have an effect, so checking them together is unobservable.
+  // A group of indices all proven in bounds gets the *_UNCHECKED form.
+  void element(const ASTNodePtr& node, const ASTNodePtr* value = nullptr);
+  // Pushes an int or float operand of a float operator as a float
+  void floatOperand(const ASTNodePtr& node);
+  void literal(const ASTNodePtr& node);
+  void pushInteger(int64_t value);
+  void call(const ASTNodePtr& node);
+
+  // Pushes the value a variable of `type` holds before its first assignment
+  void zeroValue(TypeId type);
+
+  // Converts the scalar on top of the stack from `source` to `target`
+  void convert(TypeId target, TypeId source);
+
+  void load(uint32_t binding);
+  void store(uint32_t binding);
+  uint32_t declareLocal(const ASTNode* declaration);
+  uint32_t allocateSlot(const std::string& name);
+  uint32_t globalIndex(uint32_t binding, const std::string& name);
+
+  [[nodiscard]] ValueKind valueKind(TypeId type) const;
+
+  void emit(OpCode op);
+  void emit(OpCode op, uint32_t operand);
+  void emit(OpCode op, uint32_t first, uint32_t second);
+  void emitJump(OpCode op, Label& label);
+  void bind(Label& label);
+  void adjustStack(int delta);
+
+  uint32_t addString(const std::string& value);
+  uint32_t addFloat(double value);
 };
 
 
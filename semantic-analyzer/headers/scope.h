@@ -0,0 +1,59 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+
+#include "../../includes/libraries.h"
+#include "interner.h"
+
+
+using ScopeId = uint32_t;
+
+inline constexpr ScopeId GLOBAL_SCOPE = 0;
+inline constexpr ScopeId NO_SCOPE = UINT32_MAX;
+
+
+// Open-addressing hash table (linear probing, power-of-two capacity) from an interned
+// symbol to an index in the TID's identifier storage. Keys and values sit side by side
+// in one flat array, so a probe never leaves the current cache line in the common case.
+class FlatSymbolTable {
+public:
+  static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+  [[nodiscard]] uint32_t find(SymbolId symbol) const;
+
+  // Returns false if the symbol is already present (the table is left unchanged)
+  bool insert(SymbolId symbol, uint32_t value);
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] size_t memoryUsage() const { return slots_.capacity() * sizeof(Slot); }
+
+private:
+  struct Slot {
+    SymbolId key = INVALID_SYMBOL;
+    uint32_t value = NOT_FOUND;
+  };
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+
+  static uint32_t hash(const SymbolId symbol) {
+    return symbol * 0x9E3779B1u; // multiplicative hash, a bijection on the low bits
+  }
+
+  void grow();
+};
+
+
+struct Scope {
+  Scope(const ScopeId iParent, const uint32_t iDepth, std::string iName) :
+  parent(iParent), depth(iDepth), name(std::move(iName)) {}
+
+  ScopeId parent;
+  uint32_t depth;
+  std::string name; // only for diagnostics
+
+  FlatSymbolTable symbols;
+};
+
+
+#endif //SCOPE_H
@@ -6,28 +6,55 @@
 
 
 #include "../../lexical-analyzer/headers/tokens.h"
+#include "ast-node.h"
+#include "diagnostics.h"
+#include "function-analyzer.h"
 #include "tid.h"
+#include "types.h"
 
 
 class SemanticAnalyzer {
 public:
-  explicit SemanticAnalyzer() : currentScope("global") {}
+  SemanticAnalyzer() = default;
 
-  // Управление областями видимости
-  void enterScope(const std::string& scopeName);
-  void exitScope();
+  // Declares and resolves every identifier of the program and type checks it; the type of
+  // each expression is cached in its node (ASTNode::getTypeId()), the TID record of each
+  // name in ASTNode::getBinding(). Runs in two phases:
+  //   1. serially: every function signature, then the top-level instructions, are declared
+  //      in the global scope (functions can be called before their definition);
+  //   2. in parallel: one FunctionAnalyzer per function body, each on its own TID over the
+  //      now read-only global one, with its own diagnostics buffer.
+  // The per-function tables and buffers are then merged in source order, so the result
+  // (record numbering, warnings, the first error thrown) does not depend on the threads.
+  void analyze(const ASTNodePtr& program);
 
-  // Работа с идентификаторами
-  void declareIdentifier(const std::string& name, IdentifierType type);
-  void useIdentifier(const std::string& name);
-  void initializeIdentifier(const std::string& name);
+  SymbolId intern(const std::string& name) { return tid.intern(name); }
 
-  // Проверки
-  void checkType(const std::string& expectedType, const std::string& actualType);
+  // Threads for phase 2, 0 (default) - one per hardware thread
+  void setThreads(const size_t threads) { threads_ = threads; }
+  [[nodiscard]] size_t getThreads() const { return threads_; }
+
+  // Отладочный вывод объявлений
+  void setVerbose(const bool verbose) { verbose_ = verbose; }
+  [[nodiscard]] bool isVerbose() const { return verbose_; }
+
+  [[nodiscard]] const TID& getTID() const { return tid; }
+  [[nodiscard]] TypeTable& getTypes() { return types; }
+  [[nodiscard]] const TypeTable& getTypes() const { return types; }
+
+  [[nodiscard]] const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics_; }
 
 private:
   TID tid; // Используемый TID
-  std::string currentScope; // Текущая область видимост
+  TypeTable types; // Все типы программы (интернированные)
+  bool verbose_ = true;
+  size_t threads_ = 0;
+  std::vector<Diagnostic> diagnostics_;
+
+  void declareSignature(const ASTNodePtr& function);
+
+  // Rewrites the bindings of a function's nodes after its table was absorbed
+  static void relocateBindings(const ASTNodePtr& node, const TID::Relocation& relocation);
 };
 
 
@@ -6,58 +6,170 @@
 
 #include "../../includes/libraries.h"
 #include "../../global_functions/global_funcs.h"
+#include "interner.h"
+#include "scope.h"
+#include "types.h"
 
 
-enum class IdentifierType {
-  FUNCTION, INT, FLOAT, CHAR, BOOL, VOID, STRING, ARRAY, UNKNOWN
+// One entry of the identifier pool. Everything is an integer id, the name lives in the
+// interner and the rarely used free-form info in a side table, so a record is 16 bytes.
+struct IdentifierRecord {
+  static constexpr uint8_t INITIALIZED = 1 << 0;
+  static constexpr uint8_t USED = 1 << 1;
+
+  static constexpr uint32_t MAX_SCOPE = (1u << 24) - 1;
+  static constexpr uint32_t NO_EXTRA = UINT32_MAX;
+
+  SymbolId symbol;
+  uint32_t scope : 24;
+  uint32_t flags : 8;
+  TypeId type;
+  uint32_t extra; // index into TID's additional-info side table or NO_EXTRA
 };
 
-struct IdentifierInfo {
-  explicit IdentifierInfo(std::string iName, std::string iScope,
-    const IdentifierType& iType,
-    const bool iIsInitialized, const bool iIsUsed,
-    std::string  iAdditionalInfo) : name(std::move(iName)), scope(std::move(iScope)),
-  type(iType), isInitialized(iIsInitialized), isUsed(iIsUsed),
-  additionalInfo(std::move(iAdditionalInfo)) {}
+static_assert(sizeof(IdentifierRecord) == 16, "IdentifierRecord must stay packed");
 
 
-  std::string name;
-  std::string scope;
+class TID;
+
+// Lightweight reference to a pooled identifier (a table pointer and an index), cheap
+// to copy; it stays valid as long as the TID is alive
+class IdentifierHandle {
+public:
+  IdentifierHandle(const TID* tid, const uint32_t index) : tid_(tid), index_(index) {}
 
-  IdentifierType type;
+  [[nodiscard]] uint32_t getIndex() const { return index_; }
 
-  bool isInitialized;
-  bool isUsed;
+  [[nodiscard]] SymbolId getSymbol() const;
+  [[nodiscard]] const std::string& getName() const;
+  [[nodiscard]] ScopeId getScope() const;
+  [[nodiscard]] TypeId getType() const;
+  [[nodiscard]] bool isInitialized() const;
+  [[nodiscard]] bool isUsed() const;
+  [[nodiscard]] const std::string& getAdditionalInfo() const;
 
-  std::string additionalInfo;
+private:
+  const TID* tid_;
+  uint32_t index_;
 };
 
 
+// Table of identifiers organised as a tree of scopes. Every scope gets a dense integer
+// id and a link to its parent; the global scope (id 0) always exists.
+//
+// A table can also be opened on top of an enclosing one (one per function analysed in
+// parallel): it continues the enclosing table's record and scope numbering, resolves
+// what it does not declare itself in the enclosing table and never writes to it, so any
+// number of such tables can share one enclosing table across threads. absorb() appends
+// one back into the enclosing table.
 class TID {
 public:
+  TID() {
+    scopes_.emplace_back(NO_SCOPE, 0, "global");
+  }
+
+  explicit TID(const TID* enclosing) :
+  enclosing_(enclosing), recordBase_(static_cast<uint32_t>(enclosing->identifierCount())),
+  scopeBase_(static_cast<uint32_t>(enclosing->scopeCount())) {}
+
+  TID(const TID&) = default;
+  TID(TID&&) = default;
+  TID& operator=(const TID&) = default;
+  TID& operator=(TID&&) = default;
+
+  // Approximate heap footprint of the table, split by component (see memoryUsage())
+  struct MemoryUsage {
+    size_t records = 0;
+    size_t scopes = 0;
+    size_t interner = 0;
+    size_t sideTable = 0;
+
+    [[nodiscard]] size_t total() const { return records + scopes + interner + sideTable; }
+  };
+
+  // How absorb() renumbered the absorbed table's records and scopes
+  struct Relocation {
+    uint32_t recordBase = 0;
+    uint32_t recordShift = 0;
+    uint32_t scopeBase = 0;
+    uint32_t scopeShift = 0;
+
+    [[nodiscard]] uint32_t record(const uint32_t index) const {
+      return index >= recordBase ? index + recordShift : index;
+    }
+    [[nodiscard]] ScopeId scope(const ScopeId scope) const {
+      return scope >= scopeBase && scope != NO_SCOPE ? scope + scopeShift : scope;
+    }
+  };
+
+  // Interns an identifier's spelling (see SymbolInterner); a table with an enclosing
+  // table uses the enclosing interner and cannot intern
+  SymbolId intern(const std::string& name);
+  [[nodiscard]] const SymbolInterner& getInterner() const {
+    return enclosing_ ? enclosing_->getInterner() : interner_;
+  }
+
+  // Opens a new scope nested in `parent` and returns its id
+  ScopeId createScope(ScopeId parent, const std::string& name);
+  [[nodiscard]] const Scope& getScope(ScopeId scope) const {
+    return scope < scopeBase_ ? enclosing_->getScope(scope) : scopes_.at(scope - scopeBase_);
+  }
+  [[nodiscard]] size_t scopeCount() const { return scopeBase_ + scopes_.size(); }
+
   // Adds a new identifier to the table
-  void addIdentifier(const std::string& name, IdentifierType type, const std::string& scope);
+  IdentifierHandle addIdentifier(SymbolId symbol, TypeId type, ScopeId scope);
+
+  // Retrieves an identifier visible from `scope` (walks outward)
+  [[nodiscard]] IdentifierHandle getIdentifier(SymbolId symbol, ScopeId scope) const;
 
-  // Retrieves information about an identifier
-  [[nodiscard]] IdentifierInfo getIdentifier(const std::string& name, const std::string& scope) const;
+  // Same as getIdentifier(), but without throwing if the identifier is not visible
+  [[nodiscard]] std::optional<IdentifierHandle> lookup(SymbolId symbol, ScopeId scope) const;
 
   // Updates an identifier's usage status
-  void markAsUsed(const std::string& name, const std::string& scope);
+  void markAsUsed(SymbolId symbol, ScopeId scope);
+  void markAsUsed(IdentifierHandle identifier);
 
   // Updates an identifier's initialization status
-  void markAsInitialized(const std::string& name, const std::string& scope);
+  void markAsInitialized(SymbolId symbol, ScopeId scope);
+  void markAsInitialized(IdentifierHandle identifier);
 
-  // Checks if an identifier exists in the table
-  [[nodiscard]] bool identifierExists(const std::string& name, const std::string& scope) const;
+  // Attaches free-form info to an identifier (stored out of line)
+  void setAdditionalInfo(IdentifierHandle identifier, std::string info);
+
+  // Checks if an identifier is declared directly in `scope` (enclosing scopes are not searched)
+  [[nodiscard]] bool identifierExists(SymbolId symbol, ScopeId scope) const;
+
+  [[nodiscard]] size_t identifierCount() const { return recordBase_ + records_.size(); }
+  [[nodiscard]] const IdentifierRecord& getRecord(const uint32_t index) const {
+    return index < recordBase_ ? enclosing_->getRecord(index) : records_[index - recordBase_];
+  }
+  [[nodiscard]] const std::string& getAdditionalInfo(uint32_t index) const;
+
+  // Appends the records and scopes of a table opened on top of this one (which must not
+  // have changed since), including the flags it set on this table's records
+  Relocation absorb(const TID& nested);
+
+  [[nodiscard]] MemoryUsage memoryUsage() const;
 
   // Prints the entire table (for debugging purposes)
   void printTable() const;
 
 private:
-  std::unordered_map<std::string, std::vector<IdentifierInfo>> table_;
+  SymbolInterner interner_;
+  std::vector<Scope> scopes_;
+  std::vector<IdentifierRecord> records_;
+  std::vector<std::string> additionalInfo_;
+
+  // nested tables only: the read-only enclosing table and where numbering continues
+  const TID* enclosing_ = nullptr;
+  uint32_t recordBase_ = 0;
+  uint32_t scopeBase_ = 0;
+  std::vector<std::pair<uint32_t, uint8_t>> enclosingFlags_; // flags to set on enclosing records
+
+  // Resolves a symbol from `scope` outwards: one integer probe per enclosing scope
+  [[nodiscard]] uint32_t resolve(SymbolId symbol, ScopeId scope) const;
 
-  // Helper to find an identifier within a scope
-  IdentifierInfo* findIdentifier(const std::string& name, const std::string& scope);
+  void setFlags(uint32_t index, uint8_t flags);
 };
 
 
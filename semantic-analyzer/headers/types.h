@@ -0,0 +1,75 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+
+#include "../../includes/libraries.h"
+
+
+using TypeId = uint32_t;
+
+enum class TypeKind : uint8_t {
+  ERROR, VOID, INT, FLOAT, CHAR, BOOL, STRING, ARRAY, FUNCTION
+};
+
+struct TypeInfo {
+  TypeKind kind;
+  TypeId element = 0; // ARRAY: element type, FUNCTION: result type
+  std::vector<TypeId> parameters; // FUNCTION only
+};
+
+
+// Type interner: every structurally distinct type (nested arrays and function signatures
+// included) is created exactly once and named by a dense id, so two types are equal iff
+// their ids are equal
+class TypeTable {
+public:
+  // primitive types are pre-interned with fixed ids
+  static constexpr TypeId ERROR = 0;
+  static constexpr TypeId VOID = 1;
+  static constexpr TypeId INT = 2;
+  static constexpr TypeId FLOAT = 3;
+  static constexpr TypeId CHAR = 4;
+  static constexpr TypeId BOOL = 5;
+  static constexpr TypeId STRING = 6;
+
+  static constexpr TypeId NO_TYPE = UINT32_MAX; // "not computed yet" marker for caches
+
+  TypeTable();
+
+  TypeId arrayOf(TypeId element);
+  TypeId function(TypeId result, const std::vector<TypeId>& parameters);
+
+  [[nodiscard]] const TypeInfo& get(TypeId type) const { return types_.at(type); }
+  [[nodiscard]] TypeKind kind(const TypeId type) const { return types_.at(type).kind; }
+  [[nodiscard]] size_t size() const { return types_.size(); }
+
+  [[nodiscard]] bool isArray(const TypeId type) const { return kind(type) == TypeKind::ARRAY; }
+  [[nodiscard]] bool isFunction(const TypeId type) const { return kind(type) == TypeKind::FUNCTION; }
+
+  // int, float and char take part in arithmetic
+  [[nodiscard]] static bool isNumeric(const TypeId type) {
+    return type == INT || type == FLOAT || type == CHAR;
+  }
+
+  // numeric types and bool convert into each other implicitly (and can be conditions)
+  [[nodiscard]] static bool isScalar(const TypeId type) {
+    return isNumeric(type) || type == BOOL;
+  }
+
+  // Number of nested array levels (array< array< int > > -> 2)
+  [[nodiscard]] size_t rank(TypeId type) const;
+
+  // Innermost non-array type (array< array< int > > -> int)
+  [[nodiscard]] TypeId scalar(TypeId type) const;
+
+  [[nodiscard]] std::string toString(TypeId type) const;
+
+private:
+  std::vector<TypeInfo> types_;
+  std::map<std::vector<uint32_t>, TypeId> ids_; // structural key -> id
+
+  TypeId intern(TypeInfo info);
+};
+
+
+#endif //TYPES_H
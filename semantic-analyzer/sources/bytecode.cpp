@@ -0,0 +1,173 @@
+#include "../headers/bytecode.h"
+
+#include <iomanip>
+#include <sstream>
+
+
+const char* valueKindName(const ValueKind kind) {
+  switch (kind) {
+    case ValueKind::VOID:
+      return "void";
+    case ValueKind::INT:
+      return "int";
+    case ValueKind::FLOAT:
+      return "float";
+    case ValueKind::CHAR:
+      return "char";
+    case ValueKind::BOOL:
+      return "bool";
+    case ValueKind::STRING:
+      return "string";
+    default:
+      return "array";
+  }
+}
+
+uint32_t BytecodeProgram::lineAt(const uint32_t offset) const {
+  // last entry at or before the offset
+  const auto next = std::upper_bound(lines.begin(), lines.end(), offset,
+    [](const uint32_t value, const std::pair<uint32_t, uint32_t>& entry) { return value < entry.first; });
+  return next == lines.begin() ? 0 : std::prev(next)->second;
+}
+
+uint32_t switchHash(const uint32_t seed, const std::string_view text) {
+  // FNV-1a from a seeded basis, then a 64-bit finalizer so that the low bits mix
+  uint64_t hash = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+  for (const char c : text) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return static_cast<uint32_t>(hash);
+}
+
+size_t SwitchTable::find(const std::string_view text, const std::vector<std::string>& strings) const {
+  const uint32_t seed = seeds[switchHash(0, text) % seeds.size()];
+  const size_t slot = switchHash(seed, text) & (targets.size() - 1);
+  return labels[slot] != EMPTY && strings[labels[slot]] == text ? slot : targets.size();
+}
+
+size_t RPNProgram::instructionCount() const {
+  size_t count = 0;
+  for (size_t pc = 0; pc < code.size(); pc += instructionSize(static_cast<OpCode>(code[pc]))) {
+    ++count;
+  }
+  return count;
+}
+
+
+// Comment after an instruction's operands: what a slot, pool index or callee stands for
+static std::string describeOperand(const RPNProgram& program, const RPNFunction& function,
+  const OpCode op, const uint32_t operand) {
+  std::ostringstream out;
+  switch (op) {
+    case OpCode::PUSH_LONG:
+      out << program.integers.at(operand);
+      break;
+    case OpCode::PUSH_FLOAT:
+      out << program.floats.at(operand);
+      break;
+    case OpCode::PUSH_CHAR:
+      out << '\'' << static_cast<char>(operand) << '\'';
+      break;
+    case OpCode::PUSH_STRING:
+    case OpCode::TRAP:
+      out << '"' << program.strings.at(operand) << '"';
+      break;
+    case OpCode::LOAD_LOCAL:
+    case OpCode::STORE_LOCAL:
+    case OpCode::LOAD_LOCAL_PAIR:
+    case OpCode::LOAD_LOCAL_ADD_CONST:
+    case OpCode::INC_LOCAL:
+      if (operand < function.slotNames.size()) {
+        out << function.slotNames[operand];
+      }
+      break;
+    case OpCode::LOAD_GLOBAL:
+    case OpCode::STORE_GLOBAL:
+      if (operand < program.globalNames.size()) {
+        out << program.globalNames[operand];
+      }
+      break;
+    case OpCode::CALL:
+      out << program.functions.at(operand).name;
+      break;
+    case OpCode::READ:
+      out << valueKindName(static_cast<ValueKind>(operand));
+      break;
+    case OpCode::SWITCH_TABLE: {
+      const SwitchTable& table = program.switches.at(operand);
+      out << table.targets.size() << " entries from " << table.low << ", default " << table.fallback;
+      break;
+    }
+    case OpCode::SWITCH_STRING: {
+      const SwitchTable& table = program.switches.at(operand);
+      const auto labels = std::count_if(table.labels.begin(), table.labels.end(),
+        [](const uint32_t label) { return label != SwitchTable::EMPTY; });
+      out << labels << " labels in " << table.targets.size() << " slots, " << table.seeds.size()
+          << " seeds, default " << table.fallback;
+      break;
+    }
+    default:
+      break;
+  }
+  return out.str();
+}
+
+static void disassembleFunction(std::ostringstream& out, const RPNProgram& program, const size_t index) {
+  const RPNFunction& function = program.functions[index];
+  out << "function #" << index << " " << function.name << ": parameters " << function.parameters << ", slots "
+      << function.slots << ", max stack " << function.maxStack << (function.returnsValue ? ", returns a value" : "")
+      << (function.localStrings ? ", local strings" : "") << "\n";
+
+  uint32_t line = 0;
+  for (uint32_t pc = function.entry; pc < function.end;) {
+    const auto op = static_cast<OpCode>(program.code[pc]);
+    if (const uint32_t current = program.lineAt(pc); current != line) {
+      line = current;
+      out << "  ; line " << line << "\n";
+    }
+
+    std::ostringstream text;
+    text << OPCODE_NAMES[static_cast<uint8_t>(op)];
+    std::string comment;
+    for (uint8_t i = 0; i < OPCODE_OPERANDS[static_cast<uint8_t>(op)]; ++i) {
+      const uint32_t operand = readOperand(&program.code[pc + 1 + 4 * i]);
+      if (op == OpCode::PUSH_INT || (i == 1 && (op == OpCode::LOAD_LOCAL_ADD_CONST || op == OpCode::INC_LOCAL))) {
+        text << " " << static_cast<int32_t>(operand);
+      } else if (op == OpCode::NEW_ARRAY && i == 1) {
+        text << " " << valueKindName(arrayLeaf(operand)) << (isLocalArray(operand) ? " local" : "");
+      } else {
+        text << " " << operand;
+      }
+      if (i == 0 || op == OpCode::LOAD_LOCAL_PAIR) {
+        const std::string description = describeOperand(program, function, op, operand);
+        comment += (i == 0 ? "" : ", ") + description;
+      }
+    }
+
+    out << "  " << std::setw(6) << std::setfill('0') << pc << std::setfill(' ') << "  " << std::left
+        << std::setw(24) << text.str() << std::right;
+    if (!comment.empty()) {
+      out << " ; " << comment;
+    }
+    out << "\n";
+    pc += static_cast<uint32_t>(instructionSize(op));
+  }
+}
+
+std::string disassemble(const RPNProgram& program) {
+  std::ostringstream out;
+  out << "globals: " << program.globals;
+  for (size_t i = 0; i < program.globalNames.size(); ++i) {
+    out << (i == 0 ? " (" : ", ") << program.globalNames[i] << (i + 1 == program.globalNames.size() ? ")" : "");
+  }
+  out << "\ncode: " << program.code.size() << " bytes, " << program.instructionCount() << " instructions\n";
+
+  for (size_t i = 0; i < program.functions.size(); ++i) {
+    out << "\n";
+    disassembleFunction(out, program, i);
+  }
+  return out.str();
+}
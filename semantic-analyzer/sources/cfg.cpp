@@ -0,0 +1,293 @@
+#include "../headers/cfg.h"
+
+
+// Walks a function body once, appending events to the current block. A block is entered
+// exactly once and left for good, so its events are always contiguous.
+class CFGBuilder {
+public:
+  CFGBuilder(ControlFlowGraph& graph, const TypeTable& types) : graph_(graph), types_(types) {}
+
+  void build(const ASTNodePtr& function) {
+    newBlock(); // ENTRY
+    newBlock(); // EXIT
+    enter(ControlFlowGraph::ENTRY);
+
+    const auto& children = function->getChildren();
+    for (size_t i = 0; i + 1 < children.size(); ++i) { // parameters hold the arguments
+      event(CFGEvent::Kind::DEF, declare(children[i].get(), true), children[i].get());
+    }
+    statement(children.back());
+    edge(current_, ControlFlowGraph::EXIT); // falling off the end
+
+    enter(ControlFlowGraph::EXIT);
+    leave();
+  }
+
+private:
+  ControlFlowGraph& graph_;
+  const TypeTable& types_;
+  uint32_t current_ = 0;
+  uint32_t slotsInScope_ = 0; // next free slot
+  std::unordered_map<uint32_t, uint32_t> localByBinding_;
+
+  std::vector<uint32_t> breakTargets_;
+  std::vector<uint32_t> continueTargets_;
+
+  uint32_t newBlock() {
+    graph_.blocks_.emplace_back();
+    return static_cast<uint32_t>(graph_.blocks_.size() - 1);
+  }
+
+  void leave() {
+    graph_.blocks_[current_].lastEvent = static_cast<uint32_t>(graph_.events_.size());
+  }
+
+  void enter(const uint32_t block) {
+    leave();
+    current_ = block;
+    graph_.blocks_[block].firstEvent = static_cast<uint32_t>(graph_.events_.size());
+  }
+
+  void edge(const uint32_t from, const uint32_t to) {
+    graph_.blocks_[from].successors.push_back(to);
+    graph_.blocks_[to].predecessors.push_back(from);
+  }
+
+  // control leaves the current block for `target`; whatever follows is unreachable
+  void jump(const uint32_t target) {
+    edge(current_, target);
+    enter(newBlock());
+  }
+
+  uint32_t declare(const ASTNode* declaration, const bool parameter) {
+    const auto local = static_cast<uint32_t>(graph_.locals_.size());
+    graph_.locals_.push_back({declaration->getBinding(), declaration, parameter, slotsInScope_++});
+    graph_.slotCount_ = std::max(graph_.slotCount_, slotsInScope_);
+    localByBinding_[declaration->getBinding()] = local; // shadowed names have their own records
+    return local;
+  }
+
+  void event(const CFGEvent::Kind kind, const uint32_t local, const ASTNode* node) {
+    graph_.events_.push_back({kind, local, graph_.locals_[local].slot, node});
+  }
+
+  // `true`, `false` and integer literals decide the branch at compile time
+  static std::optional<bool> constantCondition(const ASTNodePtr& condition) {
+    if (condition->getType() != ASTNodeType::LITERAL) {
+      return std::nullopt;
+    }
+    if (condition->getTokenType() == my::TokenType::KEYWORD) {
+      return condition->getValue() == "true";
+    }
+    if (condition->getTokenType() == my::TokenType::INTEGER_LITERAL) {
+      return decodeIntegerLiteral(condition->getValue()) != 0;
+    }
+    return std::nullopt;
+  }
+
+  // edges of a two-way branch from the current block, pruned for constant conditions
+  void branch(const ASTNodePtr& condition, const uint32_t onTrue, const uint32_t onFalse) {
+    const std::optional<bool> constant = constantCondition(condition);
+    if (!constant || *constant) {
+      edge(current_, onTrue);
+    }
+    if (!constant || !*constant) {
+      edge(current_, onFalse);
+    }
+  }
+
+  // Expressions cannot store into variables, so the order of the reads inside one
+  // (and short-circuiting) does not matter
+  void expression(const ASTNodePtr& node) {
+    if (!node) {
+      return;
+    }
+    if (node->getType() == ASTNodeType::IDENTIFIER) {
+      if (const auto local = localByBinding_.find(node->getBinding()); local != localByBinding_.end()) {
+        event(CFGEvent::Kind::USE, local->second, node.get());
+      }
+      return;
+    }
+    for (const auto& child : node->getChildren()) {
+      expression(child);
+    }
+  }
+
+  void store(const ASTNodePtr& target) {
+    if (const auto local = localByBinding_.find(target->getBinding()); local != localByBinding_.end()) {
+      event(CFGEvent::Kind::DEF, local->second, target.get());
+    }
+  }
+
+  void statement(const ASTNodePtr& node) {
+    switch (node->getType()) {
+      case ASTNodeType::BLOCK: {
+        const uint32_t slots = slotsInScope_; // the block's locals go out of scope at its end
+        for (const auto& instruction : node->getChildren()) {
+          statement(instruction);
+        }
+        slotsInScope_ = slots;
+        break;
+      }
+      case ASTNodeType::VARIABLE_DECLARATION: {
+        const auto& children = node->getChildren();
+        for (size_t i = 1; i < children.size(); ++i) {
+          expression(children[i]);
+        }
+        expression(children[0]);
+        const uint32_t local = declare(node.get(), false);
+        const bool initialized = children[0] || types_.isArray(node->getTypeId());
+        event(initialized ? CFGEvent::Kind::DEF : CFGEvent::Kind::KILL, local, node.get());
+        break;
+      }
+      case ASTNodeType::ASSIGNMENT: {
+        expression(node->getChild(1));
+        const ASTNodePtr& target = node->getChild(0);
+        if (target->getType() == ASTNodeType::IDENTIFIER) {
+          store(target);
+        } else {
+          expression(target); // an element store reads the array (and the indices)
+        }
+        break;
+      }
+      case ASTNodeType::INPUT:
+        for (const auto& target : node->getChildren()) {
+          store(target);
+        }
+        break;
+      case ASTNodeType::OUTPUT:
+        for (const auto& value : node->getChildren()) {
+          expression(value);
+        }
+        break;
+      case ASTNodeType::IF_STATEMENT: {
+        const auto& children = node->getChildren();
+        expression(children[0]);
+        const uint32_t thenBlock = newBlock();
+        const uint32_t elseBlock = children.size() > 2 ? newBlock() : 0;
+        const uint32_t join = newBlock();
+        branch(children[0], thenBlock, children.size() > 2 ? elseBlock : join);
+
+        enter(thenBlock);
+        statement(children[1]);
+        edge(current_, join);
+        if (children.size() > 2) {
+          enter(elseBlock);
+          statement(children[2]);
+          edge(current_, join);
+        }
+        enter(join);
+        break;
+      }
+      case ASTNodeType::LOOP_STATEMENT:
+        loop(node);
+        break;
+      case ASTNodeType::SWITCH: {
+        const auto& children = node->getChildren();
+        expression(children[0]);
+        const uint32_t dispatch = current_;
+        const uint32_t exit = newBlock();
+        const uint32_t slots = slotsInScope_; // the cases share one scope
+
+        breakTargets_.push_back(exit);
+        for (size_t i = 1; i < children.size(); ++i) {
+          const uint32_t arm = newBlock();
+          edge(dispatch, arm);
+          enter(arm);
+          const auto& instructions = children[i]->getChildren();
+          const size_t first = children[i]->getTokenType() == my::TokenType::CASE ? 1 : 0; // skip the label
+          for (size_t j = first; j < instructions.size(); ++j) {
+            statement(instructions[j]);
+          }
+          edge(current_, exit);
+        }
+        breakTargets_.pop_back();
+        slotsInScope_ = slots;
+        enter(exit);
+        break;
+      }
+      case ASTNodeType::RETURN_STATEMENT:
+        if (!node->getChildren().empty()) {
+          expression(node->getChild(0));
+        }
+        jump(ControlFlowGraph::EXIT);
+        break;
+      case ASTNodeType::BREAK:
+        jump(breakTargets_.back());
+        break;
+      case ASTNodeType::CONTINUE:
+        jump(continueTargets_.back());
+        break;
+      default: // expression used as an instruction
+        expression(node);
+        break;
+    }
+  }
+
+  void loop(const ASTNodePtr& node) {
+    const auto& children = node->getChildren();
+    const bool isFor = node->getTokenType() == my::TokenType::FOR;
+    const uint32_t slots = slotsInScope_; // the counter lives only inside the loop
+    if (isFor) {
+      statement(children[0]); // the counter's declaration runs once
+    }
+    const ASTNodePtr& condition = children[isFor ? 1 : 0];
+
+    const uint32_t header = newBlock();
+    const uint32_t body = newBlock();
+    const uint32_t step = isFor ? newBlock() : header; // 'continue' target
+    const uint32_t exit = newBlock();
+
+    edge(current_, header);
+    enter(header);
+    expression(condition);
+    branch(condition, body, exit);
+
+    breakTargets_.push_back(exit);
+    continueTargets_.push_back(step);
+    enter(body);
+    statement(children.back());
+    edge(current_, step);
+    continueTargets_.pop_back();
+    breakTargets_.pop_back();
+
+    if (isFor) {
+      enter(step);
+      statement(children[2]);
+      edge(current_, header);
+    }
+    slotsInScope_ = slots;
+    enter(exit);
+  }
+};
+
+
+ControlFlowGraph ControlFlowGraph::build(const ASTNodePtr& function, const TypeTable& types) {
+  ControlFlowGraph graph;
+  CFGBuilder(graph, types).build(function);
+  return graph;
+}
+
+std::vector<uint32_t> ControlFlowGraph::reversePostorder() const {
+  std::vector<uint32_t> order;
+  std::vector<uint8_t> visited(blocks_.size(), 0);
+  std::vector<std::pair<uint32_t, size_t>> stack; // block, next successor (no recursion on deep nests)
+
+  visited[ENTRY] = 1;
+  stack.emplace_back(ENTRY, 0);
+  while (!stack.empty()) {
+    auto& [block, next] = stack.back();
+    if (next < blocks_[block].successors.size()) {
+      const uint32_t successor = blocks_[block].successors[next++];
+      if (!visited[successor]) {
+        visited[successor] = 1;
+        stack.emplace_back(successor, 0);
+      }
+    } else {
+      order.push_back(block);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
@@ -0,0 +1,207 @@
+#include "../headers/dataflow.h"
+
+
+DataflowAnalyzer::DataflowAnalyzer(const ControlFlowGraph& graph) :
+graph_(graph), order_(graph.reversePostorder()), reachable_(graph.getBlocks().size(), 0) {
+  for (const uint32_t block : order_) {
+    reachable_[block] = 1;
+  }
+}
+
+void DataflowAnalyzer::solve() {
+  summarizeBlocks();
+  solveAssignment(definiteIn_, definiteOut_, true);
+  solveAssignment(possibleIn_, possibleOut_, false);
+  solveLiveness();
+}
+
+void DataflowAnalyzer::summarizeBlocks() {
+  const size_t blocks = graph_.getBlocks().size();
+  const size_t slots = graph_.slotCount();
+  const auto& events = graph_.getEvents();
+
+  assignGen_.assign(blocks, BitVector(slots));
+  assignKill_.assign(blocks, BitVector(slots));
+  liveUse_.assign(blocks, BitVector(slots));
+  liveDef_.assign(blocks, BitVector(slots));
+
+  for (const uint32_t b : order_) {
+    const BasicBlock& block = graph_.getBlocks()[b];
+    for (uint32_t i = block.firstEvent; i < block.lastEvent; ++i) {
+      const CFGEvent& event = events[i];
+      switch (event.kind) {
+        case CFGEvent::Kind::USE:
+          if (!liveDef_[b].test(event.slot)) {
+            liveUse_[b].set(event.slot);
+          }
+          break;
+        case CFGEvent::Kind::DEF:
+          assignGen_[b].set(event.slot);
+          assignKill_[b].reset(event.slot);
+          liveDef_[b].set(event.slot);
+          break;
+        case CFGEvent::Kind::KILL:
+          assignKill_[b].set(event.slot);
+          assignGen_[b].reset(event.slot);
+          liveDef_[b].set(event.slot);
+          break;
+      }
+    }
+  }
+}
+
+// out = gen | (in & ~kill), in = meet of the predecessors' out. For the must problem
+// every out starts at "all assigned" so that a not yet visited back edge does not
+// weaken the result; ENTRY starts with nothing assigned (parameters are DEFs in it).
+void DataflowAnalyzer::solveAssignment(std::vector<BitVector>& in, std::vector<BitVector>& out, const bool must) {
+  const size_t blocks = graph_.getBlocks().size();
+  const size_t slots = graph_.slotCount();
+  in.assign(blocks, BitVector(slots, must));
+  out.assign(blocks, BitVector(slots, must));
+
+  std::deque<uint32_t> worklist(order_.begin(), order_.end());
+  std::vector<uint8_t> queued(blocks, 0);
+  for (const uint32_t block : order_) {
+    queued[block] = 1;
+  }
+
+  BitVector meet(slots);
+  while (!worklist.empty()) {
+    const uint32_t b = worklist.front();
+    worklist.pop_front();
+    queued[b] = 0;
+
+    meet.fill(must && b != ControlFlowGraph::ENTRY);
+    for (const uint32_t predecessor : graph_.getBlocks()[b].predecessors) {
+      if (!reachable_[predecessor]) {
+        continue;
+      }
+      if (must) {
+        meet &= out[predecessor];
+      } else {
+        meet |= out[predecessor];
+      }
+    }
+    in[b] = meet;
+
+    if (out[b].assignTransfer(assignGen_[b], meet, assignKill_[b])) {
+      for (const uint32_t successor : graph_.getBlocks()[b].successors) {
+        if (!queued[successor]) {
+          queued[successor] = 1;
+          worklist.push_back(successor);
+        }
+      }
+    }
+  }
+}
+
+// in = use | (out & ~def), out = union of the successors' in
+void DataflowAnalyzer::solveLiveness() {
+  const size_t blocks = graph_.getBlocks().size();
+  const size_t slots = graph_.slotCount();
+  liveIn_.assign(blocks, BitVector(slots));
+  liveOut_.assign(blocks, BitVector(slots));
+
+  std::deque<uint32_t> worklist(order_.rbegin(), order_.rend());
+  std::vector<uint8_t> queued(blocks, 0);
+  for (const uint32_t block : order_) {
+    queued[block] = 1;
+  }
+
+  while (!worklist.empty()) {
+    const uint32_t b = worklist.front();
+    worklist.pop_front();
+    queued[b] = 0;
+
+    BitVector& out = liveOut_[b];
+    out.fill(false);
+    for (const uint32_t successor : graph_.getBlocks()[b].successors) {
+      out |= liveIn_[successor];
+    }
+
+    if (liveIn_[b].assignTransfer(liveUse_[b], out, liveDef_[b])) {
+      for (const uint32_t predecessor : graph_.getBlocks()[b].predecessors) {
+        if (reachable_[predecessor] && !queued[predecessor]) {
+          queued[predecessor] = 1;
+          worklist.push_back(predecessor);
+        }
+      }
+    }
+  }
+}
+
+std::vector<Diagnostic> DataflowAnalyzer::diagnose(const TID& tid) const {
+  const auto& locals = graph_.getLocals();
+  const auto& events = graph_.getEvents();
+  const auto nameOf = [&](const uint32_t local) -> const std::string& {
+    return tid.getInterner().getName(tid.getRecord(locals[local].binding).symbol);
+  };
+
+  std::vector<Diagnostic> diagnostics;
+  const auto warn = [&](const ASTNode* node, std::string message) {
+    diagnostics.push_back({Diagnostic::Severity::WARNING, node->getLine(), std::move(message)});
+  };
+
+  BitVector used(locals.size()); // read anywhere, even in unreachable code
+  for (const CFGEvent& event : events) {
+    if (event.kind == CFGEvent::Kind::USE) {
+      used.set(event.local);
+    }
+  }
+  for (uint32_t local = 0; local < locals.size(); ++local) {
+    if (!used.test(local)) {
+      warn(locals[local].declaration, (locals[local].parameter ? "parameter '" : "variable '") +
+        nameOf(local) + "' is never used");
+    }
+  }
+
+  BitVector reported(locals.size()); // one uninitialized-read warning per variable
+  for (const uint32_t b : order_) {
+    const BasicBlock& block = graph_.getBlocks()[b];
+
+    BitVector definite = definiteIn_[b];
+    BitVector possible = possibleIn_[b];
+    for (uint32_t i = block.firstEvent; i < block.lastEvent; ++i) {
+      const CFGEvent& event = events[i];
+      if (event.kind == CFGEvent::Kind::USE) {
+        if (!definite.test(event.slot) && !reported.test(event.local)) {
+          reported.set(event.local);
+          warn(event.node, "variable '" + nameOf(event.local) + (possible.test(event.slot) ?
+            "' may be used uninitialized" : "' is used uninitialized"));
+        }
+      } else if (event.kind == CFGEvent::Kind::DEF) {
+        definite.set(event.slot);
+        possible.set(event.slot);
+      } else {
+        definite.reset(event.slot);
+        possible.reset(event.slot);
+      }
+    }
+
+    // dead stores; unused variables are already reported, parameters and literal
+    // initializers ('int x = 0;') are deliberate
+    BitVector live = liveOut_[b];
+    for (uint32_t i = block.lastEvent; i-- > block.firstEvent;) {
+      const CFGEvent& event = events[i];
+      if (event.kind == CFGEvent::Kind::USE) {
+        live.set(event.slot);
+        continue;
+      }
+      if (event.kind == CFGEvent::Kind::DEF && !live.test(event.slot) && used.test(event.local) &&
+        !locals[event.local].parameter && !isLiteralInitializer(event.node)) {
+        warn(event.node, "value assigned to '" + nameOf(event.local) + "' is never read");
+      }
+      live.reset(event.slot);
+    }
+  }
+
+  std::stable_sort(diagnostics.begin(), diagnostics.end(), [](const Diagnostic& a, const Diagnostic& b) {
+    return a.line < b.line;
+  });
+  return diagnostics;
+}
+
+bool DataflowAnalyzer::isLiteralInitializer(const ASTNode* node) {
+  return node->getType() == ASTNodeType::VARIABLE_DECLARATION && node->getChild(0) &&
+    node->getChild(0)->getType() == ASTNodeType::LITERAL;
+}
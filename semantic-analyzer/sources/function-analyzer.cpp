@@ -0,0 +1,444 @@
+#include "../headers/function-analyzer.h"
+
+
+void FunctionAnalyzer::enterScope(const std::string& scopeName) {
+  currentScope = tid.createScope(currentScope, scopeName);
+}
+
+void FunctionAnalyzer::exitScope() {
+  if (currentScope == GLOBAL_SCOPE) {
+    throw std::runtime_error("Semantic error: exitScope() called in the global scope.");
+  }
+  currentScope = tid.getScope(currentScope).parent; // возвращаемся в объемлющую область
+}
+
+IdentifierHandle FunctionAnalyzer::declareIdentifier(const SymbolId symbol, const TypeId type) {
+  try {
+    const IdentifierHandle identifier = tid.addIdentifier(symbol, type, currentScope);
+    if (verbose_) {
+      trace_ += "Declared identifier \"" + identifier.getName() + "\" of type \"" + types.toString(type) +
+        "\" in scope: " + tid.getScope(currentScope).name + "\n";
+    }
+    return identifier;
+  } catch (const std::exception& e) {
+    throw std::runtime_error("Semantic error: " + std::string(e.what()));
+  }
+}
+
+IdentifierHandle FunctionAnalyzer::useIdentifier(const SymbolId symbol) {
+  const auto identifier = tid.lookup(symbol, currentScope);
+  if (!identifier) {
+    throw std::runtime_error("Semantic error: Variable '" + tid.getInterner().getName(symbol) +
+      "' used without declaration in scope '" + tid.getScope(currentScope).name + "'.");
+  }
+  tid.markAsUsed(*identifier);
+  return *identifier;
+}
+
+void FunctionAnalyzer::initializeIdentifier(const SymbolId symbol) {
+  const auto identifier = tid.lookup(symbol, currentScope);
+  if (!identifier) {
+    throw std::runtime_error("Semantic error: Variable '" + tid.getInterner().getName(symbol) +
+      "' initialized without declaration in scope '" + tid.getScope(currentScope).name + "'.");
+  }
+  tid.markAsInitialized(*identifier);
+}
+
+void FunctionAnalyzer::checkType(const TypeId expectedType, const TypeId actualType) const {
+  if (expectedType != actualType) { // types are interned: equal types have equal ids
+    throw std::runtime_error("Type mismatch: Expected '" + types.toString(expectedType) + "', but got '" +
+      types.toString(actualType) + "'.");
+  }
+}
+
+bool FunctionAnalyzer::isAssignable(const TypeId target, const TypeId source) {
+  return target == source || (TypeTable::isScalar(target) && TypeTable::isScalar(source));
+}
+
+void FunctionAnalyzer::analyzeFunction(const ASTNodePtr& function) {
+  insideFunction_ = true;
+  returnType_ = types.get(function->getTypeId()).element;
+
+  enterScope(function->getValue()); // parameters, the body block nests inside
+  const auto& children = function->getChildren();
+  for (size_t i = 0; i + 1 < children.size(); ++i) {
+    const IdentifierHandle parameter = declareIdentifier(children[i]->getSymbol(), children[i]->getTypeId());
+    tid.markAsInitialized(parameter);
+    children[i]->setBinding(parameter.getIndex());
+  }
+  analyzeBlock(children.back(), "block");
+  exitScope();
+
+  insideFunction_ = false;
+  analyzeDataflow(function);
+}
+
+void FunctionAnalyzer::analyzeDataflow(const ASTNodePtr& function) {
+  const ControlFlowGraph graph = ControlFlowGraph::build(function, types);
+  DataflowAnalyzer dataflow(graph);
+  dataflow.solve();
+
+  for (auto& diagnostic : dataflow.diagnose(tid)) {
+    diagnostic.message = "in function '" + function->getValue() + "': " + diagnostic.message;
+    diagnostics_.push_back(std::move(diagnostic));
+  }
+}
+
+void FunctionAnalyzer::analyzeBlock(const ASTNodePtr& block, const std::string& scopeName) {
+  enterScope(scopeName);
+  for (const auto& instruction : block->getChildren()) {
+    analyzeInstruction(instruction);
+  }
+  exitScope();
+}
+
+void FunctionAnalyzer::analyzeInstruction(const ASTNodePtr& instruction) {
+  switch (instruction->getType()) {
+    case ASTNodeType::FUNCTION:
+      throw std::runtime_error("Semantic error: nested function '" + instruction->getValue() + "' is not allowed.");
+    case ASTNodeType::BLOCK:
+      analyzeBlock(instruction, "block");
+      break;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      analyzeDeclaration(instruction);
+      break;
+    case ASTNodeType::ASSIGNMENT:
+      analyzeAssignment(instruction);
+      break;
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = instruction->getChildren();
+      analyzeCondition(children[0], "if");
+      analyzeBlock(children[1], "block");
+      if (children.size() > 2) {
+        analyzeBlock(children[2], "block"); // else
+      }
+      break;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      analyzeLoop(instruction);
+      break;
+    case ASTNodeType::SWITCH:
+      analyzeSwitch(instruction);
+      break;
+    case ASTNodeType::RETURN_STATEMENT: {
+      if (!insideFunction_) {
+        throw std::runtime_error("Semantic error: 'return' outside of a function.");
+      }
+      if (instruction->getChildren().empty()) {
+        if (returnType_ != TypeTable::VOID) {
+          throw std::runtime_error("Semantic error: 'return;' in a function returning '" +
+            types.toString(returnType_) + "'.");
+        }
+      } else {
+        if (returnType_ == TypeTable::VOID) {
+          throw std::runtime_error("Semantic error: returning a value from a void function.");
+        }
+        expectAssignable(returnType_, analyzeExpression(instruction->getChild(0)), "return");
+      }
+      break;
+    }
+    case ASTNodeType::INPUT:
+      for (const auto& target : instruction->getChildren()) {
+        const IdentifierHandle identifier = useIdentifier(target->getSymbol());
+        const TypeId type = identifier.getType();
+        if (!TypeTable::isScalar(type) && type != TypeTable::STRING) {
+          throw std::runtime_error("Semantic error: cannot read a value of type '" + types.toString(type) +
+            "' into '" + target->getValue() + "'.");
+        }
+        target->setTypeId(type);
+        target->setBinding(identifier.getIndex());
+        tid.markAsInitialized(identifier);
+      }
+      break;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : instruction->getChildren()) {
+        if (const TypeId type = analyzeExpression(value); type == TypeTable::VOID) {
+          throw std::runtime_error("Semantic error: cannot print a value of type 'void'.");
+        }
+      }
+      break;
+    case ASTNodeType::BREAK:
+      if (breakableDepth_ == 0) {
+        throw std::runtime_error("Semantic error: 'break' outside of a loop or switch.");
+      }
+      break;
+    case ASTNodeType::CONTINUE:
+      if (loopDepth_ == 0) {
+        throw std::runtime_error("Semantic error: 'continue' outside of a loop.");
+      }
+      break;
+    default: // expression used as an instruction ('f(x);', 'x;')
+      analyzeExpression(instruction);
+      break;
+  }
+}
+
+void FunctionAnalyzer::analyzeDeclaration(const ASTNodePtr& declaration) {
+  const TypeId type = declaration->getTypeId();
+  const auto& children = declaration->getChildren();
+
+  if (type == TypeTable::VOID) {
+    throw std::runtime_error("Semantic error: variable '" + declaration->getValue() + "' has type void.");
+  }
+
+  // dimensions: one per nested array level at most, each an integer
+  if (children.size() - 1 > types.rank(type)) {
+    throw std::runtime_error("Semantic error: too many dimensions for '" + declaration->getValue() + "' of type '" +
+      types.toString(type) + "'.");
+  }
+  for (size_t i = 1; i < children.size(); ++i) {
+    if (const TypeId size = analyzeExpression(children[i]); size != TypeTable::INT && size != TypeTable::CHAR) {
+      throw std::runtime_error("Semantic error: array size must be an integer, got '" + types.toString(size) + "'.");
+    }
+  }
+
+  // the initializer cannot see the variable it initializes
+  const TypeId initializer = children[0] ? analyzeExpression(children[0]) : TypeTable::NO_TYPE;
+  if (children[0]) {
+    expectAssignable(type, initializer, "initialization of '" + declaration->getValue() + "'");
+  }
+
+  const IdentifierHandle identifier = declareIdentifier(declaration->getSymbol(), type);
+  declaration->setBinding(identifier.getIndex());
+  if (children[0] || types.isArray(type)) { // arrays always hold (zeroed) elements
+    tid.markAsInitialized(identifier);
+  }
+}
+
+void FunctionAnalyzer::analyzeAssignment(const ASTNodePtr& assignment) {
+  const ASTNodePtr& target = assignment->getChild(0);
+  const TypeId value = analyzeExpression(assignment->getChild(1));
+
+  TypeId targetType;
+  if (target->getType() == ASTNodeType::IDENTIFIER) {
+    const auto identifier = tid.lookup(target->getSymbol(), currentScope);
+    if (!identifier) {
+      throw std::runtime_error("Semantic error: Variable '" + target->getValue() +
+        "' assigned without declaration in scope '" + tid.getScope(currentScope).name + "'.");
+    }
+    targetType = identifier->getType();
+    if (types.isFunction(targetType)) {
+      throw std::runtime_error("Semantic error: cannot assign to function '" + target->getValue() + "'.");
+    }
+    target->setTypeId(targetType);
+    target->setBinding(identifier->getIndex());
+    tid.markAsInitialized(*identifier);
+  } else { // element of an array
+    targetType = analyzeExpression(target);
+  }
+
+  expectAssignable(targetType, value, "assignment");
+}
+
+void FunctionAnalyzer::analyzeLoop(const ASTNodePtr& loop) {
+  const auto& children = loop->getChildren();
+
+  ++loopDepth_;
+  ++breakableDepth_;
+  if (loop->getTokenType() == my::TokenType::WHILE) {
+    analyzeCondition(children[0], "while");
+    analyzeBlock(children[1], "block");
+  } else { // for
+    enterScope("for"); // counter lives only inside the loop
+    analyzeDeclaration(children[0]);
+    analyzeCondition(children[1], "for");
+    analyzeAssignment(children[2]);
+    analyzeBlock(children[3], "block");
+    exitScope();
+  }
+  --breakableDepth_;
+  --loopDepth_;
+}
+
+void FunctionAnalyzer::analyzeSwitch(const ASTNodePtr& switchNode) {
+  const auto& children = switchNode->getChildren();
+
+  const TypeId subject = analyzeExpression(children[0]);
+  if (subject != TypeTable::INT && subject != TypeTable::CHAR && subject != TypeTable::STRING) {
+    throw std::runtime_error("Semantic error: switch over a value of type '" + types.toString(subject) + "'.");
+  }
+
+  ++breakableDepth_;
+  enterScope("switch"); // all cases share the switch's scope
+  std::unordered_set<std::string> seen;
+  for (size_t i = 1; i < children.size(); ++i) {
+    const auto& arm = children[i];
+    const auto& instructions = arm->getChildren();
+
+    size_t first = 0;
+    if (arm->getTokenType() == my::TokenType::CASE) {
+      const ASTNodePtr& label = instructions[0];
+      const TypeId labelType = analyzeExpression(label);
+      if ((subject == TypeTable::STRING) != (labelType == TypeTable::STRING) || labelType == TypeTable::FLOAT) {
+        throw std::runtime_error("Semantic error: case label " + label->getValue() + " of type '" +
+          types.toString(labelType) + "' in a switch over '" + types.toString(subject) + "'.");
+      }
+
+      // 'a' and 97 are the same label
+      const std::string key = labelType == TypeTable::CHAR ?
+        std::to_string(static_cast<int>(decodeCharLiteral(label->getValue()))) : label->getValue();
+      if (!seen.insert(key).second) {
+        throw std::runtime_error("Semantic error: duplicate case label " + label->getValue() + ".");
+      }
+      first = 1;
+    }
+
+    for (size_t j = first; j < instructions.size(); ++j) {
+      analyzeInstruction(instructions[j]);
+    }
+  }
+  exitScope();
+  --breakableDepth_;
+}
+
+void FunctionAnalyzer::analyzeCondition(const ASTNodePtr& condition, const std::string& statement) {
+  if (const TypeId type = analyzeExpression(condition); !TypeTable::isScalar(type)) {
+    throw std::runtime_error("Semantic error: condition of '" + statement + "' has type '" +
+      types.toString(type) + "'.");
+  }
+}
+
+TypeId FunctionAnalyzer::analyzeExpression(const ASTNodePtr& expression) {
+  if (expression->getTypeId() == TypeTable::NO_TYPE) {
+    expression->setTypeId(computeExpressionType(expression));
+  }
+  return expression->getTypeId();
+}
+
+TypeId FunctionAnalyzer::computeExpressionType(const ASTNodePtr& expression) {
+  switch (expression->getType()) {
+    case ASTNodeType::LITERAL:
+      return computeLiteralType(expression);
+    case ASTNodeType::IDENTIFIER: {
+      const IdentifierHandle identifier = useIdentifier(expression->getSymbol());
+      if (types.isFunction(identifier.getType())) {
+        throw std::runtime_error("Semantic error: function '" + expression->getValue() + "' used as a value.");
+      }
+      expression->setBinding(identifier.getIndex());
+      return identifier.getType();
+    }
+    case ASTNodeType::INDEX: {
+      const TypeId array = analyzeExpression(expression->getChild(0));
+      if (!types.isArray(array)) {
+        throw std::runtime_error("Semantic error: subscript of a value of type '" + types.toString(array) + "'.");
+      }
+      if (const TypeId index = analyzeExpression(expression->getChild(1));
+        index != TypeTable::INT && index != TypeTable::CHAR) {
+        throw std::runtime_error("Semantic error: array index must be an integer, got '" +
+          types.toString(index) + "'.");
+      }
+      return types.get(array).element;
+    }
+    case ASTNodeType::CALL:
+      return computeCallType(expression);
+    case ASTNodeType::EXPRESSION:
+      return computeOperatorType(expression);
+    default:
+      throw std::runtime_error("Semantic error: instruction used as an expression.");
+  }
+}
+
+TypeId FunctionAnalyzer::computeOperatorType(const ASTNodePtr& expression) {
+  const my::TokenType op = expression->getTokenType();
+  const std::string& symbol = expression->getValue();
+
+  if (expression->getChildren().size() == 1) { // unary
+    const TypeId operand = analyzeExpression(expression->getChild(0));
+    if (op == my::TokenType::NOT) {
+      if (!TypeTable::isScalar(operand)) {
+        throw std::runtime_error("Semantic error: operator ! applied to '" + types.toString(operand) + "'.");
+      }
+      return TypeTable::BOOL;
+    }
+    if (!TypeTable::isNumeric(operand)) { // unary minus
+      throw std::runtime_error("Semantic error: operator - applied to '" + types.toString(operand) + "'.");
+    }
+    return operand == TypeTable::FLOAT ? TypeTable::FLOAT : TypeTable::INT;
+  }
+
+  const TypeId lhs = analyzeExpression(expression->getChild(0));
+  const TypeId rhs = analyzeExpression(expression->getChild(1));
+  const auto mismatch = [&] {
+    return std::runtime_error("Semantic error: operator " + symbol + " applied to '" + types.toString(lhs) +
+      "' and '" + types.toString(rhs) + "'.");
+  };
+
+  switch (op) {
+    case my::TokenType::COMMA:
+      return rhs;
+    case my::TokenType::PLUS:
+      if (lhs == TypeTable::STRING && (rhs == TypeTable::STRING || rhs == TypeTable::CHAR)) {
+        return TypeTable::STRING; // concatenation
+      }
+      [[fallthrough]];
+    case my::TokenType::MINUS:
+    case my::TokenType::MUL:
+    case my::TokenType::DIV:
+      if (!TypeTable::isNumeric(lhs) || !TypeTable::isNumeric(rhs)) {
+        throw mismatch();
+      }
+      return lhs == TypeTable::FLOAT || rhs == TypeTable::FLOAT ? TypeTable::FLOAT : TypeTable::INT;
+    case my::TokenType::LT:
+    case my::TokenType::GT:
+      if (!(TypeTable::isNumeric(lhs) && TypeTable::isNumeric(rhs)) &&
+        !(lhs == TypeTable::STRING && rhs == TypeTable::STRING)) {
+        throw mismatch();
+      }
+      return TypeTable::BOOL;
+    case my::TokenType::EQ:
+    case my::TokenType::NEQ:
+      if (!(TypeTable::isScalar(lhs) && TypeTable::isScalar(rhs)) &&
+        !(lhs == TypeTable::STRING && rhs == TypeTable::STRING)) {
+        throw mismatch();
+      }
+      return TypeTable::BOOL;
+    default: // && and ||
+      if (!TypeTable::isScalar(lhs) || !TypeTable::isScalar(rhs)) {
+        throw mismatch();
+      }
+      return TypeTable::BOOL;
+  }
+}
+
+TypeId FunctionAnalyzer::computeCallType(const ASTNodePtr& call) {
+  const IdentifierHandle function = useIdentifier(call->getSymbol());
+  const TypeId callee = function.getType();
+  call->setBinding(function.getIndex());
+  if (!types.isFunction(callee)) {
+    throw std::runtime_error("Semantic error: '" + call->getValue() + "' is not a function.");
+  }
+
+  const TypeInfo& signature = types.get(callee);
+  const auto& arguments = call->getChildren();
+  if (arguments.size() != signature.parameters.size()) {
+    throw std::runtime_error("Semantic error: function '" + call->getValue() + "' expects " +
+      std::to_string(signature.parameters.size()) + " argument(s), got " + std::to_string(arguments.size()) + ".");
+  }
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    expectAssignable(signature.parameters[i], analyzeExpression(arguments[i]),
+      "argument " + std::to_string(i + 1) + " of '" + call->getValue() + "'");
+  }
+  return signature.element;
+}
+
+TypeId FunctionAnalyzer::computeLiteralType(const ASTNodePtr& literal) const {
+  switch (literal->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL:
+      return TypeTable::INT;
+    case my::TokenType::FLOAT_LITERAL:
+      return TypeTable::FLOAT;
+    case my::TokenType::CHAR_LITERAL:
+      return TypeTable::CHAR;
+    case my::TokenType::STRING_LITERAL:
+      return TypeTable::STRING;
+    default: // true / false
+      return TypeTable::BOOL;
+  }
+}
+
+void FunctionAnalyzer::expectAssignable(const TypeId target, const TypeId source, const std::string& context) const {
+  if (!isAssignable(target, source)) {
+    throw std::runtime_error("Semantic error: Type mismatch in " + context + ": Expected '" +
+      types.toString(target) + "', but got '" + types.toString(source) + "'.");
+  }
+}
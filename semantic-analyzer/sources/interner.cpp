@@ -0,0 +1,36 @@
+#include "../headers/interner.h"
+
+
+SymbolId SymbolInterner::intern(const std::string& name) {
+  const auto [it, inserted] = ids_.try_emplace(name, static_cast<SymbolId>(names_.size()));
+  if (inserted) {
+    names_.push_back(&it->first);
+  }
+  return it->second;
+}
+
+SymbolId SymbolInterner::find(const std::string& name) const {
+  const auto it = ids_.find(name);
+  return it == ids_.end() ? INVALID_SYMBOL : it->second;
+}
+
+const std::string& SymbolInterner::getName(const SymbolId symbol) const {
+  if (symbol >= names_.size()) {
+    throw std::runtime_error("Unknown symbol id " + std::to_string(symbol) + ".");
+  }
+  return *names_[symbol];
+}
+
+size_t SymbolInterner::memoryUsage() const {
+  // a hash node holds the key/value pair, the next pointer and the cached hash
+  constexpr size_t nodeSize = sizeof(std::pair<const std::string, SymbolId>) + 2 * sizeof(void*);
+
+  size_t bytes = ids_.bucket_count() * sizeof(void*) + ids_.size() * nodeSize;
+  bytes += names_.capacity() * sizeof(const std::string*);
+  for (const auto* name : names_) {
+    if (name->capacity() > 15) { // outside of the small-string buffer
+      bytes += name->capacity() + 1;
+    }
+  }
+  return bytes;
+}
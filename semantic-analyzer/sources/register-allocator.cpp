@@ -0,0 +1,250 @@
+#include "../headers/register-allocator.h"
+
+#include <queue>
+
+
+// control never falls through these
+static bool endsFlow(const RegOp op) {
+  return op == RegOp::JUMP || op == RegOp::RETURN || op == RegOp::RETURN_VOID || op == RegOp::TRAP ||
+    op == RegOp::HALT;
+}
+
+static bool isBranch(const RegOp op) {
+  return op == RegOp::JUMP || op == RegOp::JUMP_IF_FALSE || op == RegOp::JUMP_IF_TRUE;
+}
+
+std::vector<LinearScanAllocator::Block> LinearScanAllocator::buildBlocks() const {
+  const auto& instructions = function_.instructions;
+  const auto count = static_cast<uint32_t>(instructions.size());
+
+  std::vector<bool> leader(count + 1, false);
+  leader[0] = true;
+  for (const uint32_t target : function_.labels) {
+    leader[target] = true;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    if (isBranch(instructions[i].op) || endsFlow(instructions[i].op)) {
+      leader[i + 1] = true;
+    }
+  }
+
+  std::vector<Block> blocks;
+  std::vector<uint32_t> blockOf(count + 1, NONE);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (leader[i]) {
+      blocks.push_back({i, i, {}});
+    }
+    blocks.back().last = i;
+    blockOf[i] = static_cast<uint32_t>(blocks.size() - 1);
+  }
+
+  for (Block& block : blocks) {
+    const RegisterInstruction& last = instructions[block.last];
+    if (isBranch(last.op)) {
+      const uint32_t target = function_.labels[last.operands.back()];
+      if (blockOf[target] != NONE) {
+        block.successors.push_back(blockOf[target]);
+      }
+    }
+    if (!endsFlow(last.op) && blockOf[block.last + 1] != NONE) {
+      block.successors.push_back(blockOf[block.last + 1]);
+    }
+  }
+  return blocks;
+}
+
+std::vector<LinearScanAllocator::Interval> LinearScanAllocator::buildIntervals(const std::vector<Block>& blocks) const {
+  const auto& instructions = function_.instructions;
+  const size_t registers = function_.virtualRegisters;
+
+  // backward liveness: in = use | (out & ~def)
+  std::vector<BitVector> use(blocks.size(), BitVector(registers));
+  std::vector<BitVector> def(blocks.size(), BitVector(registers));
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    for (uint32_t i = blocks[b].first; i <= blocks[b].last; ++i) {
+      const RegisterInstruction& instruction = instructions[i];
+      RegisterFunctionIR::forEachRegister(instruction, [&](const size_t operand, const bool isDefinition) {
+        const uint32_t reg = instruction.operands[operand];
+        if (!isDefinition && !def[b].test(reg)) {
+          use[b].set(reg);
+        }
+      });
+      RegisterFunctionIR::forEachRegister(instruction, [&](const size_t operand, const bool isDefinition) {
+        if (isDefinition) {
+          def[b].set(instruction.operands[operand]);
+        }
+      });
+    }
+  }
+
+  std::vector<BitVector> in(blocks.size(), BitVector(registers));
+  std::vector<BitVector> out(blocks.size(), BitVector(registers));
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t b = blocks.size(); b-- > 0;) {
+      for (const uint32_t successor : blocks[b].successors) {
+        out[b] |= in[successor];
+      }
+      changed |= in[b].assignTransfer(use[b], out[b], def[b]);
+    }
+  }
+
+  std::vector<Interval> intervals(registers);
+  for (uint32_t parameter = 0; parameter < function_.parameters; ++parameter) {
+    intervals[parameter].extend(0); // arguments are in place before the first instruction
+  }
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    for (uint32_t reg = 0; reg < registers; ++reg) {
+      if (in[b].test(reg)) {
+        intervals[reg].extend(2 * blocks[b].first);
+      }
+      if (out[b].test(reg)) {
+        intervals[reg].extend(2 * blocks[b].last + 1);
+      }
+    }
+    for (uint32_t i = blocks[b].first; i <= blocks[b].last; ++i) {
+      const RegisterInstruction& instruction = instructions[i];
+      RegisterFunctionIR::forEachRegister(instruction, [&](const size_t operand, const bool isDefinition) {
+        intervals[instruction.operands[operand]].extend(2 * i + (isDefinition ? 1 : 0));
+      });
+    }
+  }
+  return intervals;
+}
+
+void LinearScanAllocator::allocate() {
+  const std::vector<Block> blocks = buildBlocks();
+  const std::vector<Interval> intervals = buildIntervals(blocks);
+  const uint32_t registers = function_.virtualRegisters;
+
+  // the other side of every MOVE is the preferred slot
+  std::vector<std::vector<uint32_t>> hints(registers);
+  for (const auto& instruction : function_.instructions) {
+    if (instruction.op == RegOp::MOVE) {
+      hints[instruction.operands[0]].push_back(instruction.operands[1]);
+      hints[instruction.operands[1]].push_back(instruction.operands[0]);
+    }
+  }
+
+  std::vector<uint32_t> order;
+  for (uint32_t reg = 0; reg < registers; ++reg) {
+    if (intervals[reg].start != NONE) {
+      order.push_back(reg);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+    return intervals[a].start < intervals[b].start;
+  });
+
+  slots_.assign(registers, NONE);
+  slotCount_ = function_.parameters;
+  std::vector<bool> busy(function_.parameters, false);
+  using Active = std::pair<uint32_t, uint32_t>; // (end, register), the earliest end on top
+  std::priority_queue<Active, std::vector<Active>, std::greater<>> active;
+
+  for (const uint32_t reg : order) {
+    const Interval& interval = intervals[reg];
+    while (!active.empty() && active.top().first < interval.start) {
+      busy[slots_[active.top().second]] = false;
+      active.pop();
+    }
+
+    uint32_t slot = NONE;
+    if (reg < function_.parameters) {
+      slot = reg; // fixed by the calling convention; free, no interval starts earlier
+    }
+    for (size_t h = 0; slot == NONE && h < hints[reg].size(); ++h) {
+      if (const uint32_t hinted = slots_[hints[reg][h]]; hinted != NONE && !busy[hinted]) {
+        slot = hinted;
+      }
+    }
+    for (uint32_t candidate = 0; slot == NONE && candidate < busy.size(); ++candidate) {
+      if (!busy[candidate]) {
+        slot = candidate;
+      }
+    }
+    if (slot == NONE) {
+      slot = static_cast<uint32_t>(busy.size());
+      busy.push_back(false);
+    }
+
+    slots_[reg] = slot;
+    busy[slot] = true;
+    slotCount_ = std::max(slotCount_, slot + 1);
+    active.emplace(interval.end, reg);
+  }
+
+  // registers that are never live (results nobody reads) still need a slot to write to
+  for (uint32_t reg = 0; reg < registers; ++reg) {
+    if (slots_[reg] == NONE) {
+      slots_[reg] = reg < function_.parameters ? reg : slotCount_;
+      slotCount_ = std::max(slotCount_, slots_[reg] + 1);
+    }
+  }
+}
+
+
+// Allocates the frame slots and encodes the function as program.functions[index]
+void encodeFunction(const RegisterFunctionIR& function, RegisterProgram& program, const uint32_t index) {
+  LinearScanAllocator allocator(function);
+  allocator.allocate();
+
+  // a MOVE between registers that share a slot is dropped
+  const auto& instructions = function.instructions;
+  const auto isDropped = [&](const RegisterInstruction& instruction) {
+    return instruction.op == RegOp::MOVE &&
+      allocator.slot(instruction.operands[0]) == allocator.slot(instruction.operands[1]);
+  };
+
+  RPNFunction& encoded = program.functions[index];
+  encoded.entry = static_cast<uint32_t>(program.code.size());
+  std::vector<uint32_t> offsets(instructions.size() + 1);
+  uint32_t offset = encoded.entry;
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    offsets[i] = offset;
+    if (!isDropped(instructions[i])) {
+      offset += static_cast<uint32_t>(1 + 4 * instructions[i].operands.size());
+    }
+  }
+  offsets[instructions.size()] = offset;
+
+  for (const auto& instruction : instructions) {
+    if (isDropped(instruction)) {
+      continue;
+    }
+    const auto position = static_cast<uint32_t>(program.code.size());
+    if (program.lines.empty() || program.lines.back().second != instruction.line) {
+      program.lines.emplace_back(position, instruction.line);
+    }
+
+    std::vector<uint32_t> operands = instruction.operands;
+    RegisterFunctionIR::forEachRegister(instruction, [&](const size_t operand, bool) {
+      operands[operand] = allocator.slot(operands[operand]);
+    });
+    const char* roles = REGISTER_OPCODE_ROLES[static_cast<uint8_t>(instruction.op)];
+    for (size_t i = 0; roles[i]; ++i) {
+      if (roles[i] == 't') {
+        operands[i] = offsets[function.labels[operands[i]]];
+      }
+    }
+
+    program.code.push_back(static_cast<uint8_t>(instruction.op));
+    program.code.resize(program.code.size() + 4 * operands.size());
+    for (size_t i = 0; i < operands.size(); ++i) {
+      writeOperand(&program.code[position + 1 + 4 * i], operands[i]);
+    }
+  }
+  encoded.end = static_cast<uint32_t>(program.code.size());
+  encoded.slots = allocator.slotCount();
+
+  encoded.slotNames.assign(encoded.slots, "");
+  for (uint32_t reg = 0; reg < function.virtualRegisters; ++reg) {
+    const std::string& name = function.names[reg];
+    std::string& names = encoded.slotNames[allocator.slot(reg)];
+    if (name.empty() || names == name || names.starts_with(name + "/") || names.ends_with("/" + name) ||
+      names.find("/" + name + "/") != std::string::npos) {
+      continue;
+    }
+    names += names.empty() ? name : "/" + name;
+  }
+}
@@ -0,0 +1,132 @@
+#include "../headers/register-bytecode.h"
+
+#include <iomanip>
+#include <sstream>
+
+
+size_t RegisterProgram::instructionCount() const {
+  size_t count = 0;
+  for (size_t pc = 0; pc < code.size(); pc += registerInstructionSize(&code[pc])) {
+    ++count;
+  }
+  return count;
+}
+
+
+// Register operand: r<slot>, with the variable names sharing the slot
+static std::string registerName(const RPNFunction& function, const uint32_t slot) {
+  std::string name = "r" + std::to_string(slot);
+  if (slot < function.slotNames.size() && !function.slotNames[slot].empty()) {
+    name += "(" + function.slotNames[slot] + ")";
+  }
+  return name;
+}
+
+// Immediate or pool operand, with what it stands for
+static std::string describeImmediate(const RegisterProgram& program, const RegOp op, const uint32_t operand) {
+  std::ostringstream out;
+  switch (op) {
+    case RegOp::LOAD_INT:
+      out << static_cast<int32_t>(operand);
+      break;
+    case RegOp::LOAD_LONG:
+      out << "#" << operand << " " << program.integers.at(operand);
+      break;
+    case RegOp::LOAD_FLOAT:
+      out << "#" << operand << " " << program.floats.at(operand);
+      break;
+    case RegOp::LOAD_CHAR:
+      out << '\'' << static_cast<char>(operand) << '\'';
+      break;
+    case RegOp::LOAD_BOOL:
+      out << (operand ? "true" : "false");
+      break;
+    case RegOp::LOAD_STRING:
+    case RegOp::TRAP:
+      out << "#" << operand << " \"" << program.strings.at(operand) << '"';
+      break;
+    case RegOp::LOAD_GLOBAL:
+    case RegOp::STORE_GLOBAL:
+      out << "g" << operand;
+      if (operand < program.globalNames.size()) {
+        out << "(" << program.globalNames[operand] << ")";
+      }
+      break;
+    case RegOp::CALL:
+    case RegOp::CALL_VOID:
+      out << program.functions.at(operand).name;
+      break;
+    case RegOp::NEW_ARRAY:
+      out << valueKindName(arrayLeaf(operand)) << (isLocalArray(operand) ? " local" : "");
+      break;
+    case RegOp::READ:
+      out << valueKindName(static_cast<ValueKind>(operand));
+      break;
+    default:
+      out << operand;
+      break;
+  }
+  return out.str();
+}
+
+static void disassembleFunction(std::ostringstream& out, const RegisterProgram& program, const size_t index) {
+  const RPNFunction& function = program.functions[index];
+  out << "function #" << index << " " << function.name << ": parameters " << function.parameters << ", registers "
+      << function.slots << (function.returnsValue ? ", returns a value" : "")
+      << (function.localStrings ? ", local strings" : "") << "\n";
+
+  uint32_t line = 0;
+  for (uint32_t pc = function.entry; pc < function.end;) {
+    const uint8_t* instruction = &program.code[pc];
+    const auto op = static_cast<RegOp>(*instruction);
+    if (const uint32_t current = program.lineAt(pc); current != line) {
+      line = current;
+      out << "  ; line " << line << "\n";
+    }
+
+    out << "  " << std::setw(6) << std::setfill('0') << pc << std::setfill(' ') << "  " << std::left
+        << std::setw(14) << REGISTER_OPCODE_NAMES[*instruction] << std::right;
+    const char* roles = REGISTER_OPCODE_ROLES[*instruction];
+    size_t operand = 0;
+    for (size_t i = 0; roles[i]; ++i) {
+      const uint32_t value = readOperand(instruction + 1 + 4 * operand++);
+      out << (i == 0 ? " " : ", ");
+      switch (roles[i]) {
+        case 'd':
+        case 'u':
+          out << registerName(function, value);
+          break;
+        case 't':
+          out << "-> " << value;
+          break;
+        case 'n':
+          out << "(";
+          for (uint32_t j = 0; j < value; ++j) {
+            out << (j == 0 ? "" : ", ") << registerName(function, readOperand(instruction + 1 + 4 * operand++));
+          }
+          out << ")";
+          break;
+        default:
+          out << describeImmediate(program, op, value);
+          break;
+      }
+    }
+    out << "\n";
+    pc += static_cast<uint32_t>(registerInstructionSize(instruction));
+  }
+}
+
+std::string disassemble(const RegisterProgram& program) {
+  std::ostringstream out;
+  out << "globals: " << program.globals;
+  for (size_t i = 0; i < program.globalNames.size(); ++i) {
+    out << (i == 0 ? " (" : ", ") << program.globalNames[i] << (i + 1 == program.globalNames.size() ? ")" : "");
+  }
+  out << "\ncode: " << program.code.size() << " bytes, " << program.instructionCount() << " instructions\n";
+
+  for (size_t i = 0; i < program.functions.size(); ++i) {
+    out << "\n";
+    disassembleFunction(out, program, i);
+  }
+  return out.str();
+}
@@ -0,0 +1,704 @@
+#include "../headers/register-generator.h"
+
+
+RegisterProgram RegisterGenerator::generate(const ASTNodePtr& program) {
+  program_ = RegisterProgram();
+  functionByBinding_.clear();
+  globalByBinding_.clear();
+  stringIndex_.clear();
+  floatIndex_.clear();
+
+  // every function's signature first, calls can precede definitions
+  std::vector<ASTNodePtr> functions;
+  ASTNodePtr main;
+  program_.functions.emplace_back();
+  program_.functions[0].name = "<top-level>";
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      continue;
+    }
+    functionByBinding_[declaration->getBinding()] = static_cast<uint32_t>(program_.functions.size());
+    functions.push_back(declaration);
+
+    RPNFunction& function = program_.functions.emplace_back();
+    function.name = declaration->getValue();
+    function.parameters = static_cast<uint32_t>(declaration->getChildren().size() - 1);
+    function.returnsValue = types_.get(declaration->getTypeId()).element != TypeTable::VOID;
+    if (function.name == "main" && function.parameters == 0) {
+      main = declaration;
+    }
+  }
+
+  compileEntry(program, main);
+  for (size_t i = 0; i < functions.size(); ++i) {
+    compileFunction(functions[i], static_cast<uint32_t>(i + 1));
+  }
+  return std::move(program_);
+}
+
+void RegisterGenerator::compileEntry(const ASTNodePtr& program, const ASTNodePtr& main) {
+  beginFunction();
+
+  // globals hold their zero values even for functions that run before the declaration
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::VARIABLE_DECLARATION) {
+      line_ = declaration->getLine();
+      const uint32_t zero = newRegister();
+      zeroValueInto(declaration->getTypeId(), zero);
+      emit(RegOp::STORE_GLOBAL, {globalIndex(declaration->getBinding()), zero});
+    }
+  }
+
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration);
+    }
+  }
+  if (main) {
+    line_ = main->getLine();
+    const uint32_t index = functionByBinding_.at(main->getBinding());
+    if (program_.functions[index].returnsValue) {
+      emit(RegOp::CALL, {newRegister(), index, 0});
+    } else {
+      emit(RegOp::CALL_VOID, {index, 0});
+    }
+  }
+  emit(RegOp::HALT, {});
+  endFunction(0);
+}
+
+void RegisterGenerator::compileFunction(const ASTNodePtr& function, const uint32_t index) {
+  beginFunction();
+  returnType_ = types_.get(function->getTypeId()).element;
+  line_ = function->getLine();
+  program_.functions[index].localStrings = locals_ && locals_->strings.contains(function.get());
+
+  const auto& children = function->getChildren();
+  ir_.parameters = static_cast<uint32_t>(children.size() - 1);
+  for (size_t i = 0; i + 1 < children.size(); ++i) { // virtual registers 0..n-1
+    registerByBinding_[children[i]->getBinding()] = newRegister(children[i]->getValue());
+  }
+  statement(children.back());
+
+  // falling off the end
+  if (returnType_ == TypeTable::VOID) {
+    emit(RegOp::RETURN_VOID, {});
+  } else {
+    emit(RegOp::TRAP, {addString("function '" + function->getValue() + "' ended without returning a value")});
+  }
+  endFunction(index);
+}
+
+void RegisterGenerator::beginFunction() {
+  ir_ = RegisterFunctionIR();
+  prologue_.clear();
+  constants_.clear();
+  registerByBinding_.clear();
+  registerByValue_.clear();
+  returnType_ = TypeTable::VOID;
+}
+
+// Prepends the constant loads, allocates the frame slots and encodes the function
+void RegisterGenerator::endFunction(const uint32_t index) {
+  const auto shift = static_cast<uint32_t>(prologue_.size());
+  for (RegisterInstruction& load : prologue_) { // attributed to the function's first line
+    load.line = ir_.instructions.empty() ? line_ : ir_.instructions.front().line;
+  }
+  ir_.instructions.insert(ir_.instructions.begin(), prologue_.begin(), prologue_.end());
+  for (uint32_t& label : ir_.labels) {
+    label += shift;
+  }
+
+  encodeFunction(ir_, program_, index);
+}
+
+void RegisterGenerator::statement(const ASTNodePtr& node) {
+  line_ = node->getLine();
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK:
+      for (const auto& instruction : node->getChildren()) {
+        statement(instruction);
+      }
+      break;
+    case ASTNodeType::VARIABLE_DECLARATION:
+      declaration(node);
+      break;
+    case ASTNodeType::ASSIGNMENT:
+      assignment(node);
+      break;
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      const uint32_t otherwise = newLabel();
+      condition(children[0], otherwise, false);
+      statement(children[1]);
+      if (children.size() > 2) {
+        const uint32_t end = newLabel();
+        emit(RegOp::JUMP, {end});
+        bind(otherwise);
+        statement(children[2]);
+        bind(end);
+      } else {
+        bind(otherwise);
+      }
+      break;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      loop(node);
+      break;
+    case ASTNodeType::SWITCH:
+      switchStatement(node);
+      break;
+    case ASTNodeType::RETURN_STATEMENT:
+      if (node->getChildren().empty()) {
+        emit(RegOp::RETURN_VOID, {});
+      } else {
+        emit(RegOp::RETURN, {convertedValue(node->getChild(0), returnType_)});
+      }
+      break;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        const auto kind = static_cast<uint32_t>(valueKind(target->getTypeId()));
+        if (isLocal(target->getBinding())) {
+          emit(RegOp::READ, {registerByBinding_.at(target->getBinding()), kind});
+        } else {
+          const uint32_t input = newRegister();
+          emit(RegOp::READ, {input, kind});
+          emit(RegOp::STORE_GLOBAL, {globalIndex(target->getBinding()), input});
+        }
+      }
+      break;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : node->getChildren()) {
+        emit(RegOp::PRINT, {this->value(value)});
+      }
+      break;
+    case ASTNodeType::BREAK:
+      emit(RegOp::JUMP, {breakLabels_.back()});
+      break;
+    case ASTNodeType::CONTINUE:
+      emit(RegOp::JUMP, {continueLabels_.back()});
+      break;
+    default: // expression statement
+      effect(node);
+      break;
+  }
+}
+
+void RegisterGenerator::declaration(const ASTNodePtr& node) {
+  const TypeId type = node->getTypeId();
+  const auto& children = node->getChildren();
+  const bool global = tid_.getRecord(node->getBinding()).scope == GLOBAL_SCOPE;
+  const uint32_t local = locals_ && locals_->arrays.contains(node.get()) ? LOCAL_ARRAY : 0;
+
+  // the initializer cannot see the variable, so its register is bound only afterwards
+  const uint32_t target = newRegister(global ? "" : node->getValue());
+  if (children[0]) {
+    convertedValueInto(children[0], type, target);
+  } else if (children.size() > 1) { // sized array
+    std::vector<uint32_t> operands = {target, 0, static_cast<uint32_t>(children.size() - 1)};
+    for (size_t i = 1; i < children.size(); ++i) {
+      operands.push_back(value(children[i]));
+    }
+    const ValueKind leaf = operands[2] < types_.rank(type) ? ValueKind::ARRAY : valueKind(types_.scalar(type));
+    operands[1] = static_cast<uint32_t>(leaf) | local;
+    emit(RegOp::NEW_ARRAY, std::move(operands));
+  } else if (local) {
+    emit(RegOp::NEW_ARRAY, {target, static_cast<uint32_t>(valueKind(types_.get(type).element)) | local, 0});
+  } else {
+    zeroValueInto(type, target);
+  }
+
+  if (global) {
+    emit(RegOp::STORE_GLOBAL, {globalIndex(node->getBinding()), target});
+  } else {
+    registerByBinding_[node->getBinding()] = target;
+  }
+}
+
+void RegisterGenerator::assignment(const ASTNodePtr& node) {
+  const ASTNodePtr& target = node->getChild(0);
+  const ASTNodePtr& value = node->getChild(1);
+
+  if (target->getType() == ASTNodeType::IDENTIFIER) {
+    if (isLocal(target->getBinding())) {
+      convertedValueInto(value, target->getTypeId(), registerByBinding_.at(target->getBinding()));
+    } else {
+      emit(RegOp::STORE_GLOBAL, {globalIndex(target->getBinding()), convertedValue(value, target->getTypeId())});
+    }
+    return;
+  }
+
+  // element store: the array and index first, then the value
+  const uint32_t array = this->value(target->getChild(0));
+  const uint32_t index = this->value(target->getChild(1));
+  emit(RegOp::STORE_INDEX, {array, index, convertedValue(value, target->getTypeId())});
+}
+
+// Loops are laid out with the test at the bottom: one conditional branch per iteration
+// instead of a conditional branch at the top plus a jump back
+void RegisterGenerator::loop(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const uint32_t body = newLabel();
+  const uint32_t test = newLabel();
+  const uint32_t end = newLabel();
+  const bool isWhile = node->getTokenType() == my::TokenType::WHILE;
+  const uint32_t next = isWhile ? test : newLabel(); // `continue` runs the step of `for`
+
+  if (!isWhile) {
+    statement(children[0]);
+  }
+  line_ = node->getLine();
+  emit(RegOp::JUMP, {test});
+
+  bind(body);
+  breakLabels_.push_back(end);
+  continueLabels_.push_back(next);
+  statement(children[isWhile ? 1 : 3]);
+  breakLabels_.pop_back();
+  continueLabels_.pop_back();
+  if (!isWhile) {
+    bind(next);
+    statement(children[2]);
+  }
+
+  bind(test);
+  line_ = node->getLine();
+  condition(children[isWhile ? 0 : 1], body, true);
+  bind(end);
+}
+
+// A switch over ints or chars with at least MIN_TREE_CASES literal labels is a balanced
+// tree of `<` comparisons, O(log n) per dispatch; strings and fewer labels are compared
+// in source order (a value labelled twice goes to its first arm either way). The register
+// VM has no indirect jump, so there are no jump tables or hashes here (see RPNGenerator).
+void RegisterGenerator::switchStatement(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+
+  // the subject is evaluated once, then compared with the labels
+  const uint32_t subject = value(children[0]);
+  std::vector<uint32_t> arms(children.size() - 1);
+  uint32_t fallback = UINT32_MAX;
+  std::vector<SwitchCase> cases;
+  std::unordered_set<int64_t> values;
+  bool tree = switchLowering_ && types_.kind(children[0]->getTypeId()) != TypeKind::STRING;
+  for (size_t i = 1; i < children.size(); ++i) {
+    arms[i - 1] = newLabel();
+    const ASTNodePtr& arm = children[i];
+    if (arm->getTokenType() != my::TokenType::CASE) {
+      fallback = arms[i - 1];
+      continue;
+    }
+    const ASTNodePtr& label = arm->getChild(0);
+    if (label->getType() != ASTNodeType::LITERAL) {
+      tree = false;
+    } else if (label->getTokenType() == my::TokenType::INTEGER_LITERAL) {
+      if (values.insert(decodeIntegerLiteral(label->getValue())).second) {
+        cases.push_back({decodeIntegerLiteral(label->getValue()), label, i - 1});
+      }
+    } else if (label->getTokenType() == my::TokenType::CHAR_LITERAL) {
+      if (values.insert(decodeCharLiteral(label->getValue())).second) {
+        cases.push_back({decodeCharLiteral(label->getValue()), label, i - 1});
+      }
+    } else {
+      tree = false;
+    }
+  }
+
+  const uint32_t end = newLabel();
+  if (fallback == UINT32_MAX) {
+    fallback = end;
+  }
+  if (tree && cases.size() >= MIN_TREE_CASES) {
+    line_ = node->getLine();
+    std::sort(cases.begin(), cases.end(), [](const SwitchCase& a, const SwitchCase& b) { return a.value < b.value; });
+    switchTree(subject, cases, 0, cases.size(), arms, fallback);
+  } else {
+    for (size_t i = 1; i < children.size(); ++i) {
+      const ASTNodePtr& arm = children[i];
+      if (arm->getTokenType() != my::TokenType::CASE) {
+        continue;
+      }
+      line_ = arm->getLine();
+      const uint32_t equal = newRegister();
+      emit(RegOp::EQ, {equal, subject, value(arm->getChild(0))});
+      emit(RegOp::JUMP_IF_TRUE, {equal, arms[i - 1]});
+    }
+    emit(RegOp::JUMP, {fallback});
+  }
+
+  // the arms in source order, each one ends with the `break` the parser consumed
+  breakLabels_.push_back(end);
+  for (size_t i = 1; i < children.size(); ++i) {
+    const auto& instructions = children[i]->getChildren();
+    bind(arms[i - 1]);
+    line_ = children[i]->getLine();
+    const size_t first = children[i]->getTokenType() == my::TokenType::CASE ? 1 : 0;
+    for (size_t j = first; j < instructions.size(); ++j) {
+      statement(instructions[j]);
+    }
+    if (i + 1 < children.size()) {
+      emit(RegOp::JUMP, {end});
+    }
+  }
+  breakLabels_.pop_back();
+  bind(end);
+}
+
+void RegisterGenerator::switchTree(const uint32_t subject, const std::vector<SwitchCase>& cases, const size_t first,
+  const size_t last, const std::vector<uint32_t>& arms, const uint32_t fallback) {
+  if (last - first <= TREE_LEAF_CASES) {
+    for (size_t i = first; i < last; ++i) {
+      const uint32_t equal = newRegister();
+      emit(RegOp::EQ, {equal, subject, value(cases[i].label)});
+      emit(RegOp::JUMP_IF_TRUE, {equal, arms[cases[i].arm]});
+    }
+    emit(RegOp::JUMP, {fallback});
+    return;
+  }
+  const size_t middle = first + (last - first) / 2;
+  const uint32_t upper = newLabel();
+  const uint32_t less = newRegister();
+  emit(RegOp::LT, {less, subject, value(cases[middle].label)});
+  emit(RegOp::JUMP_IF_FALSE, {less, upper});
+  switchTree(subject, cases, first, middle, arms, fallback);
+  bind(upper);
+  switchTree(subject, cases, middle, last, arms, fallback);
+}
+
+
+void RegisterGenerator::condition(const ASTNodePtr& node, const uint32_t target, const bool when) {
+  const my::TokenType op = node->getType() == ASTNodeType::EXPRESSION ? node->getTokenType() : my::TokenType::UNKNOWN;
+  const auto& children = node->getChildren();
+  if (op == my::TokenType::NOT && children.size() == 1) {
+    condition(children[0], target, !when);
+  } else if (op == my::TokenType::AND || op == my::TokenType::OR) {
+    // a && b is false as soon as a is, a || b true as soon as a is
+    if ((op == my::TokenType::AND) != when) {
+      condition(children[0], target, when);
+      condition(children[1], target, when);
+    } else {
+      const uint32_t decided = newLabel();
+      condition(children[0], decided, !when);
+      condition(children[1], target, when);
+      bind(decided);
+    }
+  } else {
+    emit(when ? RegOp::JUMP_IF_TRUE : RegOp::JUMP_IF_FALSE, {value(node), target});
+  }
+}
+
+uint32_t RegisterGenerator::value(const ASTNodePtr& node) {
+  if (node->getType() == ASTNodeType::IDENTIFIER && isLocal(node->getBinding())) {
+    return registerByBinding_.at(node->getBinding());
+  }
+  if (node->getType() == ASTNodeType::LITERAL) {
+    const auto [load, operand] = literalLoad(node);
+    return constant(load, operand);
+  }
+  if (shared_ && shared_->contains(node.get())) {
+    const auto [value, first] = shared_->at(node.get());
+    if (const auto kept = registerByValue_.find(value); !first && kept != registerByValue_.end()) {
+      return kept->second;
+    }
+    const uint32_t result = newRegister();
+    computeInto(node, result);
+    if (first) {
+      registerByValue_[value] = result;
+    }
+    return result;
+  }
+  const uint32_t result = newRegister();
+  computeInto(node, result);
+  return result;
+}
+
+void RegisterGenerator::valueInto(const ASTNodePtr& node, const uint32_t target) {
+  if (!shared_ || !shared_->contains(node.get())) {
+    computeInto(node, target);
+  } else if (const uint32_t source = value(node); source != target) {
+    emit(RegOp::MOVE, {target, source}); // the shared value stays in its own register
+  }
+}
+
+void RegisterGenerator::computeInto(const ASTNodePtr& node, const uint32_t target) {
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL:
+      literalInto(node, target);
+      break;
+    case ASTNodeType::IDENTIFIER:
+      if (isLocal(node->getBinding())) {
+        if (const uint32_t source = registerByBinding_.at(node->getBinding()); source != target) {
+          emit(RegOp::MOVE, {target, source});
+        }
+      } else {
+        emit(RegOp::LOAD_GLOBAL, {target, globalIndex(node->getBinding())});
+      }
+      break;
+    case ASTNodeType::INDEX: {
+      const uint32_t array = value(node->getChild(0));
+      emit(RegOp::LOAD_INDEX, {target, array, value(node->getChild(1))});
+      break;
+    }
+    case ASTNodeType::CALL:
+      callInto(node, target);
+      break;
+    case ASTNodeType::EXPRESSION:
+      binaryInto(node, target);
+      break;
+    default:
+      throw std::runtime_error("Code generation error: instruction used as an expression.");
+  }
+}
+
+void RegisterGenerator::effect(const ASTNodePtr& node) {
+  if (node->getType() == ASTNodeType::CALL && node->getTypeId() == TypeTable::VOID) {
+    callInto(node, UINT32_MAX);
+  } else if (node->getType() == ASTNodeType::EXPRESSION && node->getTokenType() == my::TokenType::COMMA &&
+    node->getChildren().size() == 2) {
+    effect(node->getChild(0));
+    effect(node->getChild(1));
+  } else {
+    valueInto(node, newRegister()); // still evaluated: it may fail at run time
+  }
+}
+
+uint32_t RegisterGenerator::convertedValue(const ASTNodePtr& node, const TypeId type) {
+  const std::optional<RegOp> convert = conversion(type, node->getTypeId());
+  if (!convert) {
+    return value(node);
+  }
+  const uint32_t result = newRegister();
+  emit(*convert, {result, value(node)});
+  return result;
+}
+
+void RegisterGenerator::convertedValueInto(const ASTNodePtr& node, const TypeId type, const uint32_t target) {
+  if (const std::optional<RegOp> convert = conversion(type, node->getTypeId())) {
+    emit(*convert, {target, value(node)});
+  } else {
+    valueInto(node, target);
+  }
+}
+
+void RegisterGenerator::binaryInto(const ASTNodePtr& node, const uint32_t target) {
+  const auto& children = node->getChildren();
+  const my::TokenType op = node->getTokenType();
+
+  if (children.size() == 1) {
+    emit(op == my::TokenType::NOT ? RegOp::NOT : RegOp::NEG, {target, value(children[0])});
+    return;
+  }
+
+  RegOp instruction;
+  switch (op) {
+    case my::TokenType::COMMA:
+      effect(children[0]);
+      valueInto(children[1], target);
+      return;
+    case my::TokenType::AND:
+    case my::TokenType::OR:
+      logicalInto(node, target);
+      return;
+    case my::TokenType::PLUS:
+      instruction = RegOp::ADD;
+      break;
+    case my::TokenType::MINUS:
+      instruction = RegOp::SUB;
+      break;
+    case my::TokenType::MUL:
+      instruction = RegOp::MUL;
+      break;
+    case my::TokenType::DIV:
+      instruction = RegOp::DIV;
+      break;
+    case my::TokenType::LT:
+      instruction = RegOp::LT;
+      break;
+    case my::TokenType::GT:
+      instruction = RegOp::GT;
+      break;
+    case my::TokenType::EQ:
+      instruction = RegOp::EQ;
+      break;
+    case my::TokenType::NEQ:
+      instruction = RegOp::NEQ;
+      break;
+    default:
+      throw std::runtime_error("Code generation error: unknown operator " + node->getValue() + ".");
+  }
+  const uint32_t lhs = value(children[0]);
+  emit(instruction, {target, lhs, value(children[1])});
+}
+
+// `a && b`: the result is written before `b` runs, so it goes to a temporary (which the
+// allocator merges with the target when `b` does not read the target)
+void RegisterGenerator::logicalInto(const ASTNodePtr& node, const uint32_t target) {
+  const auto& children = node->getChildren();
+  const uint32_t result = newRegister();
+  const uint32_t end = newLabel();
+
+  convertedValueInto(children[0], TypeTable::BOOL, result);
+  emit(node->getTokenType() == my::TokenType::AND ? RegOp::JUMP_IF_FALSE : RegOp::JUMP_IF_TRUE, {result, end});
+  convertedValueInto(children[1], TypeTable::BOOL, result);
+  bind(end);
+  emit(RegOp::MOVE, {target, result});
+}
+
+std::pair<RegOp, uint32_t> RegisterGenerator::literalLoad(const ASTNodePtr& node) {
+  const std::string& lexeme = node->getValue();
+  switch (node->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL: {
+      const int64_t value = decodeIntegerLiteral(lexeme);
+      if (value >= INT32_MIN && value <= INT32_MAX) {
+        return {RegOp::LOAD_INT, static_cast<uint32_t>(static_cast<int32_t>(value))};
+      }
+      program_.integers.push_back(value);
+      return {RegOp::LOAD_LONG, static_cast<uint32_t>(program_.integers.size() - 1)};
+    }
+    case my::TokenType::FLOAT_LITERAL:
+      return {RegOp::LOAD_FLOAT, addFloat(decodeFloatLiteral(lexeme))};
+    case my::TokenType::CHAR_LITERAL:
+      return {RegOp::LOAD_CHAR, static_cast<uint8_t>(decodeCharLiteral(lexeme))};
+    case my::TokenType::STRING_LITERAL:
+      return {RegOp::LOAD_STRING, addString(decodeStringLiteral(lexeme))};
+    default: // true / false
+      return {RegOp::LOAD_BOOL, lexeme == "true" ? 1u : 0u};
+  }
+}
+
+void RegisterGenerator::literalInto(const ASTNodePtr& node, const uint32_t target) {
+  const auto [load, operand] = literalLoad(node);
+  emit(load, {target, operand});
+}
+
+uint32_t RegisterGenerator::constant(const RegOp load, const uint32_t operand) {
+  const auto [entry, inserted] = constants_.try_emplace({load, operand}, 0);
+  if (inserted) {
+    entry->second = newRegister();
+    prologue_.push_back({load, line_, {entry->second, operand}});
+  }
+  return entry->second;
+}
+
+void RegisterGenerator::callInto(const ASTNodePtr& node, const uint32_t target) {
+  const TypeInfo& signature = types_.get(tid_.getRecord(node->getBinding()).type);
+  const auto& arguments = node->getChildren();
+  const uint32_t function = functionByBinding_.at(node->getBinding());
+
+  std::vector<uint32_t> operands;
+  if (target != UINT32_MAX) {
+    operands.push_back(target);
+  }
+  operands.push_back(function);
+  operands.push_back(static_cast<uint32_t>(arguments.size()));
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    operands.push_back(convertedValue(arguments[i], signature.parameters[i]));
+  }
+  emit(target != UINT32_MAX ? RegOp::CALL : RegOp::CALL_VOID, std::move(operands));
+}
+
+void RegisterGenerator::zeroValueInto(const TypeId type, const uint32_t target) {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      emit(RegOp::LOAD_INT, {target, 0});
+      break;
+    case TypeKind::FLOAT:
+      emit(RegOp::LOAD_FLOAT, {target, addFloat(0.0)});
+      break;
+    case TypeKind::CHAR:
+      emit(RegOp::LOAD_CHAR, {target, 0});
+      break;
+    case TypeKind::BOOL:
+      emit(RegOp::LOAD_BOOL, {target, 0});
+      break;
+    case TypeKind::STRING:
+      emit(RegOp::LOAD_STRING, {target, addString("")});
+      break;
+    case TypeKind::ARRAY:
+      emit(RegOp::NEW_ARRAY, {target, static_cast<uint32_t>(valueKind(types_.get(type).element)), 0});
+      break;
+    default:
+      throw std::runtime_error("Code generation error: no value of type '" + types_.toString(type) + "'.");
+  }
+}
+
+
+uint32_t RegisterGenerator::newRegister(const std::string& name) {
+  ir_.names.push_back(name);
+  return ir_.virtualRegisters++;
+}
+
+uint32_t RegisterGenerator::newLabel() {
+  ir_.labels.push_back(UINT32_MAX);
+  return static_cast<uint32_t>(ir_.labels.size() - 1);
+}
+
+void RegisterGenerator::bind(const uint32_t label) {
+  ir_.labels[label] = static_cast<uint32_t>(ir_.instructions.size());
+}
+
+void RegisterGenerator::emit(const RegOp op, std::vector<uint32_t> operands) {
+  ir_.instructions.push_back({op, line_, std::move(operands)});
+}
+
+std::optional<RegOp> RegisterGenerator::conversion(const TypeId target, const TypeId source) {
+  if (target == source || !TypeTable::isScalar(target)) {
+    return std::nullopt;
+  }
+  switch (target) {
+    case TypeTable::INT:
+      return RegOp::TO_INT;
+    case TypeTable::FLOAT:
+      return RegOp::TO_FLOAT;
+    case TypeTable::CHAR:
+      return RegOp::TO_CHAR;
+    default:
+      return RegOp::TO_BOOL;
+  }
+}
+
+ValueKind RegisterGenerator::valueKind(const TypeId type) const {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      return ValueKind::INT;
+    case TypeKind::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeKind::CHAR:
+      return ValueKind::CHAR;
+    case TypeKind::BOOL:
+      return ValueKind::BOOL;
+    case TypeKind::STRING:
+      return ValueKind::STRING;
+    case TypeKind::ARRAY:
+      return ValueKind::ARRAY;
+    default:
+      return ValueKind::VOID;
+  }
+}
+
+uint32_t RegisterGenerator::globalIndex(const uint32_t binding) {
+  const auto [global, inserted] = globalByBinding_.try_emplace(binding, program_.globals);
+  if (inserted) {
+    ++program_.globals;
+    program_.globalNames.push_back(tid_.getInterner().getName(tid_.getRecord(binding).symbol));
+  }
+  return global->second;
+}
+
+uint32_t RegisterGenerator::addString(const std::string& value) {
+  const auto [entry, inserted] = stringIndex_.try_emplace(value, static_cast<uint32_t>(program_.strings.size()));
+  if (inserted) {
+    program_.strings.push_back(value);
+  }
+  return entry->second;
+}
+
+uint32_t RegisterGenerator::addFloat(const double value) {
+  uint64_t bits; // by bit pattern: 0.0 and -0.0 are different constants
+  std::memcpy(&bits, &value, sizeof(bits));
+  const auto [entry, inserted] = floatIndex_.try_emplace(bits, static_cast<uint32_t>(program_.floats.size()));
+  if (inserted) {
+    program_.floats.push_back(value);
+  }
+  return entry->second;
+}
@@ -1 +1,977 @@
-#include "../headers/rpn.h"
\ No newline at end of file
+#include "../headers/rpn.h"
+
+#include <bit>
+#include <numeric>
+
+
+RPNProgram RPNGenerator::generate(const ASTNodePtr& program) {
+  program_ = RPNProgram();
+  functionByBinding_.clear();
+  globalByBinding_.clear();
+  stringIndex_.clear();
+  floatIndex_.clear();
+
+  // every function's signature first, calls can precede definitions
+  std::vector<ASTNodePtr> functions;
+  ASTNodePtr main;
+  program_.functions.emplace_back();
+  program_.functions[0].name = "<top-level>";
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      continue;
+    }
+    const auto index = static_cast<uint32_t>(program_.functions.size());
+    functionByBinding_[declaration->getBinding()] = index;
+    functions.push_back(declaration);
+
+    RPNFunction& function = program_.functions.emplace_back();
+    function.name = declaration->getValue();
+    function.parameters = static_cast<uint32_t>(declaration->getChildren().size() - 1);
+    function.returnsValue = types_.get(declaration->getTypeId()).element != TypeTable::VOID;
+    if (function.name == "main" && function.parameters == 0) {
+      main = declaration;
+    }
+  }
+
+  compileEntry(program, main);
+  for (size_t i = 0; i < functions.size(); ++i) {
+    compileFunction(functions[i], static_cast<uint32_t>(i + 1));
+  }
+  return std::move(program_);
+}
+
+void RPNGenerator::compileEntry(const ASTNodePtr& program, const ASTNodePtr& main) {
+  beginFunction(0);
+
+  // globals hold their zero values even for functions that run before the declaration
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::VARIABLE_DECLARATION) {
+      line_ = declaration->getLine();
+      zeroValue(declaration->getTypeId());
+      store(declaration->getBinding());
+    }
+  }
+
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      statement(declaration);
+    }
+  }
+  if (main) {
+    line_ = main->getLine();
+    emit(OpCode::CALL, functionByBinding_.at(main->getBinding()));
+    if (program_.functions[functionByBinding_.at(main->getBinding())].returnsValue) {
+      emit(OpCode::POP);
+    }
+  }
+  emit(OpCode::HALT);
+  endFunction();
+}
+
+void RPNGenerator::compileFunction(const ASTNodePtr& function, const uint32_t index) {
+  beginFunction(index);
+  returnType_ = types_.get(function->getTypeId()).element;
+  line_ = function->getLine();
+  function_->localStrings = locals_ && locals_->strings.contains(function.get());
+
+  const auto& children = function->getChildren();
+  for (size_t i = 0; i + 1 < children.size(); ++i) { // arguments arrive in slots 0..n-1
+    declareLocal(children[i].get());
+  }
+  statement(children.back());
+
+  // falling off the end
+  if (returnType_ == TypeTable::VOID) {
+    emit(OpCode::RETURN_VOID);
+  } else {
+    emit(OpCode::TRAP, addString("function '" + function->getValue() + "' ended without returning a value"));
+  }
+  endFunction();
+}
+
+void RPNGenerator::beginFunction(const uint32_t index) {
+  function_ = &program_.functions[index];
+  function_->entry = static_cast<uint32_t>(program_.code.size());
+  returnType_ = TypeTable::VOID;
+  slotByBinding_.clear();
+  slotByValue_.clear();
+  nextSlot_ = 0;
+  stackDepth_ = 0;
+}
+
+void RPNGenerator::endFunction() {
+  function_->end = static_cast<uint32_t>(program_.code.size());
+  function_ = nullptr;
+}
+
+
+void RPNGenerator::statement(const ASTNodePtr& node) {
+  line_ = node->getLine();
+  switch (node->getType()) {
+    case ASTNodeType::BLOCK: {
+      const uint32_t slots = nextSlot_; // the block's locals go out of scope at its end
+      for (const auto& instruction : node->getChildren()) {
+        statement(instruction);
+      }
+      nextSlot_ = slots;
+      break;
+    }
+    case ASTNodeType::VARIABLE_DECLARATION:
+      declaration(node);
+      break;
+    case ASTNodeType::ASSIGNMENT:
+      assignment(node);
+      break;
+    case ASTNodeType::IF_STATEMENT: {
+      const auto& children = node->getChildren();
+      Label otherwise, end;
+      condition(children[0], otherwise, false);
+      statement(children[1]);
+      if (children.size() > 2) {
+        emitJump(OpCode::JUMP, end);
+        bind(otherwise);
+        statement(children[2]);
+      } else {
+        bind(otherwise);
+      }
+      bind(end);
+      break;
+    }
+    case ASTNodeType::LOOP_STATEMENT:
+      loop(node);
+      break;
+    case ASTNodeType::SWITCH:
+      switchStatement(node);
+      break;
+    case ASTNodeType::RETURN_STATEMENT:
+      if (node->getChildren().empty()) {
+        emit(OpCode::RETURN_VOID);
+      } else {
+        expression(node->getChild(0));
+        convert(returnType_, node->getChild(0)->getTypeId());
+        emit(OpCode::RETURN);
+      }
+      break;
+    case ASTNodeType::INPUT:
+      for (const auto& target : node->getChildren()) {
+        emit(OpCode::READ, static_cast<uint32_t>(valueKind(target->getTypeId())));
+        store(target->getBinding());
+      }
+      break;
+    case ASTNodeType::OUTPUT:
+      for (const auto& value : node->getChildren()) {
+        expression(value);
+        emit(OpCode::PRINT);
+      }
+      break;
+    case ASTNodeType::BREAK:
+      emitJump(OpCode::JUMP, *breakLabels_.back());
+      break;
+    case ASTNodeType::CONTINUE:
+      emitJump(OpCode::JUMP, *continueLabels_.back());
+      break;
+    default: // expression statement, its value is dropped
+      expression(node);
+      if (node->getTypeId() != TypeTable::VOID) {
+        emit(OpCode::POP);
+      }
+      break;
+  }
+}
+
+void RPNGenerator::declaration(const ASTNodePtr& node) {
+  const TypeId type = node->getTypeId();
+  const auto& children = node->getChildren();
+  const uint32_t local = locals_ && locals_->arrays.contains(node.get()) ? LOCAL_ARRAY : 0;
+
+  if (children[0]) {
+    expression(children[0]);
+    convert(type, children[0]->getTypeId());
+  } else if (children.size() > 1) { // sized array
+    for (size_t i = 1; i < children.size(); ++i) {
+      expression(children[i]);
+    }
+    const auto dimensions = static_cast<uint32_t>(children.size() - 1);
+    const ValueKind leaf = dimensions < types_.rank(type) ? ValueKind::ARRAY : valueKind(types_.scalar(type));
+    emit(OpCode::NEW_ARRAY, dimensions, static_cast<uint32_t>(leaf) | local);
+  } else if (local) {
+    emit(OpCode::NEW_ARRAY, 0, static_cast<uint32_t>(valueKind(types_.get(type).element)) | local);
+  } else {
+    zeroValue(type); // slots are reused, a fresh variable must not see an old value
+  }
+
+  // the initializer cannot see the variable, so the slot is taken only now
+  if (tid_.getRecord(node->getBinding()).scope != GLOBAL_SCOPE) {
+    declareLocal(node.get());
+  }
+  store(node->getBinding());
+}
+
+void RPNGenerator::assignment(const ASTNodePtr& node) {
+  const ASTNodePtr& target = node->getChild(0);
+  const ASTNodePtr& value = node->getChild(1);
+
+  if (target->getType() == ASTNodeType::IDENTIFIER) {
+    expression(value);
+    convert(target->getTypeId(), value->getTypeId());
+    store(target->getBinding());
+    return;
+  }
+
+  // element store: the array and indices first, then the value
+  element(target, &value);
+}
+
+void RPNGenerator::loop(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const uint32_t slots = nextSlot_; // the counter of `for` lives only inside the loop
+  Label test, next, end;
+
+  if (node->getTokenType() == my::TokenType::WHILE) {
+    bind(test);
+    condition(children[0], end, false);
+    breakLabels_.push_back(&end);
+    continueLabels_.push_back(&test);
+    statement(children[1]);
+    emitJump(OpCode::JUMP, test);
+  } else {
+    statement(children[0]);
+    bind(test);
+    line_ = node->getLine();
+    condition(children[1], end, false);
+    breakLabels_.push_back(&end);
+    continueLabels_.push_back(&next);
+    statement(children[3]);
+    bind(next); // `continue` runs the step
+    statement(children[2]);
+    emitJump(OpCode::JUMP, test);
+  }
+  breakLabels_.pop_back();
+  continueLabels_.pop_back();
+  bind(end);
+  nextSlot_ = slots;
+}
+
+// A switch of at least MIN_LOWERED_CASES literal labels is dispatched by its labels' shape:
+//   - ints or chars with at least half of the values from the lowest to the highest:
+//     SWITCH_TABLE, one entry per value;
+//   - other ints or chars: a balanced tree of `<` comparisons, O(log n) per dispatch;
+//   - strings: SWITCH_STRING, a perfect hash of the labels and one string comparison.
+// Fewer labels (or the lowering off) are compared with the subject in source order. A
+// value labelled twice (7 and 007) goes to its first arm either way.
+void RPNGenerator::switchStatement(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const uint32_t slots = nextSlot_;
+  const TypeId type = children[0]->getTypeId();
+
+  std::vector<Label> arms(children.size() - 1);
+  Label end;
+  Label* fallback = &end;
+  std::vector<SwitchCase> cases;
+  std::unordered_set<int64_t> values;
+  bool literals = true;
+  for (size_t i = 1; i < children.size(); ++i) {
+    const ASTNodePtr& arm = children[i];
+    if (arm->getTokenType() != my::TokenType::CASE) {
+      fallback = &arms[i - 1];
+      continue;
+    }
+    const ASTNodePtr& label = arm->getChild(0);
+    int64_t value;
+    switch (label->getType() == ASTNodeType::LITERAL ? label->getTokenType() : my::TokenType::UNKNOWN) {
+      case my::TokenType::INTEGER_LITERAL:
+        value = decodeIntegerLiteral(label->getValue());
+        break;
+      case my::TokenType::CHAR_LITERAL:
+        value = decodeCharLiteral(label->getValue());
+        break;
+      case my::TokenType::STRING_LITERAL:
+        value = addString(decodeStringLiteral(label->getValue()));
+        break;
+      default:
+        literals = false;
+        continue;
+    }
+    if (values.insert(value).second) {
+      cases.push_back({value, i - 1});
+    }
+  }
+
+  line_ = node->getLine();
+  expression(children[0]);
+  std::optional<uint32_t> table;
+  if (!switchLowering_ || !literals || cases.size() < MIN_LOWERED_CASES) {
+    // the subject is evaluated once into a hidden slot, then compared with each label
+    const uint32_t subject = allocateSlot("<switch>");
+    emit(OpCode::STORE_LOCAL, subject);
+    for (size_t i = 1; i < children.size(); ++i) {
+      const ASTNodePtr& arm = children[i];
+      if (arm->getTokenType() != my::TokenType::CASE) {
+        continue;
+      }
+      line_ = arm->getLine();
+      emit(OpCode::LOAD_LOCAL, subject);
+      expression(arm->getChild(0));
+      emit(OpCode::EQ);
+      emitJump(OpCode::JUMP_IF_TRUE, arms[i - 1]);
+    }
+    emitJump(OpCode::JUMP, *fallback);
+  } else if (types_.kind(type) == TypeKind::STRING) {
+    table = static_cast<uint32_t>(program_.switches.size());
+    perfectHash(program_.switches.emplace_back(), cases);
+    emit(OpCode::SWITCH_STRING, *table);
+  } else {
+    convert(TypeTable::INT, type); // a char is compared by its code
+    std::sort(cases.begin(), cases.end(), [](const SwitchCase& a, const SwitchCase& b) { return a.value < b.value; });
+    const int64_t low = cases.front().value;
+    const int64_t high = cases.back().value;
+    if (low >= INT32_MIN && high <= INT32_MAX && high - low < 2 * static_cast<int64_t>(cases.size())) {
+      table = static_cast<uint32_t>(program_.switches.size());
+      program_.switches.emplace_back().low = low;
+      program_.switches.back().targets.resize(static_cast<size_t>(high - low + 1));
+      emit(OpCode::SWITCH_TABLE, *table);
+    } else {
+      const uint32_t subject = allocateSlot("<switch>");
+      emit(OpCode::STORE_LOCAL, subject);
+      switchTree(subject, cases, 0, cases.size(), arms, *fallback);
+    }
+  }
+
+  // the arms in source order, each one ends with the `break` the parser consumed
+  breakLabels_.push_back(&end);
+  for (size_t i = 1; i < children.size(); ++i) {
+    const auto& instructions = children[i]->getChildren();
+    bind(arms[i - 1]);
+    line_ = children[i]->getLine();
+    const size_t first = children[i]->getTokenType() == my::TokenType::CASE ? 1 : 0;
+    for (size_t j = first; j < instructions.size(); ++j) {
+      statement(instructions[j]);
+    }
+    if (i + 1 < children.size()) {
+      emitJump(OpCode::JUMP, end);
+    }
+  }
+  breakLabels_.pop_back();
+  bind(end);
+  nextSlot_ = slots;
+
+  if (table) { // every arm is bound now
+    SwitchTable& dispatch = program_.switches[*table];
+    dispatch.fallback = fallback->offset;
+    if (dispatch.labels.empty()) {
+      std::fill(dispatch.targets.begin(), dispatch.targets.end(), fallback->offset);
+      for (const SwitchCase& label : cases) {
+        dispatch.targets[static_cast<size_t>(label.value - dispatch.low)] = arms[label.arm].offset;
+      }
+    } else {
+      std::unordered_map<int64_t, size_t> armByString;
+      for (const SwitchCase& label : cases) {
+        armByString.emplace(label.value, label.arm);
+      }
+      for (size_t slot = 0; slot < dispatch.targets.size(); ++slot) {
+        dispatch.targets[slot] = dispatch.labels[slot] == SwitchTable::EMPTY ? fallback->offset :
+          arms[armByString.at(dispatch.labels[slot])].offset;
+      }
+    }
+  }
+}
+
+void RPNGenerator::switchTree(const uint32_t subject, const std::vector<SwitchCase>& cases, const size_t first,
+  const size_t last, std::vector<Label>& arms, Label& fallback) {
+  if (last - first <= TREE_LEAF_CASES) {
+    for (size_t i = first; i < last; ++i) {
+      emit(OpCode::LOAD_LOCAL, subject);
+      pushInteger(cases[i].value);
+      emit(OpCode::EQ_I64);
+      emitJump(OpCode::JUMP_IF_TRUE, arms[cases[i].arm]);
+    }
+    emitJump(OpCode::JUMP, fallback);
+    return;
+  }
+  const size_t middle = first + (last - first) / 2;
+  Label upper;
+  emit(OpCode::LOAD_LOCAL, subject);
+  pushInteger(cases[middle].value);
+  emit(OpCode::LT_I64);
+  emitJump(OpCode::JUMP_IF_FALSE, upper);
+  switchTree(subject, cases, first, middle, arms, fallback);
+  bind(upper);
+  switchTree(subject, cases, middle, last, arms, fallback);
+}
+
+void RPNGenerator::perfectHash(SwitchTable& table, const std::vector<SwitchCase>& cases) const {
+  // buckets of about four labels by switchHash(0, s), placed largest first, each with the
+  // first seed that sends all of its labels to free slots; at most 3/4 of the slots are used
+  const auto text = [&](const SwitchCase& label) -> const std::string& {
+    return program_.strings[static_cast<size_t>(label.value)];
+  };
+  std::vector<std::vector<size_t>> buckets((cases.size() + 3) / 4);
+  for (size_t i = 0; i < cases.size(); ++i) {
+    buckets[switchHash(0, text(cases[i])) % buckets.size()].push_back(i);
+  }
+  std::vector<size_t> order(buckets.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+    [&](const size_t a, const size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+  std::vector<size_t> candidates;
+  for (size_t slots = std::bit_ceil(cases.size() * 4 / 3 + 1);; slots *= 2) {
+    table.seeds.assign(buckets.size(), 0);
+    table.labels.assign(slots, SwitchTable::EMPTY);
+    bool placed = true;
+    for (const size_t bucket : order) {
+      if (buckets[bucket].empty()) {
+        break; // so are the rest
+      }
+      uint32_t seed = 1;
+      for (; seed <= MAX_HASH_SEED; ++seed) {
+        candidates.clear();
+        for (const size_t i : buckets[bucket]) {
+          const size_t slot = switchHash(seed, text(cases[i])) & (slots - 1);
+          if (table.labels[slot] != SwitchTable::EMPTY ||
+            std::find(candidates.begin(), candidates.end(), slot) != candidates.end()) {
+            break;
+          }
+          candidates.push_back(slot);
+        }
+        if (candidates.size() == buckets[bucket].size()) {
+          break;
+        }
+      }
+      if (seed > MAX_HASH_SEED) {
+        placed = false;
+        break;
+      }
+      table.seeds[bucket] = seed;
+      for (size_t j = 0; j < candidates.size(); ++j) {
+        table.labels[candidates[j]] = static_cast<uint32_t>(cases[buckets[bucket][j]].value);
+      }
+    }
+    if (placed) {
+      table.targets.resize(slots);
+      return;
+    }
+  }
+}
+
+
+void RPNGenerator::condition(const ASTNodePtr& node, Label& target, const bool when) {
+  const my::TokenType op = node->getType() == ASTNodeType::EXPRESSION ? node->getTokenType() : my::TokenType::UNKNOWN;
+  const auto& children = node->getChildren();
+  if (op == my::TokenType::NOT && children.size() == 1) {
+    condition(children[0], target, !when);
+  } else if (op == my::TokenType::AND || op == my::TokenType::OR) {
+    // a && b is false as soon as a is, a || b true as soon as a is
+    if ((op == my::TokenType::AND) != when) {
+      condition(children[0], target, when);
+      condition(children[1], target, when);
+    } else {
+      Label decided;
+      condition(children[0], decided, !when);
+      condition(children[1], target, when);
+      bind(decided);
+    }
+  } else {
+    expression(node);
+    convert(TypeTable::BOOL, node->getTypeId());
+    emitJump(when ? OpCode::JUMP_IF_TRUE : OpCode::JUMP_IF_FALSE, target);
+  }
+}
+
+void RPNGenerator::expression(const ASTNodePtr& node) {
+  if (!shared_ || !shared_->contains(node.get())) {
+    computeExpression(node);
+    return;
+  }
+  const auto [value, first] = shared_->at(node.get());
+  if (const auto slot = slotByValue_.find(value); !first && slot != slotByValue_.end()) {
+    emit(OpCode::LOAD_LOCAL, slot->second);
+    return;
+  }
+  computeExpression(node);
+  if (first) { // the slot lives until the end of the block, like the basic block itself
+    const uint32_t slot = allocateSlot("<cse>");
+    emit(OpCode::DUP);
+    emit(OpCode::STORE_LOCAL, slot);
+    slotByValue_[value] = slot;
+  }
+}
+
+void RPNGenerator::computeExpression(const ASTNodePtr& node) {
+  switch (node->getType()) {
+    case ASTNodeType::LITERAL:
+      literal(node);
+      break;
+    case ASTNodeType::IDENTIFIER:
+      load(node->getBinding());
+      break;
+    case ASTNodeType::INDEX:
+      element(node);
+      break;
+    case ASTNodeType::CALL:
+      call(node);
+      break;
+    case ASTNodeType::EXPRESSION:
+      operatorExpression(node);
+      break;
+    default:
+      throw std::runtime_error("Code generation error: instruction used as an expression.");
+  }
+}
+
+void RPNGenerator::operatorExpression(const ASTNodePtr& node) {
+  const auto& children = node->getChildren();
+  const my::TokenType op = node->getTokenType();
+
+  if (children.size() == 1) {
+    expression(children[0]);
+    if (op == my::TokenType::NOT) {
+      emit(OpCode::NOT);
+    } else {
+      const TypeId type = children[0]->getTypeId();
+      emit(type == TypeTable::INT ? OpCode::NEG_I64 : type == TypeTable::FLOAT ? OpCode::NEG_F64 : OpCode::NEG);
+    }
+    return;
+  }
+
+  switch (op) {
+    case my::TokenType::COMMA:
+      expression(children[0]);
+      if (children[0]->getTypeId() != TypeTable::VOID) {
+        emit(OpCode::POP);
+      }
+      expression(children[1]);
+      return;
+    case my::TokenType::AND:
+    case my::TokenType::OR: {
+      // the left operand decides alone when it is false (&&) or true (||)
+      Label end;
+      expression(children[0]);
+      convert(TypeTable::BOOL, children[0]->getTypeId());
+      emit(OpCode::DUP);
+      emitJump(op == my::TokenType::AND ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE, end);
+      emit(OpCode::POP);
+      expression(children[1]);
+      convert(TypeTable::BOOL, children[1]->getTypeId());
+      bind(end);
+      return;
+    }
+    default:
+      break;
+  }
+
+  // typed opcodes where the operand types allow them: two ints, or a float with a float
+  // or an int (converted first); chars, bools and strings are left to the generic ones
+  const TypeId left = children[0]->getTypeId();
+  const TypeId right = children[1]->getTypeId();
+  const bool integers = left == TypeTable::INT && right == TypeTable::INT;
+  const bool floats = !integers && (left == TypeTable::INT || left == TypeTable::FLOAT) &&
+    (right == TypeTable::INT || right == TypeTable::FLOAT);
+  if (floats) {
+    floatOperand(children[0]);
+    floatOperand(children[1]);
+  } else {
+    expression(children[0]);
+    expression(children[1]);
+  }
+  const auto pick = [&](const OpCode generic, const OpCode i64, const OpCode f64) {
+    emit(integers ? i64 : floats ? f64 : generic);
+  };
+  switch (op) {
+    case my::TokenType::PLUS:
+      pick(OpCode::ADD, OpCode::ADD_I64, OpCode::ADD_F64);
+      break;
+    case my::TokenType::MINUS:
+      pick(OpCode::SUB, OpCode::SUB_I64, OpCode::SUB_F64);
+      break;
+    case my::TokenType::MUL:
+      pick(OpCode::MUL, OpCode::MUL_I64, OpCode::MUL_F64);
+      break;
+    case my::TokenType::DIV:
+      pick(OpCode::DIV, OpCode::DIV_I64, OpCode::DIV_F64);
+      break;
+    case my::TokenType::LT:
+      pick(OpCode::LT, OpCode::LT_I64, OpCode::LT_F64);
+      break;
+    case my::TokenType::GT:
+      pick(OpCode::GT, OpCode::GT_I64, OpCode::GT_F64);
+      break;
+    case my::TokenType::EQ:
+      pick(OpCode::EQ, OpCode::EQ_I64, OpCode::EQ_F64);
+      break;
+    case my::TokenType::NEQ:
+      pick(OpCode::NEQ, OpCode::NEQ_I64, OpCode::NEQ_F64);
+      break;
+    default:
+      throw std::runtime_error("Code generation error: unknown operator " + node->getValue() + ".");
+  }
+}
+
+// Whether evaluating an expression can neither fail nor have an effect
+static bool isPlain(const ASTNode& node) {
+  switch (node.getType()) {
+    case ASTNodeType::LITERAL:
+    case ASTNodeType::IDENTIFIER:
+      return true;
+    case ASTNodeType::EXPRESSION:
+      if (node.getTokenType() == my::TokenType::DIV && node.getTypeId() != TypeTable::FLOAT) {
+        return false; // integer division by zero
+      }
+      return std::ranges::all_of(node.getChildren(), [](const ASTNodePtr& child) { return isPlain(*child); });
+    default: // calls, element loads
+      return false;
+  }
+}
+
+void RPNGenerator::element(const ASTNodePtr& node, const ASTNodePtr* value) {
+  std::vector<const ASTNodePtr*> indices;
+  std::vector<bool> inBounds;
+  const ASTNodePtr* array = &node;
+  while ((*array)->getType() == ASTNodeType::INDEX) {
+    indices.push_back(&(*array)->getChild(1));
+    inBounds.push_back(inBounds_ && inBounds_->contains(array->get()));
+    array = &(*array)->getChild(0);
+  }
+  std::reverse(indices.begin(), indices.end());
+  std::reverse(inBounds.begin(), inBounds.end());
+
+  // a group of indices starts at every index that must be checked before it is evaluated
+  std::vector<bool> starts(indices.size());
+  starts[0] = true;
+  for (size_t i = 1; i < indices.size(); ++i) {
+    starts[i] = !isPlain(**indices[i]);
+  }
+  if (value) {
+    const TypeId target = node->getTypeId();
+    const bool narrowing = (target == TypeTable::INT || target == TypeTable::CHAR) &&
+      (*value)->getTypeId() == TypeTable::FLOAT; // fails on floats out of range
+    starts.back() = starts.back() || narrowing || !isPlain(**value);
+  }
+
+  expression(*array);
+  for (size_t first = 0; first < indices.size();) {
+    size_t end = first + 1;
+    while (end < indices.size() && !starts[end]) {
+      ++end;
+    }
+    for (size_t i = first; i < end; ++i) {
+      expression(*indices[i]);
+    }
+    const auto count = static_cast<uint32_t>(end - first);
+    const bool checked = !std::all_of(inBounds.begin() + static_cast<ptrdiff_t>(first),
+      inBounds.begin() + static_cast<ptrdiff_t>(end), [](const bool proven) { return proven; });
+    if (value && end == indices.size()) {
+      expression(*value);
+      convert(node->getTypeId(), (*value)->getTypeId());
+      if (count == 1) {
+        emit(checked ? OpCode::STORE_INDEX : OpCode::STORE_INDEX_UNCHECKED);
+      } else {
+        emit(checked ? OpCode::STORE_ELEMENT : OpCode::STORE_ELEMENT_UNCHECKED, count);
+      }
+    } else if (count == 1) {
+      emit(checked ? OpCode::LOAD_INDEX : OpCode::LOAD_INDEX_UNCHECKED);
+    } else {
+      emit(checked ? OpCode::LOAD_ELEMENT : OpCode::LOAD_ELEMENT_UNCHECKED, count);
+    }
+    first = end;
+  }
+}
+
+void RPNGenerator::floatOperand(const ASTNodePtr& node) {
+  if (node->getTypeId() == TypeTable::FLOAT) {
+    expression(node);
+  } else if (node->getType() == ASTNodeType::LITERAL) { // an int constant is converted now
+    emit(OpCode::PUSH_FLOAT, addFloat(static_cast<double>(decodeIntegerLiteral(node->getValue()))));
+  } else {
+    expression(node);
+    emit(OpCode::I64_TO_F64);
+  }
+}
+
+void RPNGenerator::literal(const ASTNodePtr& node) {
+  const std::string& lexeme = node->getValue();
+  switch (node->getTokenType()) {
+    case my::TokenType::INTEGER_LITERAL:
+      pushInteger(decodeIntegerLiteral(lexeme));
+      break;
+    case my::TokenType::FLOAT_LITERAL:
+      emit(OpCode::PUSH_FLOAT, addFloat(decodeFloatLiteral(lexeme)));
+      break;
+    case my::TokenType::CHAR_LITERAL:
+      emit(OpCode::PUSH_CHAR, static_cast<uint8_t>(decodeCharLiteral(lexeme)));
+      break;
+    case my::TokenType::STRING_LITERAL:
+      emit(OpCode::PUSH_STRING, addString(decodeStringLiteral(lexeme)));
+      break;
+    default: // true / false
+      emit(OpCode::PUSH_BOOL, lexeme == "true" ? 1 : 0);
+      break;
+  }
+}
+
+void RPNGenerator::pushInteger(const int64_t value) {
+  if (value >= INT32_MIN && value <= INT32_MAX) {
+    emit(OpCode::PUSH_INT, static_cast<uint32_t>(static_cast<int32_t>(value)));
+  } else {
+    program_.integers.push_back(value);
+    emit(OpCode::PUSH_LONG, static_cast<uint32_t>(program_.integers.size() - 1));
+  }
+}
+
+void RPNGenerator::call(const ASTNodePtr& node) {
+  const TypeInfo& signature = types_.get(tid_.getRecord(node->getBinding()).type);
+  const auto& arguments = node->getChildren();
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    expression(arguments[i]);
+    convert(signature.parameters[i], arguments[i]->getTypeId());
+  }
+  emit(OpCode::CALL, functionByBinding_.at(node->getBinding()));
+}
+
+
+void RPNGenerator::zeroValue(const TypeId type) {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      emit(OpCode::PUSH_INT, 0);
+      break;
+    case TypeKind::FLOAT:
+      emit(OpCode::PUSH_FLOAT, addFloat(0.0));
+      break;
+    case TypeKind::CHAR:
+      emit(OpCode::PUSH_CHAR, 0);
+      break;
+    case TypeKind::BOOL:
+      emit(OpCode::PUSH_BOOL, 0);
+      break;
+    case TypeKind::STRING:
+      emit(OpCode::PUSH_STRING, addString(""));
+      break;
+    case TypeKind::ARRAY:
+      emit(OpCode::NEW_ARRAY, 0, static_cast<uint32_t>(valueKind(types_.get(type).element)));
+      break;
+    default:
+      throw std::runtime_error("Code generation error: no value of type '" + types_.toString(type) + "'.");
+  }
+}
+
+void RPNGenerator::convert(const TypeId target, const TypeId source) {
+  if (target == source || !TypeTable::isScalar(target)) {
+    return;
+  }
+  switch (target) {
+    case TypeTable::INT:
+      emit(OpCode::TO_INT);
+      break;
+    case TypeTable::FLOAT:
+      emit(source == TypeTable::INT ? OpCode::I64_TO_F64 : OpCode::TO_FLOAT);
+      break;
+    case TypeTable::CHAR:
+      emit(OpCode::TO_CHAR);
+      break;
+    default:
+      emit(OpCode::TO_BOOL);
+      break;
+  }
+}
+
+void RPNGenerator::load(const uint32_t binding) {
+  if (const auto local = slotByBinding_.find(binding); local != slotByBinding_.end()) {
+    emit(OpCode::LOAD_LOCAL, local->second);
+  } else {
+    emit(OpCode::LOAD_GLOBAL, globalIndex(binding, tid_.getInterner().getName(tid_.getRecord(binding).symbol)));
+  }
+}
+
+void RPNGenerator::store(const uint32_t binding) {
+  if (const auto local = slotByBinding_.find(binding); local != slotByBinding_.end()) {
+    emit(OpCode::STORE_LOCAL, local->second);
+  } else {
+    emit(OpCode::STORE_GLOBAL, globalIndex(binding, tid_.getInterner().getName(tid_.getRecord(binding).symbol)));
+  }
+}
+
+uint32_t RPNGenerator::declareLocal(const ASTNode* declaration) {
+  const uint32_t slot = allocateSlot(declaration->getValue());
+  slotByBinding_[declaration->getBinding()] = slot; // shadowed names have their own records
+  return slot;
+}
+
+uint32_t RPNGenerator::allocateSlot(const std::string& name) {
+  const uint32_t slot = nextSlot_++;
+  if (function_->slots < nextSlot_) {
+    function_->slots = nextSlot_;
+    function_->slotNames.resize(nextSlot_);
+  }
+  std::string& names = function_->slotNames[slot];
+  if (names.empty()) {
+    names = name;
+  } else if (names != name && !names.ends_with("/" + name)) {
+    names += "/" + name;
+  }
+  return slot;
+}
+
+uint32_t RPNGenerator::globalIndex(const uint32_t binding, const std::string& name) {
+  const auto [global, inserted] = globalByBinding_.try_emplace(binding, program_.globals);
+  if (inserted) {
+    ++program_.globals;
+    program_.globalNames.push_back(name);
+  }
+  return global->second;
+}
+
+ValueKind RPNGenerator::valueKind(const TypeId type) const {
+  switch (types_.kind(type)) {
+    case TypeKind::INT:
+      return ValueKind::INT;
+    case TypeKind::FLOAT:
+      return ValueKind::FLOAT;
+    case TypeKind::CHAR:
+      return ValueKind::CHAR;
+    case TypeKind::BOOL:
+      return ValueKind::BOOL;
+    case TypeKind::STRING:
+      return ValueKind::STRING;
+    case TypeKind::ARRAY:
+      return ValueKind::ARRAY;
+    default:
+      return ValueKind::VOID;
+  }
+}
+
+
+// Operand stack change of one instruction
+void RPNGenerator::emit(const OpCode op) {
+  switch (op) {
+    case OpCode::DUP:
+      adjustStack(1);
+      break;
+    case OpCode::POP:
+    case OpCode::LOAD_INDEX:
+    case OpCode::LOAD_INDEX_UNCHECKED:
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+    case OpCode::DIV:
+    case OpCode::LT:
+    case OpCode::GT:
+    case OpCode::EQ:
+    case OpCode::NEQ:
+    case OpCode::ADD_I64:
+    case OpCode::SUB_I64:
+    case OpCode::MUL_I64:
+    case OpCode::DIV_I64:
+    case OpCode::LT_I64:
+    case OpCode::GT_I64:
+    case OpCode::EQ_I64:
+    case OpCode::NEQ_I64:
+    case OpCode::ADD_F64:
+    case OpCode::SUB_F64:
+    case OpCode::MUL_F64:
+    case OpCode::DIV_F64:
+    case OpCode::LT_F64:
+    case OpCode::GT_F64:
+    case OpCode::EQ_F64:
+    case OpCode::NEQ_F64:
+    case OpCode::RETURN:
+    case OpCode::PRINT:
+      adjustStack(-1);
+      break;
+    case OpCode::STORE_INDEX:
+    case OpCode::STORE_INDEX_UNCHECKED:
+      adjustStack(-3);
+      break;
+    default: // NOP, NEG*, NOT, TO_*, I64_TO_F64, RETURN_VOID, HALT
+      break;
+  }
+
+  if (program_.lines.empty() || program_.lines.back().second != line_) {
+    program_.lines.emplace_back(static_cast<uint32_t>(program_.code.size()), line_);
+  }
+  program_.code.push_back(static_cast<uint8_t>(op));
+}
+
+void RPNGenerator::emit(const OpCode op, const uint32_t operand) {
+  switch (op) {
+    case OpCode::STORE_LOCAL:
+    case OpCode::STORE_GLOBAL:
+    case OpCode::JUMP_IF_FALSE:
+    case OpCode::JUMP_IF_TRUE:
+    case OpCode::SWITCH_TABLE:
+    case OpCode::SWITCH_STRING:
+      adjustStack(-1);
+      break;
+    case OpCode::CALL: {
+      const RPNFunction& callee = program_.functions[operand];
+      adjustStack((callee.returnsValue ? 1 : 0) - static_cast<int>(callee.parameters));
+      break;
+    }
+    case OpCode::LOAD_ELEMENT:
+    case OpCode::LOAD_ELEMENT_UNCHECKED:
+      adjustStack(-static_cast<int>(operand));
+      break;
+    case OpCode::STORE_ELEMENT:
+    case OpCode::STORE_ELEMENT_UNCHECKED:
+      adjustStack(-static_cast<int>(operand) - 2);
+      break;
+    case OpCode::JUMP:
+    case OpCode::TRAP:
+      break;
+    default: // pushes and loads, READ
+      adjustStack(1);
+      break;
+  }
+
+  emit(OpCode::NOP); // records the line, the opcode is overwritten
+  program_.code.back() = static_cast<uint8_t>(op);
+  program_.code.resize(program_.code.size() + sizeof(uint32_t));
+  writeOperand(&program_.code[program_.code.size() - sizeof(uint32_t)], operand);
+}
+
+void RPNGenerator::emit(const OpCode op, const uint32_t first, const uint32_t second) {
+  // the only two-operand instruction is NEW_ARRAY: pops the sizes, pushes the array
+  adjustStack(1 - static_cast<int>(first));
+  emit(OpCode::NOP);
+  program_.code.back() = static_cast<uint8_t>(op);
+  program_.code.resize(program_.code.size() + 2 * sizeof(uint32_t));
+  writeOperand(&program_.code[program_.code.size() - 2 * sizeof(uint32_t)], first);
+  writeOperand(&program_.code[program_.code.size() - sizeof(uint32_t)], second);
+}
+
+void RPNGenerator::emitJump(const OpCode op, Label& label) {
+  emit(op, label.offset);
+  if (label.offset == UNBOUND) {
+    label.patches.push_back(static_cast<uint32_t>(program_.code.size() - sizeof(uint32_t)));
+  }
+}
+
+void RPNGenerator::bind(Label& label) {
+  label.offset = static_cast<uint32_t>(program_.code.size());
+  for (const uint32_t patch : label.patches) {
+    writeOperand(&program_.code[patch], label.offset);
+  }
+  label.patches.clear();
+}
+
+void RPNGenerator::adjustStack(const int delta) {
+  stackDepth_ = static_cast<uint32_t>(static_cast<int>(stackDepth_) + delta);
+  function_->maxStack = std::max(function_->maxStack, stackDepth_);
+}
+
+uint32_t RPNGenerator::addString(const std::string& value) {
+  const auto [entry, inserted] = stringIndex_.try_emplace(value, static_cast<uint32_t>(program_.strings.size()));
+  if (inserted) {
+    program_.strings.push_back(value);
+  }
+  return entry->second;
+}
+
+uint32_t RPNGenerator::addFloat(const double value) {
+  uint64_t bits; // by bit pattern: 0.0 and -0.0 are different constants
+  std::memcpy(&bits, &value, sizeof(bits));
+  const auto [entry, inserted] = floatIndex_.try_emplace(bits, static_cast<uint32_t>(program_.floats.size()));
+  if (inserted) {
+    program_.floats.push_back(value);
+  }
+  return entry->second;
+}
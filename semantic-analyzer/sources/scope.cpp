@@ -0,0 +1,54 @@
+#include "../headers/scope.h"
+
+
+uint32_t FlatSymbolTable::find(const SymbolId symbol) const {
+  if (slots_.empty()) {
+    return NOT_FOUND;
+  }
+
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash(symbol) & mask;; i = (i + 1) & mask) {
+    if (slots_[i].key == symbol) {
+      return slots_[i].value;
+    }
+    if (slots_[i].key == INVALID_SYMBOL) {
+      return NOT_FOUND;
+    }
+  }
+}
+
+bool FlatSymbolTable::insert(const SymbolId symbol, const uint32_t value) {
+  // keep load factor <= 1/2 so probe sequences stay short
+  if ((size_ + 1) * 2 > slots_.size()) {
+    grow();
+  }
+
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash(symbol) & mask;; i = (i + 1) & mask) {
+    if (slots_[i].key == symbol) {
+      return false;
+    }
+    if (slots_[i].key == INVALID_SYMBOL) {
+      slots_[i] = {symbol, value};
+      ++size_;
+      return true;
+    }
+  }
+}
+
+void FlatSymbolTable::grow() {
+  std::vector<Slot> old = std::move(slots_);
+  slots_.assign(old.empty() ? 8 : old.size() * 2, Slot{});
+
+  const size_t mask = slots_.size() - 1;
+  for (const auto& slot : old) {
+    if (slot.key == INVALID_SYMBOL) {
+      continue;
+    }
+    size_t i = hash(slot.key) & mask;
+    while (slots_[i].key != INVALID_SYMBOL) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = slot;
+  }
+}
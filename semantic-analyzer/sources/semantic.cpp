@@ -1,69 +1,113 @@
 #include "../headers/semantic.h"
 
+#include <atomic>
 
-std::string identifierTypeToString(const IdentifierType& type) {
-  switch (type) {
-    case IdentifierType::BOOL:
-      return "bool";
-    case IdentifierType::INT:
-      return "int";
-    case IdentifierType::CHAR:
-      return "char";
-    case IdentifierType::VOID:
-      return "void";
-    case IdentifierType::ARRAY:
-      return "array";
-    case IdentifierType::FLOAT:
-      return "float";
-    case IdentifierType::STRING:
-      return "string";
-    case IdentifierType::FUNCTION:
-      return "function";
-    case IdentifierType::UNKNOWN:
-      return "unknown";
-    default:
-      throw std::runtime_error("Syntax-semantic error: invalid identifier type");
+
+// Result of analysing one function body on its own table
+struct FunctionTask {
+  explicit FunctionTask(const TID* global) : table(global) {}
+
+  TID table;
+  std::vector<Diagnostic> diagnostics;
+  std::string trace;
+  std::optional<std::string> error;
+};
+
+
+void SemanticAnalyzer::analyze(const ASTNodePtr& program) {
+  // phase 1: the global scope
+  std::vector<ASTNodePtr> functions;
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() == ASTNodeType::FUNCTION) {
+      declareSignature(declaration);
+      functions.push_back(declaration);
+    }
   }
-}
 
-void SemanticAnalyzer::enterScope(const std::string& scopeName) {
-  currentScope = scopeName;
-}
+  FunctionAnalyzer topLevel(tid, types, verbose_);
+  for (const auto& declaration : program->getChildren()) {
+    if (declaration->getType() != ASTNodeType::FUNCTION) {
+      topLevel.analyzeInstruction(declaration);
+    }
+  }
+  std::cout << topLevel.getTrace();
 
-void SemanticAnalyzer::exitScope() {
-  currentScope = "global"; // По умолчанию возвращаемся в глобальную область
-}
+  // phase 2: function bodies, the global table is read-only from here on
+  std::vector<FunctionTask> tasks;
+  tasks.reserve(functions.size());
+  for (size_t i = 0; i < functions.size(); ++i) {
+    tasks.emplace_back(&tid);
+  }
 
-void SemanticAnalyzer::declareIdentifier(const std::string& name, const IdentifierType type) {
-  try {
-    tid.addIdentifier(name, type, currentScope);
-    std::cout << "Declared identifier \"" << name << "\" of type \"" << identifierTypeToString(type)
-    << "\" in scope: " << currentScope << std::endl;
-  } catch (const std::exception& e) {
-    throw std::runtime_error("Semantic error: " + std::string(e.what()));
+  std::atomic<size_t> next = 0;
+  const auto worker = [&] {
+    for (size_t i = next++; i < tasks.size(); i = next++) {
+      FunctionTask& task = tasks[i];
+      FunctionAnalyzer analyzer(task.table, types, verbose_);
+      try {
+        analyzer.analyzeFunction(functions[i]);
+      } catch (const std::exception& e) {
+        task.error = e.what();
+      }
+      task.diagnostics = std::move(analyzer.getDiagnostics());
+      task.trace = analyzer.getTrace();
+    }
+  };
+
+  const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  const size_t threads = std::min(threads_ ? threads_ : hardware, tasks.size());
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i) {
+    pool.emplace_back(worker);
+  }
+  worker(); // the calling thread works too
+  for (auto& thread : pool) {
+    thread.join();
   }
-}
 
-void SemanticAnalyzer::useIdentifier(const std::string& name) {
-  try {
-    tid.markAsUsed(name, currentScope);
-  } catch (const std::exception& e) {
-    throw std::runtime_error("Semantic error: Variable '" + name + "' used without declaration in scope '"
-      + currentScope + "'.");
+  // merge in source order
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    FunctionTask& task = tasks[i];
+    std::cout << task.trace;
+    if (task.error) {
+      throw std::runtime_error(*task.error);
+    }
+    relocateBindings(functions[i], tid.absorb(task.table));
+    for (auto& diagnostic : task.diagnostics) {
+      diagnostics_.push_back(std::move(diagnostic));
+    }
   }
 }
 
-void SemanticAnalyzer::initializeIdentifier(const std::string& name) {
+void SemanticAnalyzer::declareSignature(const ASTNodePtr& function) {
+  const auto& children = function->getChildren();
+  for (size_t i = 0; i + 1 < children.size(); ++i) {
+    if (children[i]->getTypeId() == TypeTable::VOID) {
+      throw std::runtime_error("Semantic error: parameter '" + children[i]->getValue() + "' has type void.");
+    }
+  }
+
   try {
-    tid.markAsInitialized(name, currentScope);
+    const IdentifierHandle identifier = tid.addIdentifier(function->getSymbol(), function->getTypeId(), GLOBAL_SCOPE);
+    tid.markAsInitialized(identifier);
+    function->setBinding(identifier.getIndex());
+    if (verbose_) {
+      std::cout << "Declared identifier \"" << identifier.getName() << "\" of type \"" <<
+        types.toString(function->getTypeId()) << "\" in scope: global" << std::endl;
+    }
   } catch (const std::exception& e) {
-    throw std::runtime_error("Semantic error: Variable '" + name + "' initialized without declaration in scope '"
-      + currentScope + "'.");
+    throw std::runtime_error("Semantic error: " + std::string(e.what()));
   }
 }
 
-void SemanticAnalyzer::checkType(const std::string& expectedType, const std::string& actualType) {
-  if (expectedType != actualType) {
-    throw std::runtime_error("Type mismatch: Expected '" + expectedType + "', but got '" + actualType + "'.");
+void SemanticAnalyzer::relocateBindings(const ASTNodePtr& node, const TID::Relocation& relocation) {
+  if (!node) {
+    return;
+  }
+  if (node->getBinding() != ASTNode::NO_BINDING) {
+    node->setBinding(relocation.record(node->getBinding()));
+  }
+  for (const auto& child : node->getChildren()) {
+    relocateBindings(child, relocation);
   }
 }
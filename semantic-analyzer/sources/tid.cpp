@@ -1,70 +1,213 @@
 #include "../headers/tid.h"
 
 
-void TID::addIdentifier(const std::string& name, IdentifierType type, const std::string& scope) {
-  if (identifierExists(name, scope)) {
-    throw std::runtime_error("Identifier '" + name + "' already exists in scope '" + scope + "'.");
+static const std::string EMPTY_INFO;
+
+
+SymbolId IdentifierHandle::getSymbol() const {
+  return tid_->getRecord(index_).symbol;
+}
+
+const std::string& IdentifierHandle::getName() const {
+  return tid_->getInterner().getName(getSymbol());
+}
+
+ScopeId IdentifierHandle::getScope() const {
+  return tid_->getRecord(index_).scope;
+}
+
+TypeId IdentifierHandle::getType() const {
+  return tid_->getRecord(index_).type;
+}
+
+bool IdentifierHandle::isInitialized() const {
+  return tid_->getRecord(index_).flags & IdentifierRecord::INITIALIZED;
+}
+
+bool IdentifierHandle::isUsed() const {
+  return tid_->getRecord(index_).flags & IdentifierRecord::USED;
+}
+
+const std::string& IdentifierHandle::getAdditionalInfo() const {
+  return tid_->getAdditionalInfo(index_);
+}
+
+
+SymbolId TID::intern(const std::string& name) {
+  if (enclosing_) {
+    throw std::runtime_error("Cannot intern '" + name + "' in a nested identifier table.");
   }
-  table_[name].emplace_back(name, scope, type, false, false, "");
+  return interner_.intern(name);
 }
 
-IdentifierInfo TID::getIdentifier(const std::string& name, const std::string& scope) const {
-  for (const auto& info : table_.at(name)) {
-    if (info.scope == scope) {
-      return info;
-    }
+ScopeId TID::createScope(const ScopeId parent, const std::string& name) {
+  if (scopeCount() > IdentifierRecord::MAX_SCOPE) {
+    throw std::runtime_error("Too many scopes (limit is " + std::to_string(IdentifierRecord::MAX_SCOPE) + ").");
   }
-  throw std::runtime_error("Identifier '" + name + "' not found in scope '" + scope + "'.");
+  const uint32_t depth = getScope(parent).depth + 1;
+  scopes_.emplace_back(parent, depth, name);
+  return static_cast<ScopeId>(scopeCount() - 1);
 }
 
-void TID::markAsUsed(const std::string& name, const std::string& scope) {
-  if (auto* identifier = findIdentifier(name, scope)) {
-    identifier->isUsed = true;
-  } else {
-    throw std::runtime_error("Identifier '" + name + "' not found in scope '" + scope + "'.");
+IdentifierHandle TID::addIdentifier(const SymbolId symbol, const TypeId type, const ScopeId scope) {
+  if (scope < scopeBase_) {
+    throw std::runtime_error("Cannot declare '" + getInterner().getName(symbol) + "' in the read-only scope '" +
+      getScope(scope).name + "'.");
+  }
+  const auto index = static_cast<uint32_t>(identifierCount());
+  if (!scopes_.at(scope - scopeBase_).symbols.insert(symbol, index)) {
+    throw std::runtime_error("Identifier '" + getInterner().getName(symbol) + "' already exists in scope '" +
+      getScope(scope).name + "'.");
   }
+  records_.push_back({symbol, scope, 0, type, IdentifierRecord::NO_EXTRA});
+  return {this, index};
+}
+
+IdentifierHandle TID::getIdentifier(const SymbolId symbol, const ScopeId scope) const {
+  if (const uint32_t index = resolve(symbol, scope); index != FlatSymbolTable::NOT_FOUND) {
+    return {this, index};
+  }
+  throw std::runtime_error("Identifier '" + getInterner().getName(symbol) + "' not found in scope '" +
+    getScope(scope).name + "'.");
+}
+
+std::optional<IdentifierHandle> TID::lookup(const SymbolId symbol, const ScopeId scope) const {
+  if (const uint32_t index = resolve(symbol, scope); index != FlatSymbolTable::NOT_FOUND) {
+    return IdentifierHandle(this, index);
+  }
+  return std::nullopt;
+}
+
+void TID::markAsUsed(const SymbolId symbol, const ScopeId scope) {
+  markAsUsed(getIdentifier(symbol, scope));
+}
+
+void TID::markAsInitialized(const SymbolId symbol, const ScopeId scope) {
+  markAsInitialized(getIdentifier(symbol, scope));
+}
+
+void TID::markAsUsed(const IdentifierHandle identifier) {
+  setFlags(identifier.getIndex(), IdentifierRecord::USED);
+}
+
+void TID::markAsInitialized(const IdentifierHandle identifier) {
+  setFlags(identifier.getIndex(), IdentifierRecord::INITIALIZED);
 }
 
-void TID::markAsInitialized(const std::string& name, const std::string& scope) {
-  if (auto* identifier = findIdentifier(name, scope)) {
-    identifier->isInitialized = true;
+void TID::setAdditionalInfo(const IdentifierHandle identifier, std::string info) {
+  if (identifier.getIndex() < recordBase_) {
+    throw std::runtime_error("Cannot change '" + identifier.getName() + "' of the enclosing identifier table.");
+  }
+  IdentifierRecord& record = records_.at(identifier.getIndex() - recordBase_);
+  if (record.extra == IdentifierRecord::NO_EXTRA) {
+    record.extra = static_cast<uint32_t>(additionalInfo_.size());
+    additionalInfo_.emplace_back(std::move(info));
   } else {
-    throw std::runtime_error("Identifier '" + name + "' not found in scope '" + scope + "'.");
+    additionalInfo_[record.extra] = std::move(info);
+  }
+}
+
+bool TID::identifierExists(const SymbolId symbol, const ScopeId scope) const {
+  return getScope(scope).symbols.find(symbol) != FlatSymbolTable::NOT_FOUND;
+}
+
+const std::string& TID::getAdditionalInfo(const uint32_t index) const {
+  if (index < recordBase_) {
+    return enclosing_->getAdditionalInfo(index);
   }
+  const uint32_t extra = records_.at(index - recordBase_).extra;
+  return extra == IdentifierRecord::NO_EXTRA ? EMPTY_INFO : additionalInfo_.at(extra);
 }
 
-bool TID::identifierExists(const std::string& name, const std::string& scope) const {
-  if (table_.contains(name)) {
-    for (const auto& info : table_.at(name)) {
-      if (info.scope == scope) {
-        return true;
-      }
+TID::Relocation TID::absorb(const TID& nested) {
+  if (nested.enclosing_ != this) {
+    throw std::runtime_error("absorb(): the table was not opened on top of this one.");
+  }
+
+  Relocation relocation;
+  relocation.recordBase = nested.recordBase_;
+  relocation.recordShift = static_cast<uint32_t>(identifierCount()) - nested.recordBase_;
+  relocation.scopeBase = nested.scopeBase_;
+  relocation.scopeShift = static_cast<uint32_t>(scopeCount()) - nested.scopeBase_;
+  if (scopeCount() + nested.scopes_.size() > IdentifierRecord::MAX_SCOPE + 1) {
+    throw std::runtime_error("Too many scopes (limit is " + std::to_string(IdentifierRecord::MAX_SCOPE) + ").");
+  }
+
+  for (const Scope& scope : nested.scopes_) {
+    scopes_.emplace_back(relocation.scope(scope.parent), scope.depth, scope.name);
+  }
+  for (uint32_t i = 0; i < nested.records_.size(); ++i) {
+    IdentifierRecord record = nested.records_[i];
+    record.scope = relocation.scope(record.scope);
+    record.extra = IdentifierRecord::NO_EXTRA;
+
+    const auto index = static_cast<uint32_t>(records_.size());
+    scopes_[record.scope].symbols.insert(record.symbol, index);
+    records_.push_back(record);
+    if (const std::string& info = nested.getAdditionalInfo(nested.recordBase_ + i); !info.empty()) {
+      setAdditionalInfo({this, index}, info);
     }
   }
-  return false;
+  for (const auto& [index, flags] : nested.enclosingFlags_) {
+    setFlags(index, flags);
+  }
+  return relocation;
 }
 
-void TID::printTable() const {
-  for (const auto& [name, infos] : table_) {
-    for (const auto& info : infos) {
-      std::cout << "Name: " << info.name
-                << ", Type: " << static_cast<int>(info.type)
-                << ", Scope: " << info.scope
-                << ", Initialized: " << (info.isInitialized ? "Yes" : "No")
-                << ", Used: " << (info.isUsed ? "Yes" : "No")
-                << ", Additional Info: " << info.additionalInfo
-                << std::endl;
+TID::MemoryUsage TID::memoryUsage() const {
+  MemoryUsage usage;
+  usage.records = records_.capacity() * sizeof(IdentifierRecord);
+
+  usage.scopes = scopes_.capacity() * sizeof(Scope);
+  for (const auto& scope : scopes_) {
+    usage.scopes += scope.symbols.memoryUsage();
+    if (scope.name.capacity() > 15) { // outside of the small-string buffer
+      usage.scopes += scope.name.capacity() + 1;
+    }
+  }
+
+  usage.interner = interner_.memoryUsage();
+
+  usage.sideTable = additionalInfo_.capacity() * sizeof(std::string);
+  for (const auto& info : additionalInfo_) {
+    if (info.capacity() > 15) {
+      usage.sideTable += info.capacity() + 1;
     }
   }
+  return usage;
 }
 
-IdentifierInfo* TID::findIdentifier(const std::string& name, const std::string& scope) {
-  if (table_.contains(name)) {
-    for (auto& info : table_[name]) {
-      if (info.scope == scope) {
-        return &info;
-      }
+void TID::printTable() const {
+  for (uint32_t i = 0; i < identifierCount(); ++i) {
+    const IdentifierHandle info(this, i);
+    std::cout << "Name: " << info.getName()
+              << ", Type: #" << info.getType()
+              << ", Scope: " << getScope(info.getScope()).name << " #" << info.getScope()
+              << ", Initialized: " << (info.isInitialized() ? "Yes" : "No")
+              << ", Used: " << (info.isUsed() ? "Yes" : "No")
+              << ", Additional Info: " << info.getAdditionalInfo()
+              << std::endl;
+  }
+}
+
+uint32_t TID::resolve(const SymbolId symbol, ScopeId scope) const {
+  while (scope != NO_SCOPE) {
+    if (scope < scopeBase_) { // the rest of the chain belongs to the enclosing table
+      return enclosing_->resolve(symbol, scope);
     }
+    const Scope& current = scopes_[scope - scopeBase_];
+    if (const uint32_t index = current.symbols.find(symbol); index != FlatSymbolTable::NOT_FOUND) {
+      return index;
+    }
+    scope = current.parent;
+  }
+  return FlatSymbolTable::NOT_FOUND;
+}
+
+void TID::setFlags(const uint32_t index, const uint8_t flags) {
+  if (index < recordBase_) {
+    enclosingFlags_.emplace_back(index, flags); // applied by the enclosing table's absorb()
+  } else {
+    records_.at(index - recordBase_).flags |= flags;
   }
-  return nullptr;
 }
@@ -0,0 +1,80 @@
+#include "../headers/types.h"
+
+
+TypeTable::TypeTable() {
+  // order must match the fixed ids declared in the header
+  for (const auto kind : {TypeKind::ERROR, TypeKind::VOID, TypeKind::INT, TypeKind::FLOAT,
+                          TypeKind::CHAR, TypeKind::BOOL, TypeKind::STRING}) {
+    intern({kind});
+  }
+}
+
+TypeId TypeTable::arrayOf(const TypeId element) {
+  if (element == VOID || isFunction(element)) {
+    throw std::runtime_error("Semantic error: invalid array element type '" + toString(element) + "'.");
+  }
+  return intern({TypeKind::ARRAY, element});
+}
+
+TypeId TypeTable::function(const TypeId result, const std::vector<TypeId>& parameters) {
+  return intern({TypeKind::FUNCTION, result, parameters});
+}
+
+size_t TypeTable::rank(TypeId type) const {
+  size_t levels = 0;
+  while (isArray(type)) {
+    type = get(type).element;
+    ++levels;
+  }
+  return levels;
+}
+
+TypeId TypeTable::scalar(TypeId type) const {
+  while (isArray(type)) {
+    type = get(type).element;
+  }
+  return type;
+}
+
+std::string TypeTable::toString(const TypeId type) const {
+  const TypeInfo& info = get(type);
+  switch (info.kind) {
+    case TypeKind::ERROR:
+      return "<error>";
+    case TypeKind::VOID:
+      return "void";
+    case TypeKind::INT:
+      return "int";
+    case TypeKind::FLOAT:
+      return "float";
+    case TypeKind::CHAR:
+      return "char";
+    case TypeKind::BOOL:
+      return "bool";
+    case TypeKind::STRING:
+      return "string";
+    case TypeKind::ARRAY:
+      return "array< " + toString(info.element) + " >";
+    default: { // TypeKind::FUNCTION
+      std::string result = "func " + toString(info.element) + "(";
+      for (size_t i = 0; i < info.parameters.size(); ++i) {
+        result += (i == 0 ? "" : ", ") + toString(info.parameters[i]);
+      }
+      return result + ")";
+    }
+  }
+}
+
+TypeId TypeTable::intern(TypeInfo info) {
+  std::vector<uint32_t> key = {static_cast<uint32_t>(info.kind), info.element};
+  key.insert(key.end(), info.parameters.begin(), info.parameters.end());
+
+  if (const auto it = ids_.find(key); it != ids_.end()) {
+    return it->second;
+  }
+
+  const auto id = static_cast<TypeId>(types_.size());
+  types_.emplace_back(std::move(info));
+  ids_.emplace(std::move(key), id);
+  return id;
+}
@@ -2,25 +2,29 @@
 #define PARSER_H
 
 
-#include <complex>
-
 #include "../../global_functions/global_funcs.h"
 #include "../../includes/libraries.h"
 #include "../../lexical-analyzer/headers/lexer.h"
+#include "../../semantic-analyzer/headers/ast-node.h"
 #include "../../semantic-analyzer/headers/semantic.h"
 
 
 class Parser {
 public:
-  explicit Parser(LexicalAnalyzer& lexer) : lexer_(lexer), currToken_(lexer.getLex()) {
-    std::cout << "Number of tokens in Lexer: " << lexer_.getTokens().size() << std::endl;
+  // Names are interned in `semantic`'s tables; both objects must outlive the parser
+  Parser(LexicalAnalyzer& lexer, SemanticAnalyzer& semantic, const bool verbose = true) :
+  verbose_(verbose), lexer_(lexer), semantic_(semantic), currToken_(lexer.getLex()) {
+    if (verbose_) {
+      std::cout << "Number of tokens in Lexer: " << lexer_.getTokens().size() << std::endl;
+    }
   }
 
-  void program() {
-    parseProgram();
+  // Parses the whole token stream into an AST (semantic analysis is a separate pass)
+  ASTNodePtr program() {
+    return parseProgram();
   }
 
-  [[nodiscard]] LexicalAnalyzer getLexer() const { return lexer_; }
+  [[nodiscard]] const LexicalAnalyzer& getLexer() const { return lexer_; }
 
   void expect(const my::TokenType type, const std::string& functionName) {
     if (currToken_.getType() != type) {
@@ -44,8 +48,10 @@ public:
     }
 
     currToken_ = tokens[currCount++];
-    std::cout << std::endl;
-    std::cout << "Advanced to token: '" << currToken_.getValue() << "'" << std::endl;
+    if (verbose_) {
+      std::cout << std::endl;
+      std::cout << "Advanced to token: '" << currToken_.getValue() << "'" << std::endl;
+    }
   }
 
   static bool isType(const Token& token) {
@@ -58,8 +64,10 @@ public:
   [[nodiscard]] Token getCurrToken() const { return currToken_; }
 
 private:
-  size_t currCount = 0;
-  LexicalAnalyzer lexer_;
+  bool verbose_;
+  size_t currCount = 1; // index of the next token, currToken_ starts at tokens[0]
+  LexicalAnalyzer& lexer_;
+  SemanticAnalyzer& semantic_;
   Token currToken_;
 
 
@@ -82,63 +90,77 @@ private:
   }
 
 
-  void parseProgram();
+  // new node positioned at the current token's line
+  ASTNodePtr makeNode(ASTNodeType type, const std::string& value = "",
+    my::TokenType tokenType = my::TokenType::UNKNOWN) const;
+
+  // node that carries an interned name (identifiers, declarations, functions, calls)
+  ASTNodePtr makeNamedNode(ASTNodeType type, const std::string& name) const;
+
+  ASTNodePtr parseProgram();
+
+  ASTNodePtr parseDeclaration();
+
+  ASTNodePtr parseFunction();
+
+  void parseParameters(const ASTNodePtr& function);
 
-  void parseDeclaration();
+  ASTNodePtr parseParameter();
 
-  void parseFunction();
+  ASTNodePtr parseBlock();
 
-  void parseParameters();
+  ASTNodePtr parseInstruction();
 
-  void parseParameter();
+  ASTNodePtr parseInput();
 
-  void parseBlock();
+  ASTNodePtr parseOutput();
 
-  void parseInstruction();
+  ASTNodePtr parseConditional();
 
-  void parseInput();
+  ASTNodePtr parseLoop();
 
-  void parseOutput();
+  ASTNodePtr parseInitialization();
 
-  void parseConditional();
+  ASTNodePtr parseAssignment();
 
-  void parseLoop();
+  ASTNodePtr parseStep();
 
-  void parseInitialization();
+  ASTNodePtr parseSwitch();
 
-  void parseAssignment();
+  ASTNodePtr parseLiteral();
 
-  void parseStep();
+  ASTNodePtr parseExpression();
 
-  void parseSwitch();
+  ASTNodePtr parseComma();
 
-  void parseLiteral();
+  ASTNodePtr parseLogicalOr();
 
-  void parseExpression();
+  ASTNodePtr parseLogicalAnd();
 
-  void parseComma();
+  ASTNodePtr parseEqualityOperators();
 
-  void parseLogicalOr();
+  ASTNodePtr parseRelationalOperators();
 
-  void parseLogicalAnd();
+  ASTNodePtr parsePlusMinus();
 
-  void parseEqualityOperators();
+  ASTNodePtr parseMulDiv();
 
-  void parseRelationalOperators();
+  // current token is a binary operator: builds `lhs <op> operand`, operators are left-associative
+  ASTNodePtr parseBinary(const ASTNodePtr& lhs, ASTNodePtr (Parser::*parseOperand)());
 
-  void parsePlusMinus();
+  ASTNodePtr parseUnary();
 
-  void parseMulDiv();
+  ASTNodePtr parseAtom();
 
-  void parseUnary();
+  ASTNodePtr parseCall();
 
-  void parseAtom();
+  ASTNodePtr parseSubscript(const ASTNodePtr& array);
 
-  void parseIndex();
+  ASTNodePtr parseIndex();
 
-  void parseType();
+  TypeId parseType();
 
-  void parseIdentifier();
+  ASTNodePtr parseIdentifier();
 };
 
 
@@ -1,318 +1,342 @@
 #include "../headers/parser.h"
 
 
-IdentifierType convertFromTokenTypeToIdentifierType(const my::TokenType& type) {
-  std::cout << "Converting token type: " << getTokenValue(type) << std::endl;
-  switch (type) {
-    case my::TokenType::INT:
-      return IdentifierType::INT;
-    case my::TokenType::FLOAT:
-      return IdentifierType::FLOAT;
-    case my::TokenType::CHAR:
-      return IdentifierType::CHAR;
-    case my::TokenType::BOOL:
-      return IdentifierType::BOOL;
-    case my::TokenType::VOID:
-      return IdentifierType::VOID;
-    case my::TokenType::STRING:
-      return IdentifierType::STRING;
-    case my::TokenType::ARRAY:
-      return IdentifierType::ARRAY;
-    default:
-      /*return IdentifierType::UNKNOWN;*/
-      throw std::runtime_error("Syntax-semantic error: invalid identifier type");
-  }
+ASTNodePtr Parser::makeNode(const ASTNodeType type, const std::string& value, const my::TokenType tokenType) const {
+  auto node = std::make_shared<ASTNode>(type, value, tokenType);
+  node->setLine(static_cast<uint32_t>(currToken_.getLine()));
+  return node;
 }
 
+ASTNodePtr Parser::makeNamedNode(const ASTNodeType type, const std::string& name) const {
+  auto node = makeNode(type, name);
+  node->setSymbol(semantic_.intern(name));
+  return node;
+}
 
-SemanticAnalyzer semanticAnalyzer;
-
+ASTNodePtr Parser::parseProgram() {
+  auto program = makeNode(ASTNodeType::PROGRAM);
 
-void Parser::parseProgram() {
   while (currToken_.getType() != my::TokenType::END) {
-    parseDeclaration();
+    if (auto declaration = parseDeclaration()) {
+      program->addChild(declaration);
+    }
   }
+
+  return program;
 }
 
-void Parser::parseDeclaration() {
+ASTNodePtr Parser::parseDeclaration() {
   if (currToken_.getType() == my::TokenType::KEYWORD && currToken_.getValue() == "func") {
-    parseFunction();
-  } else {
-    advance();
-    // parseInstruction();
+    return parseFunction();
   }
+  return parseInstruction();
 }
 
-void Parser::parseFunction() {
+ASTNodePtr Parser::parseFunction() {
   const std::string functionName = "parseFunction()";
 
   expect(my::TokenType::KEYWORD, functionName); // 'func'
-  advance();
 
   // is current token - type
-  IdentifierType returnType = convertFromTokenTypeToIdentifierType(currToken_.getType());
-  parseType();
+  const TypeId returnType = parseType();
 
   // check identifier
-  const std::string funcName = currToken_.getValue();
-
-  // add function to TID
-  semanticAnalyzer.declareIdentifier(funcName, IdentifierType::FUNCTION);
-
+  auto function = makeNamedNode(ASTNodeType::FUNCTION, currToken_.getValue());
   expect(my::TokenType::IDENTIFIER, functionName); // name of function
 
   // check parameters
-  semanticAnalyzer.enterScope(functionName);
   expect(my::TokenType::LPAREN, functionName); // '('
   if (currToken_.getType() != my::TokenType::RPAREN) { // if we have any parameters
-    parseParameters();
+    parseParameters(function);
   }
   expect(my::TokenType::RPAREN, functionName); // ')'
 
-  parseBlock();
-  semanticAnalyzer.exitScope();
+  std::vector<TypeId> parameterTypes;
+  for (const auto& parameter : function->getChildren()) {
+    parameterTypes.push_back(parameter->getTypeId());
+  }
+  function->setTypeId(semantic_.getTypes().function(returnType, parameterTypes));
+
+  function->addChild(parseBlock());
+  return function;
 }
 
-void Parser::parseParameters() {
+void Parser::parseParameters(const ASTNodePtr& function) {
   if (currToken_.getType() == my::TokenType::RPAREN) { // we haven't any parameters
     return;
   }
 
-  parseParameter();
+  function->addChild(parseParameter());
 
   while (currToken_.getType() == my::TokenType::COMMA) {
     advance(); // skip ','
-    parseParameter();
+    function->addChild(parseParameter());
   }
 }
 
-void Parser::parseParameter() {
+ASTNodePtr Parser::parseParameter() {
   const std::string functionName = "parseParameter()";
 
-  const my::TokenType paramTokenType =  currToken_.getType();
-
   if (!isType(currToken_)) {
     throw std::runtime_error(
       "Syntax error: Expected type for parameter, found '" + currToken_.getValue() +
       "' (" + getTokenValue(currToken_.getType()) + ")." + " || parseParameter()"
       );
   }
-  /*parseType();
-
-  semanticAnalyzer.declareIdentifier(currToken_.getValue(),
-    convertFromTokenTypeToIdentifierType(currToken_.getType()));
-  expect(my::TokenType::IDENTIFIER, functionName); // name of variable*/
 
   // Парсим тип
-  parseType();
+  const TypeId paramType = parseType();
 
   // Получаем идентификатор параметра
-  std::string paramName = currToken_.getValue();
+  auto parameter = makeNamedNode(ASTNodeType::PARAMETER, currToken_.getValue());
+  parameter->setTypeId(paramType);
   expect(my::TokenType::IDENTIFIER, functionName); // Проверяем идентификатор
 
-  // Преобразуем сохраненный тип токена в IdentifierType
-  const IdentifierType paramType = convertFromTokenTypeToIdentifierType(paramTokenType);
-
-  // Добавляем параметр в TID
-  semanticAnalyzer.declareIdentifier(paramName, paramType);
+  return parameter;
 }
 
-void Parser::parseBlock() {
+ASTNodePtr Parser::parseBlock() {
   const std::string functionName = "parseBlock()";
 
   expect(my::TokenType::LBRACE, functionName); // '{'
 
-  semanticAnalyzer.enterScope("block"); // VARY BAD - fix in future
-
+  auto block = makeNode(ASTNodeType::BLOCK);
   while (currToken_.getType() != my::TokenType::RBRACE) {
     if (currToken_.getType() == my::TokenType::END) {
       throw std::runtime_error("Syntax error: Unexpected end of input inside block || parseBlock()");
     }
 
-    parseInstruction(); // parsing next instruction
+    if (auto instruction = parseInstruction()) { // parsing next instruction
+      block->addChild(instruction);
+    }
   }
 
-  semanticAnalyzer.exitScope();
-
   expect(my::TokenType::RBRACE, functionName); // '}'
+  return block;
 }
 
-void Parser::parseInstruction() {
+ASTNodePtr Parser::parseInstruction() {
   const std::string functionName = "parseInstruction()";
 
   if (currToken_.getType() == my::TokenType::RBRACE) {
-    return; // we haven't any instructions
+    return nullptr; // we haven't any instructions
   }
 
   if (currToken_.getType() == my::TokenType::COMMENT_LITERAL) {
     advance();
-  } else if (currToken_.getType() == my::TokenType::LBRACE) {
-    parseBlock();
-  } else if (currToken_.getType() == my::TokenType::KEYWORD && currToken_.getValue() == "cin") {
-    parseInput();
-  } else if (currToken_.getType() == my::TokenType::KEYWORD && currToken_.getValue() == "cout") {
-    parseOutput();
-  } else if (currToken_.getType() == my::TokenType::IF) {
-    parseConditional();
-  } else if (currToken_.getType() == my::TokenType::FOR || currToken_.getType() == my::TokenType::WHILE) {
-    parseLoop();
-  } else if (currToken_.getType() == my::TokenType::SWITCH) {
-    parseSwitch();
-  } else if (currToken_.getType() == my::TokenType::BREAK || currToken_.getType() == my::TokenType::CONTINUE) {
+    return nullptr;
+  }
+  if (currToken_.getType() == my::TokenType::LBRACE) {
+    return parseBlock();
+  }
+  if (currToken_.getType() == my::TokenType::KEYWORD && currToken_.getValue() == "cin") {
+    return parseInput();
+  }
+  if (currToken_.getType() == my::TokenType::KEYWORD && currToken_.getValue() == "cout") {
+    return parseOutput();
+  }
+  if (currToken_.getType() == my::TokenType::IF) {
+    return parseConditional();
+  }
+  if (currToken_.getType() == my::TokenType::FOR || currToken_.getType() == my::TokenType::WHILE) {
+    return parseLoop();
+  }
+  if (currToken_.getType() == my::TokenType::SWITCH) {
+    return parseSwitch();
+  }
+  if (currToken_.getType() == my::TokenType::BREAK || currToken_.getType() == my::TokenType::CONTINUE) {
+    auto jump = makeNode(currToken_.getType() == my::TokenType::BREAK ? ASTNodeType::BREAK : ASTNodeType::CONTINUE,
+      currToken_.getValue(), currToken_.getType());
     advance(); // skip 'break' / 'continue'
-    advance(); // skip ';'
-  } else if (isType(currToken_)) {
-    parseInitialization();
-  } else if (currToken_.getType() == my::TokenType::RETURN) {
+    expect(my::TokenType::SEMICOLON, functionName); // ';'
+    return jump;
+  }
+  if (isType(currToken_)) {
+    return parseInitialization();
+  }
+  if (currToken_.getType() == my::TokenType::RETURN) {
+    auto ret = makeNode(ASTNodeType::RETURN_STATEMENT, "return", my::TokenType::RETURN);
     advance(); // Skip 'return'
-    if (currToken_.getType() == my::TokenType::SEMICOLON) {
-      advance(); // 'return;'
-    } else {
-      parseExpression();
+    if (currToken_.getType() != my::TokenType::SEMICOLON) { // not 'return;'
+      ret->addChild(parseExpression());
     }
-  } else if (currToken_.getType() == my::TokenType::SEMICOLON) {
+    expect(my::TokenType::SEMICOLON, functionName); // ';'
+    return ret;
+  }
+  if (currToken_.getType() == my::TokenType::SEMICOLON) {
     advance(); // skip ';'
-  } else if (currToken_.getType() == my::TokenType::IDENTIFIER) {
-    if (lexer_.peek(currCount).getType() == my::TokenType::SEMICOLON) {
-      advance(); // skip identifier
-      advance(); // skip ';'
-    } else {
-      parseAssignment();
+    return nullptr;
+  }
+  if (currToken_.getType() == my::TokenType::IDENTIFIER) {
+    const my::TokenType next = lexer_.peek(currCount - 1).getType(); // token after the identifier
+    if (next == my::TokenType::SEMICOLON || next == my::TokenType::LPAREN) { // 'x;' or 'f(...);'
+      auto expression = parseAtom();
+      expect(my::TokenType::SEMICOLON, functionName); // ';'
+      return expression;
     }
-  } else {
-    throw std::runtime_error(
-     "Syntax error at token: '" + currToken_.getValue() +
-     "' (" + getTokenValue(currToken_.getType()) + "), Expected: " + getTokenValue(my::TokenType::SEMICOLON) +
-     " || parseInstruction()");
-  } /*else {
-    expect(my::TokenType::SEMICOLON);
-  }*/
+    return parseAssignment();
+  }
+  throw std::runtime_error(
+   "Syntax error at token: '" + currToken_.getValue() +
+   "' (" + getTokenValue(currToken_.getType()) + "), Expected: " + getTokenValue(my::TokenType::SEMICOLON) +
+   " || parseInstruction()");
 }
 
-void Parser::parseInput() {
+ASTNodePtr Parser::parseInput() {
   const std::string functionName = "parseInput()";
 
+  auto input = makeNode(ASTNodeType::INPUT, "cin");
+
   advance(); // skip 'cin'
   expect(my::TokenType::IN, functionName); // '>>'
-  expect(my::TokenType::IDENTIFIER, functionName); // 'variable'
+  input->addChild(parseIdentifier()); // 'variable'
   while (currToken_.getType() != my::TokenType::SEMICOLON) {
     expect(my::TokenType::IN, functionName); // '>>'
-    expect(my::TokenType::IDENTIFIER, functionName); // 'variable'
+    input->addChild(parseIdentifier()); // 'variable'
   }
   expect(my::TokenType::SEMICOLON, functionName); // ';'
+
+  return input;
 }
 
-void Parser::parseOutput() {
+ASTNodePtr Parser::parseOutput() {
   const std::string functionName = "parseOutput()";
 
+  auto output = makeNode(ASTNodeType::OUTPUT, "cout");
+
   advance(); // skip 'cout'
   expect(my::TokenType::OUT, functionName); // '<<'
-  parseExpression();
+  output->addChild(parseExpression());
   while (currToken_.getType() != my::TokenType::SEMICOLON) {
     expect(my::TokenType::OUT, functionName); // '<<'
-    parseExpression();
+    output->addChild(parseExpression());
   }
   expect(my::TokenType::SEMICOLON, functionName); // ';'
+
+  return output;
 }
 
-void Parser::parseConditional() {
+ASTNodePtr Parser::parseConditional() {
   const std::string functionName = "parseConditional()";
 
+  auto conditional = makeNode(ASTNodeType::IF_STATEMENT, "if", my::TokenType::IF);
+
   advance(); // skip 'if'
   expect(my::TokenType::LPAREN, functionName); // '('
-  parseExpression(); // for the first time we haven't any conditions
+  conditional->addChild(parseExpression());
   expect(my::TokenType::RPAREN, functionName); // ');
-  parseBlock(); // 'block'
+  conditional->addChild(parseBlock()); // 'block'
+
+  if (currToken_.getType() == my::TokenType::ELSE) {
+    advance(); // skip 'else'
+    conditional->addChild(parseBlock()); // 'else block'
+  }
+
+  return conditional;
 }
 
-void Parser::parseLoop() {
+ASTNodePtr Parser::parseLoop() {
   const std::string functionName = "parseLoop()";
 
   if (currToken_.getType() == my::TokenType::WHILE) {
+    auto loop = makeNode(ASTNodeType::LOOP_STATEMENT, "while", my::TokenType::WHILE);
     advance(); // skip 'while'
 
     expect(my::TokenType::LPAREN, functionName); // '('
-    parseExpression();
+    loop->addChild(parseExpression());
     expect(my::TokenType::RPAREN, functionName); // ')'
 
-    parseBlock(); // 'block' - loop's body
-  } else if (currToken_.getType() == my::TokenType::FOR) {
+    loop->addChild(parseBlock()); // 'block' - loop's body
+    return loop;
+  }
+  if (currToken_.getType() == my::TokenType::FOR) {
+    auto loop = makeNode(ASTNodeType::LOOP_STATEMENT, "for", my::TokenType::FOR);
     advance(); // skip 'for'
 
     expect(my::TokenType::LPAREN, functionName); // '('
-    parseInitialization();
-    // expect(my::TokenType::SEMICOLON); // first ';' after initialization
-    parseExpression();
+    loop->addChild(parseInitialization()); // consumes the first ';'
+    loop->addChild(parseExpression());
     expect(my::TokenType::SEMICOLON, functionName); // second ';' after condition
-    parseStep();
+    loop->addChild(parseStep());
     expect(my::TokenType::RPAREN, functionName); // ')'
 
-    parseBlock(); // 'block' - loop's body
-  } else { // it useless, but - why not?
-    throw std::runtime_error(
-    "Syntax error at token: '" + currToken_.getValue() +
-    "' (" + getTokenValue(currToken_.getType()) + "), Expected: FOR /or/ WHILE" +
-    " || parseLoop()");
+    loop->addChild(parseBlock()); // 'block' - loop's body
+    return loop;
   }
+  // it useless, but - why not?
+  throw std::runtime_error(
+  "Syntax error at token: '" + currToken_.getValue() +
+  "' (" + getTokenValue(currToken_.getType()) + "), Expected: FOR /or/ WHILE" +
+  " || parseLoop()");
 }
 
-void Parser::parseInitialization() {
+ASTNodePtr Parser::parseInitialization() {
   const std::string functionName = "parseInitialization()";
 
-  const IdentifierType type = convertFromTokenTypeToIdentifierType(currToken_.getType());
-
-  parseType();
+  const TypeId type = parseType();
 
-  semanticAnalyzer.declareIdentifier(currToken_.getValue(), type);
+  auto declaration = makeNamedNode(ASTNodeType::VARIABLE_DECLARATION, currToken_.getValue());
+  declaration->setTypeId(type);
+  declaration->addChild(nullptr); // initializer, filled below if present
 
   expect(my::TokenType::IDENTIFIER, functionName); // variable's name
-  while (currToken_.getType() == my::TokenType::LBRACKET) { // is array's element ([i], [i][j], ...)
+  while (currToken_.getType() == my::TokenType::LBRACKET) { // array's dimensions ([n], [n][m], ...)
     advance(); // '['
-    parseIndex();
-    expect(my::TokenType::RBRACKET, functionName); // '['
+    declaration->addChild(parseIndex());
+    expect(my::TokenType::RBRACKET, functionName); // ']'
   }
   if (currToken_.getType() != my::TokenType::SEMICOLON) {
     expect(my::TokenType::ASSIGN, functionName);
-    // advance();
-    parseExpression(); // for the first time we haven't any expressions
+    declaration->setChild(0, parseExpression());
   }
   expect(my::TokenType::SEMICOLON, functionName); // maybe useful !!!!!!!!!
+
+  return declaration;
 }
 
-void Parser::parseAssignment() {
+ASTNodePtr Parser::parseAssignment() {
   const std::string functionName = "parseAssignment()";
 
-  expect(my::TokenType::IDENTIFIER, functionName); // variable's name
+  auto assignment = makeNode(ASTNodeType::ASSIGNMENT, "=", my::TokenType::ASSIGN);
+
+  auto target = parseIdentifier(); // variable's name
   while (currToken_.getType() == my::TokenType::LBRACKET) { // is array's element ([i], [i][j], ...)
-    advance(); // '['
-    parseIndex();
-    expect(my::TokenType::RBRACKET, functionName); // '['
+    target = parseSubscript(target);
   }
-  if (currToken_.getType() != my::TokenType::SEMICOLON) {
-    expect(my::TokenType::ASSIGN, functionName);
-  }
-  parseExpression(); // for the first time we haven't any expressions
+  assignment->addChild(target);
+
+  expect(my::TokenType::ASSIGN, functionName);
+  assignment->addChild(parseExpression());
   expect(my::TokenType::SEMICOLON, functionName); // maybe useful !!!!!!!!!
+
+  return assignment;
 }
 
-void Parser::parseStep() {
+ASTNodePtr Parser::parseStep() {
   const std::string functionName = "parseStep()";
 
-  expect(my::TokenType::IDENTIFIER, functionName); // name of variable-count
+  auto step = makeNode(ASTNodeType::ASSIGNMENT, "=", my::TokenType::ASSIGN);
+  step->addChild(parseIdentifier()); // name of variable-count
   expect(my::TokenType::ASSIGN, functionName);
-  parseExpression();
+  step->addChild(parseExpression());
+
+  return step;
 }
 
-void Parser::parseSwitch() {
+ASTNodePtr Parser::parseSwitch() {
   const std::string functionName = "parseSwitch()";
 
+  auto switchNode = makeNode(ASTNodeType::SWITCH, "switch", my::TokenType::SWITCH);
+
   advance(); // skip 'switch'
   expect(my::TokenType::LPAREN, functionName); // '('
-  parseExpression(); // for the first time we haven't any conditions
+  switchNode->addChild(parseExpression());
   expect(my::TokenType::RPAREN, functionName); // ')'
 
   expect(my::TokenType::LBRACE, functionName); // '{'
   while (currToken_.getType() == my::TokenType::CASE) {
+    auto caseNode = makeNode(ASTNodeType::CASE, "case", my::TokenType::CASE);
+
     expect(my::TokenType::CASE, functionName);
     if (currToken_.getType() == my::TokenType::COMMENT_LITERAL) {
       throw std::runtime_error(
@@ -321,175 +345,242 @@ void Parser::parseSwitch() {
       " || parseSwitch()"
       );
     }
-    parseLiteral(); // for the first time we haven't any realizations of parseLiteral()
+    caseNode->addChild(parseLiteral());
     expect(my::TokenType::COLON, functionName);
-    /*while (currToken_.getType() != my::TokenType::CASE &&
-         currToken_.getType() != my::TokenType::DEFAULT &&
-         currToken_.getType() != my::TokenType::RBRACE) {
-      parseInstruction();
-         }*/
     while (currToken_.getType() != my::TokenType::BREAK) {
-      parseInstruction(); // 'instruction' in case
+      if (auto instruction = parseInstruction()) { // 'instruction' in case
+        caseNode->addChild(instruction);
+      }
     }
     expect(my::TokenType::BREAK, functionName); // 'break'
     expect(my::TokenType::SEMICOLON, functionName); // ';'
+
+    switchNode->addChild(caseNode);
   }
+
+  auto defaultNode = makeNode(ASTNodeType::CASE, "default", my::TokenType::DEFAULT);
   expect(my::TokenType::DEFAULT, functionName); // 'default'
   expect(my::TokenType::COLON, functionName); // ':'
   while (currToken_.getType() != my::TokenType::RBRACE) {
-    parseInstruction(); // 'instruction' in default
+    if (auto instruction = parseInstruction()) { // 'instruction' in default
+      defaultNode->addChild(instruction);
+    }
   }
   expect(my::TokenType::RBRACE, functionName); // '}'
+  switchNode->addChild(defaultNode);
+
+  return switchNode;
 }
 
-void Parser::parseLiteral() {
+ASTNodePtr Parser::parseLiteral() {
   const std::string functionName = "parseLiteral()";
 
-  if (currToken_.getType() == my::TokenType::COMMENT_LITERAL) {
-    // parseCommentLiteral(); // maybe useless methods...
+  const my::TokenType type = currToken_.getType();
+  if (type == my::TokenType::COMMENT_LITERAL) {
+    // a comment in the middle of an expression is transparent
     expect(my::TokenType::COMMENT_LITERAL, functionName);
-  } else if (currToken_.getType() == my::TokenType::INTEGER_LITERAL) {
-    // parseIntegerLiteral(); // maybe useless methods...
-    expect(my::TokenType::INTEGER_LITERAL, functionName);
-} else if (currToken_.getType() == my::TokenType::FLOAT_LITERAL) {
-    // parseFloatLiteral(); // maybe useless methods...
-    expect(my::TokenType::FLOAT_LITERAL, functionName);
-  } else if (currToken_.getType() == my::TokenType::STRING_LITERAL) {
-    // parseStringLiteral(); // maybe useless methods...
-    expect(my::TokenType::STRING_LITERAL, functionName);
-  } else if (currToken_.getType() == my::TokenType::CHAR_LITERAL) {
-    // parseCharLiteral(); // maybe useless methods...
-    expect(my::TokenType::CHAR_LITERAL, functionName);
-  } else {
-    throw std::runtime_error(
-      "Syntax error at token: '" + currToken_.getValue() +
-      "' (" + getTokenValue(currToken_.getType()) + "), Expected: LITERAL" +
-      " || parseLiteral()"
-      );
+    return parseAtom();
   }
+  if (type == my::TokenType::INTEGER_LITERAL || type == my::TokenType::FLOAT_LITERAL ||
+    type == my::TokenType::STRING_LITERAL || type == my::TokenType::CHAR_LITERAL) {
+    auto literal = makeNode(ASTNodeType::LITERAL, currToken_.getValue(), type);
+    expect(type, functionName);
+    return literal;
+  }
+  throw std::runtime_error(
+    "Syntax error at token: '" + currToken_.getValue() +
+    "' (" + getTokenValue(currToken_.getType()) + "), Expected: LITERAL" +
+    " || parseLiteral()"
+    );
 }
 
-void Parser::parseExpression() {
-  parseComma();
+ASTNodePtr Parser::parseExpression() {
+  return parseComma();
 }
 
-void Parser::parseComma() {
-  parseLogicalOr();
-  if (currToken_.getType() == my::TokenType::COMMA) {
-    advance(); // skip ','
-    parseLogicalOr();
+ASTNodePtr Parser::parseComma() {
+  auto lhs = parseLogicalOr();
+  while (currToken_.getType() == my::TokenType::COMMA) {
+    lhs = parseBinary(lhs, &Parser::parseLogicalOr); // skip ','
   }
+  return lhs;
 }
 
-void Parser::parseLogicalOr() {
-  parseLogicalAnd();
-  if (currToken_.getType() == my::TokenType::OR) {
-    advance(); // skip '||'
-    parseLogicalAnd();
+ASTNodePtr Parser::parseLogicalOr() {
+  auto lhs = parseLogicalAnd();
+  while (currToken_.getType() == my::TokenType::OR) {
+    lhs = parseBinary(lhs, &Parser::parseLogicalAnd); // skip '||'
   }
+  return lhs;
 }
 
-void Parser::parseLogicalAnd() {
-  parseEqualityOperators();
-  if (currToken_.getType() == my::TokenType::AND) {
-    advance(); // skip '&&'
-    parseEqualityOperators();
+ASTNodePtr Parser::parseLogicalAnd() {
+  auto lhs = parseEqualityOperators();
+  while (currToken_.getType() == my::TokenType::AND) {
+    lhs = parseBinary(lhs, &Parser::parseEqualityOperators); // skip '&&'
   }
+  return lhs;
 }
 
-void Parser::parseEqualityOperators() {
-  parseRelationalOperators();
-  if (currToken_.getType() == my::TokenType::EQ || currToken_.getType() == my::TokenType::NEQ) {
-    advance(); // skip '=='/'!='
-    parseRelationalOperators();
+ASTNodePtr Parser::parseEqualityOperators() {
+  auto lhs = parseRelationalOperators();
+  while (currToken_.getType() == my::TokenType::EQ || currToken_.getType() == my::TokenType::NEQ) {
+    lhs = parseBinary(lhs, &Parser::parseRelationalOperators); // skip '=='/'!='
   }
+  return lhs;
 }
 
-void Parser::parseRelationalOperators() {
-  parsePlusMinus();
-  if (currToken_.getType() == my::TokenType::LT || currToken_.getType() == my::TokenType::GT) {
-    advance(); // skip '<'/'>'
-    parsePlusMinus();
+ASTNodePtr Parser::parseRelationalOperators() {
+  auto lhs = parsePlusMinus();
+  while (currToken_.getType() == my::TokenType::LT || currToken_.getType() == my::TokenType::GT) {
+    lhs = parseBinary(lhs, &Parser::parsePlusMinus); // skip '<'/'>'
   }
+  return lhs;
 }
 
-void Parser::parsePlusMinus() {
-  parseMulDiv();
-  if (currToken_.getType() == my::TokenType::PLUS || currToken_.getType() == my::TokenType::MINUS) {
-    advance(); // skip '+'/'-'
-    parseMulDiv();
+ASTNodePtr Parser::parsePlusMinus() {
+  auto lhs = parseMulDiv();
+  while (currToken_.getType() == my::TokenType::PLUS || currToken_.getType() == my::TokenType::MINUS) {
+    lhs = parseBinary(lhs, &Parser::parseMulDiv); // skip '+'/'-'
   }
+  return lhs;
 }
 
-void Parser::parseMulDiv() {
-  parseUnary();
-  if (currToken_.getType() == my::TokenType::MUL || currToken_.getType() == my::TokenType::DIV) {
-    advance(); // slip '*'/'\/'
-    parseUnary();
+ASTNodePtr Parser::parseMulDiv() {
+  auto lhs = parseUnary();
+  while (currToken_.getType() == my::TokenType::MUL || currToken_.getType() == my::TokenType::DIV) {
+    lhs = parseBinary(lhs, &Parser::parseUnary); // skip '*'/'\/'
   }
+  return lhs;
+}
+
+ASTNodePtr Parser::parseBinary(const ASTNodePtr& lhs, ASTNodePtr (Parser::*parseOperand)()) {
+  auto binary = makeNode(ASTNodeType::EXPRESSION, currToken_.getValue(), currToken_.getType());
+  advance(); // skip operator
+  binary->addChild(lhs);
+  binary->addChild((this->*parseOperand)());
+  return binary;
 }
 
-void Parser::parseUnary() {
-  parseAtom();
-  if (currToken_.getType() == my::TokenType::NOT) {
-    advance(); // skip
+ASTNodePtr Parser::parseUnary() {
+  if (currToken_.getType() == my::TokenType::NOT || currToken_.getType() == my::TokenType::MINUS) {
+    auto unary = makeNode(ASTNodeType::EXPRESSION, currToken_.getValue(), currToken_.getType());
+    advance(); // skip '!'/'-'
+    unary->addChild(parseUnary());
+    return unary;
   }
+  return parseAtom();
 }
 
-void Parser::parseAtom() {
+ASTNodePtr Parser::parseAtom() {
   const std::string functionName = "parseAtom()";
 
   if (currToken_.getType() == my::TokenType::KEYWORD &&
     (currToken_.getValue() == "true" || currToken_.getValue() == "false")) {
+    auto literal = makeNode(ASTNodeType::LITERAL, currToken_.getValue(), my::TokenType::KEYWORD);
     advance(); // 'true'/'false'
-  } else if (currToken_.getType() == my::TokenType::IDENTIFIER) {
-    parseIdentifier(); // 'identifier'
-  } else if (currToken_.getType() == my::TokenType::LPAREN) { // '(expression)'
+    return literal;
+  }
+  if (currToken_.getType() == my::TokenType::IDENTIFIER) {
+    if (lexer_.peek(currCount - 1).getType() == my::TokenType::LPAREN) {
+      return parseCall(); // 'identifier(arguments)'
+    }
+    auto atom = parseIdentifier(); // 'identifier'
+    while (currToken_.getType() == my::TokenType::LBRACKET) { // 'identifier[index]...'
+      atom = parseSubscript(atom);
+    }
+    return atom;
+  }
+  if (currToken_.getType() == my::TokenType::LPAREN) { // '(expression)'
     advance();
-    parseExpression();
+    auto expression = parseExpression();
     expect(my::TokenType::RPAREN, functionName);
-  } else {
-    parseLiteral(); // 'literal'
+    return expression;
   }
+  return parseLiteral(); // 'literal'
 }
 
-void Parser::parseIndex() {
-  const std::string functionName = "parseIndex()";
+ASTNodePtr Parser::parseCall() {
+  const std::string functionName = "parseCall()";
 
+  auto call = makeNamedNode(ASTNodeType::CALL, currToken_.getValue());
+  expect(my::TokenType::IDENTIFIER, functionName); // function's name
+  expect(my::TokenType::LPAREN, functionName); // '('
+  if (currToken_.getType() != my::TokenType::RPAREN) {
+    call->addChild(parseLogicalOr()); // ',' separates arguments here, not the comma operator
+    while (currToken_.getType() == my::TokenType::COMMA) {
+      advance(); // skip ','
+      call->addChild(parseLogicalOr());
+    }
+  }
+  expect(my::TokenType::RPAREN, functionName); // ')'
+
+  return call;
+}
+
+ASTNodePtr Parser::parseSubscript(const ASTNodePtr& array) {
+  const std::string functionName = "parseSubscript()";
+
+  auto index = makeNode(ASTNodeType::INDEX, "[]", my::TokenType::LBRACKET);
+  expect(my::TokenType::LBRACKET, functionName); // '['
+  index->addChild(array);
+  index->addChild(parseIndex());
+  expect(my::TokenType::RBRACKET, functionName); // ']'
+
+  return index;
+}
+
+ASTNodePtr Parser::parseIndex() {
   if (currToken_.getType() == my::TokenType::IDENTIFIER) {
-    expect(my::TokenType::IDENTIFIER, functionName);
-    // parseIdentifier();
-  } else if (currToken_.getType() == my::TokenType::INTEGER_LITERAL) {
-    expect(my::TokenType::INTEGER_LITERAL, functionName);
-  } else {
-    throw std::runtime_error(
-    "Syntax error at token: '" + currToken_.getValue() +
-     "' (" + getTokenValue(currToken_.getType()) + "), Expected: " +
-     getTokenValue(my::TokenType::IDENTIFIER) + " or " + getTokenValue(my::TokenType::INTEGER_LITERAL) +
-     " || parseIndex()"
-      );
+    return parseIdentifier();
   }
+  if (currToken_.getType() == my::TokenType::INTEGER_LITERAL) {
+    return parseLiteral();
+  }
+  throw std::runtime_error(
+  "Syntax error at token: '" + currToken_.getValue() +
+   "' (" + getTokenValue(currToken_.getType()) + "), Expected: " +
+   getTokenValue(my::TokenType::IDENTIFIER) + " or " + getTokenValue(my::TokenType::INTEGER_LITERAL) +
+   " || parseIndex()"
+    );
 }
 
-void Parser::parseType() {
+TypeId Parser::parseType() {
   const std::string functionName = "parseType()";
 
-  if (isType(currToken_)) {
-    if (currToken_.getType() == my::TokenType::ARRAY) {
-      advance();
+  if (!isType(currToken_)) {
+    throw std::runtime_error("Syntax error: invalid type '" + currToken_.getValue() + "' || pareType()");
+  }
+
+  const my::TokenType type = currToken_.getType();
+  advance();
+
+  switch (type) {
+    case my::TokenType::INT:
+      return TypeTable::INT;
+    case my::TokenType::FLOAT:
+      return TypeTable::FLOAT;
+    case my::TokenType::CHAR:
+      return TypeTable::CHAR;
+    case my::TokenType::BOOL:
+      return TypeTable::BOOL;
+    case my::TokenType::VOID:
+      return TypeTable::VOID;
+    case my::TokenType::STRING:
+      return TypeTable::STRING;
+    default: { // my::TokenType::ARRAY
       expect(my::TokenType::LT, functionName);
-      parseType();
+      const TypeId element = parseType();
       expect(my::TokenType::GT, functionName);
-    } else {
-    advance();
+      return semantic_.getTypes().arrayOf(element);
     }
-  } else {
-    throw std::runtime_error("Syntax error: invalid type '" + currToken_.getValue() + "' || pareType()");
   }
 }
 
-void Parser::parseIdentifier() { // maybe will be rewriting to expect(my::TokenType::IDENTIFIER);
+ASTNodePtr Parser::parseIdentifier() {
   const std::string functionName = "parseIdentifier()";
 
+  auto identifier = makeNamedNode(ASTNodeType::IDENTIFIER, currToken_.getValue());
   expect(my::TokenType::IDENTIFIER, functionName);
+  return identifier;
 }
@@ -0,0 +1,42 @@
+#ifndef FRAME_STACK_H
+#define FRAME_STACK_H
+
+
+#include "../../includes/libraries.h"
+#include "value.h"
+
+
+// On Linux the frame stack is reserved address space that the kernel commits a page at a
+// time; elsewhere it is allocated and initialized at once
+#if defined(__linux__)
+#define RPN_VM_RESERVED_STACK 1
+#else
+#define RPN_VM_RESERVED_STACK 0
+#endif
+
+
+// The values every call frame of a run lives in: one contiguous block that never moves,
+// so a frame is a window into it and native code may keep pointers to it. The capacity
+// is reserved up front, but a page is only backed by memory the first time a frame
+// reaches it (a fresh page reads as Value()s), so the stack grows with the deepest call
+// instead of costing its whole capacity on every run.
+class FrameStack {
+public:
+  explicit FrameStack(size_t capacity);
+  ~FrameStack();
+
+  FrameStack(const FrameStack&) = delete;
+  FrameStack& operator=(const FrameStack&) = delete;
+
+  [[nodiscard]] Value* data() const { return values_; }
+  [[nodiscard]] size_t size() const { return capacity_; } // values
+  [[nodiscard]] const Value* end() const { return values_ + capacity_; }
+
+private:
+  Value* values_ = nullptr;
+  size_t capacity_ = 0;
+  size_t mapped_ = 0; // bytes of the mapping, 0 when allocated with new[]
+};
+
+
+#endif //FRAME_STACK_H
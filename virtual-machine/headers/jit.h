@@ -0,0 +1,126 @@
+#ifndef JIT_H
+#define JIT_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+#include "runtime.h"
+#include "value.h"
+
+
+// The template JIT emits x86-64 and maps it with mmap/mprotect: Linux on x86-64 only,
+// elsewhere Jit compiles nothing and the VM keeps interpreting
+#if defined(__x86_64__) && defined(__linux__)
+#define RPN_VM_JIT 1
+#else
+#define RPN_VM_JIT 0
+#endif
+
+
+// The part of the VM's state native code reads (through r13); fp and sp are written back
+// on every exit to the interpreter
+struct JitContext {
+  Value* fp;
+  Value* sp;
+  Value* globals;
+  const Value* constants;
+  Runtime* runtime;
+  std::ostream* out;
+  // A call from native code: pushes the VM's frame of `function` (the caller's `fp`,
+  // returning to `returnPc`) and returns where the callee's native code starts; nullptr
+  // (nothing pushed) when the interpreter has to make the call
+  const uint8_t* (*call)(JitContext* context, Value* sp, Value* fp, uint32_t function, uint32_t returnPc);
+  // pops the frame of a native call that returned
+  void (*ret)(JitContext* context);
+  void* machine; // the VirtualMachine
+  uint64_t depth; // native calls in progress (each a machine call frame)
+  void* stackPointer; // rsp of the entry, the exit unwinds the native calls to it
+  uint64_t entries; // times native code was entered
+};
+
+
+// What a Jit compiled during one run
+struct JitStatistics {
+  size_t compiledFunctions = 0;
+  size_t bytecodeBytes = 0; // of the compiled functions
+  size_t nativeBytes = 0;
+  size_t exitInstructions = 0; // compiled as an exit to the interpreter (input, errors, HALT)
+};
+
+
+// One function translated to x86-64, in its own mapping that is writable while the code
+// is copied in and executable afterwards (never both). It can be entered at any of the
+// function's instructions: locals and the operand stack stay in the VM's frame, so
+// native code and interpreter hand the same state back and forth.
+class NativeFunction {
+public:
+  // nullptr when the memory cannot be mapped
+  static std::unique_ptr<NativeFunction> create(const std::vector<uint8_t>& code, std::vector<uint32_t> entries,
+    uint32_t first);
+  ~NativeFunction();
+
+  NativeFunction(const NativeFunction&) = delete;
+  NativeFunction& operator=(const NativeFunction&) = delete;
+
+  // Runs from the instruction at `pc` (a bytecode offset) until an instruction left to
+  // the interpreter; returns that instruction's offset, the stack top is context.sp
+  uint32_t run(Value* fp, Value* sp, JitContext& context, uint32_t pc) const;
+
+  // The native address of the instruction at `pc`, for calls from native code
+  [[nodiscard]] const uint8_t* entry(const uint32_t pc) const {
+    return static_cast<const uint8_t*>(memory_) + entries_[pc - first_];
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+private:
+  NativeFunction(void* memory, size_t size, std::vector<uint32_t> entries, uint32_t first) :
+  memory_(memory), size_(size), entries_(std::move(entries)), first_(first) {}
+
+  void* memory_;
+  size_t size_; // of the code (the mapping is rounded up to pages)
+  std::vector<uint32_t> entries_; // native offset of each bytecode offset from first_
+  uint32_t first_;
+};
+
+
+// Baseline JIT of the stack VM. Calls of a function and loop back-edges in it are
+// counted; at HOT_THRESHOLD the function is translated by concatenating one x86-64
+// template per instruction (a template JIT: no register allocation, every instruction
+// reads and writes the VM's stack). Typed instructions and superinstructions become a
+// few machine instructions, generic operators call the runtime, a call of a compiled
+// function is a machine call. Input, calls of functions still interpreted, returns to
+// the interpreter and the rare paths (division by zero, an index out of bounds, a
+// non-bool condition) exit to the interpreter at that instruction, which re-enters the
+// native code at the next call, return or back-edge.
+class Jit {
+public:
+  static constexpr uint32_t HOT_THRESHOLD = 64;
+
+  explicit Jit(const RPNProgram& program) :
+  program_(program), counters_(program.functions.size()), native_(program.functions.size()) {}
+
+  // Counts a call of `function` or a back-edge in it; its native code once it is hot
+  // (compiled from `code`, the VM's quickened copy), nullptr before or if it cannot be
+  const NativeFunction* count(const uint32_t function, const uint8_t* code) {
+    if (native_[function] || ++counters_[function] != HOT_THRESHOLD) {
+      return native_[function].get();
+    }
+    return compile(function, code);
+  }
+
+  [[nodiscard]] const NativeFunction* get(const uint32_t function) const { return native_[function].get(); }
+
+  [[nodiscard]] const JitStatistics& getStatistics() const { return statistics_; }
+
+private:
+  const RPNProgram& program_;
+  std::vector<uint32_t> counters_;
+  std::vector<std::unique_ptr<NativeFunction>> native_;
+  JitStatistics statistics_;
+
+  const NativeFunction* compile(uint32_t function, const uint8_t* code);
+};
+
+
+#endif //JIT_H
@@ -0,0 +1,87 @@
+#ifndef REGION_H
+#define REGION_H
+
+
+#include "../../includes/libraries.h"
+#include "value.h"
+
+
+// How far a region was filled: what Region::release() goes back to
+struct RegionMark {
+  size_t chunk = 0;
+  size_t offset = 0;
+  size_t used = 0;
+  size_t arrays = 0;
+  size_t strings = 0;
+};
+
+
+// What a Region did over its lifetime
+struct RegionStatistics {
+  size_t arrays = 0; // made in the region
+  size_t strings = 0;
+  size_t bytes = 0; // allocated, in total
+  size_t peakBytes = 0; // in use at once
+  size_t chunks = 0; // reserved from the system
+};
+
+
+// Bump allocation for the arrays and strings that never outlive the call making them
+// (see EscapeAnalysis): a call marks the region when it starts and releases back to the
+// mark when it returns, so a local array costs a pointer increment and is gone with its
+// frame. Memory comes in chunks that are kept once reserved, a later call reuses them:
+// a loop calling a function with local arrays allocates nothing after its first
+// iteration. The objects still own what they allocate themselves (row views, the
+// characters of a flat string), a release runs their destructors.
+class Region {
+public:
+  static constexpr size_t CHUNK = 64 * 1024; // bytes, a larger object gets a chunk of its own
+
+  Region() = default;
+  ~Region();
+
+  Region(const Region&) = delete;
+  Region& operator=(const Region&) = delete;
+
+  ArrayObject* newArray(size_t size, Value element);
+  // shape[0] x shape[1] x ... values in one block (rank >= 2, no negative size)
+  ArrayObject* newDenseArray(const int64_t* shape, uint32_t rank, Value element);
+  StringObject* newString(std::string value);
+  StringObject* newRope(const Value& left, const Value& right);
+
+  [[nodiscard]] RegionMark mark() const { return {chunk_, offset_, used_, arrays_.size(), strings_.size()}; }
+  // Destroys everything made since `mark` (nothing to do when nothing was)
+  void release(const RegionMark& mark) {
+    if (offset_ != mark.offset || chunk_ != mark.chunk) {
+      releaseTo(mark);
+    }
+  }
+  void reset() { release(RegionMark()); }
+
+  // The objects alive in the region (the collector's roots)
+  [[nodiscard]] const std::vector<ArrayObject*>& arrays() const { return arrays_; }
+  [[nodiscard]] const std::vector<StringObject*>& strings() const { return strings_; }
+
+  [[nodiscard]] const RegionStatistics& getStatistics() const { return statistics_; }
+
+private:
+  struct Chunk {
+    std::byte* memory;
+    size_t size;
+  };
+
+  std::vector<Chunk> chunks_;
+  size_t chunk_ = 0; // the one being filled
+  size_t offset_ = 0; // into it
+  size_t used_ = 0; // bytes in use
+  std::vector<ArrayObject*> arrays_; // alive, in allocation order
+  std::vector<StringObject*> strings_;
+  RegionStatistics statistics_;
+
+  // `bytes` at a multiple of `alignment` (a power of two, at most a cache line)
+  void* allocate(size_t bytes, size_t alignment);
+  void releaseTo(const RegionMark& mark);
+};
+
+
+#endif //REGION_H
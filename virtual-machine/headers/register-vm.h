@@ -0,0 +1,58 @@
+#ifndef REGISTER_VM_H
+#define REGISTER_VM_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/register-bytecode.h"
+#include "runtime.h"
+#include "value.h"
+#include "vm.h"
+
+
+// Interpreter of the register bytecode. Frames are stacked in one FrameStack like in
+// VirtualMachine, but a frame is only the callee's registers: operands
+// are read from and results written to registers directly, with no operand stack.
+class RegisterMachine {
+public:
+  static constexpr size_t DEFAULT_STACK_SIZE = VirtualMachine::DEFAULT_STACK_SIZE;
+  static constexpr size_t DEFAULT_CALL_DEPTH = VirtualMachine::DEFAULT_CALL_DEPTH;
+
+  explicit RegisterMachine(const RegisterProgram& program, size_t stackSize = DEFAULT_STACK_SIZE);
+
+  // Runs the program from function 0 to HALT; runtime errors are thrown with the line
+  void run(std::istream& in, std::ostream& out);
+
+  // Calls in progress at most; a deeper call is a stack overflow (DEFAULT_CALL_DEPTH)
+  void setCallDepthLimit(const size_t depth) { callDepthLimit_ = depth; }
+  [[nodiscard]] size_t getCallDepthLimit() const { return callDepthLimit_; }
+
+  // Instructions dispatched by the last run()
+  [[nodiscard]] uint64_t getExecutedInstructions() const { return executed_; }
+
+  [[nodiscard]] const Heap& getHeap() const { return runtime_.getHeap(); }
+  // The region of the call frames and the heap, over the machine's runs
+  [[nodiscard]] MemoryStatistics getMemoryStatistics() const { return runtime_.getMemoryStatistics(); }
+
+private:
+  struct CallFrame {
+    const uint8_t* returnAddress;
+    Value* base;
+    uint32_t frameSize; // registers of the caller, the callee's frame starts after them
+    uint32_t destination; // caller's register for the result (CALL)
+    const Value* limit; // the end of the callee's registers
+    FrameMark region; // released when the callee returns
+  };
+
+  const RegisterProgram& program_;
+  FrameStack stack_;
+  std::vector<CallFrame> frames_; // reserved for callDepthLimit_ frames before a run
+  size_t callDepthLimit_ = DEFAULT_CALL_DEPTH;
+  std::vector<Value> globals_;
+  std::vector<Value> constants_; // LOAD_STRING values, interned in the heap
+  Runtime runtime_;
+  std::vector<Value> arraySizes_; // NEW_ARRAY's sizes, gathered from their registers
+  uint64_t executed_ = 0;
+};
+
+
+#endif //REGISTER_VM_H
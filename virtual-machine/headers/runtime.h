@@ -0,0 +1,166 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+
+#include "../../includes/libraries.h"
+#include "region.h"
+#include "value.h"
+
+#include <functional>
+
+
+// Binary operators of the generic slow paths
+enum class Operator : uint8_t {
+  ADD, SUB, MUL, DIV, LT, GT, EQ
+};
+
+
+// What a call took over from its caller (Runtime::enterFrame): where the region was and
+// where the caller's strings go
+struct FrameMark {
+  RegionMark region;
+  bool localStrings = false;
+};
+
+
+// Where the memory of a runtime went
+struct MemoryStatistics {
+  RegionStatistics region;
+  size_t heapObjects = 0; // alive
+  size_t collections = 0;
+  size_t freedObjects = 0; // by the collections
+};
+
+
+// What every interpreter shares: the heap and the operations that are too rare or too
+// long for the dispatch loop (anything but int op int, array creation, input). Errors
+// are thrown without a line, the interpreter adds the line of the failing instruction.
+class Runtime {
+public:
+  // ADD, SUB, MUL, DIV on numbers (float if either side is), string concatenation
+  Value arithmetic(Operator op, const Value& lhs, const Value& rhs);
+
+  // LT, GT, EQ on numbers or strings
+  static bool compare(Operator op, const Value& lhs, const Value& rhs);
+
+  // Scalar conversion to INT, FLOAT, CHAR or BOOL
+  static Value convert(ValueKind target, const Value& value);
+
+  // Array of sizes[0] x sizes[1] x ... elements, innermost ones zero values of `leaf`
+  // (empty arrays for ARRAY); no sizes - an empty array. A `local` one is made in the
+  // region of the running call (see LOCAL_ARRAY), any other on the heap.
+  Value newArray(const Value* sizes, uint32_t dimensions, ValueKind leaf, bool local = false);
+
+  // Inline when short enough, a heap object otherwise
+  Value newString(std::string value) {
+    if (value.size() <= Value::SHORT_STRING) {
+      return Value::ofShortString(value);
+    }
+    return Value::ofString(heap_.newString(std::move(value)));
+  }
+  // A literal: equal long ones are one object
+  Value intern(const std::string_view value) {
+    return value.size() <= Value::SHORT_STRING ? Value::ofShortString(value) : Value::ofString(heap_.intern(value));
+  }
+
+  Value read(std::istream& in, ValueKind kind);
+
+  // Throws if `index` is outside an array of `size` elements
+  static void checkIndex(const int64_t index, const int64_t size) {
+    if (static_cast<uint64_t>(index) >= static_cast<uint64_t>(size)) {
+      outOfBounds(index, size);
+    }
+  }
+
+  [[noreturn]] static void outOfBounds(int64_t index, int64_t size);
+
+  // Throws for a call that is `depth` calls deep when at most `limit` may be, or whose
+  // frame does not fit in a frame stack of `capacity` values
+  [[noreturn]] static void stackOverflow(const std::string& callee, size_t depth, size_t limit, size_t capacity);
+
+  // The slot of array[indices[0]]...[indices[count - 1]], every index checked in order;
+  // a dense array takes the indices of all its dimensions with one flat offset. A row of
+  // a dense array has no slot: nullptr, `array` is then the dense array, `index` the row
+  static Value* locate(ArrayObject*& array, const Value* indices, uint32_t count, int64_t& index);
+
+  // The slot of a dense array's element: one index per dimension, checked in order
+  // (unless the compiler proved them in bounds)
+  template <bool CHECKED = true>
+  static Value* denseSlot(const ArrayObject* array, const Value* indices, const uint32_t count) {
+    int64_t offset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      const int64_t index = indices[i].asInteger();
+      if constexpr (CHECKED) {
+        checkIndex(index, array->shape[i]);
+      }
+      offset += index * array->strides[i];
+    }
+    return array->data + offset;
+  }
+
+  // LOAD_ELEMENT and STORE_ELEMENT
+  static Value loadElement(ArrayObject* array, const Value* indices, uint32_t count);
+  static void storeElement(ArrayObject* array, const Value* indices, uint32_t count, const Value& value);
+
+  // A call starting: the region is marked, and the strings made until it returns go
+  // to the region when none of the callee's outlives it (RPNFunction::localStrings)
+  FrameMark enterFrame(const bool localStrings) {
+    const FrameMark mark{region_.mark(), localStrings_};
+    localStrings_ = localStrings;
+    return mark;
+  }
+  // The call returning: everything it made in the region is released
+  void leaveFrame(const FrameMark& mark) {
+    region_.release(mark.region);
+    localStrings_ = mark.localStrings;
+  }
+  // Before a run: the region empty, the top-level code's strings on the heap
+  void resetRegion() {
+    region_.reset();
+    localStrings_ = false;
+  }
+
+  // The interpreter's values that may point to heap objects (its frames, globals and
+  // constants), as ranges; without them the heap is never collected
+  using RootProvider = std::function<void(std::vector<std::pair<const Value*, const Value*>>&)>;
+  void setRoots(RootProvider roots) { roots_ = std::move(roots); }
+
+  [[nodiscard]] const Heap& getHeap() const { return heap_; }
+  [[nodiscard]] MemoryStatistics getMemoryStatistics() const {
+    return {region_.getStatistics(), heap_.objectCount(), heap_.collections(), heap_.freedObjects()};
+  }
+
+private:
+  Heap heap_;
+  Region region_;
+  bool localStrings_ = false; // the running call's strings go to the region
+  RootProvider roots_;
+  std::vector<std::pair<const Value*, const Value*>> rootRanges_;
+  std::vector<int64_t> shape_; // of the array newArray() makes
+
+  // A long string made by the running call
+  Value makeString(std::string value) {
+    if (value.size() <= Value::SHORT_STRING) {
+      return Value::ofShortString(value);
+    }
+    if (localStrings_) {
+      return Value::ofString(region_.newString(std::move(value)));
+    }
+    collectIfDue();
+    return Value::ofString(heap_.newString(std::move(value)));
+  }
+  // Before a heap allocation: collects when the heap asks for it, `operands` (values of
+  // the operation being run, held nowhere else) are roots too
+  void collectIfDue(const Value* operands = nullptr, const size_t count = 0) {
+    if (heap_.wantsCollection() && roots_) {
+      collect(operands, count);
+    }
+  }
+  void collect(const Value* operands, size_t count);
+
+  // lhs + rhs, a string and a string or a char
+  Value concatenate(const Value& lhs, const Value& rhs);
+};
+
+
+#endif //RUNTIME_H
@@ -0,0 +1,212 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+
+#include <new>
+
+
+struct StringObject;
+struct ArrayObject;
+
+// Runtime value: a kind tag next to an 8-byte payload. Scalars are stored inline, so
+// int, float, char and bool values never touch the heap; so are strings of up to
+// SHORT_STRING characters, longer strings and arrays point to objects owned by the VM's
+// heap. A value is always copied whole (the native code too), `length` included.
+struct Value {
+  static constexpr size_t SHORT_STRING = 8;
+  static constexpr uint8_t LONG_STRING = 0xFF;
+
+  union {
+    int64_t integer;
+    double real;
+    char character;
+    bool boolean;
+    StringObject* string;
+    ArrayObject* array;
+    char characters[SHORT_STRING]; // a short string
+  };
+  ValueKind kind;
+  uint8_t length; // STRING: the characters of a short string, LONG_STRING for a StringObject
+
+  Value() : integer(0), kind(ValueKind::VOID), length(0) {}
+
+  static Value ofInt(const int64_t value) { Value v; v.integer = value; v.kind = ValueKind::INT; return v; }
+  static Value ofFloat(const double value) { Value v; v.real = value; v.kind = ValueKind::FLOAT; return v; }
+  static Value ofChar(const char value) { Value v; v.integer = 0; v.character = value; v.kind = ValueKind::CHAR; return v; }
+  static Value ofBool(const bool value) { Value v; v.integer = 0; v.boolean = value; v.kind = ValueKind::BOOL; return v; }
+  static Value ofString(StringObject* value) {
+    Value v;
+    v.string = value;
+    v.kind = ValueKind::STRING;
+    v.length = LONG_STRING;
+    return v;
+  }
+  // At most SHORT_STRING characters
+  static Value ofShortString(const std::string_view text) {
+    Value v;
+    std::copy(text.begin(), text.end(), v.characters);
+    v.kind = ValueKind::STRING;
+    v.length = static_cast<uint8_t>(text.size());
+    return v;
+  }
+  static Value ofArray(ArrayObject* value) { Value v; v.array = value; v.kind = ValueKind::ARRAY; return v; }
+
+  // int, char and bool as an integer (the operand of integer arithmetic)
+  [[nodiscard]] int64_t asInteger() const {
+    switch (kind) {
+      case ValueKind::CHAR:
+        return character;
+      case ValueKind::BOOL:
+        return boolean;
+      case ValueKind::FLOAT:
+        return static_cast<int64_t>(real);
+      default:
+        return integer;
+    }
+  }
+
+  [[nodiscard]] double asFloat() const {
+    return kind == ValueKind::FLOAT ? real : static_cast<double>(asInteger());
+  }
+
+  // condition value of a scalar
+  [[nodiscard]] bool isTrue() const {
+    return kind == ValueKind::FLOAT ? real != 0.0 : asInteger() != 0;
+  }
+
+  // The characters of a string, flattening a rope; valid as long as the value is
+  [[nodiscard]] std::string_view text() const;
+  [[nodiscard]] size_t stringLength() const;
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay two words");
+
+
+// A string longer than Value::SHORT_STRING characters. Strings are immutable once
+// created, so sharing one object gives value semantics and nothing is ever copied to be
+// changed. A concatenation longer than FLAT_CONCATENATION is a rope node: it keeps its
+// two parts and only copies them into `flat` the first time its characters are needed,
+// so a loop appending to a string costs its length once instead of on every append.
+struct StringObject {
+  static constexpr size_t FLAT_CONCATENATION = 64;
+
+  std::string flat; // the characters, once flat
+  Value left; // the parts of a rope node not flattened yet, VOID when flat
+  Value right;
+  size_t length = 0;
+
+  [[nodiscard]] bool isFlat() const { return left.kind == ValueKind::VOID; }
+  std::string_view text() {
+    if (!isFlat()) {
+      flatten();
+    }
+    return flat;
+  }
+  // Copies the leaves of the rope in order (without recursion, ropes are as deep as
+  // the loops building them are long) and drops the parts
+  void flatten();
+};
+
+inline std::string_view Value::text() const {
+  return length == LONG_STRING ? string->text() : std::string_view(characters, length);
+}
+
+inline size_t Value::stringLength() const {
+  return length == LONG_STRING ? string->length : length;
+}
+
+// Storage of array elements: one 64-byte (cache line) aligned block
+struct AlignedDelete {
+  void operator()(Value* data) const { ::operator delete(data, std::align_val_t{64}); }
+};
+using ElementBlock = std::unique_ptr<Value[], AlignedDelete>;
+
+ElementBlock allocateElements(size_t count, Value element);
+
+// Copies `shape` to dimensions[0, rank) and its strides (in values) to dimensions[rank,
+// 2 * rank); returns the values of the dense block, std::bad_alloc if they cannot fit
+size_t denseLayout(const int64_t* shape, uint32_t rank, int64_t* dimensions);
+
+
+// Arrays are shared by reference. A rank 1 array holds `size` values at `data`. An array
+// of several dimensions created at once is dense: one block of all its innermost values
+// in row-major order, `shape` and `strides` (in values) per dimension, so an element of
+// every dimension is data[i0 * strides[0] + i1 * strides[1] + ...]. Its rows are views
+// into the block, made when first loaded and kept; storing a whole row makes the array
+// (and the dense arrays it is a row of) jagged: rank 1, values of its row views.
+struct ArrayObject {
+  Value* data = nullptr;
+  int64_t size = 0; // elements of the first dimension (shape[0] when dense)
+  uint32_t rank = 1; // dimensions stored in `data`
+  const int64_t* shape = nullptr; // dense only
+  const int64_t* strides = nullptr; // dense only, the last one 1
+  ArrayObject* parent = nullptr; // the dense array this one is a row of
+  std::vector<std::unique_ptr<ArrayObject>> rows; // views made so far, by index (dense)
+  std::unique_ptr<int64_t[]> dimensions; // shape and strides of a dense root
+  ElementBlock block; // the values of a root, the dense block of a dense one (none in a Region)
+  Value* dense = nullptr; // the dense block of a dense root, wherever it is
+  ElementBlock elements; // the values of a dense array made jagged
+
+  // Unchecked element access
+  Value load(const int64_t index) { return rank == 1 ? data[index] : Value::ofArray(row(index)); }
+  void store(const int64_t index, const Value& value) {
+    if (rank > 1) {
+      makeJagged();
+    }
+    data[index] = value;
+  }
+
+  // The view of row `index` of a dense array
+  ArrayObject* row(int64_t index);
+  void makeJagged();
+};
+
+
+// Owner of every string and array a run creates that is not in a Region. Strings are
+// immutable and shared, so they need no reference counts; nothing is freed but by
+// collect(), a mark and sweep from the values the interpreter passes as roots.
+class Heap {
+public:
+  static constexpr size_t MIN_COLLECTION = 1 << 16; // objects made before the first collection
+
+  StringObject* newString(std::string value);
+  // The rope node of left + right, both strings
+  StringObject* newRope(const Value& left, const Value& right);
+  // The one object of `value` (literals: equal ones share it, they are never freed)
+  StringObject* intern(std::string_view value);
+  ArrayObject* newArray(size_t size, Value element = Value());
+  // shape[0] x shape[1] x ... values in one block (rank >= 2, no negative size)
+  ArrayObject* newDenseArray(const int64_t* shape, uint32_t rank, Value element);
+
+  [[nodiscard]] size_t objectCount() const { return strings_.size() + arrays_.size(); }
+
+  // Whether enough was made since the last collection for another to pay off: the heap
+  // may double between two
+  [[nodiscard]] bool wantsCollection() const { return objectCount() >= threshold_; }
+  // Frees every object that neither a root value (the ranges) nor `arrays` and
+  // `strings` (alive elsewhere) reach. A root may be a stale value (a slot of a frame
+  // that returned): an object pointer is only followed when it is one of the heap's.
+  void collect(const std::vector<std::pair<const Value*, const Value*>>& roots,
+    const std::vector<ArrayObject*>& arrays, const std::vector<StringObject*>& strings);
+
+  [[nodiscard]] size_t collections() const { return collections_; }
+  [[nodiscard]] size_t freedObjects() const { return freed_; }
+
+private:
+  std::vector<std::unique_ptr<StringObject>> strings_;
+  std::unordered_map<std::string_view, StringObject*> interned_; // keys view `flat`
+  std::vector<std::unique_ptr<ArrayObject>> arrays_;
+  size_t threshold_ = MIN_COLLECTION;
+  size_t collections_ = 0;
+  size_t freed_ = 0;
+};
+
+
+// cout formatting: bool as 1/0, arrays as [a, b, c]
+void printValue(std::ostream& out, const Value& value);
+
+
+#endif //VALUE_H
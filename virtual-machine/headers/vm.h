@@ -0,0 +1,118 @@
+#ifndef VM_H
+#define VM_H
+
+
+#include "../../includes/libraries.h"
+#include "../../semantic-analyzer/headers/bytecode.h"
+#include "frame-stack.h"
+#include "jit.h"
+#include "runtime.h"
+#include "value.h"
+
+
+// Direct-threaded dispatch through computed goto where the compiler supports it (GCC,
+// Clang); define RPN_VM_SWITCH_DISPATCH to force the portable switch loop
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(RPN_VM_SWITCH_DISPATCH)
+#define RPN_VM_COMPUTED_GOTO 1
+#else
+#define RPN_VM_COMPUTED_GOTO 0
+#endif
+
+
+// How often each opcode, and each sequence of two and three consecutively dispatched
+// opcodes, ran in VirtualMachine::run(in, out, profile); superinstructions are chosen
+// from these counts (see PeepholeOptimizer)
+struct DispatchProfile {
+  std::vector<uint64_t> opcodes = std::vector<uint64_t>(OPCODE_COUNT);
+  std::vector<uint64_t> pairs = std::vector<uint64_t>(OPCODE_COUNT * OPCODE_COUNT); // first * COUNT + second
+  std::vector<uint64_t> triples = std::vector<uint64_t>(OPCODE_COUNT * OPCODE_COUNT * OPCODE_COUNT);
+
+  void record(const uint8_t op) {
+    ++opcodes[op];
+    if (history_ > 0) {
+      ++pairs[last_ * OPCODE_COUNT + op];
+    }
+    if (history_ > 1) {
+      ++triples[(beforeLast_ * OPCODE_COUNT + last_) * OPCODE_COUNT + op];
+    }
+    beforeLast_ = last_;
+    last_ = op;
+    history_ = std::min<size_t>(history_ + 1, 2);
+  }
+
+private:
+  size_t beforeLast_ = 0;
+  size_t last_ = 0;
+  size_t history_ = 0;
+};
+
+
+// Interpreter of the stack bytecode. All frames live in one FrameStack, reserved once per
+// machine: a frame is the callee's slots (its arguments are the caller's topmost stack
+// values, so a call copies nothing) followed by its operand stack, both sized by the
+// compiler, and a call allocates nothing. Each run works on its
+// own copy of the code: a generic operator rewrites itself into a guarded specialization
+// for the operand kinds of its first execution (quickening, see bytecode.h). With the
+// JIT on, hot functions run as native code from then on (see Jit).
+class VirtualMachine {
+public:
+  static constexpr size_t DEFAULT_STACK_SIZE = 1 << 20; // values (16 MiB of address space)
+  static constexpr size_t DEFAULT_CALL_DEPTH = 100000;
+
+  explicit VirtualMachine(const RPNProgram& program, size_t stackSize = DEFAULT_STACK_SIZE);
+
+  // Runs the program from function 0 to HALT; runtime errors are thrown with the line
+  void run(std::istream& in, std::ostream& out);
+  // The same, counting the dispatched opcodes into `profile` (slower)
+  void run(std::istream& in, std::ostream& out, DispatchProfile& profile);
+
+  // Calls in progress at most; a deeper call is a stack overflow (DEFAULT_CALL_DEPTH)
+  void setCallDepthLimit(const size_t depth) { callDepthLimit_ = depth; }
+  [[nodiscard]] size_t getCallDepthLimit() const { return callDepthLimit_; }
+
+  // Off by default; does nothing where the JIT is not supported (RPN_VM_JIT)
+  void setJit(const bool enabled) { jitEnabled_ = enabled; }
+
+  // Instructions dispatched by the last run() (those run as native code are not counted)
+  [[nodiscard]] uint64_t getExecutedInstructions() const { return executed_; }
+  // Functions compiled and native code entries of the last run() with the JIT on
+  [[nodiscard]] JitStatistics getJitStatistics() const { return jit_ ? jit_->getStatistics() : JitStatistics(); }
+  [[nodiscard]] uint64_t getNativeEntries() const { return nativeEntries_; }
+
+  [[nodiscard]] const Heap& getHeap() const { return runtime_.getHeap(); }
+  // The region of the call frames and the heap, over the machine's runs
+  [[nodiscard]] MemoryStatistics getMemoryStatistics() const { return runtime_.getMemoryStatistics(); }
+
+private:
+  struct CallFrame {
+    uint32_t function;
+    const uint8_t* returnAddress;
+    Value* base;
+    const Value* limit; // the end of the callee's frame
+    FrameMark region; // released when the callee returns
+  };
+
+  const RPNProgram& program_;
+  std::vector<uint8_t> code_; // the program's code, quickened while it runs
+  FrameStack stack_;
+  std::vector<CallFrame> frames_; // reserved for callDepthLimit_ frames before a run
+  size_t callDepthLimit_ = DEFAULT_CALL_DEPTH;
+  std::vector<Value> globals_;
+  std::vector<Value> constants_; // PUSH_STRING values, interned in the heap
+  Runtime runtime_;
+  uint64_t executed_ = 0;
+  bool jitEnabled_ = false;
+  std::unique_ptr<Jit> jit_; // per run: it compiles the run's quickened code
+  uint64_t nativeEntries_ = 0;
+
+  // JitContext::call and ret
+  static const uint8_t* nativeCall(JitContext* context, Value* sp, Value* fp, uint32_t function,
+    uint32_t returnPc) noexcept;
+  static void nativeReturn(JitContext* context) noexcept;
+
+  template <bool PROFILE>
+  void execute(std::istream& in, std::ostream& out, DispatchProfile* profile);
+};
+
+
+#endif //VM_H
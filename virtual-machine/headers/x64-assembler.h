@@ -0,0 +1,111 @@
+#ifndef X64_ASSEMBLER_H
+#define X64_ASSEMBLER_H
+
+
+#include "../../includes/libraries.h"
+
+
+// General purpose registers by their encoding (R8..R15 take a REX bit)
+enum class Reg : uint8_t {
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// The xmm registers the JIT uses
+enum class Xmm : uint8_t {
+  XMM0, XMM1
+};
+
+// Condition codes of jcc / setcc
+enum class Condition : uint8_t {
+  B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7, P = 0xA, NP = 0xB, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF
+};
+
+
+// Position in the code, bound once; jumps to it before it is bound are patched by bind()
+struct Label {
+  int64_t position = -1;
+  std::vector<size_t> patches; // offsets of rel32 fields jumping here
+};
+
+
+// Encoder of the few x86-64 instructions the template JIT emits. Every memory operand is
+// [base + disp32]; 64-bit operations unless the name says otherwise.
+class X64Assembler {
+public:
+  [[nodiscard]] const std::vector<uint8_t>& code() const { return code_; }
+  [[nodiscard]] size_t size() const { return code_.size(); }
+
+  void bind(Label& label);
+
+  void push(Reg reg);
+  void pop(Reg reg);
+  void ret() { byte(0xC3); }
+
+  void mov(Reg destination, Reg source); // mov r64, r64
+  void mov(Reg destination, Reg base, int32_t disp); // mov r64, [base + disp]
+  void mov(Reg base, int32_t disp, Reg source); // mov [base + disp], r64
+  void movImmediate(Reg destination, uint64_t value); // mov r64, imm64 (shorter forms when it fits)
+  void movImmediate(Reg base, int32_t disp, int32_t value); // mov qword [base + disp], sign-extended imm32
+  void movByte(Reg base, int32_t disp, uint8_t value); // mov byte [base + disp], imm8
+  void movzxByte(Reg destination); // movzx r32, r8 of the same register (al, cl, ...)
+  void movzxByte(Reg destination, Reg base, int32_t disp); // movzx r32, byte [base + disp]
+  void movsxByte(Reg destination, Reg base, int32_t disp); // movsx r64, byte [base + disp]
+
+  void add(Reg destination, int32_t value); // add r64, imm32
+  void add(Reg destination, Reg source); // add r64, r64
+  void add(Reg base, int32_t disp, Reg source); // add [base + disp], r64
+  void addImmediate(Reg base, int32_t disp, int32_t value); // add qword [base + disp], imm32
+  void sub(Reg destination, int32_t value);
+  void sub(Reg base, int32_t disp, Reg source);
+  void imul(Reg destination, Reg base, int32_t disp); // imul r64, [base + disp]
+  void negate(Reg base, int32_t disp); // neg qword [base + disp]
+  void negate(Reg reg); // neg r64
+  void shl(Reg reg, uint8_t count); // shl r64, imm8
+  void cqo() { bytes({0x48, 0x99}); }
+  void idiv(Reg divisor);
+  void cmp(Reg lhs, Reg base, int32_t disp); // cmp r64, [base + disp]
+  void cmp(Reg lhs, int32_t value); // cmp r64, imm32
+  void cmpImmediate(Reg base, int32_t disp, int32_t value); // cmp qword [base + disp], imm32
+  void cmpDword(Reg base, int32_t disp, int32_t value); // cmp dword [base + disp], imm32
+  void cmpByte(Reg base, int32_t disp, uint8_t value); // cmp byte [base + disp], imm8
+  void xorByte(Reg base, int32_t disp, uint8_t value); // xor byte [base + disp], imm8
+  void test(Reg lhs, Reg rhs);
+  void testByte(Reg reg); // test r8, r8 of the same register
+  void set(Condition condition, Reg reg); // setcc r8
+  void andByte(Reg destination, Reg source); // and r8, r8
+  void orByte(Reg destination, Reg source); // or r8, r8
+
+  void movsd(Xmm destination, Reg base, int32_t disp); // movsd xmm, [base + disp]
+  void movsd(Reg base, int32_t disp, Xmm source); // movsd [base + disp], xmm
+  void addsd(Xmm destination, Reg base, int32_t disp);
+  void subsd(Xmm destination, Reg base, int32_t disp);
+  void mulsd(Xmm destination, Reg base, int32_t disp);
+  void divsd(Xmm destination, Reg base, int32_t disp);
+  void ucomisd(Xmm lhs, Reg base, int32_t disp);
+  void cvtsi2sd(Xmm destination, Reg base, int32_t disp); // int64 [base + disp] to double
+
+  void jmp(Label& label);
+  void jmp(Condition condition, Label& label);
+  void jmp(Reg target); // jmp r64
+  void call(Reg target); // call r64
+  void lea(Reg destination, Label& label); // lea r64, [rip + label]
+
+private:
+  std::vector<uint8_t> code_;
+
+  void byte(const uint8_t value) { code_.push_back(value); }
+  void bytes(std::initializer_list<uint8_t> values) { code_.insert(code_.end(), values); }
+  void int32(int32_t value);
+  // REX prefix when it is needed: W (64-bit operand), R (reg >= 8), B (base/rm >= 8)
+  void rex(bool wide, uint8_t reg, uint8_t rm, bool force = false);
+  // ModRM (and SIB for RSP/R12) of [base + disp32]
+  void memory(uint8_t reg, Reg base, int32_t disp);
+  // ModRM of a register operand
+  void direct(uint8_t reg, uint8_t rm) { byte(static_cast<uint8_t>(0xC0 | (reg & 7) << 3 | (rm & 7))); }
+  // [prefix] REX 0F opcode with an xmm register and a memory operand
+  void sse(uint8_t prefix, uint8_t opcode, Xmm reg, Reg base, int32_t disp, bool wide = false);
+  void rel32(Label& label);
+};
+
+
+#endif //X64_ASSEMBLER_H
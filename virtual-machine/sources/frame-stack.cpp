@@ -0,0 +1,32 @@
+#include "../headers/frame-stack.h"
+
+#if RPN_VM_RESERVED_STACK
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+FrameStack::FrameStack(const size_t capacity) : capacity_(capacity) {
+#if RPN_VM_RESERVED_STACK
+  static_assert(static_cast<uint8_t>(ValueKind::VOID) == 0, "a zero page must read as Value()s");
+  const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t bytes = (std::max<size_t>(capacity, 1) * sizeof(Value) + page - 1) / page * page;
+  void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (memory != MAP_FAILED) {
+    values_ = static_cast<Value*>(memory);
+    mapped_ = bytes;
+    return;
+  }
+#endif
+  values_ = new Value[capacity];
+}
+
+FrameStack::~FrameStack() {
+#if RPN_VM_RESERVED_STACK
+  if (mapped_ != 0) {
+    munmap(values_, mapped_);
+    return;
+  }
+#endif
+  delete[] values_;
+}
@@ -0,0 +1,947 @@
+#include "../headers/jit.h"
+
+#include "../headers/x64-assembler.h"
+
+#include <cstddef>
+#include <deque>
+
+#if RPN_VM_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// Register roles in native code: rbx - frame (fp), r12 - stack top (sp), r13 - JitContext
+static constexpr Reg FP = Reg::RBX;
+static constexpr Reg SP = Reg::R12;
+static constexpr Reg CONTEXT = Reg::R13;
+
+static constexpr int32_t VALUE = sizeof(Value);
+static constexpr int32_t KIND = offsetof(Value, kind);
+static_assert(offsetof(Value, integer) == 0 && KIND == 8, "native code expects the payload, then the kind");
+
+static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+// slots and globals are addressed with a 32-bit displacement
+static constexpr uint32_t MAX_SLOTS = 1u << 26;
+
+
+// Runtime calls of native code: the operands are on the stack below `sp`. None may let an
+// exception through native frames (they have no unwind information), so a failing one
+// returns false, changes nothing, and the native code exits to the interpreter at the
+// instruction, which runs it again and throws with the line.
+
+static bool binaryOperator(JitContext* context, Value* sp, const uint32_t op) noexcept {
+  try {
+    const Value& lhs = sp[-2];
+    const Value& rhs = sp[-1];
+    switch (static_cast<OpCode>(op)) {
+      case OpCode::ADD:
+        sp[-2] = context->runtime->arithmetic(Operator::ADD, lhs, rhs);
+        break;
+      case OpCode::SUB:
+        sp[-2] = context->runtime->arithmetic(Operator::SUB, lhs, rhs);
+        break;
+      case OpCode::MUL:
+        sp[-2] = context->runtime->arithmetic(Operator::MUL, lhs, rhs);
+        break;
+      case OpCode::DIV:
+        sp[-2] = context->runtime->arithmetic(Operator::DIV, lhs, rhs);
+        break;
+      case OpCode::LT:
+        sp[-2] = Value::ofBool(Runtime::compare(Operator::LT, lhs, rhs));
+        break;
+      case OpCode::GT:
+        sp[-2] = Value::ofBool(Runtime::compare(Operator::GT, lhs, rhs));
+        break;
+      case OpCode::EQ:
+        sp[-2] = Value::ofBool(Runtime::compare(Operator::EQ, lhs, rhs));
+        break;
+      default:
+        sp[-2] = Value::ofBool(!Runtime::compare(Operator::EQ, lhs, rhs));
+        break;
+    }
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool unaryOperator(JitContext*, Value* sp, const uint32_t op) noexcept {
+  try {
+    Value& value = sp[-1];
+    switch (static_cast<OpCode>(op)) {
+      case OpCode::NEG:
+        if (value.kind == ValueKind::FLOAT) {
+          value.real = -value.real;
+        } else {
+          value = Value::ofInt(static_cast<int64_t>(0 - static_cast<uint64_t>(value.asInteger())));
+        }
+        break;
+      case OpCode::NOT:
+        value = Value::ofBool(!value.isTrue());
+        break;
+      case OpCode::TO_INT:
+        value = Runtime::convert(ValueKind::INT, value);
+        break;
+      case OpCode::TO_FLOAT:
+        value = Runtime::convert(ValueKind::FLOAT, value);
+        break;
+      case OpCode::TO_CHAR:
+        value = Runtime::convert(ValueKind::CHAR, value);
+        break;
+      default:
+        value = Value::ofBool(value.isTrue());
+        break;
+    }
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool loadIndex(JitContext*, Value* sp) noexcept {
+  ArrayObject* array = sp[-2].array;
+  const int64_t index = sp[-1].asInteger();
+  if (static_cast<uint64_t>(index) >= static_cast<uint64_t>(array->size)) {
+    return false;
+  }
+  try {
+    sp[-2] = array->load(index);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool storeIndex(JitContext*, Value* sp) noexcept {
+  ArrayObject* array = sp[-3].array;
+  const int64_t index = sp[-2].asInteger();
+  if (static_cast<uint64_t>(index) >= static_cast<uint64_t>(array->size)) {
+    return false;
+  }
+  try {
+    array->store(index, sp[-1]);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+// Nothing changes before an index fails: the interpreter runs the instruction again
+static bool loadElement(JitContext*, Value* sp, const uint32_t count) noexcept {
+  try {
+    Value* indices = sp - count;
+    ArrayObject* array = indices[-1].array;
+    indices[-1] = array->rank == count ? *Runtime::denseSlot(array, indices, count)
+                                       : Runtime::loadElement(array, indices, count);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool storeElement(JitContext*, Value* sp, const uint32_t count) noexcept {
+  try {
+    Value* array = sp - count - 2;
+    if (array->array->rank == count) {
+      *Runtime::denseSlot(array->array, array + 1, count) = sp[-1];
+    } else {
+      Runtime::storeElement(array->array, array + 1, count, sp[-1]);
+    }
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool newArray(JitContext* context, Value* sp, const uint32_t dimensions, const uint32_t kind) noexcept {
+  try {
+    Value* sizes = sp - dimensions;
+    *sizes = context->runtime->newArray(sizes, dimensions, arrayLeaf(kind), isLocalArray(kind));
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+static bool print(JitContext* context, Value* sp) noexcept {
+  try {
+    printValue(*context->out, sp[-1]);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+// The SwitchTable::find() index of the string below `sp`
+static uint64_t switchString(const SwitchTable* table, const Value* sp,
+  const std::vector<std::string>* strings) noexcept {
+  return table->find(sp[-1].text(), *strings);
+}
+
+
+// Emits the templates of one function
+class TemplateCompiler {
+public:
+  TemplateCompiler(const RPNProgram& program, const RPNFunction& function, const uint8_t* code) :
+  program_(program), function_(function), code_(code), labels_(function.end - function.entry) {}
+
+  // The machine code (prologue at offset 0) and the native offset of every instruction
+  std::pair<std::vector<uint8_t>, std::vector<uint32_t>> compile(JitStatistics& statistics);
+
+private:
+  struct Exit {
+    Label label;
+    uint32_t pc;
+  };
+
+  const RPNProgram& program_;
+  const RPNFunction& function_;
+  const uint8_t* code_;
+  X64Assembler assembler_;
+  std::vector<Label> labels_; // of each bytecode offset from the entry
+  std::deque<Exit> exits_; // out-of-line exits of the rare paths
+  Label epilogue_;
+
+  // returns to the interpreter at the instruction `pc`
+  void exit(uint32_t pc);
+  // the label of an out-of-line exit at `pc`
+  Label& exitLabel(uint32_t pc);
+  void jumpTo(uint32_t target, std::optional<Condition> condition);
+
+  void copy(Reg fromBase, int32_t from, Reg toBase, int32_t to); // one Value, through rax and rcx
+  void push(int32_t payload, ValueKind kind);
+  // the runtime call `helper(context, sp, first, second)`; exits at `pc` if it fails
+  void call(const void* helper, uint32_t pc, std::optional<uint32_t> first = {}, std::optional<uint32_t> second = {});
+  void integerOperation(OpCode op, uint32_t pc); // ADD..NEQ on the payloads, the kinds are INT
+  void floatOperation(OpCode op); // ADD..NEQ on the doubles, the kinds are FLOAT
+  void comparison(Condition condition); // al = condition, then the BOOL result replaces the operands
+  // Turns the int, char or bool value at [sp + disp] into its integer payload in place
+  // (the kind is left, the value is consumed by the instruction); other kinds go to `fallback`
+  void integerOperand(int32_t disp, Label& fallback);
+  // ADD..NEQ or a QUICK_*_INT: inline on integer operands, the runtime otherwise
+  void guardedIntegerOperation(OpCode op, uint32_t pc);
+  // TO_INT or TO_CHAR: inline on an integer, the runtime otherwise
+  void integerConversion(OpCode op, uint32_t pc);
+  // LOAD_INDEX, STORE_INDEX, LOAD_ELEMENT, STORE_ELEMENT of `count` indices: the flat
+  // offset inline when the array stores exactly `count` dimensions and the indices are
+  // ints in bounds, `helper` otherwise; `checked` false for the *_UNCHECKED ones, whose
+  // indices are ints in bounds whenever the array has those dimensions
+  void element(uint32_t count, bool store, bool checked, const void* helper, uint32_t pc);
+  // CALL of `function`: a machine call of its native code when it has any
+  void nativeCall(uint32_t function, uint32_t pc);
+  // RETURN (with a value) or RETURN_VOID: a machine return to a native caller
+  void nativeReturn(bool value, uint32_t pc);
+  // SWITCH_TABLE or SWITCH_STRING once rax holds the find() index: an indirect jump into a
+  // table of jmp rel32 (five bytes each) to the targets
+  void switchDispatch(const SwitchTable& table);
+  void instruction(OpCode op, uint32_t pc);
+
+  [[nodiscard]] uint32_t operand(const uint32_t pc, const int index) const {
+    return readOperand(code_ + pc + 1 + 4 * index);
+  }
+  [[nodiscard]] static int32_t slot(const uint32_t index) { return static_cast<int32_t>(index) * VALUE; }
+};
+
+
+std::pair<std::vector<uint8_t>, std::vector<uint32_t>> TemplateCompiler::compile(JitStatistics& statistics) {
+  // uint32_t run(Value* fp, Value* sp, JitContext* context, const void* target): the
+  // callee-saved registers it uses are kept (five pushes align the stack for calls)
+  assembler_.push(Reg::RBP);
+  assembler_.push(FP);
+  assembler_.push(SP);
+  assembler_.push(CONTEXT);
+  assembler_.push(Reg::R14);
+  assembler_.mov(FP, Reg::RDI);
+  assembler_.mov(SP, Reg::RSI);
+  assembler_.mov(CONTEXT, Reg::RDX);
+  assembler_.mov(CONTEXT, offsetof(JitContext, stackPointer), Reg::RSP);
+  assembler_.jmp(Reg::RCX);
+
+  std::vector<uint32_t> entries(labels_.size(), NO_ENTRY);
+  for (uint32_t pc = function_.entry; pc < function_.end;) {
+    const auto op = static_cast<OpCode>(code_[pc]);
+    entries[pc - function_.entry] = static_cast<uint32_t>(assembler_.size());
+    assembler_.bind(labels_[pc - function_.entry]);
+    instruction(op, pc);
+    switch (op) {
+      case OpCode::READ:
+      case OpCode::TRAP:
+      case OpCode::HALT:
+        ++statistics.exitInstructions;
+        break;
+      default:
+        break;
+    }
+    pc += static_cast<uint32_t>(instructionSize(op));
+  }
+
+  for (Exit& exit : exits_) {
+    assembler_.bind(exit.label);
+    this->exit(exit.pc);
+  }
+
+  // eax holds the offset to resume at; the machine frames of native calls are dropped,
+  // the VM's frames of those calls are already pushed
+  assembler_.bind(epilogue_);
+  assembler_.mov(CONTEXT, offsetof(JitContext, fp), FP);
+  assembler_.mov(CONTEXT, offsetof(JitContext, sp), SP);
+  assembler_.movImmediate(CONTEXT, offsetof(JitContext, depth), 0);
+  assembler_.mov(Reg::RSP, CONTEXT, offsetof(JitContext, stackPointer));
+  assembler_.pop(Reg::R14);
+  assembler_.pop(CONTEXT);
+  assembler_.pop(SP);
+  assembler_.pop(FP);
+  assembler_.pop(Reg::RBP);
+  assembler_.ret();
+  return {assembler_.code(), std::move(entries)};
+}
+
+void TemplateCompiler::exit(const uint32_t pc) {
+  assembler_.movImmediate(Reg::RAX, pc);
+  assembler_.jmp(epilogue_);
+}
+
+Label& TemplateCompiler::exitLabel(const uint32_t pc) {
+  return exits_.emplace_back(Exit{Label(), pc}).label;
+}
+
+void TemplateCompiler::jumpTo(const uint32_t target, const std::optional<Condition> condition) {
+  // a target outside the function (none is generated) is left to the interpreter
+  Label& label = target >= function_.entry && target < function_.end ? labels_[target - function_.entry] :
+    exitLabel(target);
+  if (condition) {
+    assembler_.jmp(*condition, label);
+  } else {
+    assembler_.jmp(label);
+  }
+}
+
+void TemplateCompiler::copy(const Reg fromBase, const int32_t from, const Reg toBase, const int32_t to) {
+  assembler_.mov(Reg::RAX, fromBase, from);
+  assembler_.mov(Reg::RCX, fromBase, from + 8);
+  assembler_.mov(toBase, to, Reg::RAX);
+  assembler_.mov(toBase, to + 8, Reg::RCX);
+}
+
+void TemplateCompiler::push(const int32_t payload, const ValueKind kind) {
+  assembler_.movImmediate(SP, 0, payload);
+  assembler_.movByte(SP, KIND, static_cast<uint8_t>(kind));
+  assembler_.add(SP, VALUE);
+}
+
+void TemplateCompiler::call(const void* helper, const uint32_t pc, const std::optional<uint32_t> first,
+  const std::optional<uint32_t> second) {
+  assembler_.mov(Reg::RDI, CONTEXT);
+  assembler_.mov(Reg::RSI, SP);
+  if (first) {
+    assembler_.movImmediate(Reg::RDX, *first);
+  }
+  if (second) {
+    assembler_.movImmediate(Reg::RCX, *second);
+  }
+  assembler_.movImmediate(Reg::RAX, reinterpret_cast<uint64_t>(helper));
+  assembler_.call(Reg::RAX);
+  assembler_.testByte(Reg::RAX);
+  assembler_.jmp(Condition::E, exitLabel(pc));
+}
+
+void TemplateCompiler::integerOperation(const OpCode op, const uint32_t pc) {
+  switch (op) {
+    case OpCode::ADD:
+      assembler_.mov(Reg::RAX, SP, -VALUE);
+      assembler_.add(SP, -2 * VALUE, Reg::RAX);
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::SUB:
+      assembler_.mov(Reg::RAX, SP, -VALUE);
+      assembler_.sub(SP, -2 * VALUE, Reg::RAX);
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::MUL:
+      assembler_.mov(Reg::RAX, SP, -2 * VALUE);
+      assembler_.imul(Reg::RAX, SP, -VALUE);
+      assembler_.mov(SP, -2 * VALUE, Reg::RAX);
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::DIV: {
+      // by zero: the interpreter throws; by -1: negation (INT64_MIN / -1 wraps, idiv would trap)
+      Label divide;
+      Label store;
+      assembler_.mov(Reg::RCX, SP, -VALUE);
+      assembler_.test(Reg::RCX, Reg::RCX);
+      assembler_.jmp(Condition::E, exitLabel(pc));
+      assembler_.mov(Reg::RAX, SP, -2 * VALUE);
+      assembler_.cmp(Reg::RCX, -1);
+      assembler_.jmp(Condition::NE, divide);
+      assembler_.negate(Reg::RAX);
+      assembler_.jmp(store);
+      assembler_.bind(divide);
+      assembler_.cqo();
+      assembler_.idiv(Reg::RCX);
+      assembler_.bind(store);
+      assembler_.mov(SP, -2 * VALUE, Reg::RAX);
+      assembler_.sub(SP, VALUE);
+      break;
+    }
+    default: {
+      assembler_.mov(Reg::RAX, SP, -2 * VALUE);
+      assembler_.cmp(Reg::RAX, SP, -VALUE);
+      const Condition condition = op == OpCode::LT ? Condition::L : op == OpCode::GT ? Condition::G :
+        op == OpCode::EQ ? Condition::E : Condition::NE;
+      comparison(condition);
+      break;
+    }
+  }
+}
+
+void TemplateCompiler::floatOperation(const OpCode op) {
+  switch (op) {
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+    case OpCode::DIV:
+      assembler_.movsd(Xmm::XMM0, SP, -2 * VALUE);
+      if (op == OpCode::ADD) {
+        assembler_.addsd(Xmm::XMM0, SP, -VALUE);
+      } else if (op == OpCode::SUB) {
+        assembler_.subsd(Xmm::XMM0, SP, -VALUE);
+      } else if (op == OpCode::MUL) {
+        assembler_.mulsd(Xmm::XMM0, SP, -VALUE);
+      } else {
+        assembler_.divsd(Xmm::XMM0, SP, -VALUE);
+      }
+      assembler_.movsd(SP, -2 * VALUE, Xmm::XMM0);
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::LT: // b > a: "above" is false when unordered, like a < b with a NaN
+      assembler_.movsd(Xmm::XMM0, SP, -VALUE);
+      assembler_.ucomisd(Xmm::XMM0, SP, -2 * VALUE);
+      comparison(Condition::A);
+      break;
+    case OpCode::GT:
+      assembler_.movsd(Xmm::XMM0, SP, -2 * VALUE);
+      assembler_.ucomisd(Xmm::XMM0, SP, -VALUE);
+      comparison(Condition::A);
+      break;
+    default: // EQ: equal and ordered, NEQ: different or unordered
+      assembler_.movsd(Xmm::XMM0, SP, -2 * VALUE);
+      assembler_.ucomisd(Xmm::XMM0, SP, -VALUE);
+      if (op == OpCode::EQ) {
+        assembler_.set(Condition::E, Reg::RAX);
+        assembler_.set(Condition::NP, Reg::RCX);
+        assembler_.andByte(Reg::RAX, Reg::RCX);
+      } else {
+        assembler_.set(Condition::NE, Reg::RAX);
+        assembler_.set(Condition::P, Reg::RCX);
+        assembler_.orByte(Reg::RAX, Reg::RCX);
+      }
+      assembler_.movzxByte(Reg::RAX);
+      assembler_.mov(SP, -2 * VALUE, Reg::RAX);
+      assembler_.movByte(SP, -2 * VALUE + KIND, static_cast<uint8_t>(ValueKind::BOOL));
+      assembler_.sub(SP, VALUE);
+      break;
+  }
+}
+
+void TemplateCompiler::comparison(const Condition condition) {
+  assembler_.set(condition, Reg::RAX);
+  assembler_.movzxByte(Reg::RAX);
+  assembler_.mov(SP, -2 * VALUE, Reg::RAX); // Value::ofBool: the whole payload is 0 or 1
+  assembler_.movByte(SP, -2 * VALUE + KIND, static_cast<uint8_t>(ValueKind::BOOL));
+  assembler_.sub(SP, VALUE);
+}
+
+void TemplateCompiler::integerOperand(const int32_t disp, Label& fallback) {
+  Label integer;
+  assembler_.cmpByte(SP, disp + KIND, static_cast<uint8_t>(ValueKind::INT));
+  assembler_.jmp(Condition::E, integer);
+  assembler_.cmpByte(SP, disp + KIND, static_cast<uint8_t>(ValueKind::BOOL));
+  assembler_.jmp(Condition::E, integer); // the payload of a bool is already 0 or 1
+  assembler_.cmpByte(SP, disp + KIND, static_cast<uint8_t>(ValueKind::CHAR));
+  assembler_.jmp(Condition::NE, fallback);
+  assembler_.movsxByte(Reg::RAX, SP, disp); // Value::asInteger() of a char is signed
+  assembler_.mov(SP, disp, Reg::RAX);
+  assembler_.bind(integer);
+}
+
+void TemplateCompiler::guardedIntegerOperation(const OpCode op, const uint32_t pc) {
+  Label fallback;
+  Label done;
+  integerOperand(-2 * VALUE, fallback);
+  integerOperand(-VALUE, fallback);
+  integerOperation(op, pc);
+  if (op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL || op == OpCode::DIV) {
+    assembler_.movByte(SP, -VALUE + KIND, static_cast<uint8_t>(ValueKind::INT));
+  }
+  assembler_.jmp(done);
+  assembler_.bind(fallback);
+  call(reinterpret_cast<const void*>(&binaryOperator), pc, static_cast<uint32_t>(op));
+  assembler_.sub(SP, VALUE);
+  assembler_.bind(done);
+}
+
+void TemplateCompiler::integerConversion(const OpCode op, const uint32_t pc) {
+  Label fallback;
+  Label done;
+  integerOperand(-VALUE, fallback);
+  if (op == OpCode::TO_CHAR) { // Value::ofChar: the low byte, the rest of the payload zero
+    assembler_.movzxByte(Reg::RAX, SP, -VALUE);
+    assembler_.mov(SP, -VALUE, Reg::RAX);
+  }
+  assembler_.movByte(SP, -VALUE + KIND, static_cast<uint8_t>(op == OpCode::TO_CHAR ? ValueKind::CHAR : ValueKind::INT));
+  assembler_.jmp(done);
+  assembler_.bind(fallback);
+  call(reinterpret_cast<const void*>(&unaryOperator), pc, static_cast<uint32_t>(op));
+  assembler_.bind(done);
+}
+
+void TemplateCompiler::element(const uint32_t count, const bool store, const bool checked, const void* helper,
+  const uint32_t pc) {
+  const int32_t operands = static_cast<int32_t>(count) + (store ? 2 : 1);
+  const int32_t array = -operands * VALUE;
+  Label fallback;
+  Label done;
+  assembler_.mov(Reg::RDX, SP, array);
+  assembler_.cmpDword(Reg::RDX, offsetof(ArrayObject, rank), static_cast<int32_t>(count));
+  assembler_.jmp(Condition::NE, fallback);
+  // rsi = sum of index * stride, the last stride is 1
+  for (uint32_t i = 0; i < count; ++i) {
+    const int32_t index = array + static_cast<int32_t>(i + 1) * VALUE;
+    const auto dimension = static_cast<int32_t>(8 * i);
+    if (checked) { // a proven index is a statically typed int
+      assembler_.cmpByte(SP, index + KIND, static_cast<uint8_t>(ValueKind::INT));
+      assembler_.jmp(Condition::NE, fallback);
+    }
+    assembler_.mov(Reg::RCX, SP, index);
+    if (checked && i == 0) {
+      assembler_.cmp(Reg::RCX, Reg::RDX, offsetof(ArrayObject, size));
+      assembler_.jmp(Condition::AE, fallback); // negative indices too
+    } else if (checked) {
+      assembler_.mov(Reg::RAX, Reg::RDX, offsetof(ArrayObject, shape));
+      assembler_.cmp(Reg::RCX, Reg::RAX, dimension);
+      assembler_.jmp(Condition::AE, fallback);
+    }
+    if (i + 1 < count) {
+      assembler_.mov(Reg::RAX, Reg::RDX, offsetof(ArrayObject, strides));
+      assembler_.imul(Reg::RCX, Reg::RAX, dimension);
+    }
+    if (i == 0) {
+      assembler_.mov(Reg::RSI, Reg::RCX);
+    } else {
+      assembler_.add(Reg::RSI, Reg::RCX);
+    }
+  }
+  static_assert(VALUE == 16);
+  assembler_.shl(Reg::RSI, 4);
+  assembler_.mov(Reg::RAX, Reg::RDX, offsetof(ArrayObject, data));
+  assembler_.add(Reg::RSI, Reg::RAX);
+  if (store) {
+    copy(SP, -VALUE, Reg::RSI, 0);
+  } else {
+    copy(Reg::RSI, 0, SP, array);
+  }
+  assembler_.jmp(done);
+
+  assembler_.bind(fallback);
+  if (count == 1) {
+    call(helper, pc);
+  } else {
+    call(helper, pc, count);
+  }
+  assembler_.bind(done);
+  assembler_.sub(SP, (operands - 1 + (store ? 1 : 0)) * VALUE);
+}
+
+void TemplateCompiler::nativeCall(const uint32_t function, const uint32_t pc) {
+  const RPNFunction& callee = program_.functions[function];
+  assembler_.mov(Reg::RDI, CONTEXT);
+  assembler_.mov(Reg::RSI, SP);
+  assembler_.mov(Reg::RDX, FP);
+  assembler_.movImmediate(Reg::RCX, function);
+  assembler_.movImmediate(Reg::R8, pc + static_cast<uint32_t>(instructionSize(OpCode::CALL)));
+  assembler_.mov(Reg::RAX, CONTEXT, offsetof(JitContext, call));
+  assembler_.call(Reg::RAX);
+  assembler_.test(Reg::RAX, Reg::RAX);
+  assembler_.jmp(Condition::E, exitLabel(pc));
+
+  // the caller's fp is saved on the machine stack, which keeps it 16-byte aligned in the callee
+  assembler_.addImmediate(CONTEXT, offsetof(JitContext, depth), 1);
+  assembler_.push(FP);
+  assembler_.mov(FP, SP);
+  assembler_.sub(FP, static_cast<int32_t>(callee.parameters) * VALUE);
+  assembler_.mov(SP, FP);
+  assembler_.add(SP, slot(callee.slots));
+  assembler_.call(Reg::RAX);
+  assembler_.pop(FP);
+}
+
+void TemplateCompiler::nativeReturn(const bool value, const uint32_t pc) {
+  // a frame the interpreter called returns through the interpreter
+  assembler_.cmpImmediate(CONTEXT, offsetof(JitContext, depth), 0);
+  assembler_.jmp(Condition::E, exitLabel(pc));
+  assembler_.addImmediate(CONTEXT, offsetof(JitContext, depth), -1);
+  if (value) {
+    copy(SP, -VALUE, FP, 0);
+  }
+  assembler_.mov(SP, FP);
+  if (value) {
+    assembler_.add(SP, VALUE);
+  }
+  assembler_.mov(Reg::RDI, CONTEXT);
+  assembler_.mov(Reg::RAX, CONTEXT, offsetof(JitContext, ret));
+  assembler_.call(Reg::RAX);
+  assembler_.ret();
+}
+
+void TemplateCompiler::switchDispatch(const SwitchTable& table) {
+  Label entries;
+  assembler_.cmp(Reg::RAX, static_cast<int32_t>(table.targets.size()));
+  jumpTo(table.fallback, Condition::AE); // unsigned: below low as well
+  assembler_.mov(Reg::RCX, Reg::RAX);
+  assembler_.shl(Reg::RAX, 2);
+  assembler_.add(Reg::RAX, Reg::RCX);
+  assembler_.lea(Reg::RCX, entries);
+  assembler_.add(Reg::RAX, Reg::RCX);
+  assembler_.jmp(Reg::RAX);
+  assembler_.bind(entries);
+  for (const uint32_t target : table.targets) {
+    jumpTo(target, std::nullopt);
+  }
+}
+
+void TemplateCompiler::instruction(const OpCode op, const uint32_t pc) {
+  switch (op) {
+    case OpCode::NOP:
+      break;
+    case OpCode::PUSH_INT:
+      push(static_cast<int32_t>(operand(pc, 0)), ValueKind::INT);
+      break;
+    case OpCode::PUSH_LONG:
+      assembler_.movImmediate(Reg::RAX, static_cast<uint64_t>(program_.integers[operand(pc, 0)]));
+      assembler_.mov(SP, 0, Reg::RAX);
+      assembler_.movByte(SP, KIND, static_cast<uint8_t>(ValueKind::INT));
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::PUSH_FLOAT: {
+      uint64_t bits;
+      std::memcpy(&bits, &program_.floats[operand(pc, 0)], sizeof(bits));
+      assembler_.movImmediate(Reg::RAX, bits);
+      assembler_.mov(SP, 0, Reg::RAX);
+      assembler_.movByte(SP, KIND, static_cast<uint8_t>(ValueKind::FLOAT));
+      assembler_.add(SP, VALUE);
+      break;
+    }
+    case OpCode::PUSH_CHAR: // Value::ofChar: the char in the low byte, the rest of the payload zero
+      push(static_cast<uint8_t>(operand(pc, 0)), ValueKind::CHAR);
+      break;
+    case OpCode::PUSH_BOOL:
+      push(operand(pc, 0) != 0, ValueKind::BOOL);
+      break;
+    case OpCode::PUSH_STRING:
+      assembler_.mov(Reg::RDX, CONTEXT, offsetof(JitContext, constants));
+      copy(Reg::RDX, slot(operand(pc, 0)), SP, 0);
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::POP:
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::DUP:
+      copy(SP, -VALUE, SP, 0);
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::LOAD_LOCAL:
+      copy(FP, slot(operand(pc, 0)), SP, 0);
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::STORE_LOCAL:
+      assembler_.sub(SP, VALUE);
+      copy(SP, 0, FP, slot(operand(pc, 0)));
+      break;
+    case OpCode::LOAD_GLOBAL:
+      assembler_.mov(Reg::RDX, CONTEXT, offsetof(JitContext, globals));
+      copy(Reg::RDX, slot(operand(pc, 0)), SP, 0);
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::STORE_GLOBAL:
+      assembler_.mov(Reg::RDX, CONTEXT, offsetof(JitContext, globals));
+      assembler_.sub(SP, VALUE);
+      copy(SP, 0, Reg::RDX, slot(operand(pc, 0)));
+      break;
+    case OpCode::NEW_ARRAY: {
+      const uint32_t dimensions = operand(pc, 0);
+      call(reinterpret_cast<const void*>(&newArray), pc, dimensions, operand(pc, 1));
+      assembler_.sub(SP, (static_cast<int32_t>(dimensions) - 1) * VALUE);
+      break;
+    }
+    case OpCode::LOAD_INDEX:
+    case OpCode::LOAD_INDEX_UNCHECKED:
+      element(1, false, op == OpCode::LOAD_INDEX, reinterpret_cast<const void*>(&loadIndex), pc);
+      break;
+    case OpCode::STORE_INDEX:
+    case OpCode::STORE_INDEX_UNCHECKED:
+      element(1, true, op == OpCode::STORE_INDEX, reinterpret_cast<const void*>(&storeIndex), pc);
+      break;
+    case OpCode::LOAD_ELEMENT:
+    case OpCode::LOAD_ELEMENT_UNCHECKED:
+      element(operand(pc, 0), false, op == OpCode::LOAD_ELEMENT, reinterpret_cast<const void*>(&loadElement), pc);
+      break;
+    case OpCode::STORE_ELEMENT:
+    case OpCode::STORE_ELEMENT_UNCHECKED:
+      element(operand(pc, 0), true, op == OpCode::STORE_ELEMENT, reinterpret_cast<const void*>(&storeElement), pc);
+      break;
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+    case OpCode::DIV:
+    case OpCode::LT:
+    case OpCode::GT:
+    case OpCode::EQ:
+    case OpCode::NEQ: // not quickened yet, the same code as the integer specialization
+      guardedIntegerOperation(op, pc);
+      break;
+    case OpCode::TO_INT:
+    case OpCode::TO_CHAR:
+      integerConversion(op, pc);
+      break;
+    case OpCode::NEG:
+    case OpCode::NOT:
+    case OpCode::TO_FLOAT:
+    case OpCode::TO_BOOL:
+      call(reinterpret_cast<const void*>(&unaryOperator), pc, static_cast<uint32_t>(op));
+      break;
+    case OpCode::JUMP:
+      jumpTo(operand(pc, 0), std::nullopt);
+      break;
+    case OpCode::JUMP_IF_FALSE:
+    case OpCode::JUMP_IF_TRUE:
+      // conditions are bools but for `if (x)` on a number: those the interpreter tests
+      assembler_.cmpByte(SP, -VALUE + KIND, static_cast<uint8_t>(ValueKind::BOOL));
+      assembler_.jmp(Condition::NE, exitLabel(pc));
+      assembler_.sub(SP, VALUE);
+      assembler_.cmpByte(SP, 0, 0);
+      jumpTo(operand(pc, 0), op == OpCode::JUMP_IF_FALSE ? Condition::E : Condition::NE);
+      break;
+    case OpCode::SWITCH_TABLE: {
+      const SwitchTable& table = program_.switches[operand(pc, 0)];
+      assembler_.sub(SP, VALUE);
+      assembler_.mov(Reg::RAX, SP, 0);
+      assembler_.sub(Reg::RAX, static_cast<int32_t>(table.low)); // the generator keeps low in int32
+      switchDispatch(table);
+      break;
+    }
+    case OpCode::SWITCH_STRING: {
+      const SwitchTable& table = program_.switches[operand(pc, 0)];
+      assembler_.movImmediate(Reg::RDI, reinterpret_cast<uint64_t>(&table));
+      assembler_.mov(Reg::RSI, SP);
+      assembler_.movImmediate(Reg::RDX, reinterpret_cast<uint64_t>(&program_.strings));
+      assembler_.movImmediate(Reg::RAX, reinterpret_cast<uint64_t>(&switchString));
+      assembler_.call(Reg::RAX);
+      assembler_.sub(SP, VALUE);
+      switchDispatch(table);
+      break;
+    }
+    case OpCode::CALL:
+      nativeCall(operand(pc, 0), pc);
+      break;
+    case OpCode::RETURN:
+    case OpCode::RETURN_VOID:
+      nativeReturn(op == OpCode::RETURN, pc);
+      break;
+    case OpCode::PRINT:
+      call(reinterpret_cast<const void*>(&print), pc);
+      assembler_.sub(SP, VALUE);
+      break;
+    case OpCode::LOAD_LOCAL_PAIR:
+      copy(FP, slot(operand(pc, 0)), SP, 0);
+      copy(FP, slot(operand(pc, 1)), SP, VALUE);
+      assembler_.add(SP, 2 * VALUE);
+      break;
+    case OpCode::LOAD_LOCAL_ADD_CONST:
+      assembler_.mov(Reg::RAX, FP, slot(operand(pc, 0)));
+      assembler_.add(Reg::RAX, static_cast<int32_t>(operand(pc, 1)));
+      assembler_.mov(SP, 0, Reg::RAX);
+      assembler_.movByte(SP, KIND, static_cast<uint8_t>(ValueKind::INT));
+      assembler_.add(SP, VALUE);
+      break;
+    case OpCode::INC_LOCAL:
+      assembler_.addImmediate(FP, slot(operand(pc, 0)), static_cast<int32_t>(operand(pc, 1)));
+      break;
+    case OpCode::LT_I64_JUMP_IF_FALSE:
+    case OpCode::GT_I64_JUMP_IF_FALSE:
+      assembler_.sub(SP, 2 * VALUE);
+      assembler_.mov(Reg::RAX, SP, 0);
+      assembler_.cmp(Reg::RAX, SP, VALUE);
+      jumpTo(operand(pc, 0), op == OpCode::LT_I64_JUMP_IF_FALSE ? Condition::GE : Condition::LE);
+      break;
+    case OpCode::ADD_I64:
+      integerOperation(OpCode::ADD, pc);
+      break;
+    case OpCode::SUB_I64:
+      integerOperation(OpCode::SUB, pc);
+      break;
+    case OpCode::MUL_I64:
+      integerOperation(OpCode::MUL, pc);
+      break;
+    case OpCode::DIV_I64:
+      integerOperation(OpCode::DIV, pc);
+      break;
+    case OpCode::NEG_I64:
+      assembler_.negate(SP, -VALUE);
+      break;
+    case OpCode::LT_I64:
+      integerOperation(OpCode::LT, pc);
+      break;
+    case OpCode::GT_I64:
+      integerOperation(OpCode::GT, pc);
+      break;
+    case OpCode::EQ_I64:
+      integerOperation(OpCode::EQ, pc);
+      break;
+    case OpCode::NEQ_I64:
+      integerOperation(OpCode::NEQ, pc);
+      break;
+    case OpCode::ADD_F64:
+      floatOperation(OpCode::ADD);
+      break;
+    case OpCode::SUB_F64:
+      floatOperation(OpCode::SUB);
+      break;
+    case OpCode::MUL_F64:
+      floatOperation(OpCode::MUL);
+      break;
+    case OpCode::DIV_F64:
+      floatOperation(OpCode::DIV);
+      break;
+    case OpCode::NEG_F64:
+      assembler_.xorByte(SP, -VALUE + 7, 0x80); // the sign bit, in the double's high byte
+      break;
+    case OpCode::LT_F64:
+      floatOperation(OpCode::LT);
+      break;
+    case OpCode::GT_F64:
+      floatOperation(OpCode::GT);
+      break;
+    case OpCode::EQ_F64:
+      floatOperation(OpCode::EQ);
+      break;
+    case OpCode::NEQ_F64:
+      floatOperation(OpCode::NEQ);
+      break;
+    case OpCode::I64_TO_F64:
+      assembler_.cvtsi2sd(Xmm::XMM0, SP, -VALUE);
+      assembler_.movsd(SP, -VALUE, Xmm::XMM0);
+      assembler_.movByte(SP, -VALUE + KIND, static_cast<uint8_t>(ValueKind::FLOAT));
+      break;
+    case OpCode::QUICK_ADD_INT:
+      guardedIntegerOperation(OpCode::ADD, pc);
+      break;
+    case OpCode::QUICK_SUB_INT:
+      guardedIntegerOperation(OpCode::SUB, pc);
+      break;
+    case OpCode::QUICK_MUL_INT:
+      guardedIntegerOperation(OpCode::MUL, pc);
+      break;
+    case OpCode::QUICK_DIV_INT:
+      guardedIntegerOperation(OpCode::DIV, pc);
+      break;
+    case OpCode::QUICK_LT_INT:
+      guardedIntegerOperation(OpCode::LT, pc);
+      break;
+    case OpCode::QUICK_GT_INT:
+      guardedIntegerOperation(OpCode::GT, pc);
+      break;
+    case OpCode::QUICK_EQ_INT:
+      guardedIntegerOperation(OpCode::EQ, pc);
+      break;
+    case OpCode::QUICK_NEQ_INT:
+      guardedIntegerOperation(OpCode::NEQ, pc);
+      break;
+    case OpCode::QUICK_ADD_FLOAT:
+    case OpCode::QUICK_SUB_FLOAT:
+    case OpCode::QUICK_MUL_FLOAT:
+    case OpCode::QUICK_DIV_FLOAT:
+    case OpCode::QUICK_LT_FLOAT:
+    case OpCode::QUICK_GT_FLOAT:
+    case OpCode::QUICK_EQ_FLOAT:
+    case OpCode::QUICK_NEQ_FLOAT: {
+      static constexpr OpCode GENERIC[] = {OpCode::ADD, OpCode::SUB, OpCode::MUL, OpCode::DIV, OpCode::LT, OpCode::GT,
+        OpCode::EQ, OpCode::NEQ};
+      const OpCode generic = GENERIC[static_cast<uint8_t>(op) - static_cast<uint8_t>(OpCode::QUICK_ADD_FLOAT)];
+      call(reinterpret_cast<const void*>(&binaryOperator), pc, static_cast<uint32_t>(generic));
+      assembler_.sub(SP, VALUE);
+      break;
+    }
+    default: // READ, TRAP, HALT: the interpreter's
+      exit(pc);
+      break;
+  }
+}
+
+
+#if RPN_VM_JIT
+
+std::unique_ptr<NativeFunction> NativeFunction::create(const std::vector<uint8_t>& code, std::vector<uint32_t> entries,
+  const uint32_t first) {
+  const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t mapped = (code.size() + page - 1) / page * page;
+  void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+  std::memcpy(memory, code.data(), code.size());
+  if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+    munmap(memory, mapped);
+    return nullptr;
+  }
+  return std::unique_ptr<NativeFunction>(new NativeFunction(memory, code.size(), std::move(entries), first));
+}
+
+NativeFunction::~NativeFunction() {
+  const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  munmap(memory_, (size_ + page - 1) / page * page);
+}
+
+uint32_t NativeFunction::run(Value* fp, Value* sp, JitContext& context, const uint32_t pc) const {
+  using Entry = uint32_t (*)(Value*, Value*, JitContext*, const void*);
+  const auto* base = static_cast<const uint8_t*>(memory_);
+  ++context.entries;
+  return reinterpret_cast<Entry>(memory_)(fp, sp, &context, base + entries_[pc - first_]);
+}
+
+const NativeFunction* Jit::compile(const uint32_t function, const uint8_t* code) {
+  const RPNFunction& bytecode = program_.functions[function];
+  if (bytecode.slots >= MAX_SLOTS || program_.globals >= MAX_SLOTS || program_.strings.size() >= MAX_SLOTS) {
+    return nullptr;
+  }
+  TemplateCompiler compiler(program_, bytecode, code);
+  JitStatistics statistics;
+  auto [machineCode, entries] = compiler.compile(statistics);
+  native_[function] = NativeFunction::create(machineCode, std::move(entries), bytecode.entry);
+  if (native_[function]) {
+    ++statistics_.compiledFunctions;
+    statistics_.bytecodeBytes += bytecode.end - bytecode.entry;
+    statistics_.nativeBytes += machineCode.size();
+    statistics_.exitInstructions += statistics.exitInstructions;
+  }
+  return native_[function].get();
+}
+
+#else
+
+std::unique_ptr<NativeFunction> NativeFunction::create(const std::vector<uint8_t>&, std::vector<uint32_t>,
+  uint32_t) {
+  return nullptr;
+}
+
+NativeFunction::~NativeFunction() = default;
+
+uint32_t NativeFunction::run(Value*, Value*, JitContext&, const uint32_t pc) const {
+  return pc;
+}
+
+const NativeFunction* Jit::compile(uint32_t, const uint8_t*) {
+  return nullptr;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "../headers/region.h"
+
+
+Region::~Region() {
+  reset();
+  for (const Chunk& chunk : chunks_) {
+    ::operator delete(chunk.memory, std::align_val_t{64});
+  }
+}
+
+
+ArrayObject* Region::newArray(const size_t size, const Value element) {
+  if (size > PTRDIFF_MAX / sizeof(Value)) {
+    throw std::bad_alloc();
+  }
+  auto* data = static_cast<Value*>(allocate(std::max<size_t>(size, 1) * sizeof(Value), 64));
+  std::uninitialized_fill_n(data, size, element);
+  auto* array = new (allocate(sizeof(ArrayObject), alignof(ArrayObject))) ArrayObject();
+  array->data = data;
+  array->size = static_cast<int64_t>(size);
+  arrays_.push_back(array);
+  ++statistics_.arrays;
+  return array;
+}
+
+ArrayObject* Region::newDenseArray(const int64_t* shape, const uint32_t rank, const Value element) {
+  auto* dimensions = static_cast<int64_t*>(allocate(2 * rank * sizeof(int64_t), alignof(int64_t)));
+  const size_t count = denseLayout(shape, rank, dimensions);
+  auto* data = static_cast<Value*>(allocate(std::max<size_t>(count, 1) * sizeof(Value), 64));
+  std::uninitialized_fill_n(data, count, element);
+  auto* array = new (allocate(sizeof(ArrayObject), alignof(ArrayObject))) ArrayObject();
+  array->data = data;
+  array->dense = data;
+  array->size = shape[0];
+  array->rank = rank;
+  array->shape = dimensions;
+  array->strides = dimensions + rank;
+  arrays_.push_back(array);
+  ++statistics_.arrays;
+  return array;
+}
+
+StringObject* Region::newString(std::string value) {
+  auto* string = new (allocate(sizeof(StringObject), alignof(StringObject))) StringObject();
+  string->length = value.size();
+  string->flat = std::move(value);
+  strings_.push_back(string);
+  ++statistics_.strings;
+  return string;
+}
+
+StringObject* Region::newRope(const Value& left, const Value& right) {
+  auto* string = new (allocate(sizeof(StringObject), alignof(StringObject))) StringObject();
+  string->length = left.stringLength() + right.stringLength();
+  string->left = left;
+  string->right = right;
+  strings_.push_back(string);
+  ++statistics_.strings;
+  return string;
+}
+
+
+void* Region::allocate(const size_t bytes, const size_t alignment) {
+  for (;;) {
+    if (chunk_ < chunks_.size()) {
+      const size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+      if (start <= chunks_[chunk_].size && bytes <= chunks_[chunk_].size - start) {
+        offset_ = start + bytes;
+        used_ += bytes;
+        statistics_.bytes += bytes;
+        statistics_.peakBytes = std::max(statistics_.peakBytes, used_);
+        return chunks_[chunk_].memory + start;
+      }
+      ++chunk_;
+      offset_ = 0;
+      if (chunk_ < chunks_.size() && chunks_[chunk_].size >= bytes) {
+        continue;
+      }
+    }
+    // a new chunk before those too small for the object, they are kept for later
+    const size_t size = std::max(CHUNK, bytes);
+    auto* memory = static_cast<std::byte*>(::operator new(size, std::align_val_t{64}));
+    chunks_.insert(chunks_.begin() + static_cast<ptrdiff_t>(std::min(chunk_, chunks_.size())), Chunk{memory, size});
+    chunk_ = std::min(chunk_, chunks_.size() - 1);
+    offset_ = 0;
+    statistics_.chunks = chunks_.size();
+  }
+}
+
+void Region::releaseTo(const RegionMark& mark) {
+  while (arrays_.size() > mark.arrays) {
+    arrays_.back()->~ArrayObject();
+    arrays_.pop_back();
+  }
+  while (strings_.size() > mark.strings) {
+    strings_.back()->~StringObject();
+    strings_.pop_back();
+  }
+  chunk_ = mark.chunk;
+  offset_ = mark.offset;
+  used_ = mark.used;
+}
@@ -0,0 +1,328 @@
+#include "../headers/register-vm.h"
+
+
+RegisterMachine::RegisterMachine(const RegisterProgram& program, const size_t stackSize) :
+program_(program), stack_(stackSize) {}
+
+void RegisterMachine::run(std::istream& in, std::ostream& out) {
+  frames_.clear();
+  frames_.reserve(callDepthLimit_);
+  globals_.assign(program_.globals, Value());
+  constants_.clear();
+  for (const auto& string : program_.strings) {
+    constants_.push_back(runtime_.intern(string));
+  }
+
+  const uint8_t* const code = program_.code.data();
+  const RPNFunction* const functions = program_.functions.data();
+  const Value* const stackEnd = stack_.end();
+  Value* const globals = globals_.data();
+  const Value* const constants = constants_.data();
+
+  const RPNFunction& entry = functions[0];
+  if (entry.slots > stack_.size()) {
+    throw std::runtime_error("Runtime error: the frame stack of " + std::to_string(stack_.size()) +
+      " values is too small for the top-level code");
+  }
+  Value* fp = stack_.data(); // registers of the running function
+  uint32_t frameSize = entry.slots;
+
+  // the heap's roots: every frame up to the end of the running one
+  runtime_.resetRegion();
+  const Value* const top = fp + entry.slots;
+  runtime_.setRoots([this, top](std::vector<std::pair<const Value*, const Value*>>& roots) {
+    roots.emplace_back(stack_.data(), frames_.empty() ? top : frames_.back().limit);
+    roots.emplace_back(globals_.data(), globals_.data() + globals_.size());
+    roots.emplace_back(constants_.data(), constants_.data() + constants_.size());
+  });
+  const uint8_t* pc = code + entry.entry;
+  uint64_t executed = 0;
+
+  // results are computed before the destination is written: it may share a slot with an operand
+#define OPERAND(index) readOperand(pc + 1 + 4 * (index))
+#define REG(index) fp[OPERAND(index)]
+#define NEXT(name) pc += registerInstructionSize(RegOp::name); DISPATCH()
+
+#if RPN_VM_COMPUTED_GOTO
+#define REGISTER_VM_LABEL(name, roles) &&op_##name,
+  static const void* const dispatch[] = {REGISTER_OPCODES(REGISTER_VM_LABEL)};
+#undef REGISTER_VM_LABEL
+#define TARGET(name) op_##name:
+#define DISPATCH() ++executed; goto *dispatch[*pc]
+#else
+#define TARGET(name) case RegOp::name:
+#define DISPATCH() continue
+#endif
+
+  try {
+#if RPN_VM_COMPUTED_GOTO
+    DISPATCH();
+#else
+    for (;;) {
+      ++executed;
+      switch (static_cast<RegOp>(*pc)) {
+#endif
+
+    TARGET(MOVE) {
+      REG(0) = REG(1);
+      NEXT(MOVE);
+    }
+    TARGET(LOAD_INT) {
+      REG(0) = Value::ofInt(static_cast<int32_t>(OPERAND(1)));
+      NEXT(LOAD_INT);
+    }
+    TARGET(LOAD_LONG) {
+      REG(0) = Value::ofInt(program_.integers[OPERAND(1)]);
+      NEXT(LOAD_LONG);
+    }
+    TARGET(LOAD_FLOAT) {
+      REG(0) = Value::ofFloat(program_.floats[OPERAND(1)]);
+      NEXT(LOAD_FLOAT);
+    }
+    TARGET(LOAD_CHAR) {
+      REG(0) = Value::ofChar(static_cast<char>(OPERAND(1)));
+      NEXT(LOAD_CHAR);
+    }
+    TARGET(LOAD_BOOL) {
+      REG(0) = Value::ofBool(OPERAND(1) != 0);
+      NEXT(LOAD_BOOL);
+    }
+    TARGET(LOAD_STRING) {
+      REG(0) = constants[OPERAND(1)];
+      NEXT(LOAD_STRING);
+    }
+    TARGET(LOAD_GLOBAL) {
+      REG(0) = globals[OPERAND(1)];
+      NEXT(LOAD_GLOBAL);
+    }
+    TARGET(STORE_GLOBAL) {
+      globals[OPERAND(0)] = REG(1);
+      NEXT(STORE_GLOBAL);
+    }
+    TARGET(NEW_ARRAY) {
+      const uint32_t dimensions = OPERAND(2);
+      arraySizes_.resize(dimensions); // the sizes need not be in adjacent registers
+      for (uint32_t i = 0; i < dimensions; ++i) {
+        arraySizes_[i] = REG(3 + i);
+      }
+      REG(0) = runtime_.newArray(arraySizes_.data(), dimensions, arrayLeaf(OPERAND(1)), isLocalArray(OPERAND(1)));
+      pc += 1 + 4 * (3 + dimensions);
+      DISPATCH();
+    }
+    TARGET(LOAD_INDEX) {
+      ArrayObject* array = REG(1).array;
+      const int64_t index = REG(2).asInteger();
+      Runtime::checkIndex(index, array->size);
+      REG(0) = array->load(index);
+      NEXT(LOAD_INDEX);
+    }
+    TARGET(STORE_INDEX) {
+      ArrayObject* array = REG(0).array;
+      const int64_t index = REG(1).asInteger();
+      Runtime::checkIndex(index, array->size);
+      array->store(index, REG(2));
+      NEXT(STORE_INDEX);
+    }
+    TARGET(ADD) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(lhs.integer) + rhs.integer));
+      } else {
+        REG(0) = runtime_.arithmetic(Operator::ADD, lhs, rhs);
+      }
+      NEXT(ADD);
+    }
+    TARGET(SUB) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(lhs.integer) - rhs.integer));
+      } else {
+        REG(0) = runtime_.arithmetic(Operator::SUB, lhs, rhs);
+      }
+      NEXT(SUB);
+    }
+    TARGET(MUL) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(lhs.integer) * rhs.integer));
+      } else {
+        REG(0) = runtime_.arithmetic(Operator::MUL, lhs, rhs);
+      }
+      NEXT(MUL);
+    }
+    TARGET(DIV) {
+      REG(0) = runtime_.arithmetic(Operator::DIV, REG(1), REG(2));
+      NEXT(DIV);
+    }
+    TARGET(NEG) {
+      const Value& operand = REG(1);
+      if (operand.kind == ValueKind::FLOAT) {
+        REG(0) = Value::ofFloat(-operand.real);
+      } else {
+        REG(0) = Value::ofInt(static_cast<int64_t>(0 - static_cast<uint64_t>(operand.asInteger())));
+      }
+      NEXT(NEG);
+    }
+    TARGET(NOT) {
+      REG(0) = Value::ofBool(!REG(1).isTrue());
+      NEXT(NOT);
+    }
+    TARGET(LT) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofBool(lhs.integer < rhs.integer);
+      } else {
+        REG(0) = Value::ofBool(Runtime::compare(Operator::LT, lhs, rhs));
+      }
+      NEXT(LT);
+    }
+    TARGET(GT) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofBool(lhs.integer > rhs.integer);
+      } else {
+        REG(0) = Value::ofBool(Runtime::compare(Operator::GT, lhs, rhs));
+      }
+      NEXT(GT);
+    }
+    TARGET(EQ) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofBool(lhs.integer == rhs.integer);
+      } else {
+        REG(0) = Value::ofBool(Runtime::compare(Operator::EQ, lhs, rhs));
+      }
+      NEXT(EQ);
+    }
+    TARGET(NEQ) {
+      const Value& lhs = REG(1);
+      const Value& rhs = REG(2);
+      if (lhs.kind == ValueKind::INT && rhs.kind == ValueKind::INT) {
+        REG(0) = Value::ofBool(lhs.integer != rhs.integer);
+      } else {
+        REG(0) = Value::ofBool(!Runtime::compare(Operator::EQ, lhs, rhs));
+      }
+      NEXT(NEQ);
+    }
+    TARGET(TO_INT) {
+      REG(0) = Runtime::convert(ValueKind::INT, REG(1));
+      NEXT(TO_INT);
+    }
+    TARGET(TO_FLOAT) {
+      REG(0) = Runtime::convert(ValueKind::FLOAT, REG(1));
+      NEXT(TO_FLOAT);
+    }
+    TARGET(TO_CHAR) {
+      REG(0) = Runtime::convert(ValueKind::CHAR, REG(1));
+      NEXT(TO_CHAR);
+    }
+    TARGET(TO_BOOL) {
+      REG(0) = Value::ofBool(REG(1).isTrue());
+      NEXT(TO_BOOL);
+    }
+    TARGET(JUMP) {
+      pc = code + OPERAND(0);
+      DISPATCH();
+    }
+    TARGET(JUMP_IF_FALSE) {
+      pc = REG(0).isTrue() ? pc + registerInstructionSize(RegOp::JUMP_IF_FALSE) : code + OPERAND(1);
+      DISPATCH();
+    }
+    TARGET(JUMP_IF_TRUE) {
+      pc = REG(0).isTrue() ? code + OPERAND(1) : pc + registerInstructionSize(RegOp::JUMP_IF_TRUE);
+      DISPATCH();
+    }
+    TARGET(CALL) {
+      const RPNFunction& callee = functions[OPERAND(1)];
+      const uint32_t count = OPERAND(2);
+      Value* base = fp + frameSize; // the callee's registers follow the caller's
+      if (base + callee.slots > stackEnd || frames_.size() >= callDepthLimit_) {
+        Runtime::stackOverflow(callee.name, frames_.size(), callDepthLimit_, stack_.size());
+      }
+      for (uint32_t i = 0; i < count; ++i) {
+        base[i] = REG(3 + i);
+      }
+      frames_.push_back({pc + 1 + 4 * (3 + count), fp, frameSize, OPERAND(0), base + callee.slots,
+        runtime_.enterFrame(callee.localStrings)});
+      fp = base;
+      frameSize = callee.slots;
+      pc = code + callee.entry;
+      DISPATCH();
+    }
+    TARGET(CALL_VOID) {
+      const RPNFunction& callee = functions[OPERAND(0)];
+      const uint32_t count = OPERAND(1);
+      Value* base = fp + frameSize;
+      if (base + callee.slots > stackEnd || frames_.size() >= callDepthLimit_) {
+        Runtime::stackOverflow(callee.name, frames_.size(), callDepthLimit_, stack_.size());
+      }
+      for (uint32_t i = 0; i < count; ++i) {
+        base[i] = REG(2 + i);
+      }
+      frames_.push_back({pc + 1 + 4 * (2 + count), fp, frameSize, 0, base + callee.slots,
+        runtime_.enterFrame(callee.localStrings)});
+      fp = base;
+      frameSize = callee.slots;
+      pc = code + callee.entry;
+      DISPATCH();
+    }
+    TARGET(RETURN) {
+      const Value result = REG(0);
+      const CallFrame& caller = frames_.back();
+      runtime_.leaveFrame(caller.region);
+      fp = caller.base;
+      fp[caller.destination] = result;
+      frameSize = caller.frameSize;
+      pc = caller.returnAddress;
+      frames_.pop_back();
+      DISPATCH();
+    }
+    TARGET(RETURN_VOID) {
+      const CallFrame& caller = frames_.back();
+      runtime_.leaveFrame(caller.region);
+      fp = caller.base;
+      frameSize = caller.frameSize;
+      pc = caller.returnAddress;
+      frames_.pop_back();
+      DISPATCH();
+    }
+    TARGET(PRINT) {
+      printValue(out, REG(0));
+      NEXT(PRINT);
+    }
+    TARGET(READ) {
+      REG(0) = runtime_.read(in, static_cast<ValueKind>(OPERAND(1)));
+      NEXT(READ);
+    }
+    TARGET(TRAP) {
+      throw std::runtime_error(program_.strings[OPERAND(0)]);
+    }
+    TARGET(HALT) {
+      goto halt;
+    }
+
+#if !RPN_VM_COMPUTED_GOTO
+      }
+    }
+#endif
+  } catch (const std::exception& e) {
+    executed_ = executed;
+    throw std::runtime_error("Runtime error at line " + std::to_string(program_.lineAt(pc - code)) + ": " + e.what());
+  }
+
+halt:
+  executed_ = executed;
+  out.flush();
+
+#undef OPERAND
+#undef REG
+#undef NEXT
+#undef TARGET
+#undef DISPATCH
+}
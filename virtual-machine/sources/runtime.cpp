@@ -0,0 +1,259 @@
+#include "../headers/runtime.h"
+
+#include <cmath>
+
+
+Value Runtime::arithmetic(const Operator op, const Value& lhs, const Value& rhs) {
+  if (lhs.kind == ValueKind::STRING) { // concatenation (the only operator on strings)
+    return concatenate(lhs, rhs);
+  }
+
+  if (lhs.kind == ValueKind::FLOAT || rhs.kind == ValueKind::FLOAT) {
+    const double a = lhs.asFloat();
+    const double b = rhs.asFloat();
+    switch (op) {
+      case Operator::ADD:
+        return Value::ofFloat(a + b);
+      case Operator::SUB:
+        return Value::ofFloat(a - b);
+      case Operator::MUL:
+        return Value::ofFloat(a * b);
+      default:
+        return Value::ofFloat(a / b);
+    }
+  }
+
+  // integers wrap around instead of overflowing
+  const auto a = static_cast<uint64_t>(lhs.asInteger());
+  const auto b = static_cast<uint64_t>(rhs.asInteger());
+  switch (op) {
+    case Operator::ADD:
+      return Value::ofInt(static_cast<int64_t>(a + b));
+    case Operator::SUB:
+      return Value::ofInt(static_cast<int64_t>(a - b));
+    case Operator::MUL:
+      return Value::ofInt(static_cast<int64_t>(a * b));
+    default:
+      if (b == 0) {
+        throw std::runtime_error("integer division by zero");
+      }
+      if (static_cast<int64_t>(b) == -1) {
+        return Value::ofInt(static_cast<int64_t>(0 - a));
+      }
+      return Value::ofInt(static_cast<int64_t>(a) / static_cast<int64_t>(b));
+  }
+}
+
+Value Runtime::concatenate(const Value& lhs, const Value& rhs) {
+  const Value right = rhs.kind == ValueKind::STRING ? rhs : Value::ofShortString(std::string_view(&rhs.character, 1));
+  const size_t length = lhs.stringLength() + right.stringLength();
+  if (right.stringLength() == 0 || lhs.stringLength() == 0) {
+    return right.stringLength() == 0 ? lhs : right;
+  }
+  if (length > StringObject::FLAT_CONCATENATION) {
+    if (localStrings_) {
+      return Value::ofString(region_.newRope(lhs, right));
+    }
+    const Value operands[] = {lhs, right};
+    collectIfDue(operands, 2);
+    return Value::ofString(heap_.newRope(lhs, right));
+  }
+  // neither side is a rope (those are longer), copying them is cheap
+  std::string result;
+  result.reserve(length);
+  result += lhs.text();
+  result += right.text();
+  return makeString(std::move(result));
+}
+
+bool Runtime::compare(const Operator op, const Value& lhs, const Value& rhs) {
+  if (lhs.kind == ValueKind::STRING) {
+    if (op == Operator::EQ && (lhs.stringLength() != rhs.stringLength() ||
+      (lhs.length == Value::LONG_STRING && rhs.length == Value::LONG_STRING && lhs.string == rhs.string))) {
+      return lhs.stringLength() == rhs.stringLength(); // no need to flatten a rope
+    }
+    const int order = lhs.text().compare(rhs.text());
+    return op == Operator::LT ? order < 0 : op == Operator::GT ? order > 0 : order == 0;
+  }
+  if (lhs.kind == ValueKind::FLOAT || rhs.kind == ValueKind::FLOAT) {
+    const double a = lhs.asFloat();
+    const double b = rhs.asFloat();
+    return op == Operator::LT ? a < b : op == Operator::GT ? a > b : a == b;
+  }
+  const int64_t a = lhs.asInteger();
+  const int64_t b = rhs.asInteger();
+  return op == Operator::LT ? a < b : op == Operator::GT ? a > b : a == b;
+}
+
+Value Runtime::convert(const ValueKind target, const Value& value) {
+  if (value.kind == ValueKind::FLOAT && (target == ValueKind::INT || target == ValueKind::CHAR)) {
+    // out-of-range float to integer conversions are undefined in C++, reject them
+    if (!std::isfinite(value.real) || value.real >= 9223372036854775808.0 || value.real < -9223372036854775808.0) {
+      throw std::runtime_error("float value " + std::to_string(value.real) + " does not fit an int");
+    }
+  }
+  switch (target) {
+    case ValueKind::INT:
+      return Value::ofInt(value.asInteger());
+    case ValueKind::FLOAT:
+      return Value::ofFloat(value.asFloat());
+    case ValueKind::CHAR:
+      return Value::ofChar(static_cast<char>(value.asInteger()));
+    default:
+      return Value::ofBool(value.isTrue());
+  }
+}
+
+Value Runtime::newArray(const Value* sizes, const uint32_t dimensions, const ValueKind leaf, const bool local) {
+  if (!local) {
+    collectIfDue();
+  }
+  if (dimensions == 0) {
+    return Value::ofArray(local ? region_.newArray(0, Value()) : heap_.newArray(0));
+  }
+
+  // sizes are checked outermost first, those below an empty dimension never are
+  std::vector<int64_t>& shape = shape_;
+  shape.assign(dimensions, 0);
+  for (uint32_t i = 0; i < dimensions; ++i) {
+    shape[i] = sizes[i].asInteger();
+    if (shape[i] < 0) {
+      throw std::runtime_error("negative array size " + std::to_string(shape[i]));
+    }
+    if (shape[i] == 0) {
+      break;
+    }
+  }
+
+  Value zero;
+  switch (leaf) {
+    case ValueKind::FLOAT:
+      zero = Value::ofFloat(0.0);
+      break;
+    case ValueKind::CHAR:
+      zero = Value::ofChar('\0');
+      break;
+    case ValueKind::BOOL:
+      zero = Value::ofBool(false);
+      break;
+    case ValueKind::STRING:
+      zero = newString(""); // immutable, the elements can share it
+      break;
+    case ValueKind::ARRAY: // fewer sizes than nesting levels; an empty array cannot change
+      zero = Value::ofArray(local ? region_.newArray(0, Value()) : heap_.newArray(0));
+      break;
+    default:
+      zero = Value::ofInt(0);
+      break;
+  }
+  if (dimensions == 1) {
+    const auto size = static_cast<size_t>(shape[0]);
+    return Value::ofArray(local ? region_.newArray(size, zero) : heap_.newArray(size, zero));
+  }
+  return Value::ofArray(local ? region_.newDenseArray(shape.data(), dimensions, zero) :
+    heap_.newDenseArray(shape.data(), dimensions, zero));
+}
+
+void Runtime::collect(const Value* operands, const size_t count) {
+  rootRanges_.clear();
+  roots_(rootRanges_);
+  rootRanges_.emplace_back(operands, operands + count);
+  heap_.collect(rootRanges_, region_.arrays(), region_.strings());
+}
+
+void Runtime::outOfBounds(const int64_t index, const int64_t size) {
+  throw std::runtime_error("index " + std::to_string(index) + " is out of bounds for an array of size " +
+    std::to_string(size));
+}
+
+void Runtime::stackOverflow(const std::string& callee, const size_t depth, const size_t limit,
+  const size_t capacity) {
+  if (depth >= limit) {
+    throw std::runtime_error("stack overflow in a call of '" + callee + "': more than " + std::to_string(limit) +
+      " nested calls");
+  }
+  throw std::runtime_error("stack overflow in a call of '" + callee + "': the frame stack of " +
+    std::to_string(capacity) + " values is full");
+}
+
+Value* Runtime::locate(ArrayObject*& array, const Value* indices, const uint32_t count, int64_t& index) {
+  uint32_t next = 0;
+  while (true) {
+    Value* slot;
+    if (array->rank > 1 && count - next >= array->rank) {
+      slot = denseSlot(array, indices + next, array->rank);
+      next += array->rank;
+    } else {
+      index = indices[next++].asInteger();
+      checkIndex(index, array->size);
+      if (array->rank > 1) {
+        if (next == count) {
+          return nullptr;
+        }
+        array = array->row(index);
+        continue;
+      }
+      slot = array->data + index;
+    }
+    if (next == count) {
+      return slot;
+    }
+    array = slot->array;
+  }
+}
+
+Value Runtime::loadElement(ArrayObject* array, const Value* indices, const uint32_t count) {
+  int64_t index;
+  const Value* slot = locate(array, indices, count, index);
+  return slot ? *slot : Value::ofArray(array->row(index));
+}
+
+void Runtime::storeElement(ArrayObject* array, const Value* indices, const uint32_t count, const Value& value) {
+  int64_t index;
+  if (Value* slot = locate(array, indices, count, index)) {
+    *slot = value;
+  } else {
+    array->store(index, value);
+  }
+}
+
+Value Runtime::read(std::istream& in, const ValueKind kind) {
+  bool ok;
+  Value value;
+  switch (kind) {
+    case ValueKind::INT: {
+      int64_t integer;
+      ok = static_cast<bool>(in >> integer);
+      value = Value::ofInt(integer);
+      break;
+    }
+    case ValueKind::FLOAT: {
+      double real;
+      ok = static_cast<bool>(in >> real);
+      value = Value::ofFloat(real);
+      break;
+    }
+    case ValueKind::CHAR: {
+      char character;
+      ok = static_cast<bool>(in >> character);
+      value = Value::ofChar(character);
+      break;
+    }
+    case ValueKind::BOOL: { // true / false or a number
+      std::string word;
+      ok = static_cast<bool>(in >> word);
+      value = Value::ofBool(word == "true" || (word != "false" && std::strtod(word.c_str(), nullptr) != 0.0));
+      break;
+    }
+    default: {
+      std::string word;
+      ok = static_cast<bool>(in >> word);
+      value = makeString(std::move(word));
+      break;
+    }
+  }
+  if (!ok) {
+    throw std::runtime_error(std::string("cannot read a value of type '") + valueKindName(kind) + "'");
+  }
+  return value;
+}
@@ -0,0 +1,297 @@
+#include "../headers/value.h"
+
+
+void StringObject::flatten() {
+  std::string text;
+  text.reserve(length);
+  std::vector<Value> pending = {right, left}; // the leftmost part last
+  while (!pending.empty()) {
+    const Value part = pending.back();
+    pending.pop_back();
+    if (part.length != Value::LONG_STRING) {
+      text.append(part.characters, part.length);
+    } else if (part.string->isFlat()) {
+      text += part.string->flat;
+    } else {
+      pending.push_back(part.string->right);
+      pending.push_back(part.string->left);
+    }
+  }
+  flat = std::move(text);
+  left = Value();
+  right = Value();
+}
+
+
+StringObject* Heap::newString(std::string value) {
+  auto string = std::make_unique<StringObject>();
+  string->length = value.size();
+  string->flat = std::move(value);
+  strings_.push_back(std::move(string));
+  return strings_.back().get();
+}
+
+StringObject* Heap::newRope(const Value& left, const Value& right) {
+  auto string = std::make_unique<StringObject>();
+  string->length = left.stringLength() + right.stringLength();
+  string->left = left;
+  string->right = right;
+  strings_.push_back(std::move(string));
+  return strings_.back().get();
+}
+
+StringObject* Heap::intern(const std::string_view value) {
+  const auto found = interned_.find(value);
+  if (found != interned_.end()) {
+    return found->second;
+  }
+  StringObject* string = newString(std::string(value));
+  interned_.emplace(string->flat, string);
+  return string;
+}
+
+ArrayObject* Heap::newArray(const size_t size, const Value element) {
+  auto array = std::make_unique<ArrayObject>();
+  array->block = allocateElements(size, element);
+  array->data = array->block.get();
+  array->size = static_cast<int64_t>(size);
+  arrays_.push_back(std::move(array));
+  return arrays_.back().get();
+}
+
+ArrayObject* Heap::newDenseArray(const int64_t* shape, const uint32_t rank, const Value element) {
+  auto array = std::make_unique<ArrayObject>();
+  array->dimensions = std::make_unique<int64_t[]>(2 * rank);
+  const size_t count = denseLayout(shape, rank, array->dimensions.get());
+  array->block = allocateElements(count, element);
+  array->data = array->block.get();
+  array->dense = array->data;
+  array->size = shape[0];
+  array->rank = rank;
+  array->shape = array->dimensions.get();
+  array->strides = array->dimensions.get() + rank;
+  arrays_.push_back(std::move(array));
+  return arrays_.back().get();
+}
+
+
+// The values of [begin, end) that point to an object
+static void pushObjects(const Value* begin, const Value* end, std::vector<Value>& pending) {
+  for (const Value* value = begin; value != end; ++value) {
+    if (value->kind == ValueKind::ARRAY || (value->kind == ValueKind::STRING && value->length == Value::LONG_STRING)) {
+      pending.push_back(*value);
+    }
+  }
+}
+
+// The object values an array holds itself: its elements (the whole block of a dense
+// one), then the values of its row views made jagged
+static void pushElements(const ArrayObject* array, std::vector<Value>& pending) {
+  if (array->elements || (!array->parent && array->rank == 1)) {
+    pushObjects(array->data, array->data + array->size, pending);
+  }
+  if (array->dense) {
+    pushObjects(array->dense, array->dense + array->shape[0] * array->strides[0], pending);
+  }
+  for (const auto& row : array->rows) {
+    if (row) {
+      pushElements(row.get(), pending);
+    }
+  }
+}
+
+// Every array of the heap and the row views it owns, by the index of the heap's one
+static void indexArray(const ArrayObject* array, const size_t index,
+  std::unordered_map<const ArrayObject*, size_t>& arrays) {
+  arrays.emplace(array, index);
+  for (const auto& row : array->rows) {
+    if (row) {
+      indexArray(row.get(), index, arrays);
+    }
+  }
+}
+
+void Heap::collect(const std::vector<std::pair<const Value*, const Value*>>& roots,
+  const std::vector<ArrayObject*>& arrays, const std::vector<StringObject*>& strings) {
+  std::unordered_map<const ArrayObject*, size_t> arrayIndex;
+  for (size_t i = 0; i < arrays_.size(); ++i) {
+    indexArray(arrays_[i].get(), i, arrayIndex);
+  }
+  std::unordered_map<const StringObject*, size_t> stringIndex;
+  stringIndex.reserve(strings_.size());
+  for (size_t i = 0; i < strings_.size(); ++i) {
+    stringIndex.emplace(strings_[i].get(), i);
+  }
+
+  std::vector<bool> markedArrays(arrays_.size());
+  std::vector<bool> markedStrings(strings_.size());
+  std::vector<Value> pending;
+  for (const auto& [begin, end] : roots) {
+    pushObjects(begin, end, pending);
+  }
+  for (const ArrayObject* array : arrays) {
+    pushElements(array, pending);
+  }
+  for (const StringObject* string : strings) {
+    if (!string->isFlat()) {
+      pending.push_back(string->left);
+      pending.push_back(string->right);
+    }
+  }
+  for (const auto& [text, string] : interned_) {
+    markedStrings[stringIndex.at(string)] = true;
+  }
+
+  while (!pending.empty()) {
+    const Value value = pending.back();
+    pending.pop_back();
+    if (value.kind == ValueKind::ARRAY) {
+      const auto found = arrayIndex.find(value.array);
+      if (found != arrayIndex.end() && !markedArrays[found->second]) {
+        markedArrays[found->second] = true;
+        pushElements(arrays_[found->second].get(), pending);
+      }
+    } else if (value.kind == ValueKind::STRING && value.length == Value::LONG_STRING) {
+      const auto found = stringIndex.find(value.string);
+      if (found != stringIndex.end() && !markedStrings[found->second]) {
+        markedStrings[found->second] = true;
+        if (!value.string->isFlat()) {
+          pending.push_back(value.string->left);
+          pending.push_back(value.string->right);
+        }
+      }
+    }
+  }
+
+  const size_t before = objectCount();
+  size_t kept = 0;
+  for (size_t i = 0; i < arrays_.size(); ++i) {
+    if (markedArrays[i] && kept++ != i) {
+      arrays_[kept - 1] = std::move(arrays_[i]);
+    }
+  }
+  arrays_.resize(kept);
+  kept = 0;
+  for (size_t i = 0; i < strings_.size(); ++i) {
+    if (markedStrings[i] && kept++ != i) {
+      strings_[kept - 1] = std::move(strings_[i]);
+    }
+  }
+  strings_.resize(kept);
+  freed_ += before - objectCount();
+  ++collections_;
+  threshold_ = std::max(MIN_COLLECTION, 2 * objectCount());
+}
+
+
+size_t denseLayout(const int64_t* shape, const uint32_t rank, int64_t* dimensions) {
+  int64_t* strides = dimensions + rank;
+  size_t count = 1;
+  for (uint32_t i = rank; i-- > 0;) {
+    dimensions[i] = shape[i];
+    strides[i] = static_cast<int64_t>(count);
+    if (shape[i] != 0 && count > PTRDIFF_MAX / sizeof(Value) / static_cast<size_t>(shape[i])) {
+      throw std::bad_alloc();
+    }
+    count *= static_cast<size_t>(shape[i]);
+  }
+  return count;
+}
+
+
+ElementBlock allocateElements(const size_t count, const Value element) {
+  if (count > PTRDIFF_MAX / sizeof(Value)) {
+    throw std::bad_alloc();
+  }
+  ElementBlock block(static_cast<Value*>(::operator new(std::max<size_t>(count, 1) * sizeof(Value),
+    std::align_val_t{64})));
+  std::uninitialized_fill_n(block.get(), count, element);
+  return block;
+}
+
+ArrayObject* ArrayObject::row(const int64_t index) {
+  if (rows.empty()) {
+    rows.resize(static_cast<size_t>(size));
+  }
+  std::unique_ptr<ArrayObject>& row = rows[index];
+  if (!row) {
+    row = std::make_unique<ArrayObject>();
+    row->data = data + index * strides[0];
+    row->size = shape[1];
+    row->rank = rank - 1;
+    row->shape = shape + 1;
+    row->strides = strides + 1;
+    row->parent = this;
+  }
+  return row.get();
+}
+
+void ArrayObject::makeJagged() {
+  // the dense arrays above must reach this one through its row view from now on
+  if (parent && parent->rank > 1) {
+    parent->makeJagged();
+  }
+  ElementBlock values = allocateElements(static_cast<size_t>(size), Value());
+  for (int64_t i = 0; i < size; ++i) {
+    values[i] = Value::ofArray(row(i));
+  }
+  elements = std::move(values);
+  data = elements.get();
+  rank = 1;
+}
+
+
+// The innermost values of a dense block, dimension by dimension
+static void printDense(std::ostream& out, const Value* data, const int64_t* shape, const int64_t* strides,
+  const uint32_t rank) {
+  out << '[';
+  for (int64_t i = 0; i < shape[0]; ++i) {
+    if (i > 0) {
+      out << ", ";
+    }
+    if (rank > 1) {
+      printDense(out, data + i * strides[0], shape + 1, strides + 1, rank - 1);
+    } else {
+      printValue(out, data[i]);
+    }
+  }
+  out << ']';
+}
+
+void printValue(std::ostream& out, const Value& value) {
+  switch (value.kind) {
+    case ValueKind::INT:
+      out << value.integer;
+      break;
+    case ValueKind::FLOAT:
+      out << value.real;
+      break;
+    case ValueKind::CHAR:
+      out << value.character;
+      break;
+    case ValueKind::BOOL:
+      out << (value.boolean ? 1 : 0);
+      break;
+    case ValueKind::STRING:
+      out << value.text();
+      break;
+    case ValueKind::ARRAY: {
+      const ArrayObject& array = *value.array;
+      if (array.rank > 1) {
+        printDense(out, array.data, array.shape, array.strides, array.rank);
+        break;
+      }
+      out << '[';
+      for (int64_t i = 0; i < array.size; ++i) {
+        if (i > 0) {
+          out << ", ";
+        }
+        printValue(out, array.data[i]);
+      }
+      out << ']';
+      break;
+    }
+    default:
+      break;
+  }
+}
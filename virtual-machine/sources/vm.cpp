@@ -0,0 +1,761 @@
+#include "../headers/vm.h"
+
+
+// int, char and bool operands compute on their integer values
+static bool isIntegerKind(const ValueKind kind) {
+  return kind == ValueKind::INT || kind == ValueKind::CHAR || kind == ValueKind::BOOL;
+}
+
+// a float with a float or an integer value computes on doubles
+static bool isFloatOperation(const ValueKind lhs, const ValueKind rhs) {
+  return (lhs == ValueKind::FLOAT && (rhs == ValueKind::FLOAT || isIntegerKind(rhs))) ||
+    (rhs == ValueKind::FLOAT && isIntegerKind(lhs));
+}
+
+// Integer division of the language: by zero is an error, INT64_MIN / -1 wraps
+static int64_t divideIntegers(const int64_t lhs, const int64_t rhs) {
+  if (rhs == 0) {
+    throw std::runtime_error("integer division by zero");
+  }
+  return rhs == -1 ? static_cast<int64_t>(0 - static_cast<uint64_t>(lhs)) : lhs / rhs;
+}
+
+// The specialization of a generic binary operator for the operand kinds it just saw
+// (itself when there is none, like for strings)
+static OpCode quicken(const OpCode generic, const Value& lhs, const Value& rhs) {
+  static constexpr OpCode INTEGER[] = {OpCode::QUICK_ADD_INT, OpCode::QUICK_SUB_INT, OpCode::QUICK_MUL_INT,
+    OpCode::QUICK_DIV_INT, OpCode::QUICK_LT_INT, OpCode::QUICK_GT_INT, OpCode::QUICK_EQ_INT, OpCode::QUICK_NEQ_INT};
+  static constexpr OpCode FLOAT[] = {OpCode::QUICK_ADD_FLOAT, OpCode::QUICK_SUB_FLOAT, OpCode::QUICK_MUL_FLOAT,
+    OpCode::QUICK_DIV_FLOAT, OpCode::QUICK_LT_FLOAT, OpCode::QUICK_GT_FLOAT, OpCode::QUICK_EQ_FLOAT,
+    OpCode::QUICK_NEQ_FLOAT};
+  size_t index;
+  switch (generic) {
+    case OpCode::ADD:
+      index = 0;
+      break;
+    case OpCode::SUB:
+      index = 1;
+      break;
+    case OpCode::MUL:
+      index = 2;
+      break;
+    case OpCode::DIV:
+      index = 3;
+      break;
+    case OpCode::LT:
+      index = 4;
+      break;
+    case OpCode::GT:
+      index = 5;
+      break;
+    case OpCode::EQ:
+      index = 6;
+      break;
+    default:
+      index = 7;
+      break;
+  }
+  if (isIntegerKind(lhs.kind) && isIntegerKind(rhs.kind)) {
+    return INTEGER[index];
+  }
+  return isFloatOperation(lhs.kind, rhs.kind) ? FLOAT[index] : generic;
+}
+
+
+VirtualMachine::VirtualMachine(const RPNProgram& program, const size_t stackSize) :
+program_(program), stack_(stackSize) {}
+
+const uint8_t* VirtualMachine::nativeCall(JitContext* context, Value* sp, Value* fp, const uint32_t function,
+  const uint32_t returnPc) noexcept {
+  auto* vm = static_cast<VirtualMachine*>(context->machine);
+  try {
+    const NativeFunction* native = vm->jit_->count(function, vm->code_.data());
+    const RPNFunction& callee = vm->program_.functions[function];
+    // an overflow is thrown by the interpreter's CALL
+    if (!native || sp - callee.parameters + callee.slots + callee.maxStack > vm->stack_.end() ||
+      vm->frames_.size() >= vm->callDepthLimit_) {
+      return nullptr;
+    }
+    Value* base = sp - callee.parameters;
+    vm->frames_.push_back({function, vm->code_.data() + returnPc, fp, base + callee.slots + callee.maxStack,
+      vm->runtime_.enterFrame(callee.localStrings)});
+    return native->entry(callee.entry);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void VirtualMachine::nativeReturn(JitContext* context) noexcept {
+  auto* vm = static_cast<VirtualMachine*>(context->machine);
+  vm->runtime_.leaveFrame(vm->frames_.back().region);
+  vm->frames_.pop_back();
+}
+
+void VirtualMachine::run(std::istream& in, std::ostream& out) {
+  execute<false>(in, out, nullptr);
+}
+
+void VirtualMachine::run(std::istream& in, std::ostream& out, DispatchProfile& profile) {
+  execute<true>(in, out, &profile);
+}
+
+// The interpreter loop; PROFILE compiles the counting into the dispatch, so run() pays nothing for it
+template <bool PROFILE>
+void VirtualMachine::execute(std::istream& in, std::ostream& out, DispatchProfile* profile) {
+  frames_.clear();
+  frames_.reserve(callDepthLimit_);
+  globals_.assign(program_.globals, Value());
+  constants_.clear();
+  for (const auto& string : program_.strings) {
+    constants_.push_back(runtime_.intern(string));
+  }
+
+  code_ = program_.code; // quickening rewrites opcodes, the program stays as compiled
+  uint8_t* const code = code_.data();
+  const RPNFunction* const functions = program_.functions.data();
+  const Value* const stackEnd = stack_.end();
+  Value* const globals = globals_.data();
+  const Value* const constants = constants_.data();
+
+  jit_ = jitEnabled_ && RPN_VM_JIT ? std::make_unique<Jit>(program_) : nullptr;
+  Jit* const jit = jit_.get();
+  JitContext jitContext{nullptr, nullptr, globals, constants, &runtime_, &out, &nativeCall, &nativeReturn, this, 0,
+    nullptr, 0};
+  uint32_t function = 0; // the running one, only kept up to date for the JIT
+
+  const RPNFunction& entry = functions[0];
+  if (entry.slots + entry.maxStack > stack_.size()) {
+    throw std::runtime_error("Runtime error: the frame stack of " + std::to_string(stack_.size()) +
+      " values is too small for the top-level code");
+  }
+  Value* fp = stack_.data(); // slots of the running function
+  Value* sp = fp + entry.slots; // next free operand stack value
+
+  // the heap's roots: every frame up to the end of the running one
+  runtime_.resetRegion();
+  const Value* const top = fp + entry.slots + entry.maxStack;
+  runtime_.setRoots([this, top](std::vector<std::pair<const Value*, const Value*>>& roots) {
+    roots.emplace_back(stack_.data(), frames_.empty() ? top : frames_.back().limit);
+    roots.emplace_back(globals_.data(), globals_.data() + globals_.size());
+    roots.emplace_back(constants_.data(), constants_.data() + constants_.size());
+  });
+  const uint8_t* pc = code + entry.entry;
+  uint64_t executed = 0;
+
+#define OPERAND(index) readOperand(pc + 1 + 4 * (index))
+#define NEXT(name) pc += instructionSize(OpCode::name); DISPATCH()
+// the running instruction becomes `op` from its next execution on (all are one byte)
+#define REWRITE(op) code[pc - code] = static_cast<uint8_t>(op)
+// a quickened instruction whose guard failed runs again as the generic one
+#define DEOPTIMIZE(name) REWRITE(OpCode::name); DISPATCH()
+// continues in native code from pc until an instruction it leaves to the interpreter
+// (which may be in a function it called)
+#define RUN_NATIVE(native) \
+  pc = code + (native)->run(fp, sp, jitContext, static_cast<uint32_t>(pc - code)); \
+  fp = jitContext.fp; \
+  sp = jitContext.sp; \
+  function = frames_.empty() ? 0 : frames_.back().function
+// after a return the caller runs again: natively if it was compiled
+#define RETURN_TO_NATIVE() \
+  function = frames_.empty() ? 0 : frames_.back().function; \
+  if (const NativeFunction* native = jit->get(function)) { RUN_NATIVE(native); }
+
+#if RPN_VM_COMPUTED_GOTO
+#define RPN_VM_LABEL(name, operands) &&op_##name,
+  static const void* const dispatch[] = {RPN_OPCODES(RPN_VM_LABEL)};
+#undef RPN_VM_LABEL
+#define TARGET(name) op_##name:
+#define DISPATCH() ++executed; if constexpr (PROFILE) profile->record(*pc); goto *dispatch[*pc]
+#else
+#define TARGET(name) case OpCode::name:
+#define DISPATCH() continue
+#endif
+
+  try {
+#if RPN_VM_COMPUTED_GOTO
+    DISPATCH();
+#else
+    for (;;) {
+      ++executed;
+      if constexpr (PROFILE) {
+        profile->record(*pc);
+      }
+      switch (static_cast<OpCode>(*pc)) {
+#endif
+
+    TARGET(NOP) {
+      NEXT(NOP);
+    }
+    TARGET(PUSH_INT) {
+      *sp++ = Value::ofInt(static_cast<int32_t>(OPERAND(0)));
+      NEXT(PUSH_INT);
+    }
+    TARGET(PUSH_LONG) {
+      *sp++ = Value::ofInt(program_.integers[OPERAND(0)]);
+      NEXT(PUSH_LONG);
+    }
+    TARGET(PUSH_FLOAT) {
+      *sp++ = Value::ofFloat(program_.floats[OPERAND(0)]);
+      NEXT(PUSH_FLOAT);
+    }
+    TARGET(PUSH_CHAR) {
+      *sp++ = Value::ofChar(static_cast<char>(OPERAND(0)));
+      NEXT(PUSH_CHAR);
+    }
+    TARGET(PUSH_BOOL) {
+      *sp++ = Value::ofBool(OPERAND(0) != 0);
+      NEXT(PUSH_BOOL);
+    }
+    TARGET(PUSH_STRING) {
+      *sp++ = constants[OPERAND(0)];
+      NEXT(PUSH_STRING);
+    }
+    TARGET(POP) {
+      --sp;
+      NEXT(POP);
+    }
+    TARGET(DUP) {
+      *sp = sp[-1];
+      ++sp;
+      NEXT(DUP);
+    }
+    TARGET(LOAD_LOCAL) {
+      *sp++ = fp[OPERAND(0)];
+      NEXT(LOAD_LOCAL);
+    }
+    TARGET(STORE_LOCAL) {
+      fp[OPERAND(0)] = *--sp;
+      NEXT(STORE_LOCAL);
+    }
+    TARGET(LOAD_GLOBAL) {
+      *sp++ = globals[OPERAND(0)];
+      NEXT(LOAD_GLOBAL);
+    }
+    TARGET(STORE_GLOBAL) {
+      globals[OPERAND(0)] = *--sp;
+      NEXT(STORE_GLOBAL);
+    }
+    TARGET(NEW_ARRAY) {
+      const uint32_t dimensions = OPERAND(0);
+      sp -= dimensions;
+      *sp = runtime_.newArray(sp, dimensions, arrayLeaf(OPERAND(1)), isLocalArray(OPERAND(1)));
+      ++sp;
+      NEXT(NEW_ARRAY);
+    }
+    TARGET(LOAD_INDEX) {
+      ArrayObject* array = sp[-2].array;
+      const int64_t index = sp[-1].asInteger();
+      Runtime::checkIndex(index, array->size);
+      sp[-2] = array->load(index);
+      --sp;
+      NEXT(LOAD_INDEX);
+    }
+    TARGET(STORE_INDEX) {
+      sp -= 3;
+      ArrayObject* array = sp[0].array;
+      const int64_t index = sp[1].asInteger();
+      Runtime::checkIndex(index, array->size);
+      array->store(index, sp[2]);
+      NEXT(STORE_INDEX);
+    }
+    TARGET(LOAD_ELEMENT) {
+      const uint32_t count = OPERAND(0);
+      sp -= count;
+      ArrayObject* array = sp[-1].array;
+      sp[-1] = array->rank == count ? *Runtime::denseSlot(array, sp, count) : Runtime::loadElement(array, sp, count);
+      NEXT(LOAD_ELEMENT);
+    }
+    TARGET(STORE_ELEMENT) {
+      const uint32_t count = OPERAND(0);
+      sp -= count + 2;
+      ArrayObject* array = sp[0].array;
+      if (array->rank == count) {
+        *Runtime::denseSlot(array, sp + 1, count) = sp[count + 1];
+      } else {
+        Runtime::storeElement(array, sp + 1, count, sp[count + 1]);
+      }
+      NEXT(STORE_ELEMENT);
+    }
+    TARGET(LOAD_INDEX_UNCHECKED) {
+      sp[-2] = sp[-2].array->load(sp[-1].asInteger());
+      --sp;
+      NEXT(LOAD_INDEX_UNCHECKED);
+    }
+    TARGET(STORE_INDEX_UNCHECKED) {
+      sp -= 3;
+      sp[0].array->store(sp[1].asInteger(), sp[2]);
+      NEXT(STORE_INDEX_UNCHECKED);
+    }
+    TARGET(LOAD_ELEMENT_UNCHECKED) {
+      // fewer indices than the dense array has dimensions: the checked walk over the levels
+      const uint32_t count = OPERAND(0);
+      sp -= count;
+      ArrayObject* array = sp[-1].array;
+      sp[-1] = array->rank == count ? *Runtime::denseSlot<false>(array, sp, count) :
+        Runtime::loadElement(array, sp, count);
+      NEXT(LOAD_ELEMENT_UNCHECKED);
+    }
+    TARGET(STORE_ELEMENT_UNCHECKED) {
+      const uint32_t count = OPERAND(0);
+      sp -= count + 2;
+      ArrayObject* array = sp[0].array;
+      if (array->rank == count) {
+        *Runtime::denseSlot<false>(array, sp + 1, count) = sp[count + 1];
+      } else {
+        Runtime::storeElement(array, sp + 1, count, sp[count + 1]);
+      }
+      NEXT(STORE_ELEMENT_UNCHECKED);
+    }
+    TARGET(ADD) {
+      REWRITE(quicken(OpCode::ADD, sp[-2], sp[-1]));
+      sp[-2] = runtime_.arithmetic(Operator::ADD, sp[-2], sp[-1]);
+      --sp;
+      NEXT(ADD);
+    }
+    TARGET(SUB) {
+      REWRITE(quicken(OpCode::SUB, sp[-2], sp[-1]));
+      sp[-2] = runtime_.arithmetic(Operator::SUB, sp[-2], sp[-1]);
+      --sp;
+      NEXT(SUB);
+    }
+    TARGET(MUL) {
+      REWRITE(quicken(OpCode::MUL, sp[-2], sp[-1]));
+      sp[-2] = runtime_.arithmetic(Operator::MUL, sp[-2], sp[-1]);
+      --sp;
+      NEXT(MUL);
+    }
+    TARGET(DIV) {
+      REWRITE(quicken(OpCode::DIV, sp[-2], sp[-1]));
+      sp[-2] = runtime_.arithmetic(Operator::DIV, sp[-2], sp[-1]);
+      --sp;
+      NEXT(DIV);
+    }
+    TARGET(NEG) {
+      if (sp[-1].kind == ValueKind::FLOAT) {
+        sp[-1].real = -sp[-1].real;
+      } else {
+        sp[-1] = Value::ofInt(static_cast<int64_t>(0 - static_cast<uint64_t>(sp[-1].asInteger())));
+      }
+      NEXT(NEG);
+    }
+    TARGET(NOT) {
+      sp[-1] = Value::ofBool(!sp[-1].isTrue());
+      NEXT(NOT);
+    }
+    TARGET(LT) {
+      REWRITE(quicken(OpCode::LT, sp[-2], sp[-1]));
+      sp[-2] = Value::ofBool(Runtime::compare(Operator::LT, sp[-2], sp[-1]));
+      --sp;
+      NEXT(LT);
+    }
+    TARGET(GT) {
+      REWRITE(quicken(OpCode::GT, sp[-2], sp[-1]));
+      sp[-2] = Value::ofBool(Runtime::compare(Operator::GT, sp[-2], sp[-1]));
+      --sp;
+      NEXT(GT);
+    }
+    TARGET(EQ) {
+      REWRITE(quicken(OpCode::EQ, sp[-2], sp[-1]));
+      sp[-2] = Value::ofBool(Runtime::compare(Operator::EQ, sp[-2], sp[-1]));
+      --sp;
+      NEXT(EQ);
+    }
+    TARGET(NEQ) {
+      REWRITE(quicken(OpCode::NEQ, sp[-2], sp[-1]));
+      sp[-2] = Value::ofBool(!Runtime::compare(Operator::EQ, sp[-2], sp[-1]));
+      --sp;
+      NEXT(NEQ);
+    }
+    TARGET(TO_INT) {
+      sp[-1] = Runtime::convert(ValueKind::INT, sp[-1]);
+      NEXT(TO_INT);
+    }
+    TARGET(TO_FLOAT) {
+      sp[-1] = Runtime::convert(ValueKind::FLOAT, sp[-1]);
+      NEXT(TO_FLOAT);
+    }
+    TARGET(TO_CHAR) {
+      sp[-1] = Runtime::convert(ValueKind::CHAR, sp[-1]);
+      NEXT(TO_CHAR);
+    }
+    TARGET(TO_BOOL) {
+      sp[-1] = Value::ofBool(sp[-1].isTrue());
+      NEXT(TO_BOOL);
+    }
+    TARGET(JUMP) {
+      const uint8_t* target = code + OPERAND(0);
+      if (jit && target < pc) { // a loop back-edge
+        pc = target;
+        if (const NativeFunction* native = jit->count(function, code)) {
+          RUN_NATIVE(native);
+        }
+        DISPATCH();
+      }
+      pc = target;
+      DISPATCH();
+    }
+    TARGET(JUMP_IF_FALSE) {
+      pc = (--sp)->isTrue() ? pc + instructionSize(OpCode::JUMP_IF_FALSE) : code + OPERAND(0);
+      DISPATCH();
+    }
+    TARGET(JUMP_IF_TRUE) {
+      pc = (--sp)->isTrue() ? code + OPERAND(0) : pc + instructionSize(OpCode::JUMP_IF_TRUE);
+      DISPATCH();
+    }
+    TARGET(SWITCH_TABLE) {
+      const SwitchTable& table = program_.switches[OPERAND(0)];
+      const size_t index = table.find((--sp)->integer);
+      pc = code + (index < table.targets.size() ? table.targets[index] : table.fallback);
+      DISPATCH();
+    }
+    TARGET(SWITCH_STRING) {
+      const SwitchTable& table = program_.switches[OPERAND(0)];
+      const size_t index = table.find((--sp)->text(), program_.strings);
+      pc = code + (index < table.targets.size() ? table.targets[index] : table.fallback);
+      DISPATCH();
+    }
+    TARGET(CALL) {
+      const uint32_t index = OPERAND(0);
+      const RPNFunction& callee = functions[index];
+      Value* base = sp - callee.parameters; // the arguments become the callee's first slots
+      if (base + callee.slots + callee.maxStack > stackEnd || frames_.size() >= callDepthLimit_) {
+        Runtime::stackOverflow(callee.name, frames_.size(), callDepthLimit_, stack_.size());
+      }
+      frames_.push_back({index, pc + instructionSize(OpCode::CALL), fp, base + callee.slots + callee.maxStack,
+        runtime_.enterFrame(callee.localStrings)});
+      fp = base;
+      sp = base + callee.slots;
+      pc = code + callee.entry;
+      if (jit) {
+        function = index;
+        if (const NativeFunction* native = jit->count(function, code)) {
+          RUN_NATIVE(native);
+        }
+      }
+      DISPATCH();
+    }
+    TARGET(RETURN) {
+      const Value result = sp[-1];
+      const CallFrame& caller = frames_.back();
+      runtime_.leaveFrame(caller.region);
+      sp = fp;
+      *sp++ = result;
+      fp = caller.base;
+      pc = caller.returnAddress;
+      frames_.pop_back();
+      if (jit) {
+        RETURN_TO_NATIVE();
+      }
+      DISPATCH();
+    }
+    TARGET(RETURN_VOID) {
+      const CallFrame& caller = frames_.back();
+      runtime_.leaveFrame(caller.region);
+      sp = fp;
+      fp = caller.base;
+      pc = caller.returnAddress;
+      frames_.pop_back();
+      if (jit) {
+        RETURN_TO_NATIVE();
+      }
+      DISPATCH();
+    }
+    TARGET(PRINT) {
+      printValue(out, *--sp);
+      NEXT(PRINT);
+    }
+    TARGET(READ) {
+      *sp++ = runtime_.read(in, static_cast<ValueKind>(OPERAND(0)));
+      NEXT(READ);
+    }
+    TARGET(TRAP) {
+      throw std::runtime_error(program_.strings[OPERAND(0)]);
+    }
+    TARGET(HALT) {
+      goto halt;
+    }
+    TARGET(LOAD_LOCAL_PAIR) {
+      sp[0] = fp[OPERAND(0)];
+      sp[1] = fp[OPERAND(1)];
+      sp += 2;
+      NEXT(LOAD_LOCAL_PAIR);
+    }
+    TARGET(LOAD_LOCAL_ADD_CONST) {
+      const auto delta = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(OPERAND(1))));
+      *sp++ = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(fp[OPERAND(0)].integer) + delta));
+      NEXT(LOAD_LOCAL_ADD_CONST);
+    }
+    TARGET(INC_LOCAL) {
+      int64_t& local = fp[OPERAND(0)].integer;
+      const auto delta = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(OPERAND(1))));
+      local = static_cast<int64_t>(static_cast<uint64_t>(local) + delta);
+      NEXT(INC_LOCAL);
+    }
+    TARGET(LT_I64_JUMP_IF_FALSE) {
+      sp -= 2;
+      pc = sp[0].integer < sp[1].integer ? pc + instructionSize(OpCode::LT_I64_JUMP_IF_FALSE) : code + OPERAND(0);
+      DISPATCH();
+    }
+    TARGET(GT_I64_JUMP_IF_FALSE) {
+      sp -= 2;
+      pc = sp[0].integer > sp[1].integer ? pc + instructionSize(OpCode::GT_I64_JUMP_IF_FALSE) : code + OPERAND(0);
+      DISPATCH();
+    }
+
+    // typed operators: the generator proved the operand kinds, nothing is checked
+    TARGET(ADD_I64) {
+      sp[-2].integer = static_cast<int64_t>(static_cast<uint64_t>(sp[-2].integer) + static_cast<uint64_t>(sp[-1].integer));
+      --sp;
+      NEXT(ADD_I64);
+    }
+    TARGET(SUB_I64) {
+      sp[-2].integer = static_cast<int64_t>(static_cast<uint64_t>(sp[-2].integer) - static_cast<uint64_t>(sp[-1].integer));
+      --sp;
+      NEXT(SUB_I64);
+    }
+    TARGET(MUL_I64) {
+      sp[-2].integer = static_cast<int64_t>(static_cast<uint64_t>(sp[-2].integer) * static_cast<uint64_t>(sp[-1].integer));
+      --sp;
+      NEXT(MUL_I64);
+    }
+    TARGET(DIV_I64) {
+      sp[-2].integer = divideIntegers(sp[-2].integer, sp[-1].integer);
+      --sp;
+      NEXT(DIV_I64);
+    }
+    TARGET(NEG_I64) {
+      sp[-1].integer = static_cast<int64_t>(0 - static_cast<uint64_t>(sp[-1].integer));
+      NEXT(NEG_I64);
+    }
+    TARGET(LT_I64) {
+      sp[-2] = Value::ofBool(sp[-2].integer < sp[-1].integer);
+      --sp;
+      NEXT(LT_I64);
+    }
+    TARGET(GT_I64) {
+      sp[-2] = Value::ofBool(sp[-2].integer > sp[-1].integer);
+      --sp;
+      NEXT(GT_I64);
+    }
+    TARGET(EQ_I64) {
+      sp[-2] = Value::ofBool(sp[-2].integer == sp[-1].integer);
+      --sp;
+      NEXT(EQ_I64);
+    }
+    TARGET(NEQ_I64) {
+      sp[-2] = Value::ofBool(sp[-2].integer != sp[-1].integer);
+      --sp;
+      NEXT(NEQ_I64);
+    }
+    TARGET(ADD_F64) {
+      sp[-2].real += sp[-1].real;
+      --sp;
+      NEXT(ADD_F64);
+    }
+    TARGET(SUB_F64) {
+      sp[-2].real -= sp[-1].real;
+      --sp;
+      NEXT(SUB_F64);
+    }
+    TARGET(MUL_F64) {
+      sp[-2].real *= sp[-1].real;
+      --sp;
+      NEXT(MUL_F64);
+    }
+    TARGET(DIV_F64) {
+      sp[-2].real /= sp[-1].real;
+      --sp;
+      NEXT(DIV_F64);
+    }
+    TARGET(NEG_F64) {
+      sp[-1].real = -sp[-1].real;
+      NEXT(NEG_F64);
+    }
+    TARGET(LT_F64) {
+      sp[-2] = Value::ofBool(sp[-2].real < sp[-1].real);
+      --sp;
+      NEXT(LT_F64);
+    }
+    TARGET(GT_F64) {
+      sp[-2] = Value::ofBool(sp[-2].real > sp[-1].real);
+      --sp;
+      NEXT(GT_F64);
+    }
+    TARGET(EQ_F64) {
+      sp[-2] = Value::ofBool(sp[-2].real == sp[-1].real);
+      --sp;
+      NEXT(EQ_F64);
+    }
+    TARGET(NEQ_F64) {
+      sp[-2] = Value::ofBool(sp[-2].real != sp[-1].real);
+      --sp;
+      NEXT(NEQ_F64);
+    }
+    TARGET(I64_TO_F64) {
+      sp[-1] = Value::ofFloat(static_cast<double>(sp[-1].integer));
+      NEXT(I64_TO_F64);
+    }
+
+    // quickened generic operators: integer (int, char, bool) or float (a float and a number) operands
+    TARGET(QUICK_ADD_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(ADD);
+      }
+      const int64_t a = sp[-2].asInteger();
+      const int64_t b = sp[-1].asInteger();
+      sp[-2] = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)));
+      --sp;
+      NEXT(QUICK_ADD_INT);
+    }
+    TARGET(QUICK_SUB_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(SUB);
+      }
+      const int64_t a = sp[-2].asInteger();
+      const int64_t b = sp[-1].asInteger();
+      sp[-2] = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)));
+      --sp;
+      NEXT(QUICK_SUB_INT);
+    }
+    TARGET(QUICK_MUL_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(MUL);
+      }
+      const int64_t a = sp[-2].asInteger();
+      const int64_t b = sp[-1].asInteger();
+      sp[-2] = Value::ofInt(static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)));
+      --sp;
+      NEXT(QUICK_MUL_INT);
+    }
+    TARGET(QUICK_DIV_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(DIV);
+      }
+      const int64_t a = sp[-2].asInteger();
+      const int64_t b = sp[-1].asInteger();
+      sp[-2] = Value::ofInt(divideIntegers(a, b));
+      --sp;
+      NEXT(QUICK_DIV_INT);
+    }
+    TARGET(QUICK_LT_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(LT);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asInteger() < sp[-1].asInteger());
+      --sp;
+      NEXT(QUICK_LT_INT);
+    }
+    TARGET(QUICK_GT_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(GT);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asInteger() > sp[-1].asInteger());
+      --sp;
+      NEXT(QUICK_GT_INT);
+    }
+    TARGET(QUICK_EQ_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(EQ);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asInteger() == sp[-1].asInteger());
+      --sp;
+      NEXT(QUICK_EQ_INT);
+    }
+    TARGET(QUICK_NEQ_INT) {
+      if (!isIntegerKind(sp[-2].kind) || !isIntegerKind(sp[-1].kind)) {
+        DEOPTIMIZE(NEQ);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asInteger() != sp[-1].asInteger());
+      --sp;
+      NEXT(QUICK_NEQ_INT);
+    }
+    TARGET(QUICK_ADD_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(ADD);
+      }
+      sp[-2] = Value::ofFloat(sp[-2].asFloat() + sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_ADD_FLOAT);
+    }
+    TARGET(QUICK_SUB_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(SUB);
+      }
+      sp[-2] = Value::ofFloat(sp[-2].asFloat() - sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_SUB_FLOAT);
+    }
+    TARGET(QUICK_MUL_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(MUL);
+      }
+      sp[-2] = Value::ofFloat(sp[-2].asFloat() * sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_MUL_FLOAT);
+    }
+    TARGET(QUICK_DIV_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(DIV);
+      }
+      sp[-2] = Value::ofFloat(sp[-2].asFloat() / sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_DIV_FLOAT);
+    }
+    TARGET(QUICK_LT_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(LT);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asFloat() < sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_LT_FLOAT);
+    }
+    TARGET(QUICK_GT_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(GT);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asFloat() > sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_GT_FLOAT);
+    }
+    TARGET(QUICK_EQ_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(EQ);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asFloat() == sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_EQ_FLOAT);
+    }
+    TARGET(QUICK_NEQ_FLOAT) {
+      if (!isFloatOperation(sp[-2].kind, sp[-1].kind)) {
+        DEOPTIMIZE(NEQ);
+      }
+      sp[-2] = Value::ofBool(sp[-2].asFloat() != sp[-1].asFloat());
+      --sp;
+      NEXT(QUICK_NEQ_FLOAT);
+    }
+
+#if !RPN_VM_COMPUTED_GOTO
+      }
+    }
+#endif
+  } catch (const std::exception& e) {
+    executed_ = executed;
+    nativeEntries_ = jitContext.entries;
+    throw std::runtime_error("Runtime error at line " + std::to_string(program_.lineAt(pc - code)) + ": " + e.what());
+  }
+
+halt:
+  executed_ = executed;
+  nativeEntries_ = jitContext.entries;
+  out.flush();
+
+#undef OPERAND
+#undef NEXT
+#undef REWRITE
+#undef DEOPTIMIZE
+#undef RUN_NATIVE
+#undef RETURN_TO_NATIVE
+#undef TARGET
+#undef DISPATCH
+}
+
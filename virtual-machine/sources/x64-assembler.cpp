@@ -0,0 +1,339 @@
+#include "../headers/x64-assembler.h"
+
+
+static uint8_t encoding(const Reg reg) {
+  return static_cast<uint8_t>(reg);
+}
+
+static uint8_t encoding(const Xmm reg) {
+  return static_cast<uint8_t>(reg);
+}
+
+
+void X64Assembler::bind(Label& label) {
+  label.position = static_cast<int64_t>(code_.size());
+  for (const size_t patch : label.patches) {
+    const auto displacement = static_cast<int32_t>(label.position - static_cast<int64_t>(patch + 4));
+    std::memcpy(&code_[patch], &displacement, sizeof(displacement));
+  }
+  label.patches.clear();
+}
+
+void X64Assembler::push(const Reg reg) {
+  rex(false, 0, encoding(reg));
+  byte(static_cast<uint8_t>(0x50 + (encoding(reg) & 7)));
+}
+
+void X64Assembler::pop(const Reg reg) {
+  rex(false, 0, encoding(reg));
+  byte(static_cast<uint8_t>(0x58 + (encoding(reg) & 7)));
+}
+
+void X64Assembler::mov(const Reg destination, const Reg source) {
+  rex(true, encoding(source), encoding(destination));
+  byte(0x89);
+  direct(encoding(source), encoding(destination));
+}
+
+void X64Assembler::mov(const Reg destination, const Reg base, const int32_t disp) {
+  rex(true, encoding(destination), encoding(base));
+  byte(0x8B);
+  memory(encoding(destination), base, disp);
+}
+
+void X64Assembler::mov(const Reg base, const int32_t disp, const Reg source) {
+  rex(true, encoding(source), encoding(base));
+  byte(0x89);
+  memory(encoding(source), base, disp);
+}
+
+void X64Assembler::movImmediate(const Reg destination, const uint64_t value) {
+  if (value <= UINT32_MAX) { // mov r32, imm32 clears the upper half
+    rex(false, 0, encoding(destination));
+    byte(static_cast<uint8_t>(0xB8 + (encoding(destination) & 7)));
+    int32(static_cast<int32_t>(static_cast<uint32_t>(value)));
+  } else if (static_cast<int64_t>(value) >= INT32_MIN && static_cast<int64_t>(value) < 0) {
+    rex(true, 0, encoding(destination));
+    byte(0xC7);
+    direct(0, encoding(destination));
+    int32(static_cast<int32_t>(static_cast<int64_t>(value)));
+  } else {
+    rex(true, 0, encoding(destination));
+    byte(static_cast<uint8_t>(0xB8 + (encoding(destination) & 7)));
+    for (int shift = 0; shift < 64; shift += 8) {
+      byte(static_cast<uint8_t>(value >> shift));
+    }
+  }
+}
+
+void X64Assembler::movImmediate(const Reg base, const int32_t disp, const int32_t value) {
+  rex(true, 0, encoding(base));
+  byte(0xC7);
+  memory(0, base, disp);
+  int32(value);
+}
+
+void X64Assembler::movByte(const Reg base, const int32_t disp, const uint8_t value) {
+  rex(false, 0, encoding(base));
+  byte(0xC6);
+  memory(0, base, disp);
+  byte(value);
+}
+
+void X64Assembler::movzxByte(const Reg destination) {
+  rex(false, encoding(destination), encoding(destination), encoding(destination) >= 4);
+  bytes({0x0F, 0xB6});
+  direct(encoding(destination), encoding(destination));
+}
+
+void X64Assembler::movzxByte(const Reg destination, const Reg base, const int32_t disp) {
+  rex(false, encoding(destination), encoding(base));
+  bytes({0x0F, 0xB6});
+  memory(encoding(destination), base, disp);
+}
+
+void X64Assembler::movsxByte(const Reg destination, const Reg base, const int32_t disp) {
+  rex(true, encoding(destination), encoding(base));
+  bytes({0x0F, 0xBE});
+  memory(encoding(destination), base, disp);
+}
+
+void X64Assembler::add(const Reg destination, const int32_t value) {
+  rex(true, 0, encoding(destination));
+  byte(0x81);
+  direct(0, encoding(destination));
+  int32(value);
+}
+
+void X64Assembler::add(const Reg destination, const Reg source) {
+  rex(true, encoding(source), encoding(destination));
+  byte(0x01);
+  direct(encoding(source), encoding(destination));
+}
+
+void X64Assembler::add(const Reg base, const int32_t disp, const Reg source) {
+  rex(true, encoding(source), encoding(base));
+  byte(0x01);
+  memory(encoding(source), base, disp);
+}
+
+void X64Assembler::addImmediate(const Reg base, const int32_t disp, const int32_t value) {
+  rex(true, 0, encoding(base));
+  byte(0x81);
+  memory(0, base, disp);
+  int32(value);
+}
+
+void X64Assembler::sub(const Reg destination, const int32_t value) {
+  rex(true, 0, encoding(destination));
+  byte(0x81);
+  direct(5, encoding(destination));
+  int32(value);
+}
+
+void X64Assembler::sub(const Reg base, const int32_t disp, const Reg source) {
+  rex(true, encoding(source), encoding(base));
+  byte(0x29);
+  memory(encoding(source), base, disp);
+}
+
+void X64Assembler::imul(const Reg destination, const Reg base, const int32_t disp) {
+  rex(true, encoding(destination), encoding(base));
+  bytes({0x0F, 0xAF});
+  memory(encoding(destination), base, disp);
+}
+
+void X64Assembler::negate(const Reg base, const int32_t disp) {
+  rex(true, 0, encoding(base));
+  byte(0xF7);
+  memory(3, base, disp);
+}
+
+void X64Assembler::negate(const Reg reg) {
+  rex(true, 0, encoding(reg));
+  byte(0xF7);
+  direct(3, encoding(reg));
+}
+
+void X64Assembler::shl(const Reg reg, const uint8_t count) {
+  rex(true, 0, encoding(reg));
+  byte(0xC1);
+  direct(4, encoding(reg));
+  byte(count);
+}
+
+void X64Assembler::idiv(const Reg divisor) {
+  rex(true, 0, encoding(divisor));
+  byte(0xF7);
+  direct(7, encoding(divisor));
+}
+
+void X64Assembler::cmp(const Reg lhs, const Reg base, const int32_t disp) {
+  rex(true, encoding(lhs), encoding(base));
+  byte(0x3B);
+  memory(encoding(lhs), base, disp);
+}
+
+void X64Assembler::cmp(const Reg lhs, const int32_t value) {
+  rex(true, 0, encoding(lhs));
+  byte(0x81);
+  direct(7, encoding(lhs));
+  int32(value);
+}
+
+void X64Assembler::cmpImmediate(const Reg base, const int32_t disp, const int32_t value) {
+  rex(true, 0, encoding(base));
+  byte(0x81);
+  memory(7, base, disp);
+  int32(value);
+}
+
+void X64Assembler::cmpDword(const Reg base, const int32_t disp, const int32_t value) {
+  rex(false, 0, encoding(base));
+  byte(0x81);
+  memory(7, base, disp);
+  int32(value);
+}
+
+void X64Assembler::cmpByte(const Reg base, const int32_t disp, const uint8_t value) {
+  rex(false, 0, encoding(base));
+  byte(0x80);
+  memory(7, base, disp);
+  byte(value);
+}
+
+void X64Assembler::xorByte(const Reg base, const int32_t disp, const uint8_t value) {
+  rex(false, 0, encoding(base));
+  byte(0x80);
+  memory(6, base, disp);
+  byte(value);
+}
+
+void X64Assembler::test(const Reg lhs, const Reg rhs) {
+  rex(true, encoding(rhs), encoding(lhs));
+  byte(0x85);
+  direct(encoding(rhs), encoding(lhs));
+}
+
+void X64Assembler::testByte(const Reg reg) {
+  rex(false, encoding(reg), encoding(reg), encoding(reg) >= 4);
+  byte(0x84);
+  direct(encoding(reg), encoding(reg));
+}
+
+void X64Assembler::set(const Condition condition, const Reg reg) {
+  rex(false, 0, encoding(reg), encoding(reg) >= 4);
+  bytes({0x0F, static_cast<uint8_t>(0x90 + static_cast<uint8_t>(condition))});
+  direct(0, encoding(reg));
+}
+
+void X64Assembler::andByte(const Reg destination, const Reg source) {
+  rex(false, encoding(source), encoding(destination), encoding(source) >= 4 || encoding(destination) >= 4);
+  byte(0x20);
+  direct(encoding(source), encoding(destination));
+}
+
+void X64Assembler::orByte(const Reg destination, const Reg source) {
+  rex(false, encoding(source), encoding(destination), encoding(source) >= 4 || encoding(destination) >= 4);
+  byte(0x08);
+  direct(encoding(source), encoding(destination));
+}
+
+void X64Assembler::movsd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x10, destination, base, disp);
+}
+
+void X64Assembler::movsd(const Reg base, const int32_t disp, const Xmm source) {
+  sse(0xF2, 0x11, source, base, disp);
+}
+
+void X64Assembler::addsd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x58, destination, base, disp);
+}
+
+void X64Assembler::subsd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x5C, destination, base, disp);
+}
+
+void X64Assembler::mulsd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x59, destination, base, disp);
+}
+
+void X64Assembler::divsd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x5E, destination, base, disp);
+}
+
+void X64Assembler::ucomisd(const Xmm lhs, const Reg base, const int32_t disp) {
+  sse(0x66, 0x2E, lhs, base, disp);
+}
+
+void X64Assembler::cvtsi2sd(const Xmm destination, const Reg base, const int32_t disp) {
+  sse(0xF2, 0x2A, destination, base, disp, true);
+}
+
+void X64Assembler::jmp(Label& label) {
+  byte(0xE9);
+  rel32(label);
+}
+
+void X64Assembler::jmp(const Condition condition, Label& label) {
+  bytes({0x0F, static_cast<uint8_t>(0x80 + static_cast<uint8_t>(condition))});
+  rel32(label);
+}
+
+void X64Assembler::jmp(const Reg target) {
+  rex(false, 0, encoding(target));
+  byte(0xFF);
+  direct(4, encoding(target));
+}
+
+void X64Assembler::call(const Reg target) {
+  rex(false, 0, encoding(target));
+  byte(0xFF);
+  direct(2, encoding(target));
+}
+
+void X64Assembler::lea(const Reg destination, Label& label) {
+  rex(true, encoding(destination), 0);
+  byte(0x8D);
+  byte(static_cast<uint8_t>((encoding(destination) & 7) << 3 | 5)); // ModRM of [rip + disp32]
+  rel32(label);
+}
+
+void X64Assembler::int32(const int32_t value) {
+  const size_t at = code_.size();
+  code_.resize(at + sizeof(value));
+  std::memcpy(&code_[at], &value, sizeof(value));
+}
+
+void X64Assembler::rex(const bool wide, const uint8_t reg, const uint8_t rm, const bool force) {
+  const auto prefix = static_cast<uint8_t>(0x40 | (wide ? 8 : 0) | (reg >> 3) << 2 | (rm >> 3));
+  if (prefix != 0x40 || force) {
+    byte(prefix);
+  }
+}
+
+void X64Assembler::memory(const uint8_t reg, const Reg base, const int32_t disp) {
+  byte(static_cast<uint8_t>(0x80 | (reg & 7) << 3 | (encoding(base) & 7)));
+  if ((encoding(base) & 7) == 4) {
+    byte(0x24); // SIB: no index
+  }
+  int32(disp);
+}
+
+void X64Assembler::sse(const uint8_t prefix, const uint8_t opcode, const Xmm reg, const Reg base, const int32_t disp,
+  const bool wide) {
+  byte(prefix);
+  rex(wide, encoding(reg), encoding(base));
+  bytes({0x0F, opcode});
+  memory(encoding(reg), base, disp);
+}
+
+void X64Assembler::rel32(Label& label) {
+  if (label.position >= 0) {
+    int32(static_cast<int32_t>(label.position - static_cast<int64_t>(code_.size() + 4)));
+  } else {
+    label.patches.push_back(code_.size());
+    int32(0);
+  }
+}